@@ -71,6 +71,12 @@
 // so that the standing queues build in the traffic control layer where
 // they can be managed by advanced queue discs rather than in the 
 // device layer.
+//
+// With --bql, the device queue can hold 100 packets, but Byte Queue Limits
+// (BQL) stop the queue disc as soon as the bytes in the device exceed the
+// minimum needed to keep the link busy, as dynamically computed. The standing
+// queue still builds in the traffic control layer, and the queue disc moves
+// several packets to the device each time it is woken up.
 
 using namespace ns3;
 
@@ -94,9 +100,11 @@ main (int argc, char *argv[])
   double simulationTime = 10; //seconds
   std::string transportProt = "Tcp";
   std::string socketType;
+  bool bql = false;
 
   CommandLine cmd;
   cmd.AddValue ("transportProt", "Transport protocol to use: Tcp, Udp", transportProt);
+  cmd.AddValue ("bql", "Enable byte queue limits on the device queues", bql);
   cmd.Parse (argc, argv);
 
   if (transportProt.compare ("Tcp") == 0)
@@ -114,7 +122,7 @@ main (int argc, char *argv[])
   PointToPointHelper pointToPoint;
   pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
   pointToPoint.SetChannelAttribute ("Delay", StringValue ("2ms"));
-  pointToPoint.SetQueue ("ns3::DropTailQueue", "Mode", StringValue ("QUEUE_MODE_PACKETS"), "MaxPackets", UintegerValue (1));
+  pointToPoint.SetQueue ("ns3::DropTailQueue", "Mode", StringValue ("QUEUE_MODE_PACKETS"), "MaxPackets", UintegerValue (bql ? 100 : 1));
 
   NetDeviceContainer devices;
   devices = pointToPoint.Install (nodes);
@@ -126,6 +134,10 @@ main (int argc, char *argv[])
   uint16_t handle = tch.SetRootQueueDisc ("ns3::RedQueueDisc");
   // Add the internal queue used by Red
   tch.AddInternalQueues (handle, 1, "ns3::DropTailQueue", "MaxPackets", UintegerValue (10000));
+  if (bql)
+    {
+      tch.SetQueueLimits ("ns3::DynamicQueueLimits");
+    }
   QueueDiscContainer qdiscs = tch.Install (devices);
 
   Ptr<QueueDisc> q = qdiscs.Get (1);
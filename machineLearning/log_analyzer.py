@@ -1,4 +1,5 @@
 import csv
+import struct
 import matplotlib.pyplot as plt
 import seaborn as sns
 import sys
@@ -23,35 +24,62 @@ from log_time_tcb import AnalyzeMetaSocket
 warnings.filterwarnings("error")
 g_resultRecord = {}
 
+# Ipv4L3Protocol::DropReason codes reported in the monitor records
+DROP_TTL_EXPIRED = 1
+DROP_BAD_CHECKSUM = 3
+
 def preprocess_monitor_data(file_path):
-    record = []
-    with open(file_path, 'rb') as csvfile:
+    # flow endpoints are written once per flow, next to the binary records
+    flows = {}
+    with open(file_path + '_flows', 'rb') as csvfile:
         spamreader = csv.reader(csvfile, delimiter=',')
         next(spamreader)
         for row in spamreader:
-            timestamp = (int(row[0])*1.0)/1e9
-            flowId = int(row[1])
-            From = row[2]
-            To = row[3]
-            TxPacket = int(row[4])
-            TxBytes = int(row[5]) # - int(row[4]) * 52 # minus the size of header (most header is of size 20 (tcp header) + 32 (22 for mptcp DSS and 10 for TS) Bytes)
-            RxPacket = int(row[6])
-            RxBytes = int(row[7]) # - int(row[6]) * 52 # minus the size of header (most header is of size 20 (tcp header) + 32 (22 for mptcp DSS and 10 for TS) Bytes)
-            delaySum = float(row[8][1:-2])/1e9
-            jitterSum = float(row[9][1:-2])/1e9
-            lostPackets = int(row[10])
-
-            record.append([timestamp, flowId, From, To, TxPacket, TxBytes, RxPacket, RxBytes, delaySum, jitterSum, lostPackets])
-            MpTcpSubflows.updateSubflowId(From, To, flowId)
+            flows[int(row[0])] = (row[1], row[2])
 
-    record.sort(key=lambda ele:ele[0])
+    # time of every sample, in ns
+    samples = []
+    with open(file_path + '_samples', 'rb') as csvfile:
+        spamreader = csv.reader(csvfile, delimiter=',')
+        next(spamreader)
+        for row in spamreader:
+            samples.append(int(row[0]))
+
+    # binary records written by FlowMonitor::SerializeToBinaryStream, only for
+    # flows that changed since the previous sample
+    changed = {}
+    fixed = struct.Struct('=qIIQIQqqIII')
+    with open(file_path, 'rb') as binfile:
+        data = binfile.read()
+    offset = 0
+    while offset < len(data):
+        (timestamp, flowId, TxPacket, TxBytes, RxPacket, RxBytes,
+         delaySum, jitterSum, lostPackets, timesForwarded, nReasons) = fixed.unpack_from(data, offset)
+        packetsDropped = struct.unpack_from('=%dI' % nReasons, data, offset + fixed.size)
+        offset += fixed.size + 4 * nReasons
+        From, To = flows[flowId]
+        # indexed by Ipv4L3Protocol::DropReason
+        TTL_expire = packetsDropped[DROP_TTL_EXPIRED] if nReasons > DROP_TTL_EXPIRED else 0
+        Bad_checksum = packetsDropped[DROP_BAD_CHECKSUM] if nReasons > DROP_BAD_CHECKSUM else 0
+
+        changed.setdefault(timestamp, []).append([flowId, From, To, TxPacket, TxBytes, RxPacket, RxBytes, delaySum/1e9, jitterSum/1e9, lostPackets, TTL_expire, Bad_checksum])
+        MpTcpSubflows.updateSubflowId(From, To, flowId)
+
+    # carry every flow forward to each sample, as if all flows were written every time
+    record = []
+    latest = {}
+    for timestamp in sorted(samples):
+        for row in changed.get(timestamp, []):
+            latest[row[0]] = row
+        for flowId in sorted(latest):
+            record.append([timestamp/1e9] + latest[flowId])
 
     print 'mptcp subflow ids: ', MpTcpSubflows.getSubflowList()
     assert -1 not in MpTcpSubflows.getSubflowList()
     for row in record:
         row.append(MpTcpSubflows.getSubflowId(row[1])) # append -1 if it is not a flowId of subflow
 
-    columns = ['Timestamp','FlowId','From','To','TxPackets','TxBytes','RxPackets','RxBytes','DelaySum','JitterSum','LostPacketSum','SubflowId']
+    columns = ['Timestamp','FlowId','From','To','TxPackets','TxBytes','RxPackets','RxBytes','DelaySum','JitterSum','LostPacketSum','TTL_expire','Bad_checksum','SubflowId']
     monitor_records = pd.DataFrame(record, columns=columns)
 
     return monitor_records
@@ -332,7 +332,7 @@ vector<Ptr<NetDevice>> CreateSimplestNetwork (uint32_t packetSize,
 
     if(g_link_b_BER != 0){
       std::cout << "Error model installed in link B" << std::endl;
-      Ptr<RateErrorModel> ptr_em = CreateObjectWithAttributes<RateErrorModel> ();
+      Ptr<GeometricRateErrorModel> ptr_em = CreateObject<GeometricRateErrorModel> ();
       ptr_em->SetRate(g_link_b_BER);
       linkedDevices.Get(0)->SetAttribute("ReceiveErrorModel", PointerValue (ptr_em));
       linkedDevices.Get(1)->SetAttribute("ReceiveErrorModel", PointerValue (ptr_em));
@@ -459,7 +459,7 @@ vector<Ptr<NetDevice>> CreateNetwork5 (uint32_t packetSize,
 
     if(g_link_b_BER != 0){
       std::cout << "Error model installed in link D-A" << std::endl;
-      Ptr<RateErrorModel> ptr_em = CreateObjectWithAttributes<RateErrorModel> ();
+      Ptr<GeometricRateErrorModel> ptr_em = CreateObject<GeometricRateErrorModel> ();
       ptr_em->SetRate(g_link_b_BER);
       linkedDevices.Get(0)->SetAttribute("ReceiveErrorModel", PointerValue (ptr_em));
       linkedDevices.Get(1)->SetAttribute("ReceiveErrorModel", PointerValue (ptr_em));
@@ -909,7 +909,7 @@ void CreateExtendedClassicNetwork (uint32_t packetSize,
 }
 
 void ChangeLinkErrorRate (Ptr<NetDevice> nd, double bitErrorRate){
-    Ptr<RateErrorModel> error = CreateObject<RateErrorModel> ();
+    Ptr<GeometricRateErrorModel> error = CreateObject<GeometricRateErrorModel> ();
     error->SetAttribute ("ErrorRate", DoubleValue (bitErrorRate));
     nd->SetAttribute ("ReceiveErrorModel", PointerValue (error));
 }
@@ -179,37 +179,40 @@ void TraceMonitorStates(const string& outputDir){
   static Ptr<FlowMonitor> monitor = flowmon.InstallAll();;
   static bool initialized = false;
   static Ptr<OutputStreamWrapper> logFile;
+  static Ptr<OutputStreamWrapper> flowsFile;
+  static Ptr<OutputStreamWrapper> samplesFile;
+  static FlowMonitor::FlowStatsDeltaContainer delta;
+  static std::vector<bool> knownFlows;
 
   if(!initialized){
-    logFile = Create<OutputStreamWrapper>(outputDir + "/mptcp_monitor", std::ios::out);
-    *(logFile->GetStream()) << "Timestamp,FlowId,From,To,TxPackets,TxBytes,RxPackets,RxBytes,DelaySum,JitterSum,LostPacketSum,TTL_expire,Bad_checksum" << endl;
+    // Binary records, see FlowMonitor::SerializeToBinaryStream for the layout
+    logFile = Create<OutputStreamWrapper>(outputDir + "/mptcp_monitor", std::ios::out | std::ios::binary);
+    flowsFile = Create<OutputStreamWrapper>(outputDir + "/mptcp_monitor_flows", std::ios::out);
+    *(flowsFile->GetStream()) << "FlowId,From,To" << endl;
+    // Time of every sample, so that the analyzer can carry the unchanged flows forward
+    samplesFile = Create<OutputStreamWrapper>(outputDir + "/mptcp_monitor_samples", std::ios::out);
+    *(samplesFile->GetStream()) << "Timestamp" << endl;
     initialized = true;
   }
 
   monitor->CheckForLostPackets ();
+
+  // Only flows that changed since the last sample are written
+  monitor->GetFlowStatsDelta (delta);
   Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
-  FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats ();
-  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); ++i){
-    Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (i->first);
-    *(logFile->GetStream()) << Simulator::Now().GetNanoSeconds() << ","
-                            << i->first << ","
-                            << t.sourceAddress << ","
-                            << t.destinationAddress << ","
-                            << i->second.txPackets << ","
-                            << i->second.txBytes << ","
-                            << i->second.rxPackets << ","
-                            << i->second.rxBytes << ","
-                            << i->second.delaySum << ","
-                            << i->second.jitterSum << ","
-                            << i->second.lostPackets;
-    if(i->second.packetsDropped.size() > Ipv4L3Protocol::DropReason::DROP_TTL_EXPIRED){
-      *(logFile->GetStream()) << "," <<i->second.packetsDropped[Ipv4L3Protocol::DropReason::DROP_TTL_EXPIRED];
+  for (FlowMonitor::FlowStatsDeltaContainer::const_iterator i = delta.begin (); i != delta.end (); ++i){
+    if(i->flowId >= knownFlows.size()){
+      knownFlows.resize(i->flowId + 1, false);
     }
-    if(i->second.packetsDropped.size() > Ipv4L3Protocol::DropReason::DROP_BAD_CHECKSUM){
-      *(logFile->GetStream()) << "," <<i->second.packetsDropped[Ipv4L3Protocol::DropReason::DROP_BAD_CHECKSUM];
+    if(!knownFlows[i->flowId]){
+      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (i->flowId);
+      *(flowsFile->GetStream()) << i->flowId << "," << t.sourceAddress << "," << t.destinationAddress << "\n";
+      knownFlows[i->flowId] = true;
     }
-    *(logFile->GetStream()) << "\n";
   }
+
+  FlowMonitor::SerializeToBinaryStream(*(logFile->GetStream()), delta);
+  *(samplesFile->GetStream()) << Simulator::Now().GetNanoSeconds() << "\n";
 }
 
 void PrintMonitorStates(void){
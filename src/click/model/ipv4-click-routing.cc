@@ -585,6 +585,9 @@ Ipv4ClickRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
 } // namespace ns3
 
 using ns3::g_log;
+#ifdef NS3_LOG_ENABLE
+using ns3::g_logCompiledLevels;
+#endif
 
 static int simstrlcpy (char *buf, int len, const std::string &s)
 {
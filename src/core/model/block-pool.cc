@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "block-pool.h"
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::BlockPoolRegister() definition.
+ */
+
+namespace ns3 {
+
+namespace {
+
+/**
+ * Set once the pools of the current thread are drained.
+ *
+ * A plain \c bool, so that it outlives the destructors of the thread.
+ */
+thread_local bool g_blockPoolsDrained;
+
+/** The pools of one thread, drained by the destructor. */
+struct BlockPoolList
+{
+  /** Drain the pools of the thread, which may not register anymore. */
+  ~BlockPoolList ()
+  {
+    g_blockPoolsDrained = true;
+    while (m_head != 0)
+      {
+        BlockPoolLink *link = m_head;
+        m_head = link->m_next;
+        link->m_drain (link);
+      }
+  }
+
+  BlockPoolLink *m_head; //!< The last pool registered
+};
+
+/** The pools of the current thread. */
+thread_local BlockPoolList g_blockPools;
+
+} // unnamed namespace
+
+bool
+BlockPoolRegister (BlockPoolLink *link)
+{
+  if (g_blockPoolsDrained)
+    {
+      return false;
+    }
+  link->m_next = g_blockPools.m_head;
+  g_blockPools.m_head = link;
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <new>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::BlockPool declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ *
+ * \brief The link of a BlockPool in the list of pools of its thread.
+ */
+struct BlockPoolLink
+{
+  BlockPoolLink *m_next;                  //!< Next pool of the thread
+  void (*m_drain) (BlockPoolLink *link);  //!< Release the blocks of the pool
+};
+
+/**
+ * \ingroup core
+ *
+ * Add a pool to the pools drained when the current thread exits.
+ *
+ * \param [in] link The link of the pool.
+ * \returns \c false if the thread is already exiting: the pool
+ * must not keep any block.
+ */
+bool BlockPoolRegister (BlockPoolLink *link);
+
+/**
+ * \ingroup core
+ *
+ * \brief Free lists of the memory blocks of one thread, by size class.
+ *
+ * A pool is meant to be a \c thread_local variable of the allocator
+ * which owns it; the allocator decides which size class a block
+ * belongs to. Blocks come from <tt>::operator new</tt> and are not
+ * tied to the thread which allocated them: a block released by
+ * another thread simply joins the pool of that thread.
+ *
+ * The pool has neither constructor nor destructor, so that it is
+ * zero-initialized and stays usable for the whole life of its thread,
+ * static destructors included. The pool registers itself with
+ * BlockPoolRegister() when it keeps its first block; its blocks are
+ * released when the thread exits, after which Push() refuses them
+ * and the caller frees them.
+ *
+ * \tparam CLASSES The number of size classes.
+ * \tparam MAX_FREE The largest number of free blocks kept per class.
+ */
+template <std::size_t CLASSES, uint32_t MAX_FREE = 1024>
+struct BlockPool
+{
+  /**
+   * \param [in] sizeClass The size class.
+   * \returns A free block of the class, or zero if there is none.
+   */
+  void * Pop (std::size_t sizeClass)
+  {
+    Block *block = m_free[sizeClass];
+    if (block != 0)
+      {
+        m_free[sizeClass] = block->m_next;
+        m_nFree[sizeClass]--;
+      }
+    return block;
+  }
+
+  /**
+   * \param [in] sizeClass The size class.
+   * \param [in] p The block, at least as large as a pointer.
+   * \returns \c false if the block was not kept, and must be freed.
+   */
+  bool Push (std::size_t sizeClass, void *p)
+  {
+    if (m_closed || m_nFree[sizeClass] >= MAX_FREE)
+      {
+        return false;
+      }
+    if (m_link.m_drain == 0)
+      {
+        m_link.m_drain = &BlockPool::Drain;
+        if (!BlockPoolRegister (&m_link))
+          {
+            m_closed = true;
+            return false;
+          }
+      }
+    Block *block = static_cast<Block *> (p);
+    block->m_next = m_free[sizeClass];
+    m_free[sizeClass] = block;
+    m_nFree[sizeClass]++;
+    return true;
+  }
+
+  /**
+   * Release the free blocks of a pool, and refuse the later ones.
+   * \param [in] link The link of the pool.
+   */
+  static void Drain (BlockPoolLink *link)
+  {
+    // m_link is the first member of the pool
+    BlockPool *pool = reinterpret_cast<BlockPool *> (link);
+    for (std::size_t i = 0; i < CLASSES; i++)
+      {
+        while (pool->m_free[i] != 0)
+          {
+            Block *block = pool->m_free[i];
+            pool->m_free[i] = block->m_next;
+            ::operator delete (block);
+          }
+        pool->m_nFree[i] = 0;
+      }
+    pool->m_closed = true;
+  }
+
+  /** A free block, linked through its first bytes. */
+  struct Block
+  {
+    Block *m_next; //!< Next free block of the same size class
+  };
+
+  BlockPoolLink m_link;       //!< Link in the pools of the thread
+  Block *m_free[CLASSES];     //!< Free blocks, per size class
+  uint32_t m_nFree[CLASSES];  //!< Number of free blocks, per size class
+  bool m_closed;              //!< The thread is exiting
+};
+
+} // namespace ns3
+
+#endif /* BLOCK_POOL_H */
@@ -25,7 +25,13 @@
 #include "names.h"
 #include "pointer.h"
 #include "log.h"
+#include "system-mutex.h"
+#include "simulator.h"
 
+#include <atomic>
+#include <list>
+#include <map>
+#include <set>
 #include <sstream>
 
 /**
@@ -38,6 +44,16 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Config");
 
+namespace {
+
+/**
+ * Whether ConfigImpl holds persistent connections, checked without
+ * its lock by Config::NotifyNewObject.
+ */
+std::atomic<bool> g_hasPersistent (false);
+
+} // unnamed namespace
+
 namespace Config {
 
 MatchContainer::MatchContainer ()
@@ -149,7 +165,13 @@ MatchContainer::DisconnectWithoutContext (std::string name, const CallbackBase &
 } // namespace Config
 
 
-/** Helper to test if an array entry matches a config path specification. */
+/**
+ * Helper to test if an array entry matches a config path specification.
+ *
+ * The specification is parsed once into a list of index ranges,
+ * so that matching the entries of a large container does not
+ * parse it again for each entry.
+ */
 class ArrayMatcher
 {
 public:
@@ -166,7 +188,20 @@ public:
    * \returns \c true if the index matches the Config Path.
    */
   bool Matches (uint32_t i) const;
+  /**
+   * Test if the Config path specification matches exactly one index.
+   *
+   * \param [out] i The index, if the specification is a single number.
+   * \returns \c true if the specification is a single number.
+   */
+  bool GetIndex (uint32_t *i) const;
 private:
+  /**
+   * Parse a Config path specification into index ranges.
+   *
+   * \param [in] element The Config path specification.
+   */
+  void Parse (std::string element);
   /**
    * Convert a string to an \c uint32_t.
    *
@@ -177,77 +212,93 @@ private:
   bool StringToUint32 (std::string str, uint32_t *value) const;
   /** The Config path element. */
   std::string m_element;
+  /** Whether the element is "*", which matches any index. */
+  bool m_all;
+  /** The matching index ranges, bounds included. */
+  std::vector<std::pair<uint32_t, uint32_t> > m_ranges;
 };
 
 
 ArrayMatcher::ArrayMatcher (std::string element)
-  : m_element (element)
+  : m_element (element),
+    m_all (false)
 {
   NS_LOG_FUNCTION (this << element);
+  Parse (element);
 }
-bool
-ArrayMatcher::Matches (uint32_t i) const
+void
+ArrayMatcher::Parse (std::string element)
 {
-  NS_LOG_FUNCTION (this << i);
-  if (m_element == "*")
+  NS_LOG_FUNCTION (this << element);
+  if (element == "*")
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches *");
-      return true;
+      m_all = true;
+      return;
     }
   std::string::size_type tmp;
-  tmp = m_element.find ("|");
+  tmp = element.find ("|");
   if (tmp != std::string::npos)
     {
-      std::string left = m_element.substr (0, tmp-0);
-      std::string right = m_element.substr (tmp+1, m_element.size () - (tmp + 1));
-      ArrayMatcher matcher = ArrayMatcher (left);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<left);
-          return true;
-        }
-      matcher = ArrayMatcher (right);
-      if (matcher.Matches (i))
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<right);
-          return true;
-        }
-      NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
-      return false;
+      Parse (element.substr (0, tmp-0));
+      Parse (element.substr (tmp+1, element.size () - (tmp + 1)));
+      return;
     }
-  std::string::size_type leftBracket = m_element.find ("[");
-  std::string::size_type rightBracket = m_element.find ("]");
-  std::string::size_type dash = m_element.find ("-");
-  if (leftBracket == 0 && rightBracket == m_element.size () - 1 &&
+  std::string::size_type leftBracket = element.find ("[");
+  std::string::size_type rightBracket = element.find ("]");
+  std::string::size_type dash = element.find ("-");
+  if (leftBracket == 0 && rightBracket == element.size () - 1 &&
       dash > leftBracket && dash < rightBracket)
     {
-      std::string lowerBound = m_element.substr (leftBracket + 1, dash - (leftBracket + 1));
-      std::string upperBound = m_element.substr (dash + 1, rightBracket - (dash + 1));
+      std::string lowerBound = element.substr (leftBracket + 1, dash - (leftBracket + 1));
+      std::string upperBound = element.substr (dash + 1, rightBracket - (dash + 1));
       uint32_t min;
       uint32_t max;
       if (StringToUint32 (lowerBound, &min) && 
           StringToUint32 (upperBound, &max) &&
-          i >= min && i <= max)
-        {
-          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
-          return true;
-        }
-      else
+          min <= max)
         {
-          NS_LOG_DEBUG ("Array "<<i<<" does not "<<m_element);
-          return false;
+          m_ranges.push_back (std::make_pair (min, max));
         }
+      return;
     }
   uint32_t value;
-  if (StringToUint32 (m_element, &value) &&
-      i == value)
+  if (StringToUint32 (element, &value))
+    {
+      m_ranges.push_back (std::make_pair (value, value));
+    }
+}
+bool
+ArrayMatcher::Matches (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_all)
     {
-      NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+      NS_LOG_DEBUG ("Array "<<i<<" matches *");
       return true;
     }
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator j = m_ranges.begin ();
+       j != m_ranges.end (); ++j)
+    {
+      if (i >= j->first && i <= j->second)
+        {
+          NS_LOG_DEBUG ("Array "<<i<<" matches "<<m_element);
+          return true;
+        }
+    }
   NS_LOG_DEBUG ("Array "<<i<<" does not match "<<m_element);
   return false;
 }
+bool
+ArrayMatcher::GetIndex (uint32_t *i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  if (m_all || m_ranges.size () != 1 || m_ranges[0].first != m_ranges[0].second)
+    {
+      return false;
+    }
+  *i = m_ranges[0].first;
+  return true;
+}
 
 bool
 ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
@@ -259,8 +310,84 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
   return !iss.bad () && !iss.fail ();
 }
 
+/**
+ * An attribute of a TypeId which leads to other objects on a Config path.
+ */
+struct PathAttribute
+{
+  std::string name;                         //!< The attribute name.
+  Ptr<const AttributeAccessor> accessor;    //!< The attribute accessor.
+  bool container;                           //!< An ObjectPtrContainer, otherwise a Pointer.
+};
+/** The attributes matching one Config path element. */
+typedef std::vector<PathAttribute> PathAttributes;
+
+/**
+ * Find the Pointer and ObjectPtrContainer attributes of a TypeId
+ * and of its parents which match a Config path element.
+ *
+ * The result only depends on the registered TypeIds, so it is
+ * computed once per TypeId and element, instead of walking the
+ * attributes for each object on the path.
+ *
+ * \param [in] tid The TypeId of the object.
+ * \param [in] item The Config path element.
+ * \returns The matching attributes, in the order of the TypeId walk.
+ */
+static const PathAttributes &
+GetPathAttributes (TypeId tid, const std::string &item)
+{
+  NS_LOG_FUNCTION (tid << item);
+  typedef std::map<std::pair<TypeId, std::string>, PathAttributes> Cache;
+  static Cache cache;
+  static SystemMutex mutex;
+  CriticalSection cs (mutex);
+
+  std::pair<TypeId, std::string> key = std::make_pair (tid, item);
+  Cache::const_iterator found = cache.find (key);
+  if (found != cache.end ())
+    {
+      return found->second;
+    }
+  PathAttributes &attributes = cache[key];
+  TypeId nextTid = tid;
+  do
+    {
+      tid = nextTid;
+      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info;
+          info = tid.GetAttribute (i);
+          if (info.name != item && item != "*")
+            {
+              continue;
+            }
+          PathAttribute attribute;
+          attribute.name = info.name;
+          attribute.accessor = info.accessor;
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.container = false;
+              attributes.push_back (attribute);
+            }
+          else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.container = true;
+              attributes.push_back (attribute);
+            }
+          // this could be anything else and we don't know what to do with it.
+          // So, we just ignore it.
+        }
+      nextTid = tid.GetParent ();
+    } while (nextTid != tid);
+  return attributes;
+}
+
 /**
  * Abstract class to parse Config paths into object references.
+ *
+ * The path is split into its elements once, when the resolver is
+ * constructed.
  */
 class Resolver
 {
@@ -282,25 +409,48 @@ public:
    *                  in the Config path.
    */
   void Resolve (Ptr<Object> root);
+  /**
+   * Parse the stored Config path into object references, beginning
+   * at an object somewhere down the path.
+   *
+   * \param [in] object The object.
+   * \param [in] path The Config path of \p object, without wildcards.
+   * \returns \c true if \p path matches the leading part of the stored
+   *          Config path.
+   */
+  bool ResolveFrom (Ptr<Object> object, std::string path);
   
 private:
-  /** Ensure the Config path starts and ends with a '/'. */
-  void Canonicalize (void);
+  /**
+   * Ensure the Config path starts and ends with a '/'.
+   *
+   * \param [in] path The Config path.
+   * \returns The canonical Config path.
+   */
+  static std::string Canonicalize (std::string path);
+  /**
+   * Split a canonical Config path into its elements.
+   *
+   * \param [in] path The canonical Config path.
+   * \returns The path elements.
+   */
+  static std::vector<std::string> Split (std::string path);
   /**
    * Parse the next element in the Config path.
    *
-   * \param [in] path The remaining portion of the Config path.
+   * \param [in] level The index of the next element.
    * \param [in] root The object corresponding to the current positon
    *                  in the Config path.
    */
-  void DoResolve (std::string path, Ptr<Object> root);
+  void DoResolve (uint32_t level, Ptr<Object> root);
   /**
    * Parse an index on the Config path.
    *
-   * \param [in] path The remaining Config path.
-   * \param [in,out] vector The resulting list of matching objects.
+   * \param [in] level The index of the element holding the index.
+   * \param [in] root The object holding the container.
+   * \param [in] attribute The container attribute of \p root.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoArrayResolve (uint32_t level, Ptr<Object> root, const PathAttribute &attribute);
   /**
    * Handle one object found on the path.
    *
@@ -325,36 +475,63 @@ private:
   std::vector<std::string> m_workStack;
   /** The Config path. */
   std::string m_path;
+  /** The elements of the Config path. */
+  std::vector<std::string> m_items;
+  /** The index matchers of the elements, in case they follow a container. */
+  std::vector<ArrayMatcher> m_matchers;
 };
 
 Resolver::Resolver (std::string path)
-  : m_path (path)
+  : m_path (Canonicalize (path)),
+    m_items (Split (m_path))
 {
   NS_LOG_FUNCTION (this << path);
-  Canonicalize ();
+  m_matchers.reserve (m_items.size ());
+  for (std::vector<std::string>::const_iterator i = m_items.begin (); i != m_items.end (); ++i)
+    {
+      m_matchers.push_back (ArrayMatcher (*i));
+    }
 }
 Resolver::~Resolver ()
 {
   NS_LOG_FUNCTION (this);
 }
-void
-Resolver::Canonicalize (void)
+std::string
+Resolver::Canonicalize (std::string path)
 {
-  NS_LOG_FUNCTION (this);
+  NS_LOG_FUNCTION (path);
 
   // ensure that we start and end with a '/'
-  std::string::size_type tmp = m_path.find ("/");
+  std::string::size_type tmp = path.find ("/");
   if (tmp != 0)
     {
       // no slash at start
-      m_path = "/" + m_path;
+      path = "/" + path;
     }
-  tmp = m_path.find_last_of ("/");
-  if (tmp != (m_path.size () - 1))
+  tmp = path.find_last_of ("/");
+  if (tmp != (path.size () - 1))
     {
       // no slash at end
-      m_path = m_path + "/";
+      path = path + "/";
     }
+  return path;
+}
+
+std::vector<std::string>
+Resolver::Split (std::string path)
+{
+  NS_LOG_FUNCTION (path);
+  NS_ASSERT ((path.find ("/")) == 0);
+  std::vector<std::string> items;
+  std::string::size_type cur = 0;
+  std::string::size_type next = path.find ("/", 1);
+  while (next != std::string::npos)
+    {
+      items.push_back (path.substr (cur + 1, next - (cur + 1)));
+      cur = next;
+      next = path.find ("/", cur + 1);
+    }
+  return items;
 }
 
 void 
@@ -362,7 +539,39 @@ Resolver::Resolve (Ptr<Object> root)
 {
   NS_LOG_FUNCTION (this << root);
 
-  DoResolve (m_path, root);
+  DoResolve (0, root);
+}
+
+bool
+Resolver::ResolveFrom (Ptr<Object> object, std::string path)
+{
+  NS_LOG_FUNCTION (this << object << path);
+
+  std::vector<std::string> items = Split (Canonicalize (path));
+  if (items.size () > m_items.size ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < items.size (); i++)
+    {
+      if (items[i] == m_items[i] || m_items[i] == "*")
+        {
+          continue;
+        }
+      // an index of a container
+      uint32_t index;
+      std::istringstream iss (items[i]);
+      iss >> index;
+      if (iss.fail () || !iss.eof () || !m_matchers[i].Matches (index))
+        {
+          return false;
+        }
+    }
+  NS_ASSERT (m_workStack.empty ());
+  m_workStack = items;
+  DoResolve (items.size (), object);
+  m_workStack.clear ();
+  return true;
 }
 
 std::string
@@ -388,13 +597,11 @@ Resolver::DoResolveOne (Ptr<Object> object)
 }
 
 void
-Resolver::DoResolve (std::string path, Ptr<Object> root)
+Resolver::DoResolve (uint32_t level, Ptr<Object> root)
 {
-  NS_LOG_FUNCTION (this << path << root);
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
+  NS_LOG_FUNCTION (this << level << root);
 
-  if (next == std::string::npos)
+  if (level == m_items.size ())
     {
       //
       // If root is zero, we're beginning to see if we can use the object name 
@@ -410,8 +617,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
         }
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  const std::string &item = m_items[level];
 
   //
   // If root is zero, we're beginning to see if we can use the object name 
@@ -422,11 +628,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   //
   if (root == 0)
     {
-      std::string::size_type offset = path.find ("/Names");
-      if (offset == 0)
+      if (item.compare (0, 5, "Names") == 0)
         {
           m_workStack.push_back (item);
-          DoResolve (pathLeft, root);
+          DoResolve (level + 1, root);
           m_workStack.pop_back ();
           return;
         }
@@ -443,7 +648,7 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
     {
       NS_LOG_DEBUG ("Name system resolved item = " << item << " to " << namedObject);
       m_workStack.push_back (item);
-      DoResolve (pathLeft, namedObject);
+      DoResolve (level + 1, namedObject);
       m_workStack.pop_back ();
       return;
     }
@@ -473,68 +678,43 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
           return;
         }
       m_workStack.push_back (item);
-      DoResolve (pathLeft, object);
+      DoResolve (level + 1, object);
       m_workStack.pop_back ();
     }
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
+      const PathAttributes &attributes = GetPathAttributes (root->GetInstanceTypeId (), item);
       bool foundMatch = false;
-      
-      do
+      for (PathAttributes::const_iterator i = attributes.begin (); i != attributes.end (); ++i)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          if (!i->container)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
+              PointerValue ptr;
+              i->accessor->Get (PeekPointer (root), ptr);
+              Ptr<Object> object = ptr.Get<Object> ();
+              if (object == 0)
                 {
+                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
                   continue;
                 }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
-                }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
-                }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              foundMatch = true;
+              m_workStack.push_back (i->name);
+              DoResolve (level + 1, object);
+              m_workStack.pop_back ();
             }
-
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
-      
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath ());
+              foundMatch = true;
+              m_workStack.push_back (i->name);
+              DoArrayResolve (level + 1, root, *i);
+              m_workStack.pop_back ();
+            }
+        }
       if (!foundMatch)
         {
           NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
@@ -544,20 +724,35 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (uint32_t level, Ptr<Object> root, const PathAttribute &attribute)
 {
-  NS_LOG_FUNCTION(this << path << &container);
-  NS_ASSERT (path != "");
-  NS_ASSERT ((path.find ("/")) == 0);
-  std::string::size_type next = path.find ("/", 1);
-  if (next == std::string::npos)
+  NS_LOG_FUNCTION(this << level << root << attribute.name);
+  if (level == m_items.size ())
     {
       return;
     }
-  std::string item = path.substr (1, next-1);
-  std::string pathLeft = path.substr (next, path.size ()-next);
+  const ArrayMatcher &matcher = m_matchers[level];
 
-  ArrayMatcher matcher = ArrayMatcher (item);
+  // A single index is looked up directly, without copying the container.
+  uint32_t index;
+  const ObjectPtrContainerAccessor *accessor =
+    dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (attribute.accessor));
+  if (accessor != 0 && matcher.GetIndex (&index))
+    {
+      Ptr<Object> object = accessor->Find (PeekPointer (root), index);
+      if (object != 0)
+        {
+          std::ostringstream oss;
+          oss << index;
+          m_workStack.push_back (oss.str ());
+          DoResolve (level + 1, object);
+          m_workStack.pop_back ();
+        }
+      return;
+    }
+
+  ObjectPtrContainerValue container;
+  attribute.accessor->Get (PeekPointer (root), container);
   ObjectPtrContainerValue::Iterator it;
   for (it = container.Begin (); it != container.End (); ++it)
     {
@@ -566,12 +761,11 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
           std::ostringstream oss;
           oss << (*it).first;
           m_workStack.push_back (oss.str ());
-          DoResolve (pathLeft, (*it).second);
+          DoResolve (level + 1, (*it).second);
           m_workStack.pop_back ();
         }
     }
 }
-
 /** Config system implementation class. */
 class ConfigImpl : public Singleton<ConfigImpl>
 {
@@ -588,6 +782,23 @@ public:
   void Disconnect (std::string path, const CallbackBase &cb);
   /** \copydoc Config::LookupMatches() */
   Config::MatchContainer LookupMatches (std::string path);
+  /**
+   * \copybrief Config::ConnectPersistent()
+   * \param [in] path A path to match trace sources.
+   * \param [in] cb The callback to connect to the matching trace sources.
+   * \param [in] context Whether the callback receives the context.
+   */
+  void ConnectPersistent (std::string path, const CallbackBase &cb, bool context);
+  /** \copydoc Config::NotifyNewObject() */
+  void NotifyNewObject (Ptr<Object> object, std::string path);
+  /**
+   * Forget all the persistent trace connections.
+   *
+   * Called at Simulator::Destroy: the objects they reached are gone, and
+   * the objects of the next simulation, at the same paths, must be
+   * connected again.
+   */
+  static void ClearPersistent (void);
 
   /** \copydoc Config::RegisterRootNamespaceObject() */
   void RegisterRootNamespaceObject (Ptr<Object> obj);
@@ -608,14 +819,114 @@ private:
    * \param [in,out] leaf The trailing part of the \p path.
    */
   void ParsePath (std::string path, std::string *root, std::string *leaf) const;
+  /**
+   * Forget the persistent trace connections made with the given arguments.
+   * \param [in] root The leading part of the Config path.
+   * \param [in] leaf The trace source name.
+   * \param [in] cb The callback.
+   * \param [in] context Whether the callback receives the context.
+   */
+  void RemovePersistent (std::string root, std::string leaf,
+                         const CallbackBase &cb, bool context);
 
   /** Container type to hold the root Config path tokens. */
   typedef std::vector<Ptr<Object> > Roots;
 
   /** The list of Config path roots. */
   Roots m_roots;
+
+  /**
+   * A trace connection which also applies to the objects notified
+   * after it was made.
+   */
+  class PersistentResolver : public Resolver
+  {
+  public:
+    /**
+     * Constructor.
+     * \param [in] root The leading part of the Config path.
+     * \param [in] leaf The trace source name.
+     * \param [in] cb The callback to connect.
+     * \param [in] context Whether the callback receives the context.
+     */
+    PersistentResolver (std::string root, std::string leaf,
+                        const CallbackBase &cb, bool context);
+    /**
+     * Whether this connection was made with the given arguments.
+     * \param [in] root The leading part of the Config path.
+     * \param [in] leaf The trace source name.
+     * \param [in] cb The callback.
+     * \param [in] context Whether the callback receives the context.
+     * \returns \c true if the arguments are the ones of the connection.
+     */
+    bool IsEqual (std::string root, std::string leaf,
+                  const CallbackBase &cb, bool context) const;
+  private:
+    /**
+     * Connect the callback to a matching object, unless it already was.
+     * \param [in] object The matching object.
+     * \param [in] path The matching Config path context.
+     */
+    virtual void DoOne (Ptr<Object> object, std::string path);
+
+    std::string m_root;                  //!< The leading part of the Config path.
+    std::string m_leaf;                  //!< The trace source name.
+    CallbackBase m_cb;                   //!< The callback.
+    bool m_context;                      //!< Whether the callback receives the context.
+    /** The objects already connected, with their context. */
+    std::set<std::pair<std::string, Ptr<Object> > > m_connected;
+  };
+
+  /** Container type to hold the persistent trace connections. */
+  typedef std::list<PersistentResolver> PersistentConnections;
+
+  /** The persistent trace connections. */
+  PersistentConnections m_persistent;
+  /**
+   * Protects m_persistent: objects may be notified by the threads
+   * of a multithreaded simulator.
+   */
+  SystemMutex m_persistentMutex;
 };
 
+ConfigImpl::PersistentResolver::PersistentResolver (std::string root, std::string leaf,
+                                                    const CallbackBase &cb, bool context)
+  : Resolver (root),
+    m_root (root),
+    m_leaf (leaf),
+    m_cb (cb),
+    m_context (context)
+{
+  NS_LOG_FUNCTION (this << root << leaf << &cb << context);
+}
+
+bool
+ConfigImpl::PersistentResolver::IsEqual (std::string root, std::string leaf,
+                                         const CallbackBase &cb, bool context) const
+{
+  NS_LOG_FUNCTION (this << root << leaf << &cb << context);
+  return m_root == root && m_leaf == leaf && m_context == context
+         && m_cb.GetImpl ()->IsEqual (cb.GetImpl ());
+}
+
+void
+ConfigImpl::PersistentResolver::DoOne (Ptr<Object> object, std::string path)
+{
+  NS_LOG_FUNCTION (this << object << path);
+  if (!m_connected.insert (std::make_pair (path, object)).second)
+    {
+      return;
+    }
+  if (m_context)
+    {
+      object->TraceConnect (m_leaf, path + m_leaf, m_cb);
+    }
+  else
+    {
+      object->TraceConnectWithoutContext (m_leaf, m_cb);
+    }
+}
+
 void 
 ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) const
 {
@@ -628,6 +939,28 @@ ConfigImpl::ParsePath (std::string path, std::string *root, std::string *leaf) c
   NS_LOG_FUNCTION (path << *root << *leaf);
 }
 
+void
+ConfigImpl::RemovePersistent (std::string root, std::string leaf,
+                              const CallbackBase &cb, bool context)
+{
+  NS_LOG_FUNCTION (this << root << leaf << &cb << context);
+
+  CriticalSection cs (m_persistentMutex);
+  PersistentConnections::iterator i = m_persistent.begin ();
+  while (i != m_persistent.end ())
+    {
+      if (i->IsEqual (root, leaf, cb, context))
+        {
+          i = m_persistent.erase (i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+  g_hasPersistent = !m_persistent.empty ();
+}
+
 void 
 ConfigImpl::Set (std::string path, const AttributeValue &value)
 {
@@ -653,6 +986,7 @@ ConfigImpl::DisconnectWithoutContext (std::string path, const CallbackBase &cb)
   NS_LOG_FUNCTION (this << path << &cb);
   std::string root, leaf;
   ParsePath (path, &root, &leaf);
+  RemovePersistent (root, leaf, cb, false);
   Config::MatchContainer container = LookupMatches (root);
   container.DisconnectWithoutContext (leaf, cb);
 }
@@ -673,10 +1007,55 @@ ConfigImpl::Disconnect (std::string path, const CallbackBase &cb)
 
   std::string root, leaf;
   ParsePath (path, &root, &leaf);
+  RemovePersistent (root, leaf, cb, true);
   Config::MatchContainer container = LookupMatches (root);
   container.Disconnect (leaf, cb);
 }
 
+void
+ConfigImpl::ConnectPersistent (std::string path, const CallbackBase &cb, bool context)
+{
+  NS_LOG_FUNCTION (this << path << &cb << context);
+
+  std::string root, leaf;
+  ParsePath (path, &root, &leaf);
+  CriticalSection cs (m_persistentMutex);
+  if (m_persistent.empty ())
+    {
+      Simulator::ScheduleDestroy (&ConfigImpl::ClearPersistent);
+    }
+  m_persistent.push_back (PersistentResolver (root, leaf, cb, context));
+  g_hasPersistent = true;
+  PersistentResolver &resolver = m_persistent.back ();
+  for (Roots::const_iterator i = m_roots.begin (); i != m_roots.end (); i++)
+    {
+      resolver.Resolve (*i);
+    }
+  resolver.Resolve (0);
+}
+
+void
+ConfigImpl::NotifyNewObject (Ptr<Object> object, std::string path)
+{
+  NS_LOG_FUNCTION (this << object << path);
+
+  CriticalSection cs (m_persistentMutex);
+  for (PersistentConnections::iterator i = m_persistent.begin (); i != m_persistent.end (); i++)
+    {
+      i->ResolveFrom (object, path);
+    }
+}
+
+void
+ConfigImpl::ClearPersistent (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  ConfigImpl *config = Get ();
+  CriticalSection cs (config->m_persistentMutex);
+  config->m_persistent.clear ();
+  g_hasPersistent = false;
+}
+
 Config::MatchContainer 
 ConfigImpl::LookupMatches (std::string path)
 {
@@ -843,6 +1222,33 @@ Disconnect (std::string path, const CallbackBase &cb)
   NS_LOG_FUNCTION (path << &cb);
   ConfigImpl::Get ()->Disconnect (path, cb);
 }
+void
+ConnectPersistent (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (path << &cb);
+  ConfigImpl::Get ()->ConnectPersistent (path, cb, true);
+}
+void
+ConnectWithoutContextPersistent (std::string path, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (path << &cb);
+  ConfigImpl::Get ()->ConnectPersistent (path, cb, false);
+}
+void
+NotifyNewObject (Ptr<Object> object, std::string path)
+{
+  NS_LOG_FUNCTION (object << path);
+  if (!g_hasPersistent)
+    {
+      return;
+    }
+  ConfigImpl::Get ()->NotifyNewObject (object, path);
+}
+bool
+HasPersistentConnections (void)
+{
+  return g_hasPersistent;
+}
 Config::MatchContainer LookupMatches (std::string path)
 {
   NS_LOG_FUNCTION (path);
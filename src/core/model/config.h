@@ -139,6 +139,53 @@ void Connect (std::string path, const CallbackBase &cb);
  * This function undoes the work of Config::ConnectWithContext.
  */
 void Disconnect (std::string path, const CallbackBase &cb);
+/**
+ * \ingroup config
+ * \param [in] path A path to match trace sources.
+ * \param [in] cb The callback to connect to the matching trace sources.
+ *
+ * This function behaves like Config::Connect and in addition
+ * remembers the connection: the trace sources of the objects
+ * notified later with Config::NotifyNewObject which match the
+ * input path are connected too, so the connection can be made
+ * before the topology is built.  Config::Disconnect with the same
+ * path and callback forgets it, and so does Simulator::Destroy.
+ */
+void ConnectPersistent (std::string path, const CallbackBase &cb);
+/**
+ * \ingroup config
+ * \param [in] path A path to match trace sources.
+ * \param [in] cb The callback to connect to the matching trace sources.
+ *
+ * This function behaves like Config::ConnectWithoutContext and
+ * remembers the connection, like Config::ConnectPersistent.
+ * Config::DisconnectWithoutContext with the same path and callback
+ * forgets it, and so does Simulator::Destroy.
+ */
+void ConnectWithoutContextPersistent (std::string path, const CallbackBase &cb);
+/**
+ * \ingroup config
+ * \param [in] object An object which appeared in the object graph.
+ * \param [in] path The path of the object, without wildcards,
+ *             such as "/NodeList/3/DeviceList/1".
+ *
+ * Resolve the persistent connections from \p object, connecting
+ * the trace sources below it which were not connected yet.  The
+ * cost is linear in the matched objects below \p object, instead
+ * of resolving the whole paths again from the root namespaces.
+ * Node calls this when it is initialized, and for the devices and
+ * applications added after it was.
+ */
+void NotifyNewObject (Ptr<Object> object, std::string path);
+/**
+ * \ingroup config
+ * \returns \c true if there are persistent connections, which
+ * Config::NotifyNewObject would have to resolve.
+ *
+ * Lets the callers skip building the path of a new object in the
+ * common case, without any persistent connection.
+ */
+bool HasPersistentConnections (void);
 
 /**
  * \ingroup config
@@ -71,7 +71,7 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_eventsWithContext = 0;
   m_main = SystemThread::Self();
 }
 
@@ -147,6 +147,7 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
   next.impl->Invoke ();
+  // Usually the last reference: the event goes back to its free list
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -161,30 +162,36 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  // Fast path: nothing was scheduled from another thread
+  if (m_eventsWithContext.load (std::memory_order_relaxed) == 0)
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  // Take the whole stack, then reverse it to insert the events in the
+  // order they were scheduled
+  EventWithContext *stack = m_eventsWithContext.exchange (0, std::memory_order_acquire);
+  EventWithContext *fifo = 0;
+  while (stack != 0)
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
+      EventWithContext *next = stack->next;
+      stack->next = fifo;
+      fifo = stack;
+      stack = next;
+    }
+  while (fifo != 0)
+    {
+       EventWithContext *event = fifo;
+       fifo = fifo->next;
        Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
+       ev.impl = event->event;
+       ev.key.m_ts = m_currentTs + event->timestamp;
+       ev.key.m_context = event->context;
        ev.key.m_uid = m_uid;
        m_uid++;
        m_unscheduledEvents++;
        m_events->Insert (ev);
+       delete event;
     }
 }
 
@@ -264,16 +271,18 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
     }
   else
     {
-      EventWithContext ev;
-      ev.context = context;
+      EventWithContext *ev = new EventWithContext;
+      ev->context = context;
       // Current time added in ProcessEventsWithContext()
-      ev.timestamp = delay.GetTimeStep ();
-      ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      ev->timestamp = delay.GetTimeStep ();
+      ev->event = event;
+      ev->next = m_eventsWithContext.load (std::memory_order_relaxed);
+      // On failure, ev->next is updated to the current head
+      while (!m_eventsWithContext.compare_exchange_weak (ev->next, ev,
+                                                         std::memory_order_release,
+                                                         std::memory_order_relaxed))
+        {
+        }
     }
 }
 
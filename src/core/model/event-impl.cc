@@ -20,6 +20,8 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include "block-pool.h"
+#include <new>
 
 /**
  * \file
@@ -31,13 +33,61 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/** Granularity of the event size classes, in bytes. */
+const std::size_t EVENT_POOL_GRANULARITY = 16;
+/** Number of event size classes: events up to 128 bytes are pooled. */
+const std::size_t EVENT_POOL_CLASSES = 8;
+/** Largest number of free blocks kept per size class. */
+const uint32_t EVENT_POOL_MAX_FREE = 4096;
+
+/** Free lists of the current thread. */
+thread_local BlockPool<EVENT_POOL_CLASSES, EVENT_POOL_MAX_FREE> g_eventPool;
+
+} // unnamed namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass >= EVENT_POOL_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  void *block = g_eventPool.Pop (sizeClass);
+  if (block == 0)
+    {
+      // Allocate the whole class, so that the block fits any event of the class
+      return ::operator new ((sizeClass + 1) * EVENT_POOL_GRANULARITY);
+    }
+  return block;
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  // Blocks are not tied to the thread which allocated them
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass >= EVENT_POOL_CLASSES || !g_eventPool.Push (sizeClass, p))
+    {
+      ::operator delete (p);
+    }
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
 }
 
 EventImpl::EventImpl ()
-  : m_cancel (false)
+  : m_cancel (false),
+    m_invoked (false),
+    m_owner (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -46,7 +96,9 @@ void
 EventImpl::Invoke (void)
 {
   NS_LOG_FUNCTION (this);
-  if (!m_cancel)
+  // The event expires as soon as it starts, like with the clock
+  m_invoked.store (true, std::memory_order_relaxed);
+  if (!m_cancel.load (std::memory_order_relaxed))
     {
       Notify ();
     }
@@ -56,14 +108,32 @@ void
 EventImpl::Cancel (void)
 {
   NS_LOG_FUNCTION (this);
-  m_cancel = true;
+  m_cancel.store (true, std::memory_order_relaxed);
 }
 
 bool
 EventImpl::IsCancelled (void)
 {
   NS_LOG_FUNCTION (this);
-  return m_cancel;
+  return m_cancel.load (std::memory_order_relaxed);
+}
+
+bool
+EventImpl::IsInvoked (void) const
+{
+  return m_invoked.load (std::memory_order_relaxed);
+}
+
+void
+EventImpl::SetOwner (uint32_t owner)
+{
+  m_owner = owner;
+}
+
+uint32_t
+EventImpl::GetOwner (void) const
+{
+  return m_owner;
 }
 
 } // namespace ns3
@@ -21,6 +21,8 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
+#include <atomic>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +42,14 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are short-lived and allocated at a very high rate, so they
+ * do not come from the general heap: each thread keeps a free list
+ * of event blocks per size class (multiples of 16 bytes, up to 128).
+ * The event released by the simulation engine once it has been
+ * invoked is handed to the next event of the same size class which
+ * is created, so that a simulation in steady state does not allocate.
+ * Larger events use the global operator new.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -65,6 +75,41 @@ public:
    * Checked by the simulation engine before calling Invoke().
    */
   bool IsCancelled (void);
+  /**
+   * \returns true once the simulation engine called Invoke(),
+   * whether the event was cancelled or not.
+   *
+   * Unlike the clock of the simulator, this can be read from a thread
+   * other than the one which runs the event.
+   */
+  bool IsInvoked (void) const;
+  /**
+   * Record which event list holds the event, for the simulators
+   * which keep one event list per partition of the nodes.
+   *
+   * \param [in] owner The index of the event list.
+   */
+  void SetOwner (uint32_t owner);
+  /**
+   * \returns The index of the event list which holds the event,
+   * zero unless SetOwner() was called.
+   */
+  uint32_t GetOwner (void) const;
+
+  /**
+   * Allocate an event from the free list of its size class.
+   *
+   * \param [in] size The size of the concrete event type.
+   * \returns The memory block for the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Return an event to the free list of its size class.
+   *
+   * \param [in] p The memory block of the event.
+   * \param [in] size The size of the concrete event type.
+   */
+  static void operator delete (void *p, std::size_t size);
 
 protected:
   /**
@@ -76,7 +121,15 @@ protected:
   virtual void Notify (void) = 0;
 
 private:
-  bool m_cancel;  /**< Has this event been cancelled. */
+  /**
+   * Has this event been cancelled.
+   *
+   * Atomic, since another thread may cancel the event while the
+   * thread which holds it checks the flag.
+   */
+  std::atomic<bool> m_cancel;
+  std::atomic<bool> m_invoked;  /**< Has Invoke() been called. */
+  uint32_t m_owner;  /**< Event list which holds the event. */
 };
 
 } // namespace ns3
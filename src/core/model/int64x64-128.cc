@@ -60,15 +60,6 @@ output_sign (const int128_t sa,
   return (negA && !negB) || (!negA && negB);
 }
 
-void
-int64x64_t::Mul (const int64x64_t & o)
-{
-  uint128_t a, b;
-  bool negative = output_sign (_v, o._v, a, b);
-  uint128_t result = Umul (a, b);
-  _v = negative ? -result : result;
-}
-
 uint128_t
 int64x64_t::Umul (const uint128_t a, const uint128_t b)
 {
@@ -187,16 +178,6 @@ int64x64_t::Udiv (const uint128_t a, const uint128_t b)
   return result;
 }
 
-void 
-int64x64_t::MulByInvert (const int64x64_t & o)
-{
-  bool negResult = _v < 0;
-  uint128_t a = negResult ? -_v : _v;
-  uint128_t result = UmulByInvert (a, o._v);
-
-  _v = negResult ? -result : result;
-}
-
 uint128_t
 int64x64_t::UmulByInvert (const uint128_t a, const uint128_t b)
 {
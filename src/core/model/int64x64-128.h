@@ -23,7 +23,7 @@
 #define INT64X64_128_H
 
 #include <stdint.h>
-#include <cmath>  // pow
+#include <cmath>  // modf
 
 #if defined(HAVE___UINT128_T) && !defined(HAVE_UINT128_T)
 typedef __uint128_t uint128_t;
@@ -52,18 +52,12 @@ class int64x64_t
   static const uint64_t    HP_MASK_HI = ~HP_MASK_LO;
   /**
    * Floating point value of HP_MASK_LO + 1.
-   * We really want:
-   * \code
-   *   static const long double HP_MAX_64 = std:pow (2.0L, 64);
-   * \endcode
-   * but we can't call functions in const definitions.
    *
-   * We could make this a static and initialize in int64x64-128.cc or
-   * int64x64.cc, but this requires handling static initialization order
-   * when most of the implementation is inline.  Instead, we resort to
-   * this define.
+   * Written as a literal, 2^64, rather than with std::pow (2.0L, 64):
+   * the literal is a constant expression, while the std::pow call is
+   * only folded by an optimizing compiler.
    */
-#define HP_MAX_64    (std::pow (2.0L, 64))
+#define HP_MAX_64    (18446744073709551616.0L)
 
 public:
   /**
@@ -240,7 +234,7 @@ public:
    *
    * \see Invert()
    */
-  void MulByInvert (const int64x64_t & o);
+  inline void MulByInvert (const int64x64_t & o);
 
   /**
    * Compute the inverse of an integer value.
@@ -277,7 +271,7 @@ private:
    *
    * \param [in] o The other factor.
    */   
-  void Mul (const int64x64_t & o);
+  inline void Mul (const int64x64_t & o);
   /**
    * Implement `/=`.
    *
@@ -341,6 +335,59 @@ private:
 };  // class int64x64_t
 
 
+/*
+ * Time conversions and scaling multiply an integer, the Time value or
+ * the unit factor, by another value.  Without a fractional product,
+ * Umul() reduces to two 64-bit multiplications.
+ */
+void
+int64x64_t::Mul (const int64x64_t & o)
+{
+  const bool negA = _v < 0;
+  const bool negB = o._v < 0;
+  const uint128_t a = negA ? -_v : _v;
+  const uint128_t b = negB ? -o._v : o._v;
+  const uint128_t aH = a >> 64;
+  const uint128_t bH = b >> 64;
+  const uint128_t aL = a & HP_MASK_LO;
+  const uint128_t bL = b & HP_MASK_LO;
+  const uint128_t hiPart = aH * bH;
+  uint128_t result;
+  if ((aL == 0 || bL == 0) && (hiPart >> 64) == 0)
+    {
+      result = (hiPart << 64) + aH * bL + aL * bH;
+    }
+  else
+    {
+      result = Umul (a, b);
+    }
+  _v = negA != negB ? -result : result;
+}
+
+/*
+ * Converting a Time to a coarser unit multiplies an integer by the
+ * Q0.128 inverse of the unit factor, which UmulByInvert() reduces to
+ * a single 64-bit multiplication.
+ */
+void
+int64x64_t::MulByInvert (const int64x64_t & o)
+{
+  const bool negResult = _v < 0;
+  const uint128_t a = negResult ? -_v : _v;
+  const uint128_t b = o._v;
+  uint128_t result;
+  if ((a & HP_MASK_LO) == 0 && (b >> 64) == 0)
+    {
+      result = ((a >> 64) * b) >> 64;
+    }
+  else
+    {
+      result = UmulByInvert (a, b);
+    }
+  _v = negResult ? -result : result;
+}
+
+
 /**
  * \ingroup highprec
  * Equality operator.
@@ -22,7 +22,7 @@
 #define INT64X64_DOUBLE_H
 
 #include <stdint.h>
-#include <cmath>  // pow
+#include <cmath>  // modf
 #include <utility>  // pair
 
 /**
@@ -44,17 +44,12 @@ class int64x64_t
   static const uint64_t    HP_MASK_LO = 0xffffffffffffffffULL;
   /**
    * Floating point value of HP_MASK_LO + 1
-   * We really want:
-   * \code
-   *   static const long double HP_MAX_64 = std:pow (2.0L, 64);
-   * \endcode
-   * but we can't call functions in const definitions,
-   * We could make this a static and initialize in int64x64-double.cc or
-   * int64x64.cc, but this requires handling static initialization order
-   * when most of the implementation is inline.  Instead, we resort to
-   * this define.
+   *
+   * Written as a literal, 2^64, rather than with std::pow (2.0L, 64):
+   * the literal is a constant expression, while the std::pow call is
+   * only folded by an optimizing compiler.
    */
-#define HP_MAX_64    (std::pow (2.0L, 64))
+#define HP_MAX_64    (18446744073709551616.0L)
 
 public:
   /**
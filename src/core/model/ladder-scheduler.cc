@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include <algorithm>
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_nRungs (0),
+    m_bottomHead (0),
+    m_qSize (0)
+{
+  NS_LOG_FUNCTION (this);
+  // Never resized afterwards, so that references to the rungs stay valid
+  m_rungs.resize (MAX_RUNGS);
+}
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.m_start + rung.m_current * rung.m_width;
+}
+
+LadderScheduler::Rung &
+LadderScheduler::SpawnRung (uint64_t start, uint64_t end, uint32_t count)
+{
+  NS_LOG_FUNCTION (this << start << end << count);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  NS_ASSERT (end > start);
+
+  // About one event per bucket
+  uint64_t range = end - start;
+  uint64_t width = std::max<uint64_t> (1, (range + count - 1) / std::max<uint32_t> (count, 1));
+  uint32_t nBuckets = (range + width - 1) / width;
+
+  Rung &rung = m_rungs[m_nRungs++];
+  if (rung.m_buckets.size () < nBuckets)
+    {
+      rung.m_buckets.resize (nBuckets);
+    }
+  rung.m_nBuckets = nBuckets;
+  rung.m_start = start;
+  rung.m_width = width;
+  rung.m_current = 0;
+  rung.m_count = 0;
+  NS_LOG_LOGIC ("rung " << m_nRungs - 1 << ": " << nBuckets << " buckets of " << width);
+  return rung;
+}
+
+void
+LadderScheduler::InsertInRung (Rung &rung, const Event &ev)
+{
+  uint32_t bucket = (ev.key.m_ts - rung.m_start) / rung.m_width;
+  NS_ASSERT (bucket >= rung.m_current && bucket < rung.m_nBuckets);
+  rung.m_buckets[bucket].push_back (ev);
+  rung.m_count++;
+}
+
+void
+LadderScheduler::InsertInBottom (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  m_bottom.insert (std::upper_bound (m_bottom.begin () + m_bottomHead, m_bottom.end (), ev), ev);
+
+  uint32_t count = m_bottom.size () - m_bottomHead;
+  if (count <= THRESHOLD || m_nRungs == MAX_RUNGS
+      || m_bottom.back ().key.m_ts == m_bottom[m_bottomHead].key.m_ts)
+    {
+      return;
+    }
+
+  // The bottom grew too large to keep sorted: spread it over a new rung,
+  // up to where the events of the last rung (or the top) start
+  uint64_t start = m_bottom[m_bottomHead].key.m_ts;
+  uint64_t end = m_nRungs > 0 ? CurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+  Rung &rung = SpawnRung (start, end, count);
+  for (uint32_t i = m_bottomHead; i < m_bottom.size (); i++)
+    {
+      InsertInRung (rung, m_bottom[i]);
+    }
+  m_bottom.clear ();
+  m_bottomHead = 0;
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size ());
+  NS_ASSERT (m_nRungs == 0);
+
+  Rung &rung = SpawnRung (m_topMin, m_topMax + 1, m_top.size ());
+  m_topStart = rung.m_start + rung.m_nBuckets * rung.m_width;
+  for (std::vector<Event>::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+    {
+      InsertInRung (rung, *i);
+    }
+  m_top.clear ();
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  if (m_bottomHead < m_bottom.size ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_bottom.clear ();
+  m_bottomHead = 0;
+
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          if (m_top.empty ())
+            {
+              return;
+            }
+          TransferTop ();
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.m_count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+
+      while (rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      uint64_t bucketStart = CurrentStart (rung);
+      rung.m_current++;
+      rung.m_count -= bucket.size ();
+
+      if (bucket.size () > THRESHOLD && m_nRungs < MAX_RUNGS && rung.m_width > 1)
+        {
+          // Too many events to sort: spread them over a finer rung
+          Rung &child = SpawnRung (bucketStart, bucketStart + rung.m_width, bucket.size ());
+          for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+            {
+              InsertInRung (child, *i);
+            }
+          bucket.clear ();
+          continue;
+        }
+
+      // The bucket becomes the bottom, and keeps the capacity of the old bottom
+      m_bottom.swap (bucket);
+      std::sort (m_bottom.begin (), m_bottom.end ());
+      return;
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  m_qSize++;
+
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ts);
+          m_topMax = std::max (m_topMax, ts);
+        }
+      m_top.push_back (ev);
+      return;
+    }
+
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      if (ts >= CurrentStart (m_rungs[i]))
+        {
+          InsertInRung (m_rungs[i], ev);
+          return;
+        }
+    }
+
+  InsertInBottom (ev);
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_qSize == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  // Refilling the bottom does not change the order of the events
+  const_cast<LadderScheduler *> (this)->FillBottom ();
+  return m_bottom[m_bottomHead];
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  FillBottom ();
+  Scheduler::Event ev = m_bottom[m_bottomHead++];
+  m_qSize--;
+  NS_LOG_LOGIC ("remove ts=" << ev.key.m_ts << ", key=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  std::vector<Event> *events = &m_top;
+
+  if (ts < m_topStart)
+    {
+      uint32_t i = 0;
+      while (i < m_nRungs && ts < CurrentStart (m_rungs[i]))
+        {
+          i++;
+        }
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          events = &rung.m_buckets[(ts - rung.m_start) / rung.m_width];
+          rung.m_count--;
+        }
+      else
+        {
+          std::vector<Event>::iterator it = std::lower_bound (m_bottom.begin () + m_bottomHead,
+                                                              m_bottom.end (), ev);
+          NS_ASSERT (it != m_bottom.end () && it->key.m_uid == ev.key.m_uid);
+          m_bottom.erase (it);
+          m_qSize--;
+          return;
+        }
+    }
+
+  // Unsorted: move the last event in the hole
+  for (std::vector<Event>::iterator it = events->begin (); it != events->end (); ++it)
+    {
+      if (it->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == it->impl);
+          *it = events->back ();
+          events->pop_back ();
+          m_qSize--;
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh
+ * and Ian Li-Jin Thng (ACM TOMACS, 2005).
+ *
+ * The events live in three tiers:
+ *  - Top: an unsorted array of the events far in the future. Inserting
+ *    there only appends and updates the min/max timestamps.
+ *  - Ladder: up to MAX_RUNGS rungs of buckets. The whole Top is spread
+ *    over the first rung when the nearer events run out. A bucket of a
+ *    rung which holds more than THRESHOLD events is spread over a new,
+ *    finer rung instead of being sorted.
+ *  - Bottom: a small sorted array of the nearest events, filled from
+ *    the first non-empty bucket of the last rung. Events are removed
+ *    from its front.
+ *
+ * Insertions and removals are O(1) amortized for the usual event time
+ * distributions, including the bursty ones produced by timers and
+ * per-packet link events. The buckets and the bottom are std::vector,
+ * and keep their capacity across refills, so that a simulation in
+ * steady state does not allocate.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Bucket type: a vector of unsorted Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder: contiguous buckets of equal width. */
+  struct Rung
+  {
+    std::vector<Bucket> m_buckets; //!< Buckets, only the first m_nBuckets are in use
+    uint32_t m_nBuckets;           //!< Number of buckets in use
+    uint64_t m_start;              //!< Timestamp at the start of the first bucket
+    uint64_t m_width;              //!< Bucket width, in dimensionless time units
+    uint32_t m_current;            //!< First bucket which may hold events
+    uint32_t m_count;              //!< Number of events in the rung
+  };
+
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+  /** Bucket size above which a new rung is spawned rather than sorting the bucket. */
+  static const uint32_t THRESHOLD = 50;
+
+  /**
+   * Timestamp at the start of the current bucket of a rung.
+   *
+   * \param [in] rung The rung.
+   * \returns The timestamp, events before it belong to a lower rung or the bottom.
+   */
+  inline uint64_t CurrentStart (const Rung &rung) const;
+  /**
+   * Prepare the next free rung to hold events in [start, end).
+   *
+   * \param [in] start The first timestamp of the rung.
+   * \param [in] end The timestamp after the rung.
+   * \param [in] count The number of events about to be inserted.
+   * \returns The new rung.
+   */
+  Rung & SpawnRung (uint64_t start, uint64_t end, uint32_t count);
+  /**
+   * Insert an event in the bucket of a rung.
+   *
+   * \param [in] rung The rung.
+   * \param [in] ev The Event.
+   */
+  void InsertInRung (Rung &rung, const Scheduler::Event &ev);
+  /** Insert an event in the sorted bottom. \param [in] ev The Event. */
+  void InsertInBottom (const Scheduler::Event &ev);
+  /** Move the nearest events into the bottom, if it is empty. */
+  void FillBottom (void);
+  /** Spread the top over a new first rung. */
+  void TransferTop (void);
+
+  /** Events with timestamps at or after m_topStart, unsorted. */
+  std::vector<Scheduler::Event> m_top;
+  /** Smallest timestamp in the top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in the top. */
+  uint64_t m_topMax;
+  /** Timestamp from which events go to the top. */
+  uint64_t m_topStart;
+  /** The rungs, only the first m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** The nearest events, sorted, the next one at m_bottomHead. */
+  std::vector<Scheduler::Event> m_bottom;
+  /** Index of the next event in the bottom. */
+  uint32_t m_bottomHead;
+  /** Number of events in queue. */
+  uint32_t m_qSize;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
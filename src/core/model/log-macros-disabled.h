@@ -55,6 +55,9 @@
 #define NS_LOG_UNCOND(msg) \
         NS_LOG_NOOP_INTERNAL (msg)
 
+#define NS_LOG_IS_ENABLED(level) \
+        false
+
 
 #endif /* !NS3_LOG_ENABLE */
 
@@ -112,6 +112,25 @@
 #endif /* NS_LOG_APPEND_CONTEXT */
 
 
+/**
+ * \ingroup logging
+ * Check whether the messages of a log level are compiled in and enabled
+ * for the log component of this file.
+ *
+ * Use it to skip the work which is only done for logging, such as
+ * dumping a data structure:
+ * \code
+ *   if (NS_LOG_IS_ENABLED (ns3::LOG_DEBUG))
+ *     {
+ *       DumpBuffers ();
+ *     }
+ * \endcode
+ *
+ * \param [in] level The log level.
+ */
+#define NS_LOG_IS_ENABLED(level)                                \
+  ((g_logCompiledLevels & (level)) && g_log.IsEnabled (level))
+
 #ifndef NS_LOG_CONDITION
 /**
  * \ingroup logging
@@ -153,14 +172,23 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (level))                              \
+      if (NS_LOG_IS_ENABLED (level))                            \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
-          NS_LOG_APPEND_CONTEXT;                                \
-          NS_LOG_APPEND_FUNC_PREFIX;                            \
-          NS_LOG_APPEND_LEVEL_PREFIX (level);                   \
-          std::clog << msg << std::endl;                        \
+          if (ns3::LogRingIsEnabled ())                         \
+            {                                                   \
+              ns3::LogRecord (g_log, level, __FUNCTION__,       \
+                              ns3::LogRecord::MESSAGE)          \
+                << msg;                                         \
+            }                                                   \
+          else                                                  \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+              NS_LOG_APPEND_CONTEXT;                            \
+              NS_LOG_APPEND_FUNC_PREFIX;                        \
+              NS_LOG_APPEND_LEVEL_PREFIX (level);               \
+              std::clog << msg << std::endl;                    \
+            }                                                   \
         }                                                       \
     }                                                           \
   while (false)
@@ -177,13 +205,23 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_ENABLED (ns3::LOG_FUNCTION))                \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
-          NS_LOG_APPEND_CONTEXT;                                \
-          std::clog << g_log.Name () << ":"                     \
-                    << __FUNCTION__ << "()" << std::endl;       \
+          if (ns3::LogRingIsEnabled ())                         \
+            {                                                   \
+              ns3::LogRecord (g_log, ns3::LOG_FUNCTION,         \
+                              __FUNCTION__,                     \
+                              ns3::LogRecord::FUNCTION);        \
+            }                                                   \
+          else                                                  \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+              NS_LOG_APPEND_CONTEXT;                            \
+              std::clog << g_log.Name () << ":"                 \
+                        << __FUNCTION__ << "()"                 \
+                        << std::endl;                           \
+            }                                                   \
         }                                                       \
     }                                                           \
   while (false)
@@ -214,15 +252,25 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_ENABLED (ns3::LOG_FUNCTION))                \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
-          NS_LOG_APPEND_CONTEXT;                                \
-          std::clog << g_log.Name () << ":"                     \
-                    << __FUNCTION__ << "(";                     \
-          ns3::ParameterLogger (std::clog) << parameters;       \
-          std::clog << ")" << std::endl;                        \
+          if (ns3::LogRingIsEnabled ())                         \
+            {                                                   \
+              ns3::LogRecord (g_log, ns3::LOG_FUNCTION,         \
+                              __FUNCTION__,                     \
+                              ns3::LogRecord::FUNCTION)         \
+                << parameters;                                  \
+            }                                                   \
+          else                                                  \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+              NS_LOG_APPEND_CONTEXT;                            \
+              std::clog << g_log.Name () << ":"                 \
+                        << __FUNCTION__ << "(";                 \
+              ns3::ParameterLogger (std::clog) << parameters;   \
+              std::clog << ")" << std::endl;                    \
+            }                                                   \
         }                                                       \
     }                                                           \
   while (false)
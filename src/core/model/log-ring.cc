@@ -0,0 +1,713 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "log.h"
+#include "log-ring.h"
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include "ns3/core-config.h"
+
+#ifdef HAVE_STDLIB_H
+#include <cstdlib>
+#endif
+
+/**
+ * \file
+ * \ingroup logging
+ * Deferred binary logging implementation.
+ */
+
+namespace ns3 {
+
+bool g_logRingEnabled = false;
+
+namespace {
+
+/** Types of the arguments recorded in a LogRecord. */
+enum ArgumentType
+{
+  ARG_BOOL,
+  ARG_CHAR,
+  ARG_INT,
+  ARG_UINT,
+  ARG_DOUBLE,
+  ARG_STRING,
+  ARG_POINTER,
+  ARG_OSTREAM_MANIP,
+  ARG_IOS_MANIP,
+  ARG_SEPARATOR,
+  ARG_SETPRECISION,
+  ARG_SETW,
+  ARG_SETFILL,
+  ARG_SETBASE
+};
+
+/** Fixed part of a LogRecord, at the start of its buffer. */
+struct RecordHeader
+{
+  uint32_t size;          //!< Size of the record, header included
+  uint32_t component;     //!< Index of the component name
+  int32_t flags;          //!< Level and prefixes of the message
+  uint32_t node;          //!< Node id, if LOG_PREFIX_NODE
+  double time;            //!< Simulation time, if LOG_PREFIX_TIME
+  const char *function;   //!< Name of the logging function
+  uint8_t kind;           //!< LogRecord::Kind
+  bool truncated;         //!< Some arguments did not fit
+};
+
+/**
+ * The names of the log components, by index.
+ *
+ * Never destroyed, so that the ring can be flushed when the program
+ * exits, after the components are gone.
+ */
+std::vector<std::string> *
+ComponentNames (void)
+{
+  static std::vector<std::string> *names = new std::vector<std::string> ();
+  return names;
+}
+
+/**
+ * The messages recorded while the log ring is enabled.
+ *
+ * The threads of the multithreaded simulator log concurrently, so the
+ * ring is protected by a spin lock: a record is only copied while it is
+ * held.
+ */
+class Ring
+{
+public:
+  Ring ()
+    : m_head (0),
+      m_used (0)
+  {
+    m_lock.clear ();
+  }
+  /**
+   * Change the size of the ring, and empty it.
+   * \param [in] size The size, in bytes.
+   */
+  void Resize (uint32_t size)
+  {
+    Lock lock (m_lock);
+    m_data.assign (size, 0);
+    m_head = 0;
+    m_used = 0;
+  }
+  /**
+   * Push a record, dropping the oldest ones to make room for it.
+   * \param [in] record The record, starting with its RecordHeader.
+   */
+  void Push (const uint8_t *record)
+  {
+    uint32_t size;
+    std::memcpy (&size, record, sizeof (size));
+    Lock lock (m_lock);
+    if (size > m_data.size ())
+      {
+        return;
+      }
+    while (m_data.size () - m_used < size)
+      {
+        uint32_t oldest;
+        CopyOut (m_head, reinterpret_cast<uint8_t *> (&oldest), sizeof (oldest));
+        m_head = (m_head + oldest) % m_data.size ();
+        m_used -= oldest;
+      }
+    CopyIn ((m_head + m_used) % m_data.size (), record, size);
+    m_used += size;
+  }
+  /**
+   * Pop the oldest record.
+   * \param [out] record A buffer of LogRecord size.
+   * \returns \c false if the ring is empty.
+   */
+  bool Pop (uint8_t *record)
+  {
+    Lock lock (m_lock);
+    if (m_used == 0)
+      {
+        return false;
+      }
+    uint32_t size;
+    CopyOut (m_head, reinterpret_cast<uint8_t *> (&size), sizeof (size));
+    CopyOut (m_head, record, size);
+    m_head = (m_head + size) % m_data.size ();
+    m_used -= size;
+    return true;
+  }
+
+private:
+  /** Holds the spin lock of the ring while in scope. */
+  class Lock
+  {
+  public:
+    /**
+     * Acquire the lock.
+     * \param [in] flag The lock.
+     */
+    Lock (std::atomic_flag &flag)
+      : m_flag (flag)
+    {
+      while (m_flag.test_and_set (std::memory_order_acquire))
+        {
+        }
+    }
+    /** Release the lock. */
+    ~Lock ()
+    {
+      m_flag.clear (std::memory_order_release);
+    }
+
+  private:
+    std::atomic_flag &m_flag;  //!< The lock
+  };
+
+  /**
+   * Copy into the ring, wrapping around its end.
+   * \param [in] offset The start in the ring.
+   * \param [in] data The bytes to copy.
+   * \param [in] size The number of bytes.
+   */
+  void CopyIn (uint32_t offset, const uint8_t *data, uint32_t size)
+  {
+    uint32_t first = std::min<uint32_t> (size, m_data.size () - offset);
+    std::memcpy (&m_data[offset], data, first);
+    std::memcpy (&m_data[0], data + first, size - first);
+  }
+  /**
+   * Copy out of the ring, wrapping around its end.
+   * \param [in] offset The start in the ring.
+   * \param [out] data The destination.
+   * \param [in] size The number of bytes.
+   */
+  void CopyOut (uint32_t offset, uint8_t *data, uint32_t size) const
+  {
+    uint32_t first = std::min<uint32_t> (size, m_data.size () - offset);
+    std::memcpy (data, &m_data[offset], first);
+    std::memcpy (data + first, &m_data[0], size - first);
+  }
+
+  std::vector<uint8_t> m_data;  //!< The ring
+  uint32_t m_head;              //!< Offset of the oldest record
+  uint32_t m_used;              //!< Bytes used by the records
+  std::atomic_flag m_lock;      //!< Protects the ring
+};
+
+/**
+ * \returns The log ring, never destroyed so that it can be flushed
+ * when the program exits.
+ */
+Ring &
+GetRing (void)
+{
+  static Ring *ring = new Ring ();
+  return *ring;
+}
+
+LogRingTimeReader g_logRingTimeReader = 0;  //!< Reads the simulation time
+LogRingNodeReader g_logRingNodeReader = 0;  //!< Reads the node id
+
+/**
+ * Read an argument out of a record.
+ * \param [in,out] data The position in the record, moved past the argument.
+ * \param [out] value The argument.
+ */
+template <typename T>
+void
+Read (const uint8_t *&data, T &value)
+{
+  std::memcpy (&value, data, sizeof (value));
+  data += sizeof (value);
+}
+
+/**
+ * Format one record.
+ * \param [in,out] os The output stream to print on.
+ * \param [in] record The record.
+ */
+void
+Format (std::ostream &os, const uint8_t *record)
+{
+  RecordHeader header;
+  std::memcpy (&header, record, sizeof (header));
+  const std::string &component = (*ComponentNames ())[header.component];
+
+  if (header.flags & LOG_PREFIX_TIME)
+    {
+      os << header.time << "s ";
+    }
+  if (header.flags & LOG_PREFIX_NODE)
+    {
+      if (header.node == 0xffffffff)
+        {
+          os << "-1 ";
+        }
+      else
+        {
+          os << header.node << " ";
+        }
+    }
+  if (header.kind == LogRecord::FUNCTION)
+    {
+      os << component << ":" << header.function << "(";
+    }
+  else
+    {
+      if (header.flags & LOG_PREFIX_FUNC)
+        {
+          os << component << ":" << header.function << "(): ";
+        }
+      if (header.flags & LOG_PREFIX_LEVEL)
+        {
+          os << "[" << LogComponent::GetLevelLabel ((enum LogLevel)(header.flags & LOG_ALL)) << "] ";
+        }
+    }
+
+  // As on std::clog, the manipulators remain in effect for the next messages
+  const uint8_t *data = record + sizeof (header);
+  const uint8_t *end = record + header.size;
+  while (data < end)
+    {
+      uint8_t type = *data++;
+      switch (type)
+        {
+        case ARG_BOOL:
+          {
+            bool v;
+            Read (data, v);
+            os << v;
+            break;
+          }
+        case ARG_CHAR:
+          {
+            char v;
+            Read (data, v);
+            os << v;
+            break;
+          }
+        case ARG_INT:
+          {
+            int64_t v;
+            Read (data, v);
+            os << v;
+            break;
+          }
+        case ARG_UINT:
+          {
+            uint64_t v;
+            Read (data, v);
+            os << v;
+            break;
+          }
+        case ARG_DOUBLE:
+          {
+            double v;
+            Read (data, v);
+            os << v;
+            break;
+          }
+        case ARG_STRING:
+          {
+            uint32_t size;
+            Read (data, size);
+            os.write (reinterpret_cast<const char *> (data), size);
+            data += size;
+            break;
+          }
+        case ARG_POINTER:
+          {
+            const void *v;
+            Read (data, v);
+            os << v;
+            break;
+          }
+        case ARG_OSTREAM_MANIP:
+          {
+            std::ostream & (*manip)(std::ostream &);
+            Read (data, manip);
+            os << manip;
+            break;
+          }
+        case ARG_IOS_MANIP:
+          {
+            std::ios_base & (*manip)(std::ios_base &);
+            Read (data, manip);
+            os << manip;
+            break;
+          }
+        case ARG_SEPARATOR:
+          os << ", ";
+          break;
+        case ARG_SETPRECISION:
+          {
+            int64_t v;
+            Read (data, v);
+            os << std::setprecision (v);
+            break;
+          }
+        case ARG_SETW:
+          {
+            int64_t v;
+            Read (data, v);
+            os << std::setw (v);
+            break;
+          }
+        case ARG_SETFILL:
+          {
+            char v;
+            Read (data, v);
+            os << std::setfill (v);
+            break;
+          }
+        case ARG_SETBASE:
+          {
+            int v;
+            Read (data, v);
+            os << std::setbase (v);
+            break;
+          }
+        default:
+          data = end;
+          break;
+        }
+    }
+
+  if (header.truncated)
+    {
+      os << "...";
+    }
+  if (header.kind == LogRecord::FUNCTION)
+    {
+      os << ")";
+    }
+  os << std::endl;
+}
+
+/**
+ * Handler for the NS_LOG_RING environment variable: enables the log
+ * ring at startup, and flushes it on \c std::clog at exit.
+ */
+class LogRingEnvVar
+{
+public:
+  LogRingEnvVar ()
+  {
+#ifdef HAVE_GETENV
+    char *envVar = getenv ("NS_LOG_RING");
+    if (envVar != 0)
+      {
+        LogRingEnable (std::atoi (envVar));
+      }
+#endif
+  }
+  ~LogRingEnvVar ()
+  {
+    LogRingFlush (std::clog);
+  }
+} g_logRingEnvVar; //!< Invoke the NS_LOG_RING handler.
+
+} // unnamed namespace
+
+
+uint32_t
+LogRingRegister (const std::string &name)
+{
+  std::vector<std::string> *names = ComponentNames ();
+  names->push_back (name);
+  return names->size () - 1;
+}
+
+void
+LogRingEnable (uint32_t size)
+{
+  GetRing ().Resize (size);
+  g_logRingEnabled = size > 0;
+}
+
+void
+LogRingDisable (void)
+{
+  GetRing ().Resize (0);
+  g_logRingEnabled = false;
+}
+
+void
+LogRingFlush (std::ostream &os)
+{
+  uint8_t record[512];
+  while (GetRing ().Pop (record))
+    {
+      Format (os, record);
+    }
+}
+
+void
+LogRingSetReaders (LogRingTimeReader time, LogRingNodeReader node)
+{
+  g_logRingTimeReader = time;
+  g_logRingNodeReader = node;
+}
+
+
+LogRecord::LogRecord (const LogComponent &component, int32_t level,
+                      const char *function, enum Kind kind)
+  : m_size (sizeof (RecordHeader)),
+    m_parameters (kind == FUNCTION),
+    m_first (true)
+{
+  RecordHeader header;
+  header.size = 0;
+  header.component = component.GetRingId ();
+  header.flags = level;
+  header.node = 0;
+  header.time = 0;
+  if (component.IsEnabled (LOG_PREFIX_TIME) && g_logRingTimeReader != 0)
+    {
+      header.flags |= LOG_PREFIX_TIME;
+      header.time = (*g_logRingTimeReader)();
+    }
+  if (component.IsEnabled (LOG_PREFIX_NODE) && g_logRingNodeReader != 0)
+    {
+      header.flags |= LOG_PREFIX_NODE;
+      header.node = (*g_logRingNodeReader)();
+    }
+  if (component.IsEnabled (LOG_PREFIX_FUNC))
+    {
+      header.flags |= LOG_PREFIX_FUNC;
+    }
+  if (component.IsEnabled (LOG_PREFIX_LEVEL))
+    {
+      header.flags |= LOG_PREFIX_LEVEL;
+    }
+  header.function = function;
+  header.kind = kind;
+  header.truncated = false;
+  std::memcpy (m_buffer, &header, sizeof (header));
+}
+
+LogRecord::~LogRecord ()
+{
+  std::memcpy (m_buffer, &m_size, sizeof (m_size));
+  GetRing ().Push (m_buffer);
+}
+
+void
+LogRecord::Append (uint8_t type, const void *data, uint32_t size)
+{
+  uint32_t separator = (m_parameters && !m_first) ? 1 : 0;
+  if (m_size + separator + 1 + size > BUFFER_SIZE)
+    {
+      m_buffer[offsetof (RecordHeader, truncated)] = true;
+      return;
+    }
+  if (separator)
+    {
+      m_buffer[m_size++] = ARG_SEPARATOR;
+    }
+  m_first = false;
+  m_buffer[m_size++] = type;
+  std::memcpy (m_buffer + m_size, data, size);
+  m_size += size;
+}
+
+void
+LogRecord::AppendString (const char *data, uint32_t size)
+{
+  uint32_t separator = (m_parameters && !m_first) ? 1 : 0;
+  uint32_t overhead = separator + 1 + sizeof (size);
+  if (m_size + overhead > BUFFER_SIZE)
+    {
+      m_buffer[offsetof (RecordHeader, truncated)] = true;
+      return;
+    }
+  if (m_size + overhead + size > BUFFER_SIZE)
+    {
+      size = BUFFER_SIZE - m_size - overhead;
+      m_buffer[offsetof (RecordHeader, truncated)] = true;
+    }
+  if (separator)
+    {
+      m_buffer[m_size++] = ARG_SEPARATOR;
+    }
+  m_first = false;
+  m_buffer[m_size++] = ARG_STRING;
+  std::memcpy (m_buffer + m_size, &size, sizeof (size));
+  m_size += sizeof (size);
+  std::memcpy (m_buffer + m_size, data, size);
+  m_size += size;
+}
+
+LogRecord &
+LogRecord::operator<< (bool v)
+{
+  Append (ARG_BOOL, &v, sizeof (v));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (char v)
+{
+  Append (ARG_CHAR, &v, sizeof (v));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (signed char v)
+{
+  return *this << static_cast<char> (v);
+}
+LogRecord &
+LogRecord::operator<< (unsigned char v)
+{
+  return *this << static_cast<char> (v);
+}
+LogRecord &
+LogRecord::operator<< (short v)
+{
+  return *this << static_cast<long long> (v);
+}
+LogRecord &
+LogRecord::operator<< (unsigned short v)
+{
+  return *this << static_cast<unsigned long long> (v);
+}
+LogRecord &
+LogRecord::operator<< (int v)
+{
+  return *this << static_cast<long long> (v);
+}
+LogRecord &
+LogRecord::operator<< (unsigned int v)
+{
+  return *this << static_cast<unsigned long long> (v);
+}
+LogRecord &
+LogRecord::operator<< (long v)
+{
+  return *this << static_cast<long long> (v);
+}
+LogRecord &
+LogRecord::operator<< (unsigned long v)
+{
+  return *this << static_cast<unsigned long long> (v);
+}
+LogRecord &
+LogRecord::operator<< (long long v)
+{
+  int64_t value = v;
+  Append (ARG_INT, &value, sizeof (value));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (unsigned long long v)
+{
+  uint64_t value = v;
+  Append (ARG_UINT, &value, sizeof (value));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (float v)
+{
+  return *this << static_cast<double> (v);
+}
+LogRecord &
+LogRecord::operator<< (double v)
+{
+  Append (ARG_DOUBLE, &v, sizeof (v));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (const char *v)
+{
+  AppendString (v, std::strlen (v));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (char *v)
+{
+  return *this << static_cast<const char *> (v);
+}
+LogRecord &
+LogRecord::operator<< (const std::string &v)
+{
+  AppendString (v.data (), v.size ());
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (const void *v)
+{
+  Append (ARG_POINTER, &v, sizeof (v));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (std::ostream & (*manip)(std::ostream &))
+{
+  Append (ARG_OSTREAM_MANIP, &manip, sizeof (manip));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (std::ios_base & (*manip)(std::ios_base &))
+{
+  Append (ARG_IOS_MANIP, &manip, sizeof (manip));
+  return *this;
+}
+// The manipulators of <iomanip> keep their argument private: apply them
+// to a scratch stream to read it back.
+LogRecord &
+LogRecord::operator<< (decltype (std::setprecision (0)) manip)
+{
+  std::ostringstream oss;
+  oss << manip;
+  int64_t precision = oss.precision ();
+  Append (ARG_SETPRECISION, &precision, sizeof (precision));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (decltype (std::setw (0)) manip)
+{
+  std::ostringstream oss;
+  oss << manip;
+  int64_t width = oss.width ();
+  Append (ARG_SETW, &width, sizeof (width));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (decltype (std::setfill ('0')) manip)
+{
+  std::ostringstream oss;
+  oss << manip;
+  char fill = oss.fill ();
+  Append (ARG_SETFILL, &fill, sizeof (fill));
+  return *this;
+}
+LogRecord &
+LogRecord::operator<< (decltype (std::setbase (0)) manip)
+{
+  std::ostringstream oss;
+  oss << manip;
+  std::ios_base::fmtflags basefield = oss.flags () & std::ios_base::basefield;
+  int base = basefield == std::ios_base::hex ? 16
+    : basefield == std::ios_base::oct ? 8
+    : basefield == std::ios_base::dec ? 10 : 0;
+  Append (ARG_SETBASE, &base, sizeof (base));
+  return *this;
+}
+
+} // namespace ns3
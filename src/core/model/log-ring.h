@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_LOG_RING_H
+#define NS3_LOG_RING_H
+
+#include "log.h"
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+
+/**
+ * \file
+ * \ingroup logging
+ * Deferred binary logging: ns3::LogRecord, recording the NS_LOG
+ * messages in the log ring.
+ *
+ * The functions which control the log ring are declared in log.h.
+ */
+
+namespace ns3 {
+
+class LogComponent;
+template <typename T> class Ptr;
+template <typename T> T * PeekPointer (const Ptr<T> &p);
+
+/**
+ * \ingroup logging
+ * \internal
+ * Register the name of a log component, called by its constructor.
+ * \param [in] name The name of the component.
+ * \returns The index of the name, recorded in the messages of the component.
+ */
+uint32_t LogRingRegister (const std::string &name);
+
+/**
+ * \ingroup logging
+ * \internal
+ * Whether the log ring is enabled. Use LogRingIsEnabled() instead.
+ */
+extern bool g_logRingEnabled;
+
+/**
+ * \ingroup logging
+ * \returns \c true if the NS_LOG messages go to the log ring.
+ */
+inline bool
+LogRingIsEnabled (void)
+{
+  return g_logRingEnabled;
+}
+
+/**
+ * \ingroup logging
+ *
+ * One message being recorded in the log ring.
+ *
+ * The NS_LOG macros stream the arguments of a message into a
+ * temporary LogRecord, which copies them in a fixed-size buffer on the
+ * stack, and pushes the buffer into the ring when it is destroyed.
+ * Numbers, characters, strings and pointers are copied in binary form;
+ * other types are formatted on the spot, with their \c operator<<.
+ * Arguments which do not fit in the buffer are dropped.
+ */
+class LogRecord
+{
+public:
+  /** How the message is formatted. */
+  enum Kind
+  {
+    MESSAGE,   //!< NS_LOG: prefixes, then the arguments
+    FUNCTION   //!< NS_LOG_FUNCTION: \c Component:Function(arg, arg)
+  };
+  /**
+   * Start a message.
+   *
+   * \param [in] component The log component.
+   * \param [in] level The log level of the message.
+   * \param [in] function The name of the logging function.
+   * \param [in] kind How the message is formatted.
+   */
+  LogRecord (const LogComponent &component, int32_t level,
+             const char *function, enum Kind kind);
+  /** Push the message into the log ring. */
+  ~LogRecord ();
+
+  /**
+   * Record an argument of the message.
+   * \param [in] v The argument.
+   * \returns This LogRecord, so it's chainable.
+   */
+  LogRecord & operator<< (bool v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (char v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (signed char v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (unsigned char v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (short v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (unsigned short v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (int v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (unsigned int v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (long v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (unsigned long v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (long long v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (unsigned long long v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (float v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (double v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (const char *v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (char *v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (const std::string &v);
+  /** \copydoc operator<<(bool) */
+  LogRecord & operator<< (const void *v);
+  /**
+   * Record a stream manipulator, applied when the message is formatted.
+   * \param [in] manip The manipulator.
+   * \returns This LogRecord, so it's chainable.
+   */
+  LogRecord & operator<< (std::ostream & (*manip)(std::ostream &));
+  /** \copydoc operator<<(std::ostream&(*)(std::ostream&)) */
+  LogRecord & operator<< (std::ios_base & (*manip)(std::ios_base &));
+
+  /**
+   * Record a manipulator of the \c <iomanip> header.
+   *
+   * The types of these manipulators are unspecified, so their argument
+   * is recorded, and the manipulator is created again when the message
+   * is formatted.
+   *
+   * \param [in] manip The manipulator.
+   * \returns This LogRecord, so it's chainable.
+   */
+  LogRecord & operator<< (decltype (std::setprecision (0)) manip);
+  /** \copydoc operator<<(decltype(std::setprecision(0))) */
+  LogRecord & operator<< (decltype (std::setw (0)) manip);
+  /** \copydoc operator<<(decltype(std::setprecision(0))) */
+  LogRecord & operator<< (decltype (std::setfill ('0')) manip);
+  /** \copydoc operator<<(decltype(std::setprecision(0))) */
+  LogRecord & operator<< (decltype (std::setbase (0)) manip);
+
+  /**
+   * Record a pointer argument.
+   * \param [in] v The pointer.
+   * \returns This LogRecord, so it's chainable.
+   */
+  template <typename T>
+  LogRecord & operator<< (T *v)
+  {
+    return *this << static_cast<const void *> (v);
+  }
+  /** \copydoc operator<<(T*) */
+  template <typename T>
+  LogRecord & operator<< (const Ptr<T> &v)
+  {
+    return *this << static_cast<const void *> (PeekPointer (v));
+  }
+  /** \copydoc operator<<(T*) */
+  template <typename T>
+  LogRecord & operator<< (Ptr<T> &v)
+  {
+    return *this << static_cast<const void *> (PeekPointer (v));
+  }
+  /**
+   * Record a function pointer argument; \c std::ostream prints it
+   * as a \c bool.
+   * \param [in] v The function pointer.
+   * \returns This LogRecord, so it's chainable.
+   */
+  template <typename R, typename... Args>
+  LogRecord & operator<< (R (*v)(Args...))
+  {
+    return *this << (v != 0);
+  }
+  /**
+   * Format an argument of any other type, and record the text.
+   * \param [in] v The argument.
+   * \returns This LogRecord, so it's chainable.
+   */
+  template <typename T>
+  LogRecord & operator<< (const T &v)
+  {
+    return AppendFormatted (v);
+  }
+  /**
+   * \copydoc operator<<(const T&)
+   *
+   * Some operator<< of the tree take their argument by non-const
+   * reference.
+   */
+  template <typename T>
+  LogRecord & operator<< (T &v)
+  {
+    return AppendFormatted (v);
+  }
+
+private:
+  /**
+   * Append an argument to the buffer.
+   * \param [in] type The type of the argument.
+   * \param [in] data The argument.
+   * \param [in] size The size of the argument.
+   */
+  void Append (uint8_t type, const void *data, uint32_t size);
+  /**
+   * Append a string argument to the buffer, truncated to fit.
+   * \param [in] data The characters.
+   * \param [in] size The number of characters.
+   */
+  void AppendString (const char *data, uint32_t size);
+  /**
+   * Format an argument with its \c operator<<, and append the text.
+   * \param [in] v The argument.
+   * \returns This LogRecord, so it's chainable.
+   */
+  template <typename T>
+  LogRecord & AppendFormatted (T &v)
+  {
+    std::ostringstream oss;
+    std::ostream &os = oss;
+    os << v;
+    return *this << oss.str ();
+  }
+
+  /** Size of the message buffer, header included. */
+  static const uint32_t BUFFER_SIZE = 512;
+
+  uint8_t m_buffer[BUFFER_SIZE];  //!< The message being recorded.
+  uint32_t m_size;                //!< Bytes used in m_buffer.
+  bool m_parameters;              //!< Separate the arguments with ", ".
+  bool m_first;                   //!< No argument recorded yet.
+};
+
+} // namespace ns3
+
+#endif /* NS3_LOG_RING_H */
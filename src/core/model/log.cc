@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "log.h"
+#include "log-ring.h"
 
 #include <list>
 #include <utility>
@@ -115,6 +116,7 @@ LogComponent::LogComponent (const std::string & name,
                             const enum LogLevel mask /* = 0 */)
   : m_levels (0), m_mask (mask), m_name (name), m_file (file)
 {
+  m_ringId = LogRingRegister (name);
   EnvVarCheck ();
 
   LogComponent::ComponentList *components = GetComponentList ();
@@ -268,13 +270,6 @@ LogComponent::EnvVarCheck (void)
 }
 
 
-bool 
-LogComponent::IsEnabled (const enum LogLevel level) const
-{
-  //  LogComponentEnableEnvVar ();
-  return (level & m_levels) ? 1 : 0;
-}
-
 bool
 LogComponent::IsNoneEnabled (void) const
 {
@@ -287,6 +282,12 @@ LogComponent::SetMask (const enum LogLevel level)
   m_mask |= level;
 }
 
+uint32_t
+LogComponent::GetRingId (void) const
+{
+  return m_ringId;
+}
+
 void 
 LogComponent::Enable (const enum LogLevel level)
 {
@@ -165,6 +165,17 @@ void LogComponentDisableAll (enum LogLevel level);
 } // namespace ns3
 
 
+#ifndef NS3_LOG_COMPILED_LEVELS
+/**
+ * \ingroup logging
+ * The log levels compiled in all the log components.
+ *
+ * Set at configure time with \c --log-levels; the NS_LOG macros of the
+ * other levels compile to nothing.
+ */
+#define NS3_LOG_COMPILED_LEVELS ns3::LOG_LEVEL_ALL
+#endif
+
 /**
  * Define a Log component with a specific name.
  *
@@ -180,7 +191,7 @@ void LogComponentDisableAll (enum LogLevel level);
  *
  * This macro should be placed within namespace ns3.  If functions
  * outside of namespace ns3 require access to logging, the preferred
- * solution is to add the following 'using' directive at file scope,
+ * solution is to add the following 'using' directives at file scope,
  * outside of namespace ns3, and after the inclusion of
  * NS_LOG_COMPONENT_DEFINE, such as follows:
  * \code
@@ -192,6 +203,9 @@ void LogComponentDisableAll (enum LogLevel level);
  *   } // namespace ns3
  *
  *   using ns3::g_log;
+ *   #ifdef NS3_LOG_ENABLE
+ *   using ns3::g_logCompiledLevels;
+ *   #endif
  *
  *   // Further definitions outside of the ns3 namespace
  *\endcode
@@ -199,7 +213,7 @@ void LogComponentDisableAll (enum LogLevel level);
  * \param [in] name The log component name.
  */
 #define NS_LOG_COMPONENT_DEFINE(name)                           \
-  static ns3::LogComponent g_log = ns3::LogComponent (name, __FILE__)
+  NS_LOG_COMPONENT_DEFINE_LEVELS (name, NS3_LOG_COMPILED_LEVELS)
 
 /**
  * Define a logging component with a mask.
@@ -210,8 +224,41 @@ void LogComponentDisableAll (enum LogLevel level);
  * \param [in] mask The default mask.
  */
 #define NS_LOG_COMPONENT_DEFINE_MASK(name, mask)                \
+  NS_LOG_COMPILED_LEVELS_DEFINE (NS3_LOG_COMPILED_LEVELS)        \
   static ns3::LogComponent g_log = ns3::LogComponent (name, __FILE__, mask)
 
+/**
+ * Define a logging component, compiling in only some log levels.
+ *
+ * The NS_LOG macros of the other levels compile to nothing in the file
+ * defining the component, whatever is enabled at run time. This is
+ * meant for the components used on the hot paths, so that the
+ * messages left there cost nothing in the builds which run with
+ * logging compiled in. The levels compiled in all the components can
+ * also be narrowed at configure time with \c --log-levels.
+ *
+ * \param [in] name The log component name.
+ * \param [in] levels The log levels compiled in, such as
+ *            \c ns3::LOG_LEVEL_INFO.
+ */
+#define NS_LOG_COMPONENT_DEFINE_LEVELS(name, levels)            \
+  NS_LOG_COMPILED_LEVELS_DEFINE ((levels) & NS3_LOG_COMPILED_LEVELS) \
+  static ns3::LogComponent g_log = ns3::LogComponent (name, __FILE__)
+
+#ifdef NS3_LOG_ENABLE
+/**
+ * \ingroup logging
+ * Define the log levels compiled in the file, read by the NS_LOG macros.
+ * Nothing when logging is compiled out.
+ *
+ * \param [in] levels The log levels compiled in.
+ */
+#define NS_LOG_COMPILED_LEVELS_DEFINE(levels)                   \
+  static const int32_t g_logCompiledLevels = levels;
+#else
+#define NS_LOG_COMPILED_LEVELS_DEFINE(levels)
+#endif
+
 /**
  * Use \ref NS_LOG to output a message of level LOG_ERROR.
  *
@@ -328,7 +375,10 @@ public:
    * \param [in] level The level to check for.
    * \return \c true if we are enabled at \c level.
    */
-  bool IsEnabled (const enum LogLevel level) const;
+  bool IsEnabled (const enum LogLevel level) const
+  {
+    return (level & m_levels) ? 1 : 0;
+  }
   /**
    * Check if all levels are disabled.
    *
@@ -371,6 +421,12 @@ public:
    * \param [in] level The LogLevel to block.
    */
   void SetMask (const enum LogLevel level);
+  /**
+   * Get the index of this LogComponent in the messages of the log ring.
+   *
+   * \return The index of this LogComponent.
+   */
+  uint32_t GetRingId (void) const;
 
   /**
    * LogComponent name map.
@@ -406,6 +462,7 @@ private:
   int32_t     m_mask;    //!< Blocked LogLevels.
   std::string m_name;    //!< LogComponent name.
   std::string m_file;    //!< File defining this LogComponent.
+  uint32_t    m_ringId;  //!< Index in the messages of the log ring.
 
 };  // class LogComponent
 
@@ -448,8 +505,73 @@ public:
   }
 };
 
+/**
+ * \ingroup logging
+ *
+ * Enable the log ring.
+ *
+ * While the ring is enabled, the enabled NS_LOG messages are not
+ * formatted on \c std::clog. The arguments of the messages are copied
+ * in binary form in a ring of \p size bytes instead, which keeps the
+ * most recent messages. LogRingFlush() formats them later.
+ *
+ * Same as running your program with the NS_LOG_RING environment
+ * variable set to the size: the ring is then flushed on \c std::clog
+ * at exit.
+ *
+ * \param [in] size The size of the ring, in bytes.
+ */
+void LogRingEnable (uint32_t size);
+
+/**
+ * \ingroup logging
+ *
+ * Disable the log ring and discard its content.
+ */
+void LogRingDisable (void);
+
+/**
+ * \ingroup logging
+ *
+ * Format the messages in the log ring, oldest first, and empty it.
+ *
+ * \param [in,out] os The output stream to print on.
+ */
+void LogRingFlush (std::ostream &os);
+
+/**
+ * \ingroup logging
+ *
+ * Function signature for reading the simulation time, in seconds,
+ * of a message recorded in the log ring.
+ */
+typedef double (*LogRingTimeReader)(void);
+/**
+ * \ingroup logging
+ *
+ * Function signature for reading the node id of a message recorded
+ * in the log ring.
+ */
+typedef uint32_t (*LogRingNodeReader)(void);
+
+/**
+ * \ingroup logging
+ *
+ * Set the functions used to stamp the messages recorded in the log
+ * ring; the counterpart of LogSetTimePrinter() and LogSetNodePrinter().
+ *
+ * \param [in] time The simulation time reader.
+ * \param [in] node The node id reader.
+ */
+void LogRingSetReaders (LogRingTimeReader time, LogRingNodeReader node);
+
 } // namespace ns3
 
 /**@}*/  // \ingroup logging
 
+#ifdef NS3_LOG_ENABLE
+// LogRecord, used by the NS_LOG macros
+#include "log-ring.h"
+#endif
+
 #endif /* NS3_LOG_H */
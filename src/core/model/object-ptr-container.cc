@@ -127,6 +127,35 @@ ObjectPtrContainerAccessor::Get (const ObjectBase * object, AttributeValue &valu
     }
   return true;
 }
+Ptr<Object>
+ObjectPtrContainerAccessor::Find (const ObjectBase *object, uint32_t index) const
+{
+  NS_LOG_FUNCTION (this << object << index);
+  uint32_t n;
+  if (!DoGetN (object, &n))
+    {
+      return 0;
+    }
+  // Most containers store the instances under their position
+  uint32_t found;
+  if (index < n)
+    {
+      Ptr<Object> o = DoGet (object, index, &found);
+      if (found == index)
+        {
+          return o;
+        }
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Object> o = DoGet (object, i, &found);
+      if (found == index)
+        {
+          return o;
+        }
+    }
+  return 0;
+}
 bool 
 ObjectPtrContainerAccessor::HasGetter (void) const
 {
@@ -220,6 +220,15 @@ public:
   virtual bool Get (const ObjectBase * object, AttributeValue &value) const;
   virtual bool HasGetter (void) const;
   virtual bool HasSetter (void) const;
+  /**
+   * Get the instance stored under an index, without copying the whole
+   * container in an ObjectPtrContainerValue.
+   *
+   * \param [in] object The container object.
+   * \param [in] index The index of the instance.
+   * \returns The instance, or zero if there is none under \p index.
+   */
+  Ptr<Object> Find (const ObjectBase *object, uint32_t index) const;
 private:
   /**
    * Get the number of instances in the container.
@@ -218,6 +218,12 @@ private:
    * \sa DoInitialize()
    */
   void Initialize (void);
+  /**
+   * Check if the object has been initialized.
+   *
+   * \returns \c true if the DoInitialize() method of this Object has run.
+   */
+  bool IsInitialized (void) const;
 
 protected:
   /**
@@ -87,6 +87,30 @@ TimePrinter (std::ostream &os)
   os << Simulator::Now ().GetSeconds () << "s";
 }
 
+/**
+ * \ingroup logging
+ * Default LogRingTimeReader implementation.
+ *
+ * \returns The simulation time, in seconds.
+ */
+static double
+TimeReader (void)
+{
+  return Simulator::Now ().GetSeconds ();
+}
+
+/**
+ * \ingroup logging
+ * Default LogRingNodeReader implementation.
+ *
+ * \returns The node id, or Simulator::NO_CONTEXT.
+ */
+static uint32_t
+NodeReader (void)
+{
+  return Simulator::GetContext ();
+}
+
 /**
  * \ingroup logging
  * Default node id printer implementation.
@@ -156,6 +180,7 @@ static SimulatorImpl * GetImpl (void)
 //
       LogSetTimePrinter (&TimePrinter);
       LogSetNodePrinter (&NodePrinter);
+      LogRingSetReaders (&TimeReader, &NodeReader);
     }
   return *pimpl;
 }
@@ -177,6 +202,7 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  LogRingSetReaders (0, 0);
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
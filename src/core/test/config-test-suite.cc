@@ -30,9 +30,11 @@
 #include "ns3/names.h"
 #include "ns3/pointer.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 
 
 #include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -721,6 +723,227 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test for the persistent trace connections, which also apply to the
+// objects notified after they were made.
+// ===========================================================================
+class PersistentTraceConfigTestCase : public TestCase
+{
+public:
+  PersistentTraceConfigTestCase ();
+  virtual ~PersistentTraceConfigTestCase () {}
+
+  void Trace (int16_t oldValue, int16_t newValue) { m_newValue = newValue; m_count++; }
+  void TraceWithPath (std::string path, int16_t old, int16_t newValue) { m_newValue = newValue; m_path = path; m_count++; }
+
+private:
+  virtual void DoRun (void);
+
+  int16_t m_newValue;
+  std::string m_path;
+  uint32_t m_count;
+};
+
+PersistentTraceConfigTestCase::PersistentTraceConfigTestCase ()
+  : TestCase ("Check that persistent trace connections reach the objects notified later")
+{
+}
+
+void
+PersistentTraceConfigTestCase::DoRun (void)
+{
+  IntegerValue iv;
+
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  root->SetNodeB (a);
+  Ptr<ConfigTestObject> obj0 = CreateObject<ConfigTestObject> ();
+  a->AddNodeB (obj0);
+
+  //
+  // Connect before the other objects exist: the existing one is connected
+  // right away.
+  //
+  Config::ConnectPersistent ("/NodeB/NodesB/[1-3]|0/Source",
+                             MakeCallback (&PersistentTraceConfigTestCase::TraceWithPath, this));
+  Config::ConnectWithoutContextPersistent ("/NodeB/NodesB/2/NodeA/Source",
+                                           MakeCallback (&PersistentTraceConfigTestCase::Trace, this));
+  m_count = 0;
+  obj0->SetAttribute ("Source", IntegerValue (-2));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Trace 0 did not fire once");
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, -2, "Trace 0 did not fire as expected");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeB/NodesB/0/Source", "Trace 0 did not provide expected context");
+
+  //
+  // The objects added later are connected once notified, and only
+  // if they match the path.
+  //
+  Ptr<ConfigTestObject> obj1 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> obj2 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> obj3 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> obj4 = CreateObject<ConfigTestObject> ();
+  Ptr<ConfigTestObject> leaf = CreateObject<ConfigTestObject> ();
+  obj2->SetNodeA (leaf);
+  a->AddNodeB (obj1);
+  a->AddNodeB (obj2);
+  a->AddNodeB (obj3);
+  a->AddNodeB (obj4);
+  a->AddNodeA (obj4);
+
+  m_count = 0;
+  obj1->SetAttribute ("Source", IntegerValue (-3));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 0, "Trace 1 fired before being notified");
+
+  Config::NotifyNewObject (obj1, "/NodeB/NodesB/1");
+  Config::NotifyNewObject (obj2, "/NodeB/NodesB/2");
+  Config::NotifyNewObject (obj4, "/NodeB/NodesB/4");
+  Config::NotifyNewObject (obj4, "/NodeB/NodesA/0");
+  Config::NotifyNewObject (a, "/NodeB");
+
+  obj1->SetAttribute ("Source", IntegerValue (-4));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Trace 1 did not fire once");
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, -4, "Trace 1 did not fire as expected");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeB/NodesB/1/Source", "Trace 1 did not provide expected context");
+
+  m_count = 0;
+  obj0->SetAttribute ("Source", IntegerValue (-5));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Trace 0 connected twice");
+
+  m_count = 0;
+  obj3->SetAttribute ("Source", IntegerValue (-6));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Trace 3 not connected by the notification of its parent");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeB/NodesB/3/Source", "Trace 3 did not provide expected context");
+
+  m_count = 0;
+  obj4->SetAttribute ("Source", IntegerValue (-7));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 0, "Trace 4 does not match the path");
+
+  m_count = 0;
+  m_path = "";
+  leaf->SetAttribute ("Source", IntegerValue (-8));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 1, "Trace of NodeA did not fire once");
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, -8, "Trace of NodeA did not fire as expected");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "", "Trace of NodeA received a context");
+
+  //
+  // A single index is resolved without going through the whole container.
+  //
+  Config::Set ("/NodeB/NodesB/3/A", IntegerValue (3));
+  obj3->GetAttribute ("A", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 3, "Object Attribute \"A\" not set correctly");
+  obj2->GetAttribute ("A", iv);
+  NS_TEST_ASSERT_MSG_EQ (iv.Get (), 10, "Object Attribute \"A\" of the wrong object set");
+  Config::MatchContainer matches = Config::LookupMatches ("/NodeB/NodesB/7");
+  NS_TEST_ASSERT_MSG_EQ (matches.GetN (), 0, "Object found past the end of the container");
+
+  //
+  // Disconnecting forgets the persistent connection.
+  //
+  Config::Disconnect ("/NodeB/NodesB/[1-3]|0/Source",
+                      MakeCallback (&PersistentTraceConfigTestCase::TraceWithPath, this));
+  Ptr<ConfigTestObject> obj5 = CreateObject<ConfigTestObject> ();
+  a->AddNodeB (obj5);
+  Config::NotifyNewObject (a, "/NodeB");
+  m_count = 0;
+  obj0->SetAttribute ("Source", IntegerValue (-9));
+  obj1->SetAttribute ("Source", IntegerValue (-9));
+  NS_TEST_ASSERT_MSG_EQ (m_count, 0, "Trace fired after being disconnected");
+
+  Config::DisconnectWithoutContext ("/NodeB/NodesB/2/NodeA/Source",
+                                    MakeCallback (&PersistentTraceConfigTestCase::Trace, this));
+  Config::UnregisterRootNamespaceObject (root);
+}
+
+// ===========================================================================
+// Test that the persistent trace connections do not outlive the simulation
+// they were made for.
+// ===========================================================================
+class PersistentTraceDestroyConfigTestCase : public TestCase
+{
+public:
+  PersistentTraceDestroyConfigTestCase ();
+  virtual ~PersistentTraceDestroyConfigTestCase () {}
+
+  void Trace1 (int16_t oldValue, int16_t newValue) { m_count1++; }
+  void Trace2 (int16_t oldValue, int16_t newValue) { m_count2++; }
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Build the objects of a simulation, notify them, and fire their traces.
+   * \param n the number of objects in /NodeB/NodesB
+   */
+  void BuildAndFire (uint32_t n);
+
+  Ptr<ConfigTestObject> m_root;
+  uint32_t m_count1;
+  uint32_t m_count2;
+};
+
+PersistentTraceDestroyConfigTestCase::PersistentTraceDestroyConfigTestCase ()
+  : TestCase ("Check that Simulator::Destroy forgets the persistent trace connections")
+{
+}
+
+void
+PersistentTraceDestroyConfigTestCase::BuildAndFire (uint32_t n)
+{
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  m_root->SetNodeB (a);
+  std::vector<Ptr<ConfigTestObject> > objects;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      objects.push_back (CreateObject<ConfigTestObject> ());
+      a->AddNodeB (objects.back ());
+    }
+  Config::NotifyNewObject (a, "/NodeB");
+  Simulator::Run ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      objects[i]->SetAttribute ("Source", IntegerValue (-2));
+    }
+}
+
+void
+PersistentTraceDestroyConfigTestCase::DoRun (void)
+{
+  m_root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (m_root);
+
+  //
+  // Each simulation has more objects than the previous one: the
+  // connections of a previous simulation would reach the new ones.
+  //
+  m_count1 = 0;
+  m_count2 = 0;
+  Config::ConnectWithoutContextPersistent ("/NodeB/NodesB/*/Source",
+                                           MakeCallback (&PersistentTraceDestroyConfigTestCase::Trace1, this));
+  BuildAndFire (1);
+  NS_TEST_EXPECT_MSG_EQ (m_count1, 1, "Trace of the first simulation did not fire once");
+  NS_TEST_EXPECT_MSG_EQ (Config::HasPersistentConnections (), true, "Connection not recorded");
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (Config::HasPersistentConnections (), false,
+                         "New objects still resolved after Simulator::Destroy");
+
+  m_count1 = 0;
+  Config::ConnectWithoutContextPersistent ("/NodeB/NodesB/*/Source",
+                                           MakeCallback (&PersistentTraceDestroyConfigTestCase::Trace2, this));
+  BuildAndFire (2);
+  NS_TEST_EXPECT_MSG_EQ (m_count1, 0, "Connection of the first simulation still made");
+  NS_TEST_EXPECT_MSG_EQ (m_count2, 2, "Traces of the second simulation did not fire once");
+  Simulator::Destroy ();
+
+  m_count2 = 0;
+  BuildAndFire (3);
+  NS_TEST_EXPECT_MSG_EQ (m_count1, 0, "Connection of the first simulation still made");
+  NS_TEST_EXPECT_MSG_EQ (m_count2, 0, "Connection of the second simulation still made");
+  Simulator::Destroy ();
+
+  Config::UnregisterRootNamespaceObject (m_root);
+  m_root = 0;
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +960,8 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new PersistentTraceConfigTestCase, TestCase::QUICK);
+  AddTestCase (new PersistentTraceDestroyConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
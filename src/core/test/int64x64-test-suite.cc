@@ -483,7 +483,15 @@ Int64x64ArithmeticTestCase::DoRun (void)
   // Check special values
   Check (51,  int64x64_t (0, 0x159fa87f8aeaad21ULL) * 10,
 	           int64x64_t (0, 0xd83c94fb6d2ac34aULL));
-  
+
+  // Products with an integer factor, as when converting a Time
+  const int64x64_t big (5000000000LL, 0);  // nanoseconds in 5 s
+  const int64x64_t half (0, 0x8000000000000000ULL);
+  Check (52,   big   *   int64x64_t (1000),  int64x64_t (5000000000000LL, 0));
+  Check (53, (-big)  *   int64x64_t (1000),  int64x64_t (-5000000000000LL, 0));
+  Check (54,   big   *   half,               int64x64_t (2500000000LL, 0));
+  Check (55,   half  * (-big),               int64x64_t (-2500000000LL, 0));
+  Check (56,   big   *   onef,               big + big * frac);
 }
 
 
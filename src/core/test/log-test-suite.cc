@@ -0,0 +1,236 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LogRingTest");
+
+class LogRingFormatTestCase : public TestCase
+{
+public:
+  LogRingFormatTestCase ();
+  virtual ~LogRingFormatTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  void LogMessages (void);
+  std::string Capture (bool ring);
+};
+
+LogRingFormatTestCase::LogRingFormatTestCase ()
+  : TestCase ("Check that the log ring formats the messages like std::clog")
+{
+}
+
+void
+LogRingFormatTestCase::LogMessages (void)
+{
+  std::string name = "abc";
+  char c = 'z';
+  uint8_t byte = 'k';
+  NS_LOG_FUNCTION (this << 7 << "literal" << name << -3 << 2.5);
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_DEBUG ("x=" << 42 << " name=" << name << " c=" << c << byte
+                << " hex=" << std::hex << 255 << " dec=" << 255
+                << " b=" << true << " p=" << this);
+  NS_LOG_INFO ("time " << Seconds (1.5) << " u64 " << UINT64_MAX);
+  NS_LOG_LOGIC ("fixed " << std::fixed << std::setprecision (3) << 3.14159);
+  NS_LOG_LOGIC ("default " << 3.14159);
+  NS_LOG_LOGIC ("padded " << std::setw (6) << std::setfill ('*') << 42
+                << std::setbase (16) << " " << 255 << std::setbase (0) << " " << 255);
+}
+
+std::string
+LogRingFormatTestCase::Capture (bool ring)
+{
+  // The manipulators of the messages stick to the stream
+  std::ios format (0);
+  format.copyfmt (std::clog);
+  std::ostringstream oss;
+  std::streambuf *clog = std::clog.rdbuf (oss.rdbuf ());
+  if (ring)
+    {
+      LogRingEnable (4096);
+    }
+  Simulator::Schedule (Seconds (2), &LogRingFormatTestCase::LogMessages, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  if (ring)
+    {
+      NS_TEST_EXPECT_MSG_EQ (oss.str (), "", "Logged on std::clog with the ring enabled");
+      LogRingFlush (oss);
+      LogRingDisable ();
+    }
+  std::clog.rdbuf (clog);
+  std::clog.copyfmt (format);
+  return oss.str ();
+}
+
+void
+LogRingFormatTestCase::DoRun (void)
+{
+  LogComponentEnable ("LogRingTest", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+  std::string expected = Capture (false);
+  std::string ring = Capture (true);
+  LogComponentDisable ("LogRingTest", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+
+#ifdef NS3_LOG_ENABLE
+  NS_TEST_EXPECT_MSG_NE (expected, "", "Nothing logged");
+#endif
+  NS_TEST_EXPECT_MSG_EQ (ring, expected, "Different output from the log ring");
+}
+
+class LogRingWrapTestCase : public TestCase
+{
+public:
+  LogRingWrapTestCase ();
+  virtual ~LogRingWrapTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+LogRingWrapTestCase::LogRingWrapTestCase ()
+  : TestCase ("Check that the log ring keeps the most recent messages")
+{
+}
+
+void
+LogRingWrapTestCase::DoRun (void)
+{
+  LogComponentEnable ("LogRingTest", LOG_DEBUG);
+  LogRingEnable (500);
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      NS_LOG_DEBUG ("message " << i);
+    }
+  std::ostringstream oss;
+  LogRingFlush (oss);
+  LogRingDisable ();
+  LogComponentDisable ("LogRingTest", LOG_ALL);
+
+#ifdef NS3_LOG_ENABLE
+  std::string output = oss.str ();
+  NS_TEST_EXPECT_MSG_EQ (output.find ("message 0\n"), std::string::npos, "Oldest message kept");
+  NS_TEST_EXPECT_MSG_NE (output.find ("message 98\nmessage 99\n"), std::string::npos,
+                         "Newest messages lost");
+  NS_TEST_EXPECT_MSG_EQ (output.substr (0, 8), "message ", "Message cut by the wrap around");
+#endif
+}
+
+#ifdef HAVE_PTHREAD_H
+class LogRingThreadsTestCase : public TestCase
+{
+public:
+  LogRingThreadsTestCase ();
+  virtual ~LogRingThreadsTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  void LogMessages (void);
+};
+
+LogRingThreadsTestCase::LogRingThreadsTestCase ()
+  : TestCase ("Check that threads can log concurrently in the log ring")
+{
+}
+
+void
+LogRingThreadsTestCase::LogMessages (void)
+{
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      NS_LOG_DEBUG ("message " << i << " of a thread");
+    }
+}
+
+void
+LogRingThreadsTestCase::DoRun (void)
+{
+  const uint32_t nThreads = 4;
+  LogComponentEnable ("LogRingTest", LOG_DEBUG);
+  LogRingEnable (1 << 20);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t t = 0; t < nThreads; t++)
+    {
+      threads.push_back (Create<SystemThread> (MakeCallback (&LogRingThreadsTestCase::LogMessages, this)));
+      threads.back ()->Start ();
+    }
+  for (uint32_t t = 0; t < nThreads; t++)
+    {
+      threads[t]->Join ();
+    }
+  std::ostringstream oss;
+  LogRingFlush (oss);
+  LogRingDisable ();
+  LogComponentDisable ("LogRingTest", LOG_ALL);
+
+#ifdef NS3_LOG_ENABLE
+  std::vector<uint32_t> counts (1000, 0);
+  std::istringstream iss (oss.str ());
+  std::string line;
+  uint32_t lines = 0;
+  while (std::getline (iss, line))
+    {
+      uint32_t i;
+      char rest[32];
+      NS_TEST_ASSERT_MSG_EQ (std::sscanf (line.c_str (), "message %u %31[a-z ]", &i, rest), 2,
+                             "Corrupted message " << line);
+      NS_TEST_ASSERT_MSG_EQ (std::string (rest), "of a thread", "Corrupted message " << line);
+      NS_TEST_ASSERT_MSG_LT (i, 1000, "Corrupted message " << line);
+      counts[i]++;
+      lines++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (lines, nThreads * 1000, "Messages lost");
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (counts[i], nThreads, "Message " << i << " lost");
+    }
+#endif
+}
+#endif /* HAVE_PTHREAD_H */
+
+class LogTestSuite : public TestSuite
+{
+public:
+  LogTestSuite ();
+};
+
+LogTestSuite::LogTestSuite ()
+  : TestSuite ("log", UNIT)
+{
+  AddTestCase (new LogRingFormatTestCase, TestCase::QUICK);
+  AddTestCase (new LogRingWrapTestCase, TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new LogRingThreadsTestCase, TestCase::QUICK);
+#endif
+}
+
+static LogTestSuite g_logTestSuite;
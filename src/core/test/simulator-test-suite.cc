@@ -23,6 +23,9 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/random-variable-stream.h"
+#include <set>
 
 using namespace ns3;
 
@@ -168,6 +171,131 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Insert (uint64_t ts);
+  Ptr<Scheduler> m_scheduler;
+  std::set<Scheduler::Event> m_expected;
+  uint32_t m_uid;
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the event order under bursty insertions and removals with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::Insert (uint64_t ts)
+{
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_ts = ts;
+  ev.key.m_uid = m_uid++;
+  ev.key.m_context = 0;
+  m_scheduler->Insert (ev);
+  m_expected.insert (ev);
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  m_scheduler = m_schedulerFactory.Create<Scheduler> ();
+  m_uid = 0;
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+
+  uint64_t now = 0;
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      double r = rand->GetValue ();
+      if (r < 0.4)
+        {
+          // per-packet events, close to each other
+          Insert (now + rand->GetInteger (0, 100));
+        }
+      else if (r < 0.5)
+        {
+          // bursts at the same time
+          Insert (now);
+        }
+      else if (r < 0.6)
+        {
+          // timers, far away
+          Insert (now + rand->GetInteger (1000, 1000000000));
+        }
+      else if (r < 0.65 && !m_expected.empty ())
+        {
+          std::set<Scheduler::Event>::iterator it = m_expected.begin ();
+          std::advance (it, rand->GetInteger (0, m_expected.size () - 1));
+          m_scheduler->Remove (*it);
+          m_expected.erase (it);
+        }
+      else if (!m_expected.empty ())
+        {
+          Scheduler::Event next = m_scheduler->PeekNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, m_expected.begin ()->key.m_uid, "Wrong next event");
+          next = m_scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, m_expected.begin ()->key.m_uid, "Wrong event removed");
+          now = next.key.m_ts;
+          m_expected.erase (m_expected.begin ());
+        }
+    }
+  while (!m_expected.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), false, "Events missing");
+      Scheduler::Event next = m_scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, m_expected.begin ()->key.m_uid, "Wrong event removed");
+      m_expected.erase (m_expected.begin ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), true, "Events left");
+  m_scheduler = 0;
+}
+
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+  virtual void DoRun (void);
+  void Chain (uint32_t left, uint64_t payload);
+  std::set<EventImpl *> m_blocks;
+  uint32_t m_runs;
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check that the events are recycled once invoked")
+{
+}
+
+void
+SimulatorEventPoolTestCase::Chain (uint32_t left, uint64_t payload)
+{
+  m_runs++;
+  if (left > 0)
+    {
+      EventId id = Simulator::Schedule (TimeStep (1), &SimulatorEventPoolTestCase::Chain,
+                                        this, left - 1, payload);
+      m_blocks.insert (id.PeekEventImpl ());
+    }
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  m_runs = 0;
+  Simulator::Schedule (TimeStep (1), &SimulatorEventPoolTestCase::Chain, this, 10000, 0);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_runs, 10001, "Events lost");
+  // Each event is scheduled while the previous one runs, then takes its block
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_blocks.size (), 3, "Events not recycled");
+  Simulator::Destroy ();
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -475,5 +603,20 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
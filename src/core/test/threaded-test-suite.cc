@@ -30,6 +30,7 @@
 #include <ctime>
 #include <list>
 #include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -225,6 +226,63 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+/**
+ * Check that the events scheduled from another thread run in the order
+ * they were scheduled.
+ */
+class ThreadedSimulatorOrderTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorOrderTestCase ();
+  void Inject (void);
+  void InjectingThread (void);
+  void Record (uint32_t i);
+  std::vector<uint32_t> m_order;
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedSimulatorOrderTestCase::ThreadedSimulatorOrderTestCase ()
+  : TestCase ("Check that events scheduled from another thread keep their order")
+{
+}
+
+void
+ThreadedSimulatorOrderTestCase::InjectingThread (void)
+{
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Simulator::ScheduleWithContext (i % 7, Seconds (0),
+                                      &ThreadedSimulatorOrderTestCase::Record, this, i);
+    }
+}
+void
+ThreadedSimulatorOrderTestCase::Inject (void)
+{
+  Ptr<SystemThread> thread = Create<SystemThread> (
+      MakeCallback (&ThreadedSimulatorOrderTestCase::InjectingThread, this));
+  thread->Start ();
+  thread->Join ();
+}
+void
+ThreadedSimulatorOrderTestCase::Record (uint32_t i)
+{
+  m_order.push_back (i);
+}
+void
+ThreadedSimulatorOrderTestCase::DoRun (void)
+{
+  Simulator::Schedule (MicroSeconds (10), &ThreadedSimulatorOrderTestCase::Inject, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_order.size (), 1000, "Events lost");
+  for (uint32_t i = 0; i < m_order.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_order[i], i, "Events out of order");
+    }
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -241,7 +299,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +321,6 @@ public:
               }
           }
       }
+    AddTestCase (new ThreadedSimulatorOrderTestCase (), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
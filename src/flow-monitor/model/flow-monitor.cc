@@ -24,11 +24,14 @@
 #include "ns3/double.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #define INDENT(level) for (int __xpto = 0; __xpto < level; __xpto++) os << ' ';
 
 #define PERIODIC_CHECK_INTERVAL (Seconds (1))
 
+#define EXPIRY_SLOT_WIDTH (MilliSeconds (100))
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("FlowMonitor");
@@ -83,7 +86,8 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_expiryBase (0),
+    m_enabled (false)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -126,14 +130,52 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
       ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
       ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
       ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+      MarkFlowChanged (flowId);
       return ref;
     }
   else
     {
+      MarkFlowChanged (flowId);
       return iter->second;
     }
 }
 
+inline void
+FlowMonitor::MarkFlowChanged (FlowId flowId)
+{
+  if (flowId >= m_dirtyFlags.size ())
+    {
+      m_dirtyFlags.resize (flowId + 1, false);
+    }
+  if (!m_dirtyFlags[flowId])
+    {
+      m_dirtyFlags[flowId] = true;
+      m_dirtyFlows.push_back (flowId);
+    }
+}
+
+inline int64_t
+FlowMonitor::GetExpirySlot (const Time &time)
+{
+  return time.GetInteger () / EXPIRY_SLOT_WIDTH.GetInteger ();
+}
+
+void
+FlowMonitor::ScheduleExpiry (const std::pair<FlowId, FlowPacketId> &key, const Time &lastSeenTime)
+{
+  int64_t slot = GetExpirySlot (lastSeenTime);
+  if (m_expiryWheel.empty ())
+    {
+      m_expiryBase = slot;
+    }
+  NS_ASSERT (slot >= m_expiryBase);
+  while (slot - m_expiryBase >= static_cast<int64_t> (m_expiryWheel.size ()))
+    {
+      m_expiryWheel.push_back (std::vector<std::pair<FlowId, FlowPacketId> > ());
+    }
+  m_expiryWheel[slot - m_expiryBase].push_back (key);
+}
+
 
 void
 FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
@@ -143,10 +185,12 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
+  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
+  TrackedPacket &tracked = m_trackedPackets[key];
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
+  ScheduleExpiry (key, now);
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                                                                 << ").");
 
@@ -180,7 +224,13 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     }
 
   tracked->second.timesForwarded++;
+  int64_t lastSlot = GetExpirySlot (tracked->second.lastSeenTime);
   tracked->second.lastSeenTime = Simulator::Now ();
+  if (GetExpirySlot (tracked->second.lastSeenTime) != lastSlot)
+    {
+      // the entry in the old slot becomes stale and is skipped when it expires
+      ScheduleExpiry (key, tracked->second.lastSeenTime);
+    }
 
   Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
@@ -290,28 +340,127 @@ FlowMonitor::GetFlowStats () const
 }
 
 
+void
+FlowMonitor::GetFlowStatsDelta (FlowStatsDeltaContainer &delta)
+{
+  std::sort (m_dirtyFlows.begin (), m_dirtyFlows.end ());
+  delta.resize (m_dirtyFlows.size ());
+  for (uint32_t i = 0; i < m_dirtyFlows.size (); i++)
+    {
+      FlowId flowId = m_dirtyFlows[i];
+      FlowStatsContainerCI flow = m_flowStats.find (flowId);
+      NS_ASSERT (flow != m_flowStats.end ());
+
+      FlowStatsSample &sample = delta[i];
+      sample.flowId = flowId;
+      sample.delaySum = flow->second.delaySum;
+      sample.jitterSum = flow->second.jitterSum;
+      sample.txBytes = flow->second.txBytes;
+      sample.rxBytes = flow->second.rxBytes;
+      sample.txPackets = flow->second.txPackets;
+      sample.rxPackets = flow->second.rxPackets;
+      sample.lostPackets = flow->second.lostPackets;
+      sample.timesForwarded = flow->second.timesForwarded;
+      sample.packetsDropped.assign (flow->second.packetsDropped.begin (),
+                                    flow->second.packetsDropped.end ());
+      m_dirtyFlags[flowId] = false;
+    }
+  m_dirtyFlows.clear ();
+}
+
+template <typename T>
+static inline void
+WriteBinary (std::ostream &os, T value)
+{
+  os.write (reinterpret_cast<const char *> (&value), sizeof (T));
+}
+
+void
+FlowMonitor::SerializeToBinaryStream (std::ostream &os, const FlowStatsDeltaContainer &delta)
+{
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  for (FlowStatsDeltaContainer::const_iterator iter = delta.begin ();
+       iter != delta.end (); iter++)
+    {
+      WriteBinary<int64_t> (os, now);
+      WriteBinary<uint32_t> (os, iter->flowId);
+      WriteBinary<uint32_t> (os, iter->txPackets);
+      WriteBinary<uint64_t> (os, iter->txBytes);
+      WriteBinary<uint32_t> (os, iter->rxPackets);
+      WriteBinary<uint64_t> (os, iter->rxBytes);
+      WriteBinary<int64_t> (os, iter->delaySum.GetNanoSeconds ());
+      WriteBinary<int64_t> (os, iter->jitterSum.GetNanoSeconds ());
+      WriteBinary<uint32_t> (os, iter->lostPackets);
+      WriteBinary<uint32_t> (os, iter->timesForwarded);
+      WriteBinary<uint32_t> (os, iter->packetsDropped.size ());
+      for (uint32_t reasonCode = 0; reasonCode < iter->packetsDropped.size (); reasonCode++)
+        {
+          WriteBinary<uint32_t> (os, iter->packetsDropped[reasonCode]);
+        }
+    }
+}
+
+uint32_t
+FlowMonitor::SerializeDeltaToBinaryStream (std::ostream &os)
+{
+  GetFlowStatsDelta (m_deltaBuffer);
+  SerializeToBinaryStream (os, m_deltaBuffer);
+  return m_deltaBuffer.size ();
+}
+
 void
 FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
+  Time cutoff = now - maxDelay;
+  if (cutoff.IsNegative ())
+    {
+      return;
+    }
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  // Only the buckets up to the slot of the cutoff time can hold
+  // packets last seen more than maxDelay ago; the rest of the tracked
+  // packets are not visited.
+  int64_t cutoffSlot = GetExpirySlot (cutoff);
+  while (!m_expiryWheel.empty () && m_expiryBase <= cutoffSlot)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      std::vector<std::pair<FlowId, FlowPacketId> > &bucket = m_expiryWheel.front ();
+      std::vector<std::pair<FlowId, FlowPacketId> >::iterator keep = bucket.begin ();
+      for (std::vector<std::pair<FlowId, FlowPacketId> >::iterator key = bucket.begin ();
+           key != bucket.end (); key++)
         {
-          // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
+          TrackedPacketMap::iterator iter = m_trackedPackets.find (*key);
+          if (iter == m_trackedPackets.end ())
+            {
+              // already received or dropped
+              continue;
+            }
+          if (now - iter->second.lastSeenTime >= maxDelay)
+            {
+              // packet is considered lost, add it to the loss statistics
+              FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
+              NS_ASSERT (flow != m_flowStats.end ());
+              flow->second.lostPackets++;
+              MarkFlowChanged (iter->first.first);
+
+              // we won't track it anymore
+              m_trackedPackets.erase (iter);
+            }
+          else if (GetExpirySlot (iter->second.lastSeenTime) == m_expiryBase)
+            {
+              // only possible in the slot of the cutoff time, which is
+              // partially expired
+              *keep++ = *key;
+            }
         }
-      else
+
+      if (m_expiryBase == cutoffSlot)
         {
-          iter++;
+          bucket.erase (keep, bucket.end ());
+          break;
         }
+      m_expiryWheel.pop_front ();
+      m_expiryBase++;
     }
 }
 
@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <map>
+#include <deque>
+#include <ostream>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
@@ -137,6 +139,24 @@ public:
     Histogram flowInterruptionsHistogram; //!< histogram of durations of flow interruptions
   };
 
+  /// \brief Structure that holds the counters of a flow at the time of a delta snapshot
+  ///
+  /// Unlike FlowStats, it carries no histograms, so it is cheap to
+  /// copy and can be stored by value in a flat vector.
+  struct FlowStatsSample
+  {
+    FlowId   flowId;         //!< flow identification
+    Time     delaySum;       //!< see FlowStats::delaySum
+    Time     jitterSum;      //!< see FlowStats::jitterSum
+    uint64_t txBytes;        //!< see FlowStats::txBytes
+    uint64_t rxBytes;        //!< see FlowStats::rxBytes
+    uint32_t txPackets;      //!< see FlowStats::txPackets
+    uint32_t rxPackets;      //!< see FlowStats::rxPackets
+    uint32_t lostPackets;    //!< see FlowStats::lostPackets
+    uint32_t timesForwarded; //!< see FlowStats::timesForwarded
+    std::vector<uint32_t> packetsDropped; //!< see FlowStats::packetsDropped
+  };
+
   // --- basic methods ---
   /**
    * \brief Get the type ID.
@@ -224,6 +244,8 @@ public:
   typedef std::vector< Ptr<FlowProbe> >::iterator FlowProbeContainerI;
   /// Container Const Iterator: FlowProbe
   typedef std::vector< Ptr<FlowProbe> >::const_iterator FlowProbeContainerCI;
+  /// Container: FlowStatsSample, sorted by FlowId
+  typedef std::vector<FlowStatsSample> FlowStatsDeltaContainer;
 
   /// Retrieve all collected the flow statistics.  Note, if the
   /// FlowMonitor has not stopped monitoring yet, you should call
@@ -232,6 +254,38 @@ public:
   /// \returns the flows statistics
   const FlowStatsContainer& GetFlowStats () const;
 
+  /// Retrieve the counters of the flows that changed since the
+  /// previous call to GetFlowStatsDelta() or
+  /// SerializeDeltaToBinaryStream(), and start a new snapshot.  The
+  /// previous contents of the container are overwritten, so callers
+  /// sampling periodically can pass the same container to avoid
+  /// reallocating it.  As with
+  /// GetFlowStats(), call CheckForLostPackets() first if losses must
+  /// be accounted for.
+  /// \param delta container to fill, sorted by FlowId
+  void GetFlowStatsDelta (FlowStatsDeltaContainer &delta);
+
+  /// Append a delta snapshot to a binary stream, one record per
+  /// flow.  All fields are written in host byte order, without
+  /// padding:
+  ///
+  ///   int64 timestamp (ns), uint32 flowId, uint32 txPackets,
+  ///   uint64 txBytes, uint32 rxPackets, uint64 rxBytes,
+  ///   int64 delaySum (ns), int64 jitterSum (ns), uint32 lostPackets,
+  ///   uint32 timesForwarded, uint32 nReasons,
+  ///   nReasons x uint32 packetsDropped[reasonCode]
+  ///
+  /// The timestamp is the current simulation time.
+  /// \param os the output stream, which should be opened in binary mode
+  /// \param delta the snapshot, as filled by GetFlowStatsDelta()
+  static void SerializeToBinaryStream (std::ostream &os, const FlowStatsDeltaContainer &delta);
+
+  /// Take a delta snapshot (see GetFlowStatsDelta()) and append it to
+  /// a binary stream (see SerializeToBinaryStream() for the layout)
+  /// \param os the output stream, which should be opened in binary mode
+  /// \return the number of records written
+  uint32_t SerializeDeltaToBinaryStream (std::ostream &os);
+
   /// Get a list of all FlowProbe's associated with this FlowMonitor
   /// \returns a list of all the probes
   const FlowProbeContainer& GetAllProbes () const;
@@ -278,6 +332,18 @@ private:
   /// (FlowId,PacketId) --> TrackedPacket
   typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
   TrackedPacketMap m_trackedPackets; //!< Tracked packets
+
+  /// Expiry wheel used by CheckForLostPackets.  Bucket i holds the
+  /// keys of the tracked packets whose lastSeenTime fell in slot
+  /// m_expiryBase + i when they were inserted.  Entries are not
+  /// removed when a packet is received, dropped or seen again; stale
+  /// entries are skipped when their bucket expires.
+  std::deque<std::vector<std::pair<FlowId, FlowPacketId> > > m_expiryWheel;
+  int64_t m_expiryBase; //!< slot number of the first bucket in m_expiryWheel
+
+  std::vector<bool> m_dirtyFlags; //!< FlowId --> flow changed since the last delta snapshot
+  std::vector<FlowId> m_dirtyFlows; //!< flows changed since the last delta snapshot
+  FlowStatsDeltaContainer m_deltaBuffer; //!< scratch container for SerializeDeltaToBinaryStream
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -298,6 +364,20 @@ private:
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
+  /// Record that the stats of a flow changed since the last delta snapshot
+  /// \param flowId the Flow identification
+  void MarkFlowChanged (FlowId flowId);
+
+  /// Get the expiry wheel slot of an absolute time
+  /// \param time the absolute time
+  /// \returns the slot number
+  static int64_t GetExpirySlot (const Time &time);
+
+  /// Insert a tracked packet into the expiry wheel, in the slot of its lastSeenTime
+  /// \param key the (FlowId,PacketId) of the tracked packet
+  /// \param lastSeenTime the time the packet was last seen
+  void ScheduleExpiry (const std::pair<FlowId, FlowPacketId> &key, const Time &lastSeenTime);
+
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
 };
@@ -0,0 +1,392 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <sstream>
+
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * FlowProbe that the test cases use to report packet events directly
+ * to the FlowMonitor.
+ */
+class FlowMonitorTestProbe : public FlowProbe
+{
+public:
+  /**
+   * Constructor
+   * \param monitor the FlowMonitor
+   */
+  FlowMonitorTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * Base class of the FlowMonitor test cases: creates a started
+ * FlowMonitor and a probe to report packet events with.
+ */
+class FlowMonitorTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param name the test case name
+   */
+  FlowMonitorTestCase (std::string name);
+
+protected:
+  virtual void DoSetup (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Report the transmission of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Tx (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the forwarding of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Forward (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the reception of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   */
+  void Rx (FlowId flowId, FlowPacketId packetId);
+  /**
+   * Report the drop of a packet
+   * \param flowId the flow
+   * \param packetId the packet
+   * \param reasonCode the reason of the drop
+   */
+  void Drop (FlowId flowId, FlowPacketId packetId, uint32_t reasonCode);
+
+  Ptr<FlowMonitor> m_monitor;  //!< the monitor under test
+  Ptr<FlowProbe> m_probe;      //!< the probe reporting the packet events
+};
+
+FlowMonitorTestCase::FlowMonitorTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+FlowMonitorTestCase::DoSetup (void)
+{
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_probe = CreateObject<FlowMonitorTestProbe> (m_monitor);
+  m_monitor->Start (Seconds (0));
+}
+
+void
+FlowMonitorTestCase::DoTeardown (void)
+{
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+  Simulator::Destroy ();
+}
+
+void
+FlowMonitorTestCase::Tx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportFirstTx (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorTestCase::Forward (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportForwarding (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorTestCase::Rx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportLastRx (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorTestCase::Drop (FlowId flowId, FlowPacketId packetId, uint32_t reasonCode)
+{
+  m_monitor->ReportDrop (m_probe, flowId, packetId, 100, reasonCode);
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * GetFlowStatsDelta only returns the flows that changed since the
+ * previous snapshot, with their cumulative counters.
+ */
+class FlowMonitorDeltaTestCase : public FlowMonitorTestCase
+{
+public:
+  FlowMonitorDeltaTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Take the first snapshot, after packets of flows 1 and 2
+  void FirstSnapshot (void);
+  /// Take the second snapshot, after a packet of flow 2 only
+  void SecondSnapshot (void);
+};
+
+FlowMonitorDeltaTestCase::FlowMonitorDeltaTestCase ()
+  : FlowMonitorTestCase ("Delta snapshots after partial intervals")
+{
+}
+
+void
+FlowMonitorDeltaTestCase::FirstSnapshot (void)
+{
+  FlowMonitor::FlowStatsDeltaContainer delta;
+  m_monitor->GetFlowStatsDelta (delta);
+  NS_TEST_ASSERT_MSG_EQ (delta.size (), 2, "Both flows changed");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].flowId, 1, "Samples are not sorted by FlowId");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].txPackets, 1, "Wrong txPackets of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].rxPackets, 1, "Wrong rxPackets of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].delaySum, MilliSeconds (100), "Wrong delaySum of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (delta[1].flowId, 2, "Samples are not sorted by FlowId");
+  NS_TEST_EXPECT_MSG_EQ (delta[1].txPackets, 1, "Wrong txPackets of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (delta[1].rxPackets, 0, "Wrong rxPackets of flow 2");
+
+  m_monitor->GetFlowStatsDelta (delta);
+  NS_TEST_EXPECT_MSG_EQ (delta.size (), 0, "No flow changed since the previous snapshot");
+}
+
+void
+FlowMonitorDeltaTestCase::SecondSnapshot (void)
+{
+  FlowMonitor::FlowStatsDeltaContainer delta;
+  m_monitor->GetFlowStatsDelta (delta);
+  NS_TEST_ASSERT_MSG_EQ (delta.size (), 1, "Only flow 2 changed");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].flowId, 2, "Wrong flow in the snapshot");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].txPackets, 2, "Counters are not cumulative");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].txBytes, 200, "Counters are not cumulative");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].rxPackets, 1, "Wrong rxPackets of flow 2");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].lostPackets, 1, "Wrong lostPackets of flow 2");
+  NS_TEST_ASSERT_MSG_EQ (delta[0].packetsDropped.size (), 4, "Wrong number of drop reasons");
+  NS_TEST_EXPECT_MSG_EQ (delta[0].packetsDropped[3], 1, "Drop not counted with its reason");
+}
+
+void
+FlowMonitorDeltaTestCase::DoRun (void)
+{
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorDeltaTestCase::Tx, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorDeltaTestCase::Tx, this, 2, 0);
+  Simulator::Schedule (MilliSeconds (200), &FlowMonitorDeltaTestCase::Rx, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (250), &FlowMonitorDeltaTestCase::FirstSnapshot, this);
+  Simulator::Schedule (MilliSeconds (300), &FlowMonitorDeltaTestCase::Rx, this, 2, 0);
+  Simulator::Schedule (MilliSeconds (300), &FlowMonitorDeltaTestCase::Tx, this, 2, 1);
+  Simulator::Schedule (MilliSeconds (350), &FlowMonitorDeltaTestCase::Drop, this, 2, 1, 3);
+  Simulator::Schedule (MilliSeconds (400), &FlowMonitorDeltaTestCase::SecondSnapshot, this);
+  Simulator::Stop (MilliSeconds (500));
+  Simulator::Run ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * The records written by SerializeToBinaryStream decode to the
+ * snapshot they were written from.
+ */
+class FlowMonitorBinaryTestCase : public FlowMonitorTestCase
+{
+public:
+  FlowMonitorBinaryTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Serialize a snapshot and decode it
+  void Serialize (void);
+
+  /**
+   * Read a field of a binary record
+   * \param is the input stream
+   * \return the field
+   */
+  template <typename T>
+  static T Read (std::istream &is);
+};
+
+FlowMonitorBinaryTestCase::FlowMonitorBinaryTestCase ()
+  : FlowMonitorTestCase ("Binary delta round trip")
+{
+}
+
+template <typename T>
+T
+FlowMonitorBinaryTestCase::Read (std::istream &is)
+{
+  T value = 0;
+  is.read (reinterpret_cast<char *> (&value), sizeof (T));
+  return value;
+}
+
+void
+FlowMonitorBinaryTestCase::Serialize (void)
+{
+  FlowMonitor::FlowStatsDeltaContainer delta;
+  m_monitor->GetFlowStatsDelta (delta);
+  NS_TEST_ASSERT_MSG_EQ (delta.size (), 2, "Both flows changed");
+
+  std::ostringstream os (std::ios::binary);
+  FlowMonitor::SerializeToBinaryStream (os, delta);
+  std::istringstream is (os.str (), std::ios::binary);
+  for (uint32_t i = 0; i < delta.size (); i++)
+    {
+      const FlowMonitor::FlowStatsSample &sample = delta[i];
+      NS_TEST_EXPECT_MSG_EQ (Read<int64_t> (is), Simulator::Now ().GetNanoSeconds (), "Wrong timestamp");
+      NS_TEST_EXPECT_MSG_EQ (Read<uint32_t> (is), sample.flowId, "Wrong flowId");
+      NS_TEST_EXPECT_MSG_EQ (Read<uint32_t> (is), sample.txPackets, "Wrong txPackets");
+      NS_TEST_EXPECT_MSG_EQ (Read<uint64_t> (is), sample.txBytes, "Wrong txBytes");
+      NS_TEST_EXPECT_MSG_EQ (Read<uint32_t> (is), sample.rxPackets, "Wrong rxPackets");
+      NS_TEST_EXPECT_MSG_EQ (Read<uint64_t> (is), sample.rxBytes, "Wrong rxBytes");
+      NS_TEST_EXPECT_MSG_EQ (Read<int64_t> (is), sample.delaySum.GetNanoSeconds (), "Wrong delaySum");
+      NS_TEST_EXPECT_MSG_EQ (Read<int64_t> (is), sample.jitterSum.GetNanoSeconds (), "Wrong jitterSum");
+      NS_TEST_EXPECT_MSG_EQ (Read<uint32_t> (is), sample.lostPackets, "Wrong lostPackets");
+      NS_TEST_EXPECT_MSG_EQ (Read<uint32_t> (is), sample.timesForwarded, "Wrong timesForwarded");
+      uint32_t nReasons = Read<uint32_t> (is);
+      NS_TEST_ASSERT_MSG_EQ (nReasons, sample.packetsDropped.size (), "Wrong number of drop reasons");
+      for (uint32_t reasonCode = 0; reasonCode < nReasons; reasonCode++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (Read<uint32_t> (is), sample.packetsDropped[reasonCode], "Wrong packetsDropped");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (is.peek (), std::char_traits<char>::eof (), "Trailing bytes after the records");
+  NS_TEST_EXPECT_MSG_EQ (delta[1].jitterSum, MilliSeconds (50), "Jitter not exercised");
+  NS_TEST_EXPECT_MSG_EQ (delta[1].packetsDropped.size (), 2, "Drops not exercised");
+
+  std::ostringstream empty (std::ios::binary);
+  NS_TEST_EXPECT_MSG_EQ (m_monitor->SerializeDeltaToBinaryStream (empty), 0, "No flow changed since the snapshot");
+  NS_TEST_EXPECT_MSG_EQ (empty.str ().size (), 0, "Records written for an empty snapshot");
+}
+
+void
+FlowMonitorBinaryTestCase::DoRun (void)
+{
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorBinaryTestCase::Tx, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorBinaryTestCase::Tx, this, 7, 0);
+  Simulator::Schedule (MilliSeconds (110), &FlowMonitorBinaryTestCase::Tx, this, 7, 1);
+  Simulator::Schedule (MilliSeconds (120), &FlowMonitorBinaryTestCase::Tx, this, 7, 2);
+  Simulator::Schedule (MilliSeconds (150), &FlowMonitorBinaryTestCase::Forward, this, 7, 0);
+  Simulator::Schedule (MilliSeconds (200), &FlowMonitorBinaryTestCase::Rx, this, 7, 0);
+  Simulator::Schedule (MilliSeconds (260), &FlowMonitorBinaryTestCase::Rx, this, 7, 1);
+  Simulator::Schedule (MilliSeconds (300), &FlowMonitorBinaryTestCase::Drop, this, 7, 2, 1);
+  Simulator::Schedule (MilliSeconds (400), &FlowMonitorBinaryTestCase::Serialize, this);
+  Simulator::Stop (MilliSeconds (500));
+  Simulator::Run ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * A packet which is not seen for longer than the maximum delay is
+ * counted as lost exactly once, even when it sits in several buckets
+ * of the expiry wheel and more checks follow.
+ */
+class FlowMonitorLossTestCase : public FlowMonitorTestCase
+{
+public:
+  FlowMonitorLossTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check for the lost packets and verify the count
+   * \param lost the expected number of lost packets of flow 1
+   */
+  void Check (uint32_t lost);
+};
+
+FlowMonitorLossTestCase::FlowMonitorLossTestCase ()
+  : FlowMonitorTestCase ("Lost packets counted once by the expiry wheel")
+{
+}
+
+void
+FlowMonitorLossTestCase::Check (uint32_t lost)
+{
+  m_monitor->CheckForLostPackets (Seconds (1));
+  FlowMonitor::FlowStatsContainer::const_iterator flow = m_monitor->GetFlowStats ().find (1);
+  NS_TEST_ASSERT_MSG_EQ ((flow != m_monitor->GetFlowStats ().end ()), true, "Flow 1 is not known");
+  NS_TEST_EXPECT_MSG_EQ (flow->second.lostPackets, lost,
+                         "Wrong number of lost packets at " << Simulator::Now ().GetSeconds () << "s");
+  NS_TEST_EXPECT_MSG_EQ (flow->second.rxPackets, 1, "Wrong number of received packets");
+}
+
+void
+FlowMonitorLossTestCase::DoRun (void)
+{
+  // Packet 0 is forwarded in later slots, so that the wheel holds
+  // stale entries for it; packet 1 is forwarded until it is almost
+  // lost; packet 2 is received; packet 3 is received after it was
+  // counted as lost.
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorLossTestCase::Tx, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorLossTestCase::Tx, this, 1, 1);
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorLossTestCase::Tx, this, 1, 2);
+  Simulator::Schedule (MilliSeconds (100), &FlowMonitorLossTestCase::Tx, this, 1, 3);
+  Simulator::Schedule (MilliSeconds (250), &FlowMonitorLossTestCase::Forward, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (450), &FlowMonitorLossTestCase::Forward, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (300), &FlowMonitorLossTestCase::Rx, this, 1, 2);
+  Simulator::Schedule (MilliSeconds (1050), &FlowMonitorLossTestCase::Forward, this, 1, 1);
+  Simulator::Schedule (MilliSeconds (1000), &FlowMonitorLossTestCase::Check, this, 0);
+  Simulator::Schedule (MilliSeconds (1200), &FlowMonitorLossTestCase::Check, this, 1);
+  Simulator::Schedule (MilliSeconds (1300), &FlowMonitorLossTestCase::Check, this, 1);
+  Simulator::Schedule (MilliSeconds (1460), &FlowMonitorLossTestCase::Check, this, 2);
+  Simulator::Schedule (MilliSeconds (1500), &FlowMonitorLossTestCase::Check, this, 2);
+  Simulator::Schedule (MilliSeconds (1600), &FlowMonitorLossTestCase::Rx, this, 1, 3);
+  Simulator::Schedule (MilliSeconds (2000), &FlowMonitorLossTestCase::Check, this, 2);
+  Simulator::Schedule (MilliSeconds (2400), &FlowMonitorLossTestCase::Check, this, 3);
+  Simulator::Schedule (MilliSeconds (5000), &FlowMonitorLossTestCase::Check, this, 3);
+  Simulator::Stop (Seconds (6));
+  Simulator::Run ();
+}
+
+/**
+ * \ingroup flow-monitor
+ * \ingroup tests
+ *
+ * FlowMonitor test suite
+ */
+static class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ()
+    : TestSuite ("flow-monitor", UNIT)
+  {
+    AddTestCase (new FlowMonitorDeltaTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowMonitorBinaryTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowMonitorLossTestCase (), TestCase::QUICK);
+  }
+} g_flowMonitorTestSuite;
@@ -82,6 +82,9 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * Only the routes of the nodes whose shortest path tree reached a
+   * changed Link State Advertisement are recomputed, the other nodes
+   * keep their routes.
    */
   static void RecomputeRoutingTables (void);
 private:
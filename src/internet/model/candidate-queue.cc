@@ -51,22 +51,25 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::IsBefore);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_index (),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -94,11 +97,13 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  uint32_t i = m_candidates.size ();
+  Candidate c;
+  c.vertex = vNew;
+  c.sequence = m_sequence++;
+  c.index = m_index.insert (std::make_pair (vNew->GetVertexId (), i));
+  m_candidates.push_back (c);
+  SiftUp (i);
 }
 
 SPFVertex *
@@ -110,9 +115,16 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
-  return v;
+  Candidate top = m_candidates.front ();
+  m_index.erase (top.index);
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
+  return top.vertex;
 }
 
 SPFVertex *
@@ -124,7 +136,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().vertex;
 }
 
 bool
@@ -145,18 +157,12 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  CandidateIndex_t::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return m_candidates[i->second].vertex;
 }
 
 void
@@ -164,11 +170,97 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  for (uint32_t i = m_candidates.size () / 2; i > 0; i--)
+    {
+      SiftDown (i - 1);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Reorder (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  std::pair<CandidateIndex_t::iterator, CandidateIndex_t::iterator> range =
+    m_index.equal_range (v->GetVertexId ());
+  for (CandidateIndex_t::iterator i = range.first; i != range.second; ++i)
+    {
+      if (m_candidates[i->second].vertex == v)
+        {
+          uint32_t pos = i->second;
+          m_candidates[pos].sequence = m_sequence++;
+          SiftUp (pos);
+          SiftDown (i->second);
+          NS_LOG_LOGIC ("After reordering the CandidateQueue");
+          NS_LOG_LOGIC (*this);
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Vertex " << v->GetVertexId () << " not in the CandidateQueue");
+}
+
+void
+CandidateQueue::Place (uint32_t i, const Candidate &c)
+{
+  m_candidates[i] = c;
+  c.index->second = i;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  while (i > 0)
+    {
+      uint32_t parent = (i - 1) / 2;
+      if (!IsBefore (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (i, m_candidates[parent]);
+      i = parent;
+    }
+  Place (i, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  uint32_t n = m_candidates.size ();
+  while (2 * i + 1 < n)
+    {
+      uint32_t child = 2 * i + 1;
+      if (child + 1 < n && IsBefore (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!IsBefore (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (i, m_candidates[child]);
+      i = child;
+    }
+  Place (i, c);
+}
+
+bool
+CandidateQueue::IsBefore (const Candidate &c1, const Candidate &c2)
+{
+  if (CompareSPFVertex (c1.vertex, c2.vertex))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (c2.vertex, c1.vertex))
+    {
+      return false;
+    }
+  return c1.sequence < c2.sequence;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -47,6 +48,11 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The queue is a binary heap, indexed by vertex ID for Find ().  The
+ * vertices with the same distance and type are popped in the order they
+ * were pushed, or reordered with Reorder (SPFVertex*), as they were when
+ * the queue was a sorted list.
  */
 class CandidateQueue
 {
@@ -154,6 +160,18 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Reorders the Candidate Queue after the distance of one vertex
+ * decreased.
+ *
+ * This is equivalent to Reorder (), in logarithmic time instead of linear
+ * time: the vertex moves after the vertices of the same distance and type.
+ *
+ * @see SPFVertex
+ * @param v The vertex, which is in the queue.
+ */
+  void Reorder (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -184,8 +202,44 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  typedef std::multimap<Ipv4Address, uint32_t> CandidateIndex_t; //!< positions in the heap, by vertex ID
+
+  /** An entry of the heap. */
+  struct Candidate
+  {
+    SPFVertex *vertex;                  //!< The vertex.
+    uint32_t sequence;                  //!< When the vertex was pushed or reordered.
+    CandidateIndex_t::iterator index;   //!< The position of the vertex in m_index.
+  };
+
+  /**
+   * \param c1 first operand
+   * \param c2 second operand
+   * \return True if c1 should be popped before c2, the earliest pushed
+   *         first among the equivalent vertices.
+   */
+  static bool IsBefore (const Candidate &c1, const Candidate &c2);
+  /**
+   * \brief Move an entry of the heap up to its place.
+   * \param i The position of the entry.
+   */
+  void SiftUp (uint32_t i);
+  /**
+   * \brief Move an entry of the heap down to its place.
+   * \param i The position of the entry.
+   */
+  void SiftDown (uint32_t i);
+  /**
+   * \brief Put an entry of the heap at a position.
+   * \param i The position.
+   * \param c The entry.
+   */
+  void Place (uint32_t i, const Candidate &c);
+
+  typedef std::vector<Candidate> CandidateList_t; //!< container of SPFVertex pointers
+  CandidateList_t m_candidates;  //!< SPFVertex candidates, as a binary heap
+  CandidateIndex_t m_index;      //!< The positions of the candidates, by vertex ID
+  uint32_t m_sequence;           //!< The sequence of the next vertex pushed or reordered
 
   /**
    * \brief Stream insertion operator.
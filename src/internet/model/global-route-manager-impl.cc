@@ -26,10 +26,17 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <iterator>
 #include <iostream>
+#ifdef NS3_MTP
+#include <thread>
+#endif
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/system-thread.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
@@ -44,6 +51,18 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * The largest number of threads computing the routes of the nodes.
+ */
+static GlobalValue g_globalRoutingThreads
+  ("GlobalRoutingThreads",
+   "The largest number of threads computing the routes of different nodes, "
+   "0 for one per processor.  Without --enable-mtp, the routes are always "
+   "computed by the calling thread.",
+   UintegerValue (0),
+   MakeUintegerChecker<uint32_t> ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -470,7 +489,33 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     } 
   else
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      std::pair<LSDBMap_t::iterator, bool> inserted = m_database.insert (LSDBPair_t (addr, lsa));
+      if (!inserted.second)
+        {
+          return;
+        }
+//
+// Index the LSA by the link data of its transit link records.  When several
+// LSAs have the same link data, GetLSAByLinkData returns the first one in
+// the database.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          LinkDataMap_t::iterator i = m_linkDataIndex.find (lr->GetLinkData ());
+          if (i == m_linkDataIndex.end ())
+            {
+              m_linkDataIndex.insert (std::make_pair (lr->GetLinkData (), inserted.first));
+            }
+          else if (addr < i->second->first)
+            {
+              i->second = inserted.first;
+            }
+        }
     }
 }
 
@@ -495,13 +540,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,24 +553,114 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of its TransitNetwork link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LinkDataMap_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
+      return i->second->second;
+    }
+  return 0;
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB* lsdb = new GlobalRouteManagerLSDB ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsdb->Insert (i->first, new GlobalRoutingLSA (*i->second));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      lsdb->Insert (m_extdatabase[j]->GetLinkStateId (), new GlobalRoutingLSA (*m_extdatabase[j]));
+    }
+  return lsdb;
+}
+
+bool
+GlobalRouteManagerLSDB::IsSameLSA (const GlobalRoutingLSA* lsa1, const GlobalRoutingLSA* lsa2)
+{
+  if (lsa1->GetLSType () != lsa2->GetLSType ()
+      || lsa1->GetLinkStateId () != lsa2->GetLinkStateId ()
+      || lsa1->GetAdvertisingRouter () != lsa2->GetAdvertisingRouter ()
+      || lsa1->GetNetworkLSANetworkMask () != lsa2->GetNetworkLSANetworkMask ()
+      || lsa1->GetNLinkRecords () != lsa2->GetNLinkRecords ()
+      || lsa1->GetNAttachedRouters () != lsa2->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t j = 0; j < lsa1->GetNLinkRecords (); j++)
+    {
+      GlobalRoutingLinkRecord *lr1 = lsa1->GetLinkRecord (j);
+      GlobalRoutingLinkRecord *lr2 = lsa2->GetLinkRecord (j);
+      if (lr1->GetLinkType () != lr2->GetLinkType ()
+          || lr1->GetLinkId () != lr2->GetLinkId ()
+          || lr1->GetLinkData () != lr2->GetLinkData ()
+          || lr1->GetMetric () != lr2->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t j = 0; j < lsa1->GetNAttachedRouters (); j++)
+    {
+      if (lsa1->GetAttachedRouter (j) != lsa2->GetAttachedRouter (j))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+std::vector<Ipv4Address>
+GlobalRouteManagerLSDB::GetChangedLSAs (const GlobalRouteManagerLSDB* lsdb) const
+{
+  NS_LOG_FUNCTION (this << lsdb);
+  std::vector<Ipv4Address> changed;
+  LSDBMap_t::const_iterator i = m_database.begin ();
+  LSDBMap_t::const_iterator j = lsdb->m_database.begin ();
+  while (i != m_database.end () || j != lsdb->m_database.end ())
+    {
+      if (j == lsdb->m_database.end () || (i != m_database.end () && i->first < j->first))
+        {
+          changed.push_back (i->first);
+          i++;
+        }
+      else if (i == m_database.end () || j->first < i->first)
         {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
+          changed.push_back (j->first);
+          j++;
+        }
+      else
+        {
+          if (!IsSameLSA (i->second, j->second))
             {
-              return temp;
+              changed.push_back (i->first);
             }
+          i++;
+          j++;
         }
     }
-  return 0;
+  return changed;
+}
+
+bool
+GlobalRouteManagerLSDB::HasSameExtLSAs (const GlobalRouteManagerLSDB* lsdb) const
+{
+  NS_LOG_FUNCTION (this << lsdb);
+  if (m_extdatabase.size () != lsdb->m_extdatabase.size ())
+    {
+      return false;
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      if (!IsSameLSA (m_extdatabase[j], lsdb->m_extdatabase[j]))
+        {
+          return false;
+        }
+    }
+  return true;
 }
 
 // ---------------------------------------------------------------------------
@@ -539,7 +671,9 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_nBuiltTrees (0),
+    m_nRefreshedTrees (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -548,6 +682,7 @@ GlobalRouteManagerImpl::GlobalRouteManagerImpl ()
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION (this);
+  ClearTrees ();
   if (m_lsdb)
     {
       delete m_lsdb;
@@ -578,20 +713,9 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
         {
           continue;
         }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (router);
     }
+  ClearTrees ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -600,6 +724,25 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
     }
 }
 
+void
+GlobalRouteManagerImpl::DeleteRoutes (Ptr<GlobalRouter> router)
+{
+  NS_LOG_FUNCTION (router);
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from router " << router->GetRouterId ());
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from router " << router->GetRouterId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from router "<< router->GetRouterId ());
+}
+
 //
 // In order to build the routing database, we need to walk the list of nodes
 // in the system and look for those that support the GlobalRouter interface.
@@ -700,6 +843,10 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // Walk the list of nodes in the system.
 //
   NS_LOG_INFO ("About to start SPF calculation");
+  FindRouters ();
+  ClearTrees ();
+  m_nRefreshedTrees = 0;
+  std::vector<Ipv4Address> roots;
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -711,23 +858,455 @@ GlobalRouteManagerImpl::InitializeRoutes ()
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
-        {
-          continue;
-        }
+      uint32_t systemId = MpiInterface::GetSystemId ();
+      // Ignore nodes that are not assigned to our systemId (distributed sim)
+      if (node->GetSystemId () != systemId) 
+        {
+          continue;
+        }
+
+//
+// if the node has a global router interface, then run the global routing
+// algorithms.
+//
+      if (rtr && rtr->GetNumLSAs () )
+        {
+          roots.push_back (rtr->GetRouterId ());
+        }
+    }
+  SPFCalculate (roots);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+//
+// The SPF tree of a node only changes when a link which was one of its
+// branches vanished, or when a new or cheaper link gives a path at most as
+// long as the ones of the tree.  The other trees are kept: their routes only
+// change if they reach a changed LSA, whose host, transit or stub networks
+// may have changed, and then they are added again from the tree, without
+// running the calculation.
+//
+void
+GlobalRouteManagerImpl::RecomputeGlobalRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB* previous = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  SPFChanges changes;
+  changes.lsas = m_lsdb->GetChangedLSAs (previous);
+  bool externalChanged = !m_lsdb->HasSameExtLSAs (previous);
+  GetLinkChanges (previous, changes);
+  delete previous;
+  NS_LOG_LOGIC (changes.lsas.size () << " changed LSAs, " << changes.removed.size () << " links removed, " <<
+                changes.added.size () << " links added, external LSAs changed: " << externalChanged);
+
+  FindRouters ();
+  m_nRefreshedTrees = 0;
+  std::vector<Ipv4Address> roots;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
+        }
+      SPFTreeMap_t::iterator tree = m_trees.find (rtr->GetRouterId ());
+      if (tree != m_trees.end () && !externalChanged && !IsTreeChanged (tree->second, changes))
+        {
+          bool reached = false;
+          for (uint32_t j = 0; j < changes.lsas.size () && !reached; j++)
+            {
+              reached = tree->second->Find (changes.lsas[j]) != 0;
+            }
+          if (reached)
+            {
+              NS_LOG_LOGIC ("Adding the routes of node " << node->GetId () << " from its tree");
+              DeleteRoutes (rtr);
+              SPFRefreshRoutes (tree->first, tree->second);
+              m_nRefreshedTrees++;
+            }
+          else
+            {
+              NS_LOG_LOGIC ("Keeping the routes of node " << node->GetId ());
+            }
+          continue;
+        }
+      if (tree != m_trees.end ())
+        {
+          delete tree->second;
+          m_trees.erase (tree);
+        }
+      DeleteRoutes (rtr);
+      // Ignore nodes that are not assigned to our systemId (distributed sim)
+      if (node->GetSystemId () == MpiInterface::GetSystemId () && rtr->GetNumLSAs ())
+        {
+          roots.push_back (rtr->GetRouterId ());
+        }
+    }
+  NS_LOG_INFO ("Recomputing the trees of " << roots.size () << " nodes, and the routes of " <<
+               m_nRefreshedTrees << " other nodes");
+  SPFCalculate (roots);
+}
+
+void
+GlobalRouteManagerImpl::GetLinks (const GlobalRouteManagerLSDB* lsdb, const GlobalRoutingLSA* lsa,
+                                  std::vector<SPFLink> &links)
+{
+  links.clear ();
+  if (lsa == 0)
+    {
+      return;
+    }
+  SPFLink link;
+  link.from = lsa->GetLinkStateId ();
+  if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+    {
+      link.metric = 0;
+      // The attached routers are given by the address of their interface
+      for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+        {
+          GlobalRoutingLSA* router = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (i));
+          if (router != 0)
+            {
+              link.to = router->GetLinkStateId ();
+              links.push_back (link);
+            }
+        }
+      return;
+    }
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+          || l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+        {
+          link.to = l->GetLinkId ();
+          link.data = l->GetLinkData ();
+          link.metric = l->GetMetric ();
+          links.push_back (link);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::GetLinkChanges (const GlobalRouteManagerLSDB* previous, SPFChanges &changes) const
+{
+  NS_LOG_FUNCTION (this << previous);
+  std::vector<SPFLink> before;
+  std::vector<SPFLink> after;
+  std::vector<SPFLink> back;
+  for (uint32_t i = 0; i < changes.lsas.size (); i++)
+    {
+      Ipv4Address id = changes.lsas[i];
+      GlobalRoutingLSA* lsaBefore = previous->GetLSA (id);
+      GlobalRoutingLSA* lsaAfter = m_lsdb->GetLSA (id);
+      if (lsaAfter == 0)
+        {
+          changes.dropped.push_back (id);
+        }
+      GetLinks (previous, lsaBefore, before);
+      GetLinks (m_lsdb, lsaAfter, after);
+      if (before == after)
+        {
+          // Only the stub networks or the masks changed
+          continue;
+        }
+      std::sort (before.begin (), before.end ());
+      std::sort (after.begin (), after.end ());
+      uint32_t nRemoved = changes.removed.size ();
+      uint32_t nAdded = changes.added.size ();
+      std::set_difference (before.begin (), before.end (), after.begin (), after.end (),
+                           std::back_inserter (changes.removed));
+      std::set_difference (after.begin (), after.end (), before.begin (), before.end (),
+                           std::back_inserter (changes.added));
+      if (changes.removed.size () == nRemoved && changes.added.size () == nAdded)
+        {
+          // Same links, in another order: the ties may be broken differently
+          changes.dropped.push_back (id);
+        }
+//
+// The links back to this LSA, which are followed only along with one of its
+// links to the same LSA.
+//
+      uint32_t nLinksRemoved = changes.removed.size ();
+      uint32_t nLinksAdded = changes.added.size ();
+      for (uint32_t j = nRemoved; j < nLinksRemoved; j++)
+        {
+          GetLinks (previous, previous->GetLSA (changes.removed[j].to), back);
+          for (uint32_t k = 0; k < back.size (); k++)
+            {
+              if (back[k].to == id)
+                {
+                  changes.removed.push_back (back[k]);
+                }
+            }
+        }
+      for (uint32_t j = nAdded; j < nLinksAdded; j++)
+        {
+          GetLinks (m_lsdb, m_lsdb->GetLSA (changes.added[j].to), back);
+          for (uint32_t k = 0; k < back.size (); k++)
+            {
+              if (back[k].to == id)
+                {
+                  changes.added.push_back (back[k]);
+                }
+            }
+        }
+    }
+  std::sort (changes.removed.begin (), changes.removed.end ());
+  changes.removed.erase (std::unique (changes.removed.begin (), changes.removed.end ()), changes.removed.end ());
+  std::sort (changes.added.begin (), changes.added.end ());
+  changes.added.erase (std::unique (changes.added.begin (), changes.added.end ()), changes.added.end ());
+}
+
+bool
+GlobalRouteManagerImpl::IsTreeChanged (const SPFTree* tree, const SPFChanges &changes) const
+{
+  NS_LOG_FUNCTION (this << tree);
+  if (tree->vertices.empty ())
+    {
+      // The default route of a stub node goes to its single neighbour
+      for (uint32_t i = 0; i < tree->stub.size (); i++)
+        {
+          if (std::binary_search (changes.lsas.begin (), changes.lsas.end (), tree->stub[i]))
+            {
+              return true;
+            }
+        }
+      return false;
+    }
+  for (uint32_t i = 0; i < changes.dropped.size (); i++)
+    {
+      if (tree->Find (changes.dropped[i]) != 0)
+        {
+          return true;
+        }
+    }
+  // The links of the root also tell whether it is a stub node
+  Ipv4Address root = tree->vertices[0]->GetVertexId ();
+  for (uint32_t i = 0; i < changes.removed.size (); i++)
+    {
+      const SPFLink &link = changes.removed[i];
+      if (link.from == root)
+        {
+          return true;
+        }
+      SPFVertex* to = tree->Find (link.to);
+      if (to == 0)
+        {
+          continue;
+        }
+      SPFVertex* parent;
+      for (uint32_t j = 0; (parent = to->GetParent (j)) != 0; j++)
+        {
+          if (parent->GetVertexId () == link.from)
+            {
+              NS_LOG_LOGIC ("Branch " << link.from << " -> " << link.to << " removed");
+              return true;
+            }
+        }
+    }
+  for (uint32_t i = 0; i < changes.added.size (); i++)
+    {
+      const SPFLink &link = changes.added[i];
+      if (link.from == root)
+        {
+          return true;
+        }
+      SPFVertex* from = tree->Find (link.from);
+      if (from == 0)
+        {
+          continue;
+        }
+      SPFVertex* to = tree->Find (link.to);
+      if (to == 0 || from->GetDistanceFromRoot () + link.metric <= to->GetDistanceFromRoot ())
+        {
+          NS_LOG_LOGIC ("Link " << link.from << " -> " << link.to << " added to the tree");
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerImpl::SPFRefreshRoutes (Ipv4Address root, SPFTree* tree)
+{
+  NS_LOG_FUNCTION (this << root << tree);
+  for (uint32_t i = 0; i < tree->vertices.size (); i++)
+    {
+      SPFVertex* v = tree->vertices[i];
+      v->SetLSA (m_lsdb->GetLSA (v->GetVertexId ()));
+      NS_ASSERT_MSG (v->GetLSA () != 0, "Vertex " << v->GetVertexId () << " of a kept tree has no LSA");
+      v->SetVertexProcessed (false);
+    }
+  SPFSetRoot (tree->vertices[0]);
+  SPFAddRoutes (tree->vertices);
+  m_spfroot = 0;
+  m_spfrootNode = 0;
+  m_spfrootRouting = 0;
+  m_spfrootIpv4 = 0;
+}
+
+void
+GlobalRouteManagerImpl::FindRouters (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_routers.clear ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr != 0)
+        {
+          m_routers.insert (std::make_pair (rtr->GetRouterId (), node));
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculate (const std::vector<Ipv4Address> &roots)
+{
+  NS_LOG_FUNCTION (this << roots.size ());
+  m_nBuiltTrees = roots.size ();
+  uint32_t nThreads = 1;
+#ifdef NS3_MTP
+  UintegerValue maxThreads;
+  g_globalRoutingThreads.GetValue (maxThreads);
+  nThreads = maxThreads.Get () > 0 ? maxThreads.Get () : std::max (1u, std::thread::hardware_concurrency ());
+  nThreads = std::min<uint32_t> (nThreads, roots.size ());
+#endif
+  if (nThreads <= 1)
+    {
+      for (uint32_t i = 0; i < roots.size (); i++)
+        {
+          SPFCalculate (roots[i]);
+        }
+      return;
+    }
+
+//
+// Each thread has its own copy of the LSDB, whose LSAs hold the state of its
+// SPF calculations, and the nodes of all the routers, found by this thread.
+// The roots are interleaved so that the threads get similar loads.
+//
+  NS_LOG_LOGIC ("Running the SPF calculations on " << nThreads << " threads");
+  std::vector<GlobalRouteManagerImpl*> workers;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t t = 0; t < nThreads; t++)
+    {
+      GlobalRouteManagerImpl* worker = new GlobalRouteManagerImpl ();
+      worker->DebugUseLsdb (m_lsdb->Copy ());
+      worker->m_routers = m_routers;
+      for (uint32_t i = t; i < roots.size (); i += nThreads)
+        {
+          worker->m_roots.push_back (roots[i]);
+        }
+      workers.push_back (worker);
+      threads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::SPFCalculateRoots, worker)));
+      threads.back ()->Start ();
+    }
+  for (uint32_t t = 0; t < nThreads; t++)
+    {
+      threads[t]->Join ();
+      GlobalRouteManagerImpl* worker = workers[t];
+      for (SPFTreeMap_t::iterator i = worker->m_trees.begin (); i != worker->m_trees.end (); i++)
+        {
+          RecordTree (i->first, i->second);
+        }
+      worker->m_trees.clear ();
+      delete worker;
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculateRoots (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_roots.size (); i++)
+    {
+      SPFCalculate (m_roots[i]);
+    }
+}
+
+void
+GlobalRouteManagerImpl::RecordTree (Ipv4Address root, SPFTree* tree)
+{
+  NS_LOG_FUNCTION (this << root << tree);
+  SPFTree* &entry = m_trees[root];
+  delete entry;
+  entry = tree;
+}
+
+void
+GlobalRouteManagerImpl::ClearTrees (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (SPFTreeMap_t::iterator i = m_trees.begin (); i != m_trees.end (); i++)
+    {
+      delete i->second;
+    }
+  m_trees.clear ();
+}
+
+GlobalRouteManagerImpl::SPFTree::~SPFTree ()
+{
+  if (!vertices.empty ())
+    {
+      // The root deletes its descendants
+      delete vertices[0];
+    }
+}
+
+SPFVertex*
+GlobalRouteManagerImpl::SPFTree::Find (Ipv4Address id) const
+{
+  std::vector<std::pair<Ipv4Address, SPFVertex*> >::const_iterator i =
+    std::lower_bound (index.begin (), index.end (), std::make_pair (id, (SPFVertex*) 0));
+  if (i != index.end () && i->first == id)
+    {
+      return i->second;
+    }
+  return 0;
+}
+
+bool
+GlobalRouteManagerImpl::SPFLink::operator< (const SPFLink &o) const
+{
+  if (from != o.from)
+    {
+      return from < o.from;
+    }
+  if (to != o.to)
+    {
+      return to < o.to;
+    }
+  if (data != o.data)
+    {
+      return data < o.data;
+    }
+  return metric < o.metric;
+}
+
+bool
+GlobalRouteManagerImpl::SPFLink::operator== (const SPFLink &o) const
+{
+  return from == o.from && to == o.to && data == o.data && metric == o.metric;
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetNBuiltTrees (void) const
+{
+  return m_nBuiltTrees;
+}
 
-//
-// if the node has a global router interface, then run the global routing
-// algorithms.
-//
-      if (rtr && rtr->GetNumLSAs () )
-        {
-          SPFCalculate (rtr->GetRouterId ());
-        }
-    }
-  NS_LOG_INFO ("Finished SPF calculation");
+uint32_t
+GlobalRouteManagerImpl::GetNRefreshedTrees (void) const
+{
+  return m_nRefreshedTrees;
 }
 
 //
@@ -960,7 +1539,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Reorder (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1247,6 +1826,7 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+  FindRouters ();
   SPFCalculate (root);
 }
 
@@ -1320,9 +1900,7 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+                  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
                   NS_ASSERT (gr);
                   gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
                                          FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1365,10 +1943,14 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // This vertex is the root of the SPF tree and it is distance 0 from the root.
 // We also mark this vertex as being in the SPF tree.
 //
-  m_spfroot= v;
+  SPFSetRoot (v);
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+//
+// The tree is kept, to tell which changes of the LSDB modify it.
+//
+  SPFTree* tree = new SPFTree ();
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1380,10 +1962,24 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      GlobalRoutingLSA *rlsa = m_spfroot->GetLSA ();
+      tree->stub.push_back (root);
+      for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
+        {
+          tree->stub.push_back (rlsa->GetLinkRecord (i)->GetLinkId ());
+        }
+      std::sort (tree->stub.begin (), tree->stub.end ());
+      tree->stub.erase (std::unique (tree->stub.begin (), tree->stub.end ()), tree->stub.end ());
+      RecordTree (root, tree);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootNode = 0;
+      m_spfrootRouting = 0;
+      m_spfrootIpv4 = 0;
       return;
     }
 
+  tree->vertices.push_back (v);
   for (;;)
     {
 //
@@ -1424,6 +2020,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
       NS_LOG_LOGIC (candidate);
       v = candidate.Pop ();
       NS_LOG_LOGIC ("Popped vertex " << v->GetVertexId ());
+      tree->vertices.push_back (v);
 //
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
@@ -1442,7 +2039,61 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // vertices must be chosen before router vertices in order to necessarily
 // find all equal-cost paths. 
 //
-// RFC2328 16.1. (4). 
+//
+// RFC2328 16.1. (5). 
+//
+// Iterate the algorithm by returning to Step 2 until there are no more
+// candidate vertices.
+
+    }  // end for loop
+
+  SPFAddRoutes (tree->vertices);
+
+//
+// We're all done setting the routing information for the node at the root of
+// the SPF tree.  Keep the tree, which owns the vertices from now on.  Go
+// possibly do it again for the next router.
+//
+  tree->index.reserve (tree->vertices.size ());
+  for (uint32_t i = 0; i < tree->vertices.size (); i++)
+    {
+      tree->index.push_back (std::make_pair (tree->vertices[i]->GetVertexId (), tree->vertices[i]));
+    }
+  std::sort (tree->index.begin (), tree->index.end ());
+  RecordTree (root, tree);
+  m_spfroot = 0;
+  m_spfrootNode = 0;
+  m_spfrootRouting = 0;
+  m_spfrootIpv4 = 0;
+}
+
+void
+GlobalRouteManagerImpl::SPFSetRoot (SPFVertex* root)
+{
+  NS_LOG_FUNCTION (this << root);
+  m_spfroot = root;
+//
+// Find the node at the root of the tree, to which the routes are added.
+//
+  RouterMap_t::const_iterator router = m_routers.find (root->GetVertexId ());
+  if (router != m_routers.end ())
+    {
+      m_spfrootNode = router->second;
+      m_spfrootRouting = m_spfrootNode->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      m_spfrootIpv4 = m_spfrootNode->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (m_spfrootIpv4, 
+                     "GlobalRouteManagerImpl::SPFSetRoot (): "
+                     "GetObject for <Ipv4> interface failed");
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFAddRoutes (const std::vector<SPFVertex*> &vertices)
+{
+  NS_LOG_FUNCTION (this << vertices.size ());
+  for (uint32_t i = 1; i < vertices.size (); i++)
+    {
+      SPFVertex* v = vertices[i];
 //
 // This is the method that actually adds the routes.  It'll walk the list
 // of nodes in the system, looking for the node corresponding to the router
@@ -1451,8 +2102,9 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // we are only actually adding routes to that one node at the root of the SPF 
 // tree.
 //
-// We're going to pop of a pointer to every vertex in the tree except the 
-// root in order of distance from the root.  For each of the vertices, we call
+// We're going to walk every vertex in the tree except the root, in the
+// order they were popped, by distance from the root.  For each of the
+// router vertices, we call
 // SPFIntraAddRouter ().  Down in SPFIntraAddRouter, we look at all of the 
 // point-to-point Global Router Link Records (the links to nodes adjacent to
 // the node represented by the vertex).  We add a route to the IP address 
@@ -1477,13 +2129,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
         {
           NS_ASSERT_MSG (0, "illegal SPFVertex type");
         }
-//
-// RFC2328 16.1. (5). 
-//
-// Iterate the algorithm by returning to Step 2 until there are no more
-// candidate vertices.
-
-    }  // end for loop
+    }
 
 // Second stage of SPF calculation procedure
   SPFProcessStubs (m_spfroot);
@@ -1494,14 +2140,6 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
       NS_LOG_LOGIC ("Processing External LSA with id " << extlsa->GetLinkStateId ());
       ProcessASExternals (m_spfroot, extlsa);
     }
-
-//
-// We're all done setting the routing information for the node at the root of
-// the SPF tree.  Delete all of the vertices and corresponding resources.  Go
-// possibly do it again for the next router.
-//
-  delete m_spfroot;
-  m_spfroot = 0;
 }
 
 void
@@ -1555,63 +2193,30 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
     }
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
-
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The root of the Shortest Path First tree is the router to which we are 
+// going to write the actual routing table entries.  Its node was found when
+// the calculation started, if it has one.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << m_spfroot->GetVertexId ());
+      return;
+    }
+  Ptr<Node> node = m_spfrootNode;
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1626,39 +2231,30 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1720,69 +2316,28 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
   NS_LOG_LOGIC ("Stub is on remote host: " << v->GetVertexId () << "; installing");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// going to write the actual routing table entries.  Its node was found when
+// the calculation started, if it has one.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << m_spfroot->GetVertexId ());
+      return;
+    }
+  Ptr<Node> node = m_spfrootNode;
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1796,40 +2351,30 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1846,68 +2391,33 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
 // We have an IP address <a> and a vertex ID of the root of the SPF tree.
 // The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
+// The node corresponding to the vertex ID was found when the calculation
+// started; we look through the Ipv4 interfaces of that node for the one
+// corresponding to the address in question.
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
 //
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
+// Couldn't find it.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << m_spfroot->GetVertexId ());
+      return -1;
+    }
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+  int32_t interface = m_spfrootIpv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1935,69 +2445,29 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// going to write the actual routing table entries.  Its node was found when
+// the calculation started, if it has one.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << m_spfroot->GetVertexId ());
+      return;
+    }
+  Ptr<Node> node = m_spfrootNode;
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2476,19 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << node->GetId () <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,44 +2502,31 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 void
@@ -2080,104 +2538,56 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+// going to write the actual routing table entries.  Its node was found when
+// the calculation started, if it has one.
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  if (m_spfrootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << m_spfroot->GetVertexId ());
+      return;
+    }
+  Ptr<Node> node = m_spfrootNode;
+  NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  Ptr<Ipv4GlobalRouting> gr = m_spfrootRouting;
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -38,6 +38,7 @@ const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
 class Ipv4GlobalRouting;
+class Ipv4;
 
 /**
  * \ingroup globalrouting
@@ -674,12 +675,54 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Copy the Link State Database.
+   *
+   * The copy holds copies of the Link State Advertisements, so that it can
+   * be used in a SPF computation while another one uses this database.
+   *
+   * @returns A new Link State Database, owned by the caller.
+   */
+  GlobalRouteManagerLSDB* Copy () const;
+
+  /**
+   * @brief Compare the Link State Advertisements with the ones of another
+   * database.
+   *
+   * The status flags of the Link State Advertisements are not compared.
+   *
+   * @param lsdb The other database.
+   * @returns The link state IDs, in increasing order, of the Link State
+   * Advertisements which are in only one of the databases or which differ.
+   */
+  std::vector<Ipv4Address> GetChangedLSAs (const GlobalRouteManagerLSDB* lsdb) const;
+
+  /**
+   * @brief Compare the External Link State Advertisements with the ones of
+   * another database.
+   *
+   * @param lsdb The other database.
+   * @returns true if both databases hold the same External Link State
+   * Advertisements, in the same order.
+   */
+  bool HasSameExtLSAs (const GlobalRouteManagerLSDB* lsdb) const;
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
 
+  /**
+   * @brief Compare two Link State Advertisements, except their status flags.
+   * @param lsa1 first operand
+   * @param lsa2 second operand
+   * @returns true if the Link State Advertisements are the same
+   */
+  static bool IsSameLSA (const GlobalRoutingLSA* lsa1, const GlobalRoutingLSA* lsa2);
+
+  typedef std::map<Ipv4Address, LSDBMap_t::iterator> LinkDataMap_t; //!< container of IPv4 addresses / database entries
+
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LinkDataMap_t m_linkDataIndex; //!< Router LSAs, by the link data of their TransitNetwork link records
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -735,6 +778,34 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and recompute the routes which
+ * depend on the changed Link State Advertisements.
+ *
+ * This is equivalent to DeleteGlobalRoutes (), BuildGlobalRoutingDatabase ()
+ * and InitializeRoutes (), but the shortest path tree of each node, built
+ * during the previous call to this method or to InitializeRoutes (), is
+ * only built again when a changed link was one of its branches, or could
+ * make one of its paths shorter.  A node whose tree is kept but reaches a
+ * changed Link State Advertisement gets its host, transit and stub routes
+ * again from that tree; the other nodes keep their routes.
+ */
+  virtual void RecomputeGlobalRoutes ();
+
+/**
+ * @brief Get the number of shortest path trees built by the last call to
+ * InitializeRoutes () or RecomputeGlobalRoutes ().
+ * @returns the number of trees built
+ */
+  uint32_t GetNBuiltTrees (void) const;
+
+/**
+ * @brief Get the number of nodes whose routes were added again from their
+ * kept shortest path tree by the last call to RecomputeGlobalRoutes ().
+ * @returns the number of trees reused
+ */
+  uint32_t GetNRefreshedTrees (void) const;
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -767,8 +838,178 @@ private:
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
   SPFVertex* m_spfroot; //!< the root node
+  Ptr<Node> m_spfrootNode; //!< the node of the root, if any
+  Ptr<Ipv4GlobalRouting> m_spfrootRouting; //!< the routing protocol to which the routes of the root are added
+  Ptr<Ipv4> m_spfrootIpv4; //!< the IPv4 stack of the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
 
+  typedef std::map<Ipv4Address, Ptr<Node> > RouterMap_t; //!< nodes by router ID
+  RouterMap_t m_routers; //!< the nodes of the global routers, by router ID
+
+  /**
+   * \brief The shortest path first (SPF) tree of a root, kept after the
+   * calculation to tell which changes of the LSDB modify it.
+   */
+  struct SPFTree
+  {
+    /** \brief Delete the vertices of the tree. */
+    ~SPFTree ();
+    /**
+     * The vertices, in the order they joined the tree, root first, or
+     * nothing for a stub node.  Their LSAs belong to the LSDB of the
+     * calculation, and are set again before the routes are added.
+     */
+    std::vector<SPFVertex*> vertices;
+    /** The vertices, sorted by vertex ID. */
+    std::vector<std::pair<Ipv4Address, SPFVertex*> > index;
+    /** For a stub node, the sorted IDs of its LSA and of its neighbours. */
+    std::vector<Ipv4Address> stub;
+    /**
+     * \param id a vertex ID
+     * \returns the vertex, or 0 if it is not in the tree
+     */
+    SPFVertex* Find (Ipv4Address id) const;
+  };
+
+  /**
+   * \brief A link followed by the SPF calculation, from a router or network
+   * LSA to a router or transit network LSA.
+   */
+  struct SPFLink
+  {
+    Ipv4Address from; //!< the link state ID of the LSA holding the link
+    Ipv4Address to; //!< the link state ID of the LSA it leads to
+    Ipv4Address data; //!< the link data: the interface address of a router
+    uint32_t metric; //!< the cost of the link
+    /**
+     * \param o the other link
+     * \returns true if this link sorts before o
+     */
+    bool operator< (const SPFLink &o) const;
+    /**
+     * \param o the other link
+     * \returns true if the links are the same
+     */
+    bool operator== (const SPFLink &o) const;
+  };
+
+  /**
+   * \brief The changes of the LSDB since the SPF trees were built.
+   */
+  struct SPFChanges
+  {
+    std::vector<Ipv4Address> lsas; //!< the changed LSAs, sorted
+    std::vector<Ipv4Address> dropped; //!< the LSAs which vanished, or whose links were reordered
+    std::vector<SPFLink> removed; //!< the links which vanished, or lost their way back
+    std::vector<SPFLink> added; //!< the links which appeared, or found their way back
+  };
+
+  typedef std::map<Ipv4Address, SPFTree*> SPFTreeMap_t; //!< SPF trees by router ID
+  SPFTreeMap_t m_trees; //!< the SPF tree of each router, by router ID
+  uint32_t m_nBuiltTrees; //!< the number of trees built by the last computation
+  uint32_t m_nRefreshedTrees; //!< the number of trees reused by the last computation
+  std::vector<Ipv4Address> m_roots; //!< the roots of the SPF calculations of a worker thread
+
+  /**
+   * \brief Index the nodes of the global routers by router ID, for the SPF
+   * calculations.
+   */
+  void FindRouters (void);
+
+  /**
+   * \brief Calculate the shortest path first (SPF) trees of several roots.
+   *
+   * The calculations are shared between threads, each with its own copy of
+   * the LSDB, when ns-3 is configured with --enable-mtp; see the
+   * GlobalRoutingThreads global value.  Each thread adds routes to the
+   * nodes of its roots only.
+   *
+   * \param roots the root nodes
+   */
+  void SPFCalculate (const std::vector<Ipv4Address> &roots);
+
+  /**
+   * \brief Calculate the shortest path first (SPF) trees of m_roots.
+   *
+   * This is the body of the worker threads of SPFCalculate.
+   */
+  void SPFCalculateRoots (void);
+
+  /**
+   * \brief Keep the SPF tree of a root, instead of the previous one.
+   * \param root the root node
+   * \param tree the tree, owned by this object from now on
+   */
+  void RecordTree (Ipv4Address root, SPFTree* tree);
+
+  /**
+   * \brief Delete all the SPF trees kept.
+   */
+  void ClearTrees (void);
+
+  /**
+   * \brief Get the links which the SPF calculation follows from an LSA.
+   * \param lsdb the database holding the LSA
+   * \param lsa the LSA, or 0
+   * \param links the links, in the order of the LSA
+   */
+  static void GetLinks (const GlobalRouteManagerLSDB* lsdb, const GlobalRoutingLSA* lsa,
+                        std::vector<SPFLink> &links);
+
+  /**
+   * \brief Find the links which changed between two LSDBs.
+   *
+   * A link also changes when the reverse link appears or vanishes, since
+   * the SPF calculation only follows the links which have a way back.
+   *
+   * \param previous the LSDB before the change
+   * \param changes the changes, whose lsas are set; the other fields are set
+   */
+  void GetLinkChanges (const GlobalRouteManagerLSDB* previous, SPFChanges &changes) const;
+
+  /**
+   * \brief Test if changes of the LSDB modify an SPF tree.
+   *
+   * The tree changes if a removed link was one of its branches, or if an
+   * added link makes one of its vertices, or a new one, at most as far
+   * from the root as before, equal cost paths included.  It is also built
+   * again when the links of the root change, since they decide whether the
+   * root is a stub node, and when the links of one of its vertices were
+   * only reordered, since the ties may then be broken differently.
+   *
+   * \param tree the tree
+   * \param changes the changes of the LSDB
+   * \returns true if the tree must be built again
+   */
+  bool IsTreeChanged (const SPFTree* tree, const SPFChanges &changes) const;
+
+  /**
+   * \brief Add again the routes of a root from its SPF tree, with the LSAs
+   * of the current LSDB.
+   * \param root the root node
+   * \param tree the tree of the root, which did not change
+   */
+  void SPFRefreshRoutes (Ipv4Address root, SPFTree* tree);
+
+  /**
+   * \brief Add the routes of the SPF tree rooted at m_spfroot.
+   * \param vertices the vertices of the tree, in the order they joined it
+   */
+  void SPFAddRoutes (const std::vector<SPFVertex*> &vertices);
+
+  /**
+   * \brief Set m_spfroot and find the node of the root, to which the routes
+   * are added.
+   * \param root the root vertex
+   */
+  void SPFSetRoot (SPFVertex* root);
+
+  /**
+   * \brief Delete the routes added to a global router.
+   * \param router the global router
+   */
+  static void DeleteRoutes (Ptr<GlobalRouter> router);
+
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
    *
@@ -64,6 +64,12 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the per-node forwarding
+ * tables whose shortest path tree saw a change since the last computation.
+ */
+  static void RecomputeGlobalRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
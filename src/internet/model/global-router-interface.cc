@@ -261,15 +261,9 @@ GlobalRoutingLinkRecord *
 GlobalRoutingLSA::GetLinkRecord (uint32_t n) const
 {
   NS_LOG_FUNCTION (this << n);
-  uint32_t j = 0;
-  for ( ListOfLinkRecords_t::const_iterator i = m_linkRecords.begin ();
-        i != m_linkRecords.end (); 
-        i++, j++)
+  if (n < m_linkRecords.size ())
     {
-      if (j == n) 
-        {
-          return *i;
-        }
+      return m_linkRecords[n];
     }
   NS_ASSERT_MSG (false, "GlobalRoutingLSA::GetLinkRecord (): invalid index");
   return 0;
@@ -364,15 +358,9 @@ Ipv4Address
 GlobalRoutingLSA::GetAttachedRouter (uint32_t n) const
 {
   NS_LOG_FUNCTION (this << n);
-  uint32_t j = 0;
-  for ( ListOfAttachedRouters_t::const_iterator i = m_attachedRouters.begin ();
-        i != m_attachedRouters.end (); 
-        i++, j++)
+  if (n < m_attachedRouters.size ())
     {
-      if (j == n) 
-        {
-          return *i;
-        }
+      return m_attachedRouters[n];
     }
   NS_ASSERT_MSG (false, "GlobalRoutingLSA::GetAttachedRouter (): invalid index");
   return Ipv4Address ("0.0.0.0");
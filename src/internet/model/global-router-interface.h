@@ -24,6 +24,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/node.h"
@@ -521,14 +522,14 @@ private:
 /**
  * A convenience typedef to avoid too much writers cramp.
  */
-  typedef std::list<GlobalRoutingLinkRecord*> ListOfLinkRecords_t;
+  typedef std::vector<GlobalRoutingLinkRecord*> ListOfLinkRecords_t;
 
 /**
  * Each Link State Advertisement contains a number of Link Records that
  * describe the kinds of links that are attached to a given node.  We 
  * consider PointToPoint and StubNetwork links.
  *
- * m_linkRecords is an STL list container to hold the Link Records that have
+ * m_linkRecords is an STL vector container to hold the Link Records that have
  * been discovered and prepared for the advertisement.
  *
  * @see GlobalRouting::DiscoverLSAs ()
@@ -543,12 +544,12 @@ private:
 /**
  * A convenience typedef to avoid too much writers cramp.
  */
-  typedef std::list<Ipv4Address> ListOfAttachedRouters_t;
+  typedef std::vector<Ipv4Address> ListOfAttachedRouters_t;
 
 /**
  * Each Network LSA contains a list of attached routers
  *
- * m_attachedRouters is an STL list container to hold the addresses that have
+ * m_attachedRouters is an STL vector container to hold the addresses that have
  * been discovered and prepared for the advertisement.
  *
  * @see GlobalRouting::DiscoverLSAs ()
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
@@ -29,7 +30,9 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_nEphemeralInUse (0),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -40,38 +43,103 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_index.clear ();
+  m_locals.clear ();
+  m_ports.clear ();
+}
+
+Ipv4EndPointDemux::Key
+Ipv4EndPointDemux::MakeKey (Ipv4Address localAddr, uint16_t localPort,
+                            Ipv4Address peerAddr, uint16_t peerPort)
+{
+  Key key;
+  key.localAddr = localAddr.Get ();
+  key.peerAddr = peerAddr.Get ();
+  key.localPort = localPort;
+  key.peerPort = peerPort;
+  return key;
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::IsAllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  return a->m_sequence < b->m_sequence;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_sequence = m_sequence++;
+  endPoint->m_position = m_endPoints.insert (m_endPoints.end (), endPoint);
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Bucket &bucket = m_index[MakeKey (endPoint->m_localAddr, endPoint->m_localPort,
+                                    endPoint->m_peerAddr, endPoint->m_peerPort)];
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), endPoint, &IsAllocatedBefore),
+                 endPoint);
+  m_locals[MakeKey (endPoint->m_localAddr, endPoint->m_localPort, Ipv4Address::GetAny (), 0)]++;
+  Bucket &port = m_ports[endPoint->m_localPort];
+  if (port.empty ())
     {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
+      SetEphemeralInUse (endPoint->m_localPort, true);
     }
-  return false;
+  port.insert (std::upper_bound (port.begin (), port.end (), endPoint, &IsAllocatedBefore),
+               endPoint);
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::unordered_map<Key, Bucket, KeyHash>::iterator i =
+    m_index.find (MakeKey (endPoint->m_localAddr, endPoint->m_localPort,
+                           endPoint->m_peerAddr, endPoint->m_peerPort));
+  NS_ASSERT (i != m_index.end ());
+  i->second.erase (std::find (i->second.begin (), i->second.end (), endPoint));
+  if (i->second.empty ())
+    {
+      m_index.erase (i);
+    }
+  std::unordered_map<Key, uint32_t, KeyHash>::iterator local =
+    m_locals.find (MakeKey (endPoint->m_localAddr, endPoint->m_localPort, Ipv4Address::GetAny (), 0));
+  if (--local->second == 0)
+    {
+      m_locals.erase (local);
+    }
+  std::unordered_map<uint16_t, Bucket>::iterator port = m_ports.find (endPoint->m_localPort);
+  port->second.erase (std::find (port->second.begin (), port->second.end (), endPoint));
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+      SetEphemeralInUse (endPoint->m_localPort, false);
+    }
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_locals.find (MakeKey (addr, port, Ipv4Address::GetAny (), 0)) != m_locals.end ();
 }
 
 Ipv4EndPoint *
@@ -84,10 +152,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -100,10 +165,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -123,10 +185,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -134,40 +193,30 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (m_index.find (MakeKey (localAddress, localPort, peerAddress, peerPort)) != m_index.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      NS_LOG_WARN ("End point " << endPoint << " not allocated by this demux.");
+      return;
     }
+  Unindex (endPoint);
+  m_endPoints.erase (endPoint->m_position);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -188,134 +237,99 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
 }
 
 
-/*
- * If we have an exact match, we return it.
- * Otherwise, if we find a generic match, we return it.
- * Otherwise, we return 0.
- */
-Ipv4EndPointDemux::EndPoints
-Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
-                           Ipv4Address saddr, uint16_t sport,
-                           Ptr<Ipv4Interface> incomingInterface)
+void
+Ipv4EndPointDemux::LookupKey (const Key &key, Ptr<Ipv4Interface> incomingInterface,
+                              std::vector<Ipv4EndPoint *> &endPoints)
 {
-  NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
-
-  EndPoints retval1; // Matches exact on local port, wildcards on others
-  EndPoints retval2; // Matches exact on local port/adder, wildcards on others
-  EndPoints retval3; // Matches all but local address
-  EndPoints retval4; // Exact match on all 4
-
-  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<Key, Bucket, KeyHash>::const_iterator i = m_index.find (key);
+  if (i == m_index.end ())
     {
-      Ipv4EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-
+      return;
+    }
+  for (Bucket::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+    {
+      Ipv4EndPoint* endP = *j;
       if (!endP->IsRxEnabled ())
         {
           NS_LOG_LOGIC ("Skipping endpoint " << &endP
                         << " because endpoint can not receive packets");
           continue;
         }
-
-      if (endP->GetLocalPort () != dport)
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
       if (endP->GetBoundNetDevice ())
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          if (!incomingInterface || endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
             {
               NS_LOG_LOGIC ("Skipping endpoint " << &endP
                                                  << " because endpoint is bound to specific device and "
                                                  << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
+                                                 << " does not match packet device");
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-      bool localAddressMatchesWildCard =
-        endP->GetLocalAddress () == Ipv4Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+      endPoints.push_back (endP);
+    }
+}
 
-      if (isBroadcast)
-        {
-          NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
-        }
+/*
+ * If we have an exact match, we return it.
+ * Otherwise, if we find a generic match, we return it.
+ * Otherwise, we return 0.
+ *
+ * Each kind of match is a four-tuple where the fields which are not
+ * matched exactly are wildcards, so it is a single probe of the index.
+ */
+Ipv4EndPointDemux::EndPoints
+Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
+                           Ipv4Address saddr, uint16_t sport,
+                           Ptr<Ipv4Interface> incomingInterface)
+{
+  NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
 
-      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; incomingInterface && i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
         {
-          localAddressMatchesExact = (endP->GetLocalAddress () ==
-                                      incomingInterfaceAddr);
-        }
-      // if no match here, keep looking
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        continue;
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-        Ipv4Address::GetAny ();
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      // Now figure out which return list to add this one to
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port and local address matches exactly
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All but local address
-          retval3.push_back (endP);
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
         }
-      if (localAddressMatchesExact &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All 4 match
-          retval4.push_back (endP);
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+  // Broadcasts match the endpoints bound to the incoming interface address
+  Ipv4Address localAddr = isBroadcast ? incomingInterfaceAddr : daddr;
+  Ipv4Address any = Ipv4Address::GetAny ();
+
+  std::vector<Ipv4EndPoint *> found;
+  // Exact match on all 4
+  LookupKey (MakeKey (localAddr, dport, saddr, sport), incomingInterface, found);
+  if (found.empty ())
+    {
+      // Matches all but local address
+      LookupKey (MakeKey (any, dport, saddr, sport), incomingInterface, found);
+    }
+  if (found.empty ())
+    {
+      // Matches exact on local port/adder, wildcards on others
+      LookupKey (MakeKey (localAddr, dport, any, 0), incomingInterface, found);
+      if (isBroadcast)
+        {
+          // along with the wildcard local address, in allocation order
+          std::vector<Ipv4EndPoint *>::size_type exact = found.size ();
+          LookupKey (MakeKey (any, dport, any, 0), incomingInterface, found);
+          std::inplace_merge (found.begin (), found.begin () + exact, found.end (), &IsAllocatedBefore);
         }
     }
-
-  // Here we find the most exact match
-  if (!retval4.empty ()) return retval4;
-  if (!retval3.empty ()) return retval3;
-  if (!retval2.empty ()) return retval2;
-  return retval1;  // might be empty if no matches
+  if (found.empty ())
+    {
+      // Matches exact on local port, wildcards on others
+      LookupKey (MakeKey (any, dport, any, 0), incomingInterface, found);
+    }
+  return EndPoints (found.begin (), found.end ());  // might be empty if no matches
 }
 
 Ipv4EndPoint *
@@ -326,23 +340,25 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  std::unordered_map<Key, Bucket, KeyHash>::const_iterator exact =
+    m_index.find (MakeKey (daddr, dport, saddr, sport));
+  if (exact != m_index.end ())
+    {
+      /* this is an exact match. */
+      return exact->second.front ();
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
-  // function.
+  // function, restricted to the end points of the destination port.
+  std::unordered_map<uint16_t, Bucket>::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (Bucket::const_iterator i = port->second.begin (); i != port->second.end (); i++)
     {
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr)
-        {
-          /* this is an exact match. */
-          return *i;
-        }
       uint32_t tmp = 0;
       if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ())
         {
@@ -360,27 +376,87 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
     }
   return generic;
 }
+void
+Ipv4EndPointDemux::SetEphemeralInUse (uint16_t port, bool inUse)
+{
+  if (m_ephemeralInUse.empty () || port < m_portFirst || port > m_portLast)
+    {
+      return;
+    }
+  uint32_t offset = port - m_portFirst;
+  uint64_t bit = uint64_t (1) << (offset % 64);
+  if (inUse)
+    {
+      m_ephemeralInUse[offset / 64] |= bit;
+      m_nEphemeralInUse++;
+    }
+  else
+    {
+      m_ephemeralInUse[offset / 64] &= ~bit;
+      m_nEphemeralInUse--;
+    }
+}
+
+uint32_t
+Ipv4EndPointDemux::FindFreeEphemeral (uint32_t offset) const
+{
+  for (uint32_t word = offset / 64; word < m_ephemeralInUse.size (); word++)
+    {
+      uint64_t free = ~m_ephemeralInUse[word];
+      if (word == offset / 64)
+        {
+          free &= ~uint64_t (0) << (offset % 64);
+        }
+      if (free != 0)
+        {
+          uint32_t bit = 0;
+          while ((free & 1) == 0)
+            {
+              free >>= 1;
+              bit++;
+            }
+          return word * 64 + bit;
+        }
+    }
+  return m_ephemeralInUse.size () * 64;
+}
+
 uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
-  // Similar to counting up logic in netinet/in_pcb.c
+  // Similar to counting up logic in netinet/in_pcb.c: the first free
+  // port after the last one allocated, found in the map of the ports in use
   NS_LOG_FUNCTION (this);
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do
+  uint32_t nPorts = m_portLast - m_portFirst + 1;
+  if (m_ephemeralInUse.empty ())
     {
-      if (count-- < 0)
+      // The bits past the last port are never free
+      m_ephemeralInUse.resize ((nPorts + 63) / 64, 0);
+      if (nPorts % 64 != 0)
         {
-          return 0;
+          m_ephemeralInUse.back () = ~uint64_t (0) << (nPorts % 64);
         }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
+      m_nEphemeralInUse = 0;
+      for (std::unordered_map<uint16_t, Bucket>::const_iterator i = m_ports.begin (); i != m_ports.end (); i++)
         {
-          port = m_portFirst;
+          SetEphemeralInUse (i->first, true);
         }
-    } while (LookupPortLocal (port));
-  m_ephemeral = port;
-  return port;
+    }
+  if (m_nEphemeralInUse == nPorts)
+    {
+      return 0;
+    }
+  uint32_t offset = 0;
+  if (m_ephemeral >= m_portFirst && m_ephemeral < m_portLast)
+    {
+      offset = FindFreeEphemeral (m_ephemeral - m_portFirst + 1);
+    }
+  if (offset >= nPorts)
+    {
+      offset = FindFreeEphemeral (0);
+    }
+  m_ephemeral = m_portFirst + offset;
+  return m_ephemeral;
 }
 
 } // namespace ns3
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +42,10 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed by their four-tuple, wildcards included, in a
+ * hash table: each kind of match of Lookup is a single probe of the table,
+ * so the cost of a lookup does not grow with the number of connections.
  */
 
 class Ipv4EndPointDemux {
@@ -163,6 +169,97 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The four-tuple of an endpoint, wildcards included.
+   */
+  struct Key
+  {
+    uint32_t localAddr;   //!< The local address.
+    uint32_t peerAddr;    //!< The peer address.
+    uint16_t localPort;   //!< The local port.
+    uint16_t peerPort;    //!< The peer port.
+    /**
+     * \param other The other four-tuple.
+     * \returns true if the four-tuples are equal.
+     */
+    bool operator== (const Key &other) const
+    {
+      return localAddr == other.localAddr && peerAddr == other.peerAddr
+             && localPort == other.localPort && peerPort == other.peerPort;
+    }
+  };
+
+  /**
+   * \brief Hash function of the four-tuples.
+   */
+  struct KeyHash
+  {
+    /**
+     * \param key The four-tuple.
+     * \returns The hash of the four-tuple.
+     */
+    size_t operator() (const Key &key) const
+    {
+      size_t h = key.localAddr;
+      h = h * 31 + key.peerAddr;
+      h = h * 31 + ((uint32_t (key.localPort) << 16) | key.peerPort);
+      return h;
+    }
+  };
+
+  /**
+   * \brief The endpoints of one four-tuple, in the order they were allocated.
+   */
+  typedef std::vector<Ipv4EndPoint *> Bucket;
+
+  /**
+   * \brief Make a four-tuple.
+   * \param localAddr local address
+   * \param localPort local port
+   * \param peerAddr peer address
+   * \param peerPort peer port
+   * \returns the four-tuple
+   */
+  static Key MakeKey (Ipv4Address localAddr, uint16_t localPort,
+                      Ipv4Address peerAddr, uint16_t peerPort);
+
+  /**
+   * \brief Compare the allocation order of two end points.
+   * \param a an end point
+   * \param b another end point
+   * \returns true if \p a was allocated before \p b
+   */
+  static bool IsAllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b);
+
+  /**
+   * \brief Add a new end point to the list and to the indexes.
+   * \param endPoint the end point
+   * \returns the end point
+   */
+  Ipv4EndPoint *Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point by its four-tuple and local port/address.
+   * \param endPoint the end point
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indexes.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Find the end points of a four-tuple which can receive a packet.
+   * \param key the four-tuple
+   * \param incomingInterface the incoming interface
+   * \param endPoints the end points found, in the order they were allocated
+   */
+  void LookupKey (const Key &key, Ptr<Ipv4Interface> incomingInterface,
+                  std::vector<Ipv4EndPoint *> &endPoints);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -170,6 +267,20 @@ private:
    */
   uint16_t AllocateEphemeralPort (void);
 
+  /**
+   * \brief Mark a local port used or free in the map of the ephemeral ports.
+   * \param port the local port, ignored out of the ephemeral range
+   * \param inUse whether an end point uses the port
+   */
+  void SetEphemeralInUse (uint16_t port, bool inUse);
+
+  /**
+   * \brief Find the first free ephemeral port from an offset.
+   * \param offset the offset of the first port to test, from m_portFirst
+   * \returns the offset of the free port, past the end of the map if none
+   */
+  uint32_t FindFreeEphemeral (uint32_t offset) const;
+
   /**
    * \brief The ephemeral port.
    */
@@ -189,6 +300,39 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The end points, by four-tuple.
+   */
+  std::unordered_map<Key, Bucket, KeyHash> m_index;
+
+  /**
+   * \brief The number of end points, by local address and port.
+   */
+  std::unordered_map<Key, uint32_t, KeyHash> m_locals;
+
+  /**
+   * \brief The end points, by local port, in the order they were allocated.
+   */
+  std::unordered_map<uint16_t, Bucket> m_ports;
+
+  /**
+   * \brief The ephemeral ports in use, one bit per port from m_portFirst.
+   *
+   * Built at the first ephemeral port allocation, and kept up to date
+   * with m_ports from then on.
+   */
+  std::vector<uint64_t> m_ephemeralInUse;
+
+  /**
+   * \brief The number of ephemeral ports in use, once m_ephemeralInUse is built.
+   */
+  uint32_t m_nEphemeralInUse;
+
+  /**
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_sequence;
 };
 
 } // namespace ns3
@@ -22,6 +22,7 @@
 #define IPV4_END_POINT_H
 
 #include <stdint.h>
+#include <list>
 #include "ns3/ipv4-address.h"
 #include "ns3/callback.h"
 #include "ns3/net-device.h"
@@ -32,6 +33,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \ingroup ipv4
@@ -44,6 +46,9 @@ class Packet;
  * layers that a packet from a lower layer was received.  In the ns3
  * internet-stack, these notifications are automatically registered to be
  * received by the corresponding socket.
+ *
+ * The demux which allocated the endpoint indexes it by its four-tuple:
+ * changing the local address or the peer updates this index.
  */
 
 class Ipv4EndPoint {
@@ -183,6 +188,8 @@ public:
   bool IsRxEnabled (void);
 
 private:
+  friend class Ipv4EndPointDemux;
+
   /**
    * \brief The local address.
    */
@@ -227,6 +234,21 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demux indexing the endpoint, if any.
+   */
+  Ipv4EndPointDemux *m_demux;
+
+  /**
+   * \brief The allocation order of the endpoint in the demux.
+   */
+  uint64_t m_sequence;
+
+  /**
+   * \brief The position of the endpoint in the list of the demux.
+   */
+  std::list<Ipv4EndPoint *>::iterator m_position;
 };
 
 } // namespace ns3
@@ -16,6 +16,7 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 
+#include <algorithm>
 #include <vector>
 #include <iomanip>
 #include "ns3/names.h"
@@ -80,6 +81,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_hostTrie.Add (route);
 }
 
 void
@@ -90,6 +92,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_hostTrie.Add (route);
 }
 
 void
@@ -105,6 +108,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkTrie.Add (route);
 }
 
 void
@@ -118,6 +122,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkTrie.Add (route);
 }
 
 void
@@ -133,6 +138,7 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_ASexternalTrie.Add (route);
 }
 
 
@@ -146,73 +152,85 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
+  const Ipv4PrefixTrie::Routes *matches[Ipv4PrefixTrie::MAX_MATCHES];
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin ();
-       i != m_hostRoutes.end ();
-       i++)
+  uint32_t n = m_hostTrie.Lookup (dest, matches);
+  for (uint32_t k = 0; k < n; k++)
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest))
+      for (Ipv4PrefixTrie::Routes::const_iterator i = matches[k]->begin (); i != matches[k]->end (); i++)
         {
-          if (oif != 0)
+          NS_ASSERT (i->entry->IsHost ());
+          if (!i->entry->GetDest ().IsEqual (dest))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              continue;
+            }
+          if (!IsUsable (*i, oif))
+            {
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i);
+          allRoutes.push_back (i->entry);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << i->entry);
         }
     }
   if (allRoutes.size () == 0) // if no host route is found
     {
+      // All the matching network routes are candidates, whatever their
+      // prefix length, in the order they were added.
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin ();
-           j != m_networkRoutes.end ();
-           j++)
+      std::vector<const Ipv4PrefixTrie::Route *> found;
+      n = m_networkTrie.Lookup (dest, matches);
+      for (uint32_t k = 0; k < n; k++)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          for (Ipv4PrefixTrie::Routes::const_iterator j = matches[k]->begin (); j != matches[k]->end (); j++)
             {
-              if (oif != 0)
+              if (IsUsable (*j, oif))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  found.push_back (&*j);
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
         }
+      const Ipv4PrefixTrie::Routes &others = m_networkTrie.GetNonContiguous ();
+      for (Ipv4PrefixTrie::Routes::const_iterator j = others.begin (); j != others.end (); j++)
+        {
+          if (j->IsMatch (dest) && IsUsable (*j, oif))
+            {
+              found.push_back (&*j);
+            }
+        }
+      std::sort (found.begin (), found.end (), &Ipv4GlobalRouting::IsAddedBefore);
+      for (std::vector<const Ipv4PrefixTrie::Route *>::const_iterator j = found.begin (); j != found.end (); j++)
+        {
+          allRoutes.push_back ((*j)->entry);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << (*j)->entry);
+        }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      // The matching external route added first
+      const Ipv4PrefixTrie::Route *first = 0;
+      n = m_ASexternalTrie.Lookup (dest, matches);
+      for (uint32_t k = 0; k < n; k++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          for (Ipv4PrefixTrie::Routes::const_iterator j = matches[k]->begin (); j != matches[k]->end (); j++)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if ((first == 0 || IsAddedBefore (&*j, first)) && IsUsable (*j, oif))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  first = &*j;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
         }
+      const Ipv4PrefixTrie::Routes &others = m_ASexternalTrie.GetNonContiguous ();
+      for (Ipv4PrefixTrie::Routes::const_iterator j = others.begin (); j != others.end (); j++)
+        {
+          if (j->IsMatch (dest) && (first == 0 || IsAddedBefore (&*j, first)) && IsUsable (*j, oif))
+            {
+              first = &*j;
+            }
+        }
+      if (first != 0)
+        {
+          allRoutes.push_back (first->entry);
+        }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
     {
@@ -245,6 +263,24 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+bool
+Ipv4GlobalRouting::IsUsable (const Ipv4PrefixTrie::Route &route, Ptr<NetDevice> oif) const
+{
+  NS_LOG_LOGIC ("Found route " << route.entry);
+  if (oif != 0 && oif != m_ipv4->GetNetDevice (route.entry->GetInterface ()))
+    {
+      NS_LOG_LOGIC ("Not on requested interface, skipping");
+      return false;
+    }
+  return true;
+}
+
+bool
+Ipv4GlobalRouting::IsAddedBefore (const Ipv4PrefixTrie::Route *a, const Ipv4PrefixTrie::Route *b)
+{
+  return a->order < b->order;
+}
+
 uint32_t
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -319,6 +355,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              m_hostTrie.Remove (*i);
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -336,6 +373,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          m_networkTrie.Remove (*j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -352,6 +390,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
+          m_ASexternalTrie.Remove (*k);
           delete *k;
           m_ASexternalRoutes.erase (k);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -392,6 +431,9 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostTrie.Clear ();
+  m_networkTrie.Clear ();
+  m_ASexternalTrie.Clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -537,9 +579,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeGlobalRoutes ();
     }
 }
 
@@ -549,9 +589,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeGlobalRoutes ();
     }
 }
 
@@ -561,9 +599,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeGlobalRoutes ();
     }
 }
 
@@ -573,9 +609,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeGlobalRoutes ();
     }
 }
 
@@ -27,6 +27,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-prefix-trie.h"
 #include "ns3/random-variable-stream.h"
 
 namespace ns3 {
@@ -267,10 +268,27 @@ private:
    * \return Ipv4Route to route the packet to reach dest address
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  /**
+   * \brief Check if a route may be used for the output interface.
+   * \param route a route
+   * \param oif output interface if any (put 0 otherwise)
+   * \return true if the route uses the output interface, if any
+   */
+  bool IsUsable (const Ipv4PrefixTrie::Route &route, Ptr<NetDevice> oif) const;
+  /**
+   * \brief Compare the routes by the order they were added.
+   * \param a a route
+   * \param b another route
+   * \return true if \p a was added before \p b
+   */
+  static bool IsAddedBefore (const Ipv4PrefixTrie::Route *a, const Ipv4PrefixTrie::Route *b);
 
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
+  Ipv4PrefixTrie m_hostTrie;           //!< Routes to hosts by destination
+  Ipv4PrefixTrie m_networkTrie;        //!< Routes to networks by destination prefix
+  Ipv4PrefixTrie m_ASexternalTrie;     //!< External routes by destination prefix
 
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
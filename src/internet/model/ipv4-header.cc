@@ -385,11 +385,9 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
   NS_LOG_FUNCTION (this << &start);
   Buffer::Iterator i = start;
 
-  uint8_t verIhl = (4 << 4) | (5);
-  i.WriteU8 (verIhl);
-  i.WriteU8 (m_tos);
-  i.WriteHtonU16 (m_payloadSize + 5*4);
-  i.WriteHtonU16 (m_identification);
+  // Build the header in place, and copy it into the packet at once
+  uint8_t header[20];
+  uint16_t totalLength = m_payloadSize + 5*4;
   uint32_t fragmentOffset = m_fragmentOffset / 8;
   uint8_t flagsFrag = (fragmentOffset >> 8) & 0x1f;
   if (m_flags & DONT_FRAGMENT) 
@@ -400,14 +398,29 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
     {
       flagsFrag |= (1<<5);
     }
-  i.WriteU8 (flagsFrag);
-  uint8_t frag = fragmentOffset & 0xff;
-  i.WriteU8 (frag);
-  i.WriteU8 (m_ttl);
-  i.WriteU8 (m_protocol);
-  i.WriteHtonU16 (0);
-  i.WriteHtonU32 (m_source.Get ());
-  i.WriteHtonU32 (m_destination.Get ());
+  uint32_t source = m_source.Get ();
+  uint32_t destination = m_destination.Get ();
+  header[0] = (4 << 4) | (5);
+  header[1] = m_tos;
+  header[2] = totalLength >> 8;
+  header[3] = totalLength & 0xff;
+  header[4] = m_identification >> 8;
+  header[5] = m_identification & 0xff;
+  header[6] = flagsFrag;
+  header[7] = fragmentOffset & 0xff;
+  header[8] = m_ttl;
+  header[9] = m_protocol;
+  header[10] = 0;
+  header[11] = 0;
+  header[12] = source >> 24;
+  header[13] = (source >> 16) & 0xff;
+  header[14] = (source >> 8) & 0xff;
+  header[15] = source & 0xff;
+  header[16] = destination >> 24;
+  header[17] = (destination >> 16) & 0xff;
+  header[18] = (destination >> 8) & 0xff;
+  header[19] = destination & 0xff;
+  i.Write (header, sizeof (header));
 
   if (m_calcChecksum) 
     {
@@ -425,7 +438,7 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
   NS_LOG_FUNCTION (this << &start);
   Buffer::Iterator i = start;
 
-  uint8_t verIhl = i.ReadU8 ();
+  uint8_t verIhl = i.PeekU8 ();
   uint8_t ihl = verIhl & 0x0f; 
   uint16_t headerSize = ihl * 4;
 
@@ -435,11 +448,14 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
       return 0;
     }
 
-  m_tos = i.ReadU8 ();
-  uint16_t size = i.ReadNtohU16 ();
+  // Copy the fixed header out of the packet at once, and decode it in place
+  uint8_t header[20];
+  i.Read (header, sizeof (header));
+  m_tos = header[1];
+  uint16_t size = (header[2] << 8) | header[3];
   m_payloadSize = size - headerSize;
-  m_identification = i.ReadNtohU16 ();
-  uint8_t flags = i.ReadU8 ();
+  m_identification = (header[4] << 8) | header[5];
+  uint8_t flags = header[6];
   m_flags = 0;
   if (flags & (1<<6)) 
     {
@@ -449,17 +465,15 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
     {
       m_flags |= MORE_FRAGMENTS;
     }
-  i.Prev ();
-  m_fragmentOffset = i.ReadU8 () & 0x1f;
+  m_fragmentOffset = flags & 0x1f;
   m_fragmentOffset <<= 8;
-  m_fragmentOffset |= i.ReadU8 ();
+  m_fragmentOffset |= header[7];
   m_fragmentOffset <<= 3;
-  m_ttl = i.ReadU8 ();
-  m_protocol = i.ReadU8 ();
-  m_checksum = i.ReadU16 ();
-  /* i.Next (2); // checksum */
-  m_source.Set (i.ReadNtohU32 ());
-  m_destination.Set (i.ReadNtohU32 ());
+  m_ttl = header[8];
+  m_protocol = header[9];
+  m_checksum = header[10] | (header[11] << 8);
+  m_source.Set ((static_cast<uint32_t> (header[12]) << 24) | (header[13] << 16) | (header[14] << 8) | header[15]);
+  m_destination.Set ((static_cast<uint32_t> (header[16]) << 24) | (header[17] << 16) | (header[18] << 8) | header[19]);
   m_headerSize = headerSize;
 
   if (m_calcChecksum) 
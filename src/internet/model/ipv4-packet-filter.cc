@@ -22,6 +22,8 @@
 
 #include "ns3/log.h"
 #include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/hash.h"
 #include "ipv4-queue-disc-item.h"
 #include "ipv4-packet-filter.h"
 
@@ -58,4 +60,78 @@ Ipv4PacketFilter::CheckProtocol (Ptr<QueueDiscItem> item) const
   return (DynamicCast<Ipv4QueueDiscItem> (item) != 0);
 }
 
+// ------------------------------------------------------------------------- //
+
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelIpv4PacketFilter);
+
+TypeId
+FqCoDelIpv4PacketFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelIpv4PacketFilter")
+    .SetParent<Ipv4PacketFilter> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<FqCoDelIpv4PacketFilter> ()
+    .AddAttribute ("Perturbation",
+                   "The salt used as an additional input to the hash function used to classify packets",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FqCoDelIpv4PacketFilter::m_perturbation),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+FqCoDelIpv4PacketFilter::FqCoDelIpv4PacketFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqCoDelIpv4PacketFilter::~FqCoDelIpv4PacketFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+int32_t
+FqCoDelIpv4PacketFilter::DoClassify (Ptr<QueueDiscItem> item) const
+{
+  NS_LOG_FUNCTION (this << item);
+  Ptr<Ipv4QueueDiscItem> ipv4Item = DynamicCast<Ipv4QueueDiscItem> (item);
+
+  NS_ASSERT (ipv4Item != 0);
+
+  const Ipv4Header &hdr = ipv4Item->GetHeader ();
+  uint8_t prot = hdr.GetProtocol ();
+
+  /* serialize the 5-tuple and the perturbation in buf */
+  uint8_t buf[17];
+  hdr.GetSource ().Serialize (buf);
+  hdr.GetDestination ().Serialize (buf + 4);
+  buf[8] = prot;
+
+  // The TCP and UDP headers both start with the source and destination
+  // ports: copy them instead of deserializing the whole header.
+  Ptr<Packet> pkt = ipv4Item->GetPacket ();
+  if ((prot == 6 || prot == 17) && hdr.GetFragmentOffset () == 0
+      && pkt->CopyData (buf + 9, 4) == 4)
+    {
+      NS_LOG_DEBUG ("Found ports " << (buf[9] << 8 | buf[10]) << " and " << (buf[11] << 8 | buf[12]));
+    }
+  else
+    {
+      buf[9] = buf[10] = buf[11] = buf[12] = 0;
+    }
+
+  buf[13] = (m_perturbation >> 24) & 0xff;
+  buf[14] = (m_perturbation >> 16) & 0xff;
+  buf[15] = (m_perturbation >> 8) & 0xff;
+  buf[16] = m_perturbation & 0xff;
+
+  // Linux uses the jenkins hash, the murmur3 hash of ns-3 is used here.
+  // The hash is made non negative, negative values being reserved.
+  uint32_t hash = Hash32 ((char*) buf, 17) & 0x7fffffff;
+
+  NS_LOG_DEBUG ("Found Ipv4 packet; hash value " << hash);
+
+  return hash;
+}
+
 } // namespace ns3
@@ -50,6 +50,41 @@ private:
   virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const = 0;
 };
 
+/**
+ * \ingroup ipv4
+ * \ingroup traffic-control
+ *
+ * FqCoDelIpv4PacketFilter is the filter to be added to the FQCoDel
+ * queue disc to simplify the installation of FQCoDel on IPv4 nodes.
+ *
+ * The flow of a packet is identified by its 5-tuple: source and
+ * destination addresses, protocol, and the source and destination
+ * ports for TCP and UDP.  The 5-tuple and a perturbation value are
+ * hashed, so the subflows of a multipath TCP connection are distinct
+ * flows.  Only the first fragment of a fragmented datagram carries the
+ * ports, the others are hashed with zero ports.
+ */
+class FqCoDelIpv4PacketFilter : public Ipv4PacketFilter {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  FqCoDelIpv4PacketFilter ();
+  virtual ~FqCoDelIpv4PacketFilter ();
+
+private:
+  /**
+   * \param item The item to classify.
+   * \returns The non negative hash of the 5-tuple of the packet.
+   */
+  virtual int32_t DoClassify (Ptr<QueueDiscItem> item) const;
+
+  uint32_t m_perturbation; //!< hash perturbation value
+};
+
 } // namespace ns3
 
 #endif /* IPV4_PACKET_FILTER */
@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ipv4-prefix-trie.h"
+#include "ipv4-routing-table-entry.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4PrefixTrie");
+
+Ipv4PrefixTrie::Ipv4PrefixTrie ()
+  : m_order (0)
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+uint32_t
+Ipv4PrefixTrie::GetMask (uint32_t length)
+{
+  return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+uint32_t
+Ipv4PrefixTrie::GetBit (uint32_t address, uint32_t i)
+{
+  return (address >> (31 - i)) & 1;
+}
+
+void
+Ipv4PrefixTrie::Add (Ipv4RoutingTableEntry *entry, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << entry << metric);
+  Route route;
+  route.entry = entry;
+  route.metric = metric;
+  route.order = m_order++;
+  route.mask = entry->GetDestNetworkMask ().Get ();
+  route.network = entry->GetDestNetwork ().Get () & route.mask;
+  route.length = entry->GetDestNetworkMask ().GetPrefixLength ();
+  if (route.mask != GetMask (route.length))
+    {
+      m_nonContiguous.push_back (route);
+      return;
+    }
+  m_nodes[Insert (route.network, route.length)].routes.push_back (route);
+}
+
+Ipv4PrefixTrie::Routes *
+Ipv4PrefixTrie::GetRoutes (const Ipv4RoutingTableEntry *entry)
+{
+  uint32_t mask = entry->GetDestNetworkMask ().Get ();
+  uint32_t length = entry->GetDestNetworkMask ().GetPrefixLength ();
+  if (mask != GetMask (length))
+    {
+      return &m_nonContiguous;
+    }
+  int32_t node = Find (entry->GetDestNetwork ().Get () & mask, length);
+  return node < 0 ? 0 : &m_nodes[node].routes;
+}
+
+void
+Ipv4PrefixTrie::Remove (Ipv4RoutingTableEntry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  Routes *routes = GetRoutes (entry);
+  NS_ASSERT_MSG (routes != 0, "Entry " << entry << " not in the trie");
+  for (Routes::iterator i = routes->begin (); i != routes->end (); ++i)
+    {
+      if (i->entry == entry)
+        {
+          routes->erase (i);
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Entry " << entry << " not in the trie");
+}
+
+void
+Ipv4PrefixTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nodes.clear ();
+  m_nonContiguous.clear ();
+  NewNode (0, 0);
+}
+
+uint32_t
+Ipv4PrefixTrie::Lookup (Ipv4Address dest, const Routes **matches) const
+{
+  NS_LOG_FUNCTION (this << dest << matches);
+  uint32_t address = dest.Get ();
+  uint32_t n = 0;
+  int32_t i = 0;
+  while (i >= 0)
+    {
+      const Node &node = m_nodes[i];
+      if (((address ^ node.prefix) & GetMask (node.length)) != 0)
+        {
+          break;
+        }
+      if (!node.routes.empty ())
+        {
+          matches[n++] = &node.routes;
+        }
+      if (node.length == 32)
+        {
+          break;
+        }
+      i = node.child[GetBit (address, node.length)];
+    }
+  return n;
+}
+
+const Ipv4PrefixTrie::Routes &
+Ipv4PrefixTrie::GetNonContiguous (void) const
+{
+  return m_nonContiguous;
+}
+
+int32_t
+Ipv4PrefixTrie::Find (uint32_t prefix, uint32_t length) const
+{
+  int32_t i = 0;
+  while (i >= 0)
+    {
+      const Node &node = m_nodes[i];
+      if (node.length > length || ((prefix ^ node.prefix) & GetMask (node.length)) != 0)
+        {
+          return -1;
+        }
+      if (node.length == length)
+        {
+          return i;
+        }
+      i = node.child[GetBit (prefix, node.length)];
+    }
+  return -1;
+}
+
+int32_t
+Ipv4PrefixTrie::NewNode (uint32_t prefix, uint32_t length)
+{
+  Node node;
+  node.prefix = prefix;
+  node.length = length;
+  node.child[0] = -1;
+  node.child[1] = -1;
+  m_nodes.push_back (node);
+  return m_nodes.size () - 1;
+}
+
+int32_t
+Ipv4PrefixTrie::Insert (uint32_t prefix, uint32_t length)
+{
+  // The prefix of the current node is a prefix of the one inserted.
+  int32_t i = 0;
+  while (m_nodes[i].length != length)
+    {
+      uint32_t bit = GetBit (prefix, m_nodes[i].length);
+      int32_t c = m_nodes[i].child[bit];
+      if (c < 0)
+        {
+          int32_t leaf = NewNode (prefix, length);
+          m_nodes[i].child[bit] = leaf;
+          return leaf;
+        }
+      // Length of the prefix shared by the child and the inserted one
+      uint32_t max = std::min (m_nodes[c].length, length);
+      uint32_t diff = (prefix ^ m_nodes[c].prefix) & GetMask (max);
+      uint32_t common = max;
+      if (diff != 0)
+        {
+          common = 0;
+          while (GetBit (diff, common) == 0)
+            {
+              common++;
+            }
+        }
+      if (common == m_nodes[c].length)
+        {
+          i = c;
+          continue;
+        }
+      // Split the edge to the child
+      int32_t branch = NewNode (prefix & GetMask (common), common);
+      m_nodes[branch].child[GetBit (m_nodes[c].prefix, common)] = c;
+      m_nodes[i].child[bit] = branch;
+      if (common == length)
+        {
+          return branch;
+        }
+      int32_t leaf = NewNode (prefix, length);
+      m_nodes[branch].child[GetBit (prefix, common)] = leaf;
+      return leaf;
+    }
+  return i;
+}
+
+} // namespace ns3
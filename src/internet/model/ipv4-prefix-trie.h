@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef IPV4_PREFIX_TRIE_H
+#define IPV4_PREFIX_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Index of routing table entries by destination prefix.
+ *
+ * A path compressed binary trie: each node holds the entries whose
+ * destination network has one prefix, in the order they were added,
+ * and the nodes on the way from the root to an address hold all the
+ * prefixes which match it.  A lookup visits at most 33 nodes, whatever
+ * the number of entries.
+ *
+ * The entries are not owned by the trie, the routing protocols keep
+ * their lists of entries and index them here.  The entries with a non
+ * contiguous mask cannot be indexed by prefix: they are kept aside, to
+ * be checked one by one with Route::IsMatch.
+ */
+class Ipv4PrefixTrie
+{
+public:
+  /** The maximum number of matching prefixes, from 0 to 32 bits. */
+  static const uint32_t MAX_MATCHES = 33;
+
+  /** A routing table entry of the trie. */
+  struct Route
+  {
+    Ipv4RoutingTableEntry *entry;   //!< The routing table entry.
+    uint32_t metric;                //!< The metric of the entry.
+    uint32_t order;                 //!< Increases with the order the entries were added.
+    uint32_t network;               //!< The destination network of the entry.
+    uint32_t mask;                  //!< The destination network mask of the entry.
+    uint32_t length;                //!< The prefix length, see Ipv4Mask::GetPrefixLength.
+    /**
+     * \param dest An address.
+     * \returns true if the route applies to \p dest.
+     */
+    bool IsMatch (Ipv4Address dest) const
+    {
+      return ((dest.Get () ^ network) & mask) == 0;
+    }
+  };
+  /** The routes of one prefix, in the order they were added. */
+  typedef std::vector<Route> Routes;
+
+  Ipv4PrefixTrie ();
+
+  /**
+   * \brief Index a routing table entry by its destination network.
+   * \param entry The entry.
+   * \param metric The metric of the entry.
+   */
+  void Add (Ipv4RoutingTableEntry *entry, uint32_t metric = 0);
+  /**
+   * \brief Remove a routing table entry from the index.
+   * \param entry The entry, with the same destination network as when
+   *        it was added.
+   */
+  void Remove (Ipv4RoutingTableEntry *entry);
+  /**
+   * \brief Remove all the entries.
+   */
+  void Clear (void);
+  /**
+   * \brief Find the prefixes which match an address.
+   * \param dest The address.
+   * \param matches An array of MAX_MATCHES elements, filled with the
+   *        routes of the matching prefixes, shortest prefix first.
+   * \returns The number of matching prefixes.
+   *
+   * The routes with a non contiguous mask are not part of the matches,
+   * see GetNonContiguous.
+   */
+  uint32_t Lookup (Ipv4Address dest, const Routes **matches) const;
+  /**
+   * \returns The routes with a non contiguous mask, in the order they
+   *          were added.
+   */
+  const Routes & GetNonContiguous (void) const;
+
+private:
+  /** A node of the trie. */
+  struct Node
+  {
+    uint32_t prefix;    //!< The prefix, with the bits past length zeroed.
+    uint32_t length;    //!< The prefix length.
+    int32_t child[2];   //!< The nodes of longer prefixes, by their next bit, or -1.
+    Routes routes;      //!< The entries of this prefix, may be empty.
+  };
+
+  /**
+   * \param prefix A prefix.
+   * \param length The prefix length.
+   * \returns The index of the node of the prefix, or -1.
+   */
+  int32_t Find (uint32_t prefix, uint32_t length) const;
+  /**
+   * \param prefix A prefix.
+   * \param length The prefix length.
+   * \returns The index of the node of the prefix, created if needed.
+   */
+  int32_t Insert (uint32_t prefix, uint32_t length);
+  /**
+   * \param prefix A prefix.
+   * \param length The prefix length.
+   * \returns The index of a new node, without children.
+   */
+  int32_t NewNode (uint32_t prefix, uint32_t length);
+  /**
+   * \param entry A routing table entry.
+   * \returns The routes holding the entry: the ones of its prefix, or
+   *          the ones with a non contiguous mask.
+   */
+  Routes * GetRoutes (const Ipv4RoutingTableEntry *entry);
+  /**
+   * \param length A prefix length.
+   * \returns The mask of the prefix length.
+   */
+  static uint32_t GetMask (uint32_t length);
+  /**
+   * \param address An address or prefix.
+   * \param i The bit index, 0 being the most significant one.
+   * \returns The bit.
+   */
+  static uint32_t GetBit (uint32_t address, uint32_t i);
+
+  std::vector<Node> m_nodes;  //!< The nodes, the root being the first one.
+  Routes m_nonContiguous;     //!< The routes with a non contiguous mask.
+  uint32_t m_order;           //!< The order of the next entry added.
+};
+
+} // namespace ns3
+
+#endif /* IPV4_PREFIX_TRIE_H */
@@ -73,6 +73,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkTrie.Add (route, metric);
 }
 
 void
@@ -87,6 +88,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkTrie.Add (route, metric);
 }
 
 void
@@ -144,6 +146,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_networkTrie.Add (route, 0);
 }
 
 uint32_t
@@ -224,11 +227,7 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION (this << dest << " " << oif);
   Ptr<Ipv4Route> rtentry = 0;
-  uint16_t longest_mask = 0;
-  uint32_t shortest_metric = 0xffffffff;
   /* when sending on local multicast, there have to be interface specified */
-  //// std::cout << "Hong Jiaming: Ipv4StaticRouting::LookupStatic: Fuck" << std::endl;
-
   if (dest.IsLocalMulticast ())
     {
       NS_ASSERT_MSG (oif, "Try to send on link-local multicast address, and no interface index is given!");
@@ -241,64 +240,39 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
       return rtentry;
     }
 
-  // std::cout << "Hong Jiaming: Ipv4StaticRouting::LookupStatic: dest == " << dest << " oif == " << oif << std::endl;
-  for(int i = 0; i < m_ipv4->GetNInterfaces();i++){
-    // std::cout << " --- Hong Jimaing: interface " << i << " :" <<  m_ipv4->GetNetDevice(i) << std::endl;
-  }
-  for (NetworkRoutesI i = m_networkRoutes.begin (); i != m_networkRoutes.end (); i++)
+  // Look for the preferred route among the routes of the longest
+  // matching prefix, then among the ones with a non contiguous mask.
+  const Ipv4PrefixTrie::Routes *matches[Ipv4PrefixTrie::MAX_MATCHES];
+  uint32_t n = m_networkTrie.Lookup (dest, matches);
+  const Ipv4PrefixTrie::Route *best = 0;
+  while (n > 0 && best == 0)
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      // std::cout << "Hong Jiaming: checking routing entry: \n";
-      // std::cout << j->GetDest() << " " << j->GetDestNetwork() << " " << j->GetInterface () << " " << j->GetGateway() << std::endl;
-      uint32_t metric =i->second;
-      Ipv4Mask mask = (j)->GetDestNetworkMask ();
-      uint16_t masklen = mask.GetPrefixLength ();
-      Ipv4Address entry = (j)->GetDestNetwork ();
-      NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
-      if (mask.IsMatch (dest, entry))
+      n--;
+      for (Ipv4PrefixTrie::Routes::const_iterator i = matches[n]->begin (); i != matches[n]->end (); i++)
         {
-          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
-          // std::cout << "Hong Jiaming 5: j->GetInterface () == " << j->GetInterface () << " ,m_ipv4->GetNetDevice (j->GetInterface ()) == "
-                  //  << m_ipv4->GetNetDevice (j->GetInterface ()) << ", oif == " << oif << std::endl;
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Hong Jiaming WTF Ipv4StaticRouting::LookupStatic Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          if (masklen < longest_mask) // Not interested if got shorter mask
-            {
-              NS_LOG_LOGIC ("Previous match longer, skipping");
-              continue;
-            }
-          if (masklen > longest_mask) // Reset metric if longer masklen
+          if (IsUsable (*i, oif) && IsPreferred (*i, best))
             {
-              shortest_metric = 0xffffffff;
-            }
-          longest_mask = masklen;
-          if (metric > shortest_metric)
-            {
-              NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
-              continue;
-            }
-          shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-          if (masklen == 32)
-            {
-              break;
+              best = &*i;
             }
         }
     }
-  if (rtentry != 0)
+  const Ipv4PrefixTrie::Routes &others = m_networkTrie.GetNonContiguous ();
+  for (Ipv4PrefixTrie::Routes::const_iterator i = others.begin (); i != others.end (); i++)
+    {
+      if (i->IsMatch (dest) && IsUsable (*i, oif) && IsPreferred (*i, best))
+        {
+          best = &*i;
+        }
+    }
+  Ipv4RoutingTableEntry *route = best == 0 ? 0 : best->entry;
+  if (route != 0)
     {
+      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetSource (m_ipv4->SourceAddressSelection (interfaceIdx, route->GetDest ()));
+      rtentry->SetGateway (route->GetGateway ());
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
       NS_LOG_LOGIC ("Matching route via " << rtentry->GetGateway () << " at the end");
     }
   else
@@ -308,6 +282,39 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
   return rtentry;
 }
 
+bool
+Ipv4StaticRouting::IsUsable (const Ipv4PrefixTrie::Route &route, Ptr<NetDevice> oif) const
+{
+  NS_LOG_LOGIC ("Found global network route " << route.entry << ", mask length " << route.length << ", metric " << route.metric);
+  if (oif != 0 && oif != m_ipv4->GetNetDevice (route.entry->GetInterface ()))
+    {
+      NS_LOG_LOGIC ("Not on requested interface, skipping");
+      return false;
+    }
+  return true;
+}
+
+bool
+Ipv4StaticRouting::IsPreferred (const Ipv4PrefixTrie::Route &route, const Ipv4PrefixTrie::Route *best)
+{
+  if (best == 0)
+    {
+      return true;
+    }
+  if (route.length != best->length)
+    {
+      return route.length > best->length;
+    }
+  if (route.length == 32)
+    {
+      // The first host route added wins
+      return route.order < best->order;
+    }
+  // The lowest metric wins, the last route added for equal metrics
+  return route.metric < best->metric
+         || (route.metric == best->metric && route.order > best->order);
+}
+
 Ptr<Ipv4MulticastRoute>
 Ipv4StaticRouting::LookupStatic (
   Ipv4Address origin,
@@ -454,6 +461,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
+          m_networkTrie.Remove (j->first);
           delete j->first;
           m_networkRoutes.erase (j);
           return;
@@ -583,6 +591,7 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_networkTrie.Clear ();
   for (MulticastRoutesI i = m_multicastRoutes.begin ();
        i != m_multicastRoutes.end ();
        i = m_multicastRoutes.erase (i))
@@ -621,6 +630,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -668,6 +678,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkMask () == networkMask)
         {
+          m_networkTrie.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
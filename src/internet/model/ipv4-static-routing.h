@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-prefix-trie.h"
 
 namespace ns3 {
 
@@ -403,6 +404,27 @@ private:
    */
   Ptr<Ipv4Route> LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Check if a route may be used for the output interface.
+   * \param route a route
+   * \param oif output interface if any (put 0 otherwise)
+   * \return true if the route uses the output interface, if any
+   */
+  bool IsUsable (const Ipv4PrefixTrie::Route &route, Ptr<NetDevice> oif) const;
+
+  /**
+   * \brief Compare a route to the best route found so far.
+   *
+   * The longest prefix wins, then the lowest metric and, for equal
+   * metrics, the route added last; among host routes, the first one
+   * added wins.
+   *
+   * \param route a matching route
+   * \param best the best matching route so far, or 0
+   * \return true if \p route is better than \p best
+   */
+  static bool IsPreferred (const Ipv4PrefixTrie::Route &route, const Ipv4PrefixTrie::Route *best);
+
   /**
    * \brief Lookup in the multicast forwarding table for destination.
    * \param origin source address
@@ -418,6 +440,11 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the network routes indexed by destination prefix.
+   */
+  Ipv4PrefixTrie m_networkTrie;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -18,6 +18,7 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <algorithm>
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
@@ -29,7 +30,9 @@ NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_nEphemeralInUse (0),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -40,36 +43,96 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_index.clear ();
+  m_locals.clear ();
+  m_ports.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv6EndPointDemux::Key Ipv6EndPointDemux::MakeKey (Ipv6Address localAddr, uint16_t localPort,
+                                                   Ipv6Address peerAddr, uint16_t peerPort)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  Key key;
+  key.localAddr = localAddr;
+  key.peerAddr = peerAddr;
+  key.localPort = localPort;
+  key.peerPort = peerPort;
+  return key;
+}
+
+bool Ipv6EndPointDemux::IsAllocatedBefore (Ipv6EndPoint *a, Ipv6EndPoint *b)
+{
+  return a->m_sequence < b->m_sequence;
+}
+
+Ipv6EndPoint* Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_sequence = m_sequence++;
+  endPoint->m_position = m_endPoints.insert (m_endPoints.end (), endPoint);
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Bucket &bucket = m_index[MakeKey (endPoint->m_localAddr, endPoint->m_localPort,
+                                    endPoint->m_peerAddr, endPoint->m_peerPort)];
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), endPoint, &IsAllocatedBefore),
+                 endPoint);
+  m_locals[MakeKey (endPoint->m_localAddr, endPoint->m_localPort, Ipv6Address::GetAny (), 0)]++;
+  Bucket &port = m_ports[endPoint->m_localPort];
+  if (port.empty ())
     {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
+      SetEphemeralInUse (endPoint->m_localPort, true);
     }
-  return false;
+  port.insert (std::upper_bound (port.begin (), port.end (), endPoint, &IsAllocatedBefore),
+               endPoint);
 }
 
-bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  NS_LOG_FUNCTION (this << endPoint);
+  std::unordered_map<Key, Bucket, KeyHash>::iterator i =
+    m_index.find (MakeKey (endPoint->m_localAddr, endPoint->m_localPort,
+                           endPoint->m_peerAddr, endPoint->m_peerPort));
+  NS_ASSERT (i != m_index.end ());
+  i->second.erase (std::find (i->second.begin (), i->second.end (), endPoint));
+  if (i->second.empty ())
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
-        {
-          return true;
-        }
+      m_index.erase (i);
+    }
+  std::unordered_map<Key, uint32_t, KeyHash>::iterator local =
+    m_locals.find (MakeKey (endPoint->m_localAddr, endPoint->m_localPort, Ipv6Address::GetAny (), 0));
+  if (--local->second == 0)
+    {
+      m_locals.erase (local);
+    }
+  std::unordered_map<uint16_t, Bucket>::iterator port = m_ports.find (endPoint->m_localPort);
+  port->second.erase (std::find (port->second.begin (), port->second.end (), endPoint));
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+      SetEphemeralInUse (endPoint->m_localPort, false);
     }
-  return false;
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
+}
+
+bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << addr << port);
+  return m_locals.find (MakeKey (addr, port, Ipv6Address::GetAny (), 0)) != m_locals.end ();
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
@@ -81,10 +144,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (Ipv6Address::GetAny (), port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
@@ -96,10 +156,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (uint16_t port)
@@ -117,93 +174,55 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv6EndPoint (address, port));
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t localPort,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (m_index.find (MakeKey (localAddress, localPort, peerAddress, peerPort)) != m_index.end ())
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      NS_LOG_WARN ("End point " << endPoint << " not allocated by this demux.");
+      return;
     }
+  Unindex (endPoint);
+  m_endPoints.erase (endPoint->m_position);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
-/*
- * If we have an exact match, we return it.
- * Otherwise, if we find a generic match, we return it.
- * Otherwise, we return 0.
- */
-Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint16_t dport,
-                                                        Ipv6Address saddr, uint16_t sport,
-                                                        Ptr<Ipv6Interface> incomingInterface)
+void Ipv6EndPointDemux::LookupKey (const Key &key, Ptr<Ipv6Interface> incomingInterface,
+                                   std::vector<Ipv6EndPoint *> &endPoints)
 {
-  NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
-
-  EndPoints retval1; /* Matches exact on local port, wildcards on others */
-  EndPoints retval2; /* Matches exact on local port/adder, wildcards on others */
-  EndPoints retval3; /* Matches all but local address */
-  EndPoints retval4; /* Exact match on all 4 */
-
-  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<Key, Bucket, KeyHash>::const_iterator i = m_index.find (key);
+  if (i == m_index.end ())
     {
-      Ipv6EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-
+      return;
+    }
+  for (Bucket::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+    {
+      Ipv6EndPoint* endP = *j;
       if (!endP->IsRxEnabled ())
         {
           NS_LOG_LOGIC ("Skipping endpoint " << &endP
                         << " because endpoint can not receive packets");
           continue;
         }
-
-      if (endP->GetLocalPort () != dport)
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-
       if (endP->GetBoundNetDevice ())
         {
           if (!incomingInterface)
@@ -219,99 +238,70 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
               continue;
             }
         }
-
-      /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
-      NS_LOG_DEBUG ("dest addr " << daddr);
-
-      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
-      bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
-
-      /* if no match here, keep looking */
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        {
-          continue;
-        }
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
-
-      /* If remote does not match either with exact or wildcard,i
-         skip this one */
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        {
-          continue;
-        }
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        {
-          continue;
-        }
-
-      /* Now figure out which return list to add this one to */
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port matches exactly */
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (localAddressMatchesAllRouters))
-          && remotePeerMatchesWildCard
-          && remoteAddressMatchesWildCard)
-        { /* Only local port and local address matches exactly */
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All but local address */
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact
-          && remotePeerMatchesExact
-          && remoteAddressMatchesExact)
-        { /* All 4 match */
-          retval4.push_back (endP);
-        }
+      endPoints.push_back (endP);
     }
+}
 
-  /* Here we find the most exact match */
-  if (!retval4.empty ())
+/*
+ * If we have an exact match, we return it.
+ * Otherwise, if we find a generic match, we return it.
+ * Otherwise, we return 0.
+ *
+ * Each kind of match is a four-tuple where the fields which are not
+ * matched exactly are wildcards, so it is a single probe of the index.
+ */
+Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint16_t dport,
+                                                        Ipv6Address saddr, uint16_t sport,
+                                                        Ptr<Ipv6Interface> incomingInterface)
+{
+  NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
+
+  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
+  Ipv6Address any = Ipv6Address::GetAny ();
+  std::vector<Ipv6EndPoint *> found;
+  /* Exact match on all 4 */
+  LookupKey (MakeKey (daddr, dport, saddr, sport), incomingInterface, found);
+  if (found.empty ())
     {
-      return retval4;
+      /* Matches all but local address */
+      LookupKey (MakeKey (any, dport, saddr, sport), incomingInterface, found);
     }
-  if (!retval3.empty ())
+  if (found.empty ())
     {
-      return retval3;
+      /* Matches exact on local port/adder, wildcards on others */
+      LookupKey (MakeKey (daddr, dport, any, 0), incomingInterface, found);
     }
-  if (!retval2.empty ())
+  if (found.empty ())
     {
-      return retval2;
+      /* Matches exact on local port, wildcards on others */
+      LookupKey (MakeKey (any, dport, any, 0), incomingInterface, found);
     }
-  return retval1;  /* might be empty if no matches */
+  return EndPoints (found.begin (), found.end ());  /* might be empty if no matches */
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  std::unordered_map<Key, Bucket, KeyHash>::const_iterator exact =
+    m_index.find (MakeKey (dst, dport, src, sport));
+  if (exact != m_index.end ())
+    {
+      /* this is an exact match. */
+      return exact->second.front ();
+    }
+
+  std::unordered_map<uint16_t, Bucket>::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
+
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (Bucket::const_iterator i = port->second.begin (); i != port->second.end (); i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
-        {
-          /* this is an exact match. */
-          return *i;
-        }
-
       if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
@@ -331,26 +321,84 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
   return generic;
 }
 
+void Ipv6EndPointDemux::SetEphemeralInUse (uint16_t port, bool inUse)
+{
+  if (m_ephemeralInUse.empty () || port < m_portFirst || port > m_portLast)
+    {
+      return;
+    }
+  uint32_t offset = port - m_portFirst;
+  uint64_t bit = uint64_t (1) << (offset % 64);
+  if (inUse)
+    {
+      m_ephemeralInUse[offset / 64] |= bit;
+      m_nEphemeralInUse++;
+    }
+  else
+    {
+      m_ephemeralInUse[offset / 64] &= ~bit;
+      m_nEphemeralInUse--;
+    }
+}
+
+uint32_t Ipv6EndPointDemux::FindFreeEphemeral (uint32_t offset) const
+{
+  for (uint32_t word = offset / 64; word < m_ephemeralInUse.size (); word++)
+    {
+      uint64_t free = ~m_ephemeralInUse[word];
+      if (word == offset / 64)
+        {
+          free &= ~uint64_t (0) << (offset % 64);
+        }
+      if (free != 0)
+        {
+          uint32_t bit = 0;
+          while ((free & 1) == 0)
+            {
+              free >>= 1;
+              bit++;
+            }
+          return word * 64 + bit;
+        }
+    }
+  return m_ephemeralInUse.size () * 64;
+}
+
 uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do
+  uint32_t nPorts = m_portLast - m_portFirst + 1;
+  if (m_ephemeralInUse.empty ())
     {
-      if (count-- < 0)
+      // The bits past the last port are never free
+      m_ephemeralInUse.resize ((nPorts + 63) / 64, 0);
+      if (nPorts % 64 != 0)
         {
-          return 0;
+          m_ephemeralInUse.back () = ~uint64_t (0) << (nPorts % 64);
         }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
+      m_nEphemeralInUse = 0;
+      for (std::unordered_map<uint16_t, Bucket>::const_iterator i = m_ports.begin (); i != m_ports.end (); i++)
         {
-          port = m_portFirst;
+          SetEphemeralInUse (i->first, true);
         }
     }
-  while (LookupPortLocal (port));
-  m_ephemeral = port;
-  return port;
+  if (m_nEphemeralInUse == nPorts)
+    {
+      return 0;
+    }
+
+  // The first free port after the last one allocated
+  uint32_t offset = 0;
+  if (m_ephemeral >= m_portFirst && m_ephemeral < m_portLast)
+    {
+      offset = FindFreeEphemeral (m_ephemeral - m_portFirst + 1);
+    }
+  if (offset >= nPorts)
+    {
+      offset = FindFreeEphemeral (0);
+    }
+  m_ephemeral = m_portFirst + offset;
+  return m_ephemeral;
 }
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
@@ -22,6 +22,7 @@
 #define IPV6_END_POINT_H
 
 #include <stdint.h>
+#include <list>
 
 #include "ns3/ipv6-address.h"
 #include "ns3/callback.h"
@@ -34,6 +35,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \ingroup ipv6
@@ -46,6 +48,9 @@ class Packet;
  * layers that a packet from a lower layer was received.  In the ns3
  * internet-stack, these notifications are automatically registered to be
  * received by the corresponding socket.
+ *
+ * The demux which allocated the endpoint indexes it by its four-tuple:
+ * changing the local address, the local port or the peer updates this index.
  */
 class Ipv6EndPoint
 {
@@ -192,6 +197,8 @@ public:
   bool IsRxEnabled (void);
 
 private:
+  friend class Ipv6EndPointDemux;
+
   /**
    * \brief The local address.
    */
@@ -236,6 +243,21 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demux indexing the endpoint, if any.
+   */
+  Ipv6EndPointDemux *m_demux;
+
+  /**
+   * \brief The allocation order of the endpoint in the demux.
+   */
+  uint64_t m_sequence;
+
+  /**
+   * \brief The position of the endpoint in the list of the demux.
+   */
+  std::list<Ipv6EndPoint *>::iterator m_position;
 };
 
 } /* namespace ns3 */
@@ -31,6 +31,7 @@
 #include "ns3/mac16-address.h"
 #include "ns3/mac64-address.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/gso-tag.h"
 
 #include "loopback-net-device.h"
 #include "ipv6-l3-protocol.h"
@@ -1131,7 +1132,11 @@ void Ipv6L3Protocol::SendRealOut (Ptr<Ipv6Route> route, Ptr<Packet> packet, Ipv6
       targetMtu = dev->GetMtu ();
     }
 
-  if (packet->GetSize () > targetMtu + 40) /* 40 => size of IPv6 header */
+  // Super-segments are split by the devices, they are not fragmented
+  GsoTag gsoTag;
+  bool gso = packet->PeekPacketTag (gsoTag);
+
+  if (!gso && packet->GetSize () > targetMtu + 40) /* 40 => size of IPv6 header */
     {
       // Router => drop
 
@@ -167,6 +167,14 @@ MpTcpMetaSocket::MpTcpMetaSocket() :  TcpSocketImpl()
                                     , m_receivedDSS(false)
                                     , m_connected (false)
                                     , m_tagSubflows(false)
+                                    , m_dataAckCoalescing(false)
+                                    , m_dataAckEveryN(2)
+                                    , m_dataAckTimeout(MilliSeconds(40))
+                                    , m_bufferAutoTuning(false)
+                                    , m_maxRcvBufSize(6291456)
+                                    , m_maxSndBufSize(4194304)
+                                    , m_rcvSpaceBytes(0)
+                                    , m_rcvSpaceTime(0)
                                     , m_subflowTypeId(MpTcpSubflow::GetTypeId ())
                                     // , m_schedulerTypeId(MpTcpSchedulerRoundRobin::GetTypeId())
                                     , m_rWnd(0)
@@ -216,6 +224,14 @@ MpTcpMetaSocket::MpTcpMetaSocket(const MpTcpMetaSocket& sock) : TcpSocketImpl(so
                                                               , m_receivedDSS(false)
                                                               , m_connected (sock.m_connected)
                                                               , m_tagSubflows(sock.m_tagSubflows)
+                                                              , m_dataAckCoalescing(sock.m_dataAckCoalescing)
+                                                              , m_dataAckEveryN(sock.m_dataAckEveryN)
+                                                              , m_dataAckTimeout(sock.m_dataAckTimeout)
+                                                              , m_bufferAutoTuning(sock.m_bufferAutoTuning)
+                                                              , m_maxRcvBufSize(sock.m_maxRcvBufSize)
+                                                              , m_maxSndBufSize(sock.m_maxSndBufSize)
+                                                              , m_rcvSpaceBytes(0)
+                                                              , m_rcvSpaceTime(0)
                                                               , m_subflowTypeId(sock.m_subflowTypeId)
                                                               // , m_schedulerTypeId(sock.m_schedulerTypeId)
                                                               , m_rWnd(0)
@@ -288,9 +304,11 @@ MpTcpMetaSocket::GetTypeId(void)
                  MakeTypeIdAccessor (&MpTcpMetaSocket::m_subflowTypeId),
                  MakeTypeIdChecker ())
   .AddAttribute ("Scheduler",
-                 "How to generate the mappings",
-                 TypeIdValue (MpTcpSchedulerRoundRobin::GetTypeId ()),
-                 MakeTypeIdAccessor (&MpTcpMetaSocket::m_schedulerTypeId),
+                 "How to generate the mappings; ns3::MpTcpScheduler keeps "
+                 "the scheduler picked at random by the constructor",
+                 TypeIdValue (MpTcpScheduler::GetTypeId ()),
+                 MakeTypeIdAccessor (&MpTcpMetaSocket::SetSchedulerTypeId,
+                                     &MpTcpMetaSocket::GetSchedulerTypeId),
                  MakeTypeIdChecker ())
   .AddAttribute ("TxBuffer",
                  "TCP Tx buffer",
@@ -308,6 +326,41 @@ MpTcpMetaSocket::GetTypeId(void)
                  MakeBooleanAccessor (&MpTcpMetaSocket::SetTagSubflows,
                                       &MpTcpMetaSocket::GetTagSubflows),
                  MakeBooleanChecker())
+  .AddAttribute ("DataAckCoalescing",
+                 "Only send a DATA_ACK when it advanced, and delay the ACKs "
+                 "of a subflow until DataAckEveryN in-order segments arrived on it.",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MpTcpMetaSocket::m_dataAckCoalescing),
+                 MakeBooleanChecker())
+  .AddAttribute ("DataAckEveryN",
+                 "Number of in-order segments of a subflow after which it "
+                 "sends an ACK when DataAckCoalescing is enabled.",
+                 UintegerValue (2),
+                 MakeUintegerAccessor (&MpTcpMetaSocket::m_dataAckEveryN),
+                 MakeUintegerChecker<uint32_t> (1))
+  .AddAttribute ("DataAckTimeout",
+                 "Timeout after which a delayed ACK is sent when "
+                 "DataAckCoalescing is enabled.",
+                 TimeValue (MilliSeconds (40)),
+                 MakeTimeAccessor (&MpTcpMetaSocket::m_dataAckTimeout),
+                 MakeTimeChecker ())
+  .AddAttribute ("BufferAutoTuning",
+                 "Grow the receive buffer from the delivery rate and the "
+                 "send buffer from the subflow windows, starting from "
+                 "RcvBufSize and SndBufSize.",
+                 BooleanValue (false),
+                 MakeBooleanAccessor (&MpTcpMetaSocket::m_bufferAutoTuning),
+                 MakeBooleanChecker())
+  .AddAttribute ("MaxRcvBufSize",
+                 "Largest receive buffer reached by autotuning.",
+                 UintegerValue (6291456),
+                 MakeUintegerAccessor (&MpTcpMetaSocket::m_maxRcvBufSize),
+                 MakeUintegerChecker<uint32_t> ())
+  .AddAttribute ("MaxSndBufSize",
+                 "Largest send buffer reached by autotuning.",
+                 UintegerValue (4194304),
+                 MakeUintegerAccessor (&MpTcpMetaSocket::m_maxSndBufSize),
+                 MakeUintegerChecker<uint32_t> ())
   // TODO rehabilitate
   //      .AddAttribute("Subflows", "The list of subflows associated to this protocol.",
   //          ObjectVectorValue(),
@@ -330,6 +383,47 @@ void MpTcpMetaSocket::SetTagSubflows (bool value)
   m_tagSubflows = value;
 }
 
+bool MpTcpMetaSocket::GetDataAckCoalescing () const
+{
+  return m_dataAckCoalescing;
+}
+
+Time MpTcpMetaSocket::GetDataAckTimeout () const
+{
+  return m_dataAckTimeout;
+}
+
+uint32_t MpTcpMetaSocket::GetDataAckEveryN () const
+{
+  return m_dataAckEveryN;
+}
+
+bool MpTcpMetaSocket::GetBufferAutoTuning () const
+{
+  return m_bufferAutoTuning;
+}
+
+uint32_t MpTcpMetaSocket::GetMaxRcvBufSize () const
+{
+  return m_maxRcvBufSize;
+}
+
+TypeId MpTcpMetaSocket::GetSchedulerTypeId () const
+{
+  return m_schedulerTypeId;
+}
+
+void MpTcpMetaSocket::SetSchedulerTypeId (TypeId schedulerTypeId)
+{
+  // The base TypeId selects nothing: keep the random pick of the constructor
+  if (schedulerTypeId == MpTcpScheduler::GetTypeId ())
+    {
+      return;
+    }
+  // The armoury is built by the constructor, before the attributes are set
+  ChooseOneScheduler(&schedulerTypeId);
+}
+
 // // Hong Jiaming: I don't know why not receive a scheduler from outside but creating one here.
 // void
 // MpTcpMetaSocket::CreateScheduler(TypeId schedulerTypeId)
@@ -626,12 +720,17 @@ void MpTcpMetaSocket::OnSubflowRecv(Ptr<MpTcpSubflow> sf,
 {
   NS_LOG_FUNCTION(this << "Received data from subflow=" << sf);
 
-  NS_LOG_INFO("=> Dumping meta RxBuffer before extraction");
-  DumpRxBuffers(sf);
+  if (NS_LOG_IS_ENABLED (LOG_INFO))
+  {
+    NS_LOG_INFO("=> Dumping meta RxBuffer before extraction");
+    DumpRxBuffers(sf);
+  }
 
   // Remove mappings for contiguous sequence numbers, and notify the application
   // Hong Jiaming: Note that packet is already added in meta-socket's rxBuffer in MpTcpSubflow::ReceivedData
   //               And expectedDSN == m_rxBuffer->NextRxSequence() BEFORE this packet is added
+  TuneRcvBuf(p->GetSize());
+
   if (expectedDSN < m_rxBuffer->NextRxSequence())
   {
     NS_LOG_LOGIC("The Rxbuffer advanced");
@@ -1000,6 +1099,8 @@ MpTcpMetaSocket::NewAck(Ptr<MpTcpSubflow> subflow, const SequenceNumber64& dsn)
     m_nextTxSequence = dsn; // Hong Jiaming: Does this happens? Previous acks are lost?
   }
 
+  TuneSndBuf();
+
   if (GetTxAvailable() > 0)
   {
     NS_LOG_INFO("Tx available" << GetTxAvailable());
@@ -1104,7 +1205,7 @@ MpTcpMetaSocket::SendPendingData()
     }
 
     //std::cout << "Hong Jiaming 43: send from " << subflow->GetEndpoint()->GetLocalAddress() << ":" << subflow->GetEndpoint()->GetLocalPort() << " to " << subflow->GetEndpoint()->GetPeerAddress() << ":" << subflow->GetEndpoint()->GetPeerPort() << std::endl;
-    uint32_t length = m_scheduler->GetSendSizeForSubflow(subflow, subflow->GetSegSize(), dataToSend);
+    uint32_t length = m_scheduler->GetSendSizeForSubflow(subflow, subflow->GetGsoSize(), dataToSend);
 
     //Create the DSN->SSN mapping in the subflow
     // Hong Jiaming: (important) m_nextTxSequence here is the so called DSN, SSN is generated in subflow
@@ -1585,6 +1686,71 @@ uint32_t MpTcpMetaSocket::GetTotalCwnd ()
   return totalCwnd;
 }
 
+void
+MpTcpMetaSocket::TuneRcvBuf(uint32_t size)
+{
+  NS_LOG_FUNCTION(this << size);
+  if (!m_bufferAutoTuning)
+  {
+    return;
+  }
+
+  // Out of order data counts too, the subflows delivered it
+  m_rcvSpaceBytes += size;
+  if (m_rcvSpaceTime.IsZero())
+  {
+    m_rcvSpaceTime = Simulator::Now();
+    return;
+  }
+
+  // Measure over the largest RTT, so that the slowest subflow is accounted for
+  Time maxRtt = Time(0);
+  for (SubflowList::iterator it = m_activeSubflows.begin(); it != m_activeSubflows.end(); ++it)
+  {
+    Time rtt = (*it)->GetRcvRtt();
+    if (rtt.IsZero())
+    {
+      rtt = (*it)->GetRttEstimator()->GetEstimate();
+    }
+    maxRtt = Max(maxRtt, rtt);
+  }
+
+  Time elapsed = Simulator::Now() - m_rcvSpaceTime;
+  if (maxRtt.IsZero() || elapsed < maxRtt)
+  {
+    return;
+  }
+
+  uint64_t space = 2 * m_rcvSpaceBytes * maxRtt.GetSeconds() / elapsed.GetSeconds();
+  space = std::min<uint64_t>(space, m_maxRcvBufSize);
+  if (space > GetRcvBufSize())
+  {
+    NS_LOG_DEBUG("Receive buffer " << GetRcvBufSize() << " -> " << space
+                 << " (" << m_rcvSpaceBytes << " bytes in " << elapsed.GetSeconds() << "s)");
+    SetRcvBufSize(space);
+  }
+
+  m_rcvSpaceBytes = 0;
+  m_rcvSpaceTime = Simulator::Now();
+}
+
+void
+MpTcpMetaSocket::TuneSndBuf()
+{
+  NS_LOG_FUNCTION(this);
+  if (!m_bufferAutoTuning)
+  {
+    return;
+  }
+
+  uint64_t space = std::min<uint64_t>(2 * uint64_t(GetTotalCwnd()), m_maxSndBufSize);
+  if (space > GetSndBufSize())
+  {
+    NS_LOG_DEBUG("Send buffer " << GetSndBufSize() << " -> " << space);
+    SetSndBufSize(space);
+  }
+}
+
 uint32_t
 MpTcpMetaSocket::AvailableWindow()
 {
@@ -1996,13 +2162,20 @@ void
 MpTcpMetaSocket::NotifyRcvBufferChange (uint32_t oldSize, uint32_t newSize)
 {
 
-  /* The size has (manually) increased. Actively inform the other end to prevent
+  NS_LOG_FUNCTION(this << oldSize << newSize);
+
+  // The subflows buffer their out of order data against the same limit
+  for (SubflowList::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it)
+  {
+    (*it)->m_rxBuffer->SetMaxBufferSize(newSize);
+  }
+
+  /* The size has increased. Actively inform the other end to prevent
    * stale zero-window states.
    */
-  if (oldSize < newSize && m_connected)
+  if (oldSize < newSize && FullyEstablished() && !m_activeSubflows.empty())
   {
-    NS_FATAL_ERROR("TODO:implement");
-    //SendEmptyPacket (TcpHeader::ACK);
+    SendDataAck(m_activeSubflows.front());
   }
 }
 
@@ -2176,6 +2349,11 @@ void MpTcpMetaSocket::SetSndBufSize (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   m_txBuffer->SetMaxBufferSize (size);
+
+  for (SubflowList::iterator it = m_subflows.begin(); it != m_subflows.end(); ++it)
+  {
+    (*it)->SetSndBufSize(size);
+  }
 }
 
 uint32_t MpTcpMetaSocket::GetSndBufSize (void) const
@@ -156,6 +156,38 @@ public:
 
   bool GetTagSubflows () const;
   void SetTagSubflows (bool value);
+  TypeId GetSchedulerTypeId () const;
+  void SetSchedulerTypeId (TypeId schedulerTypeId);
+
+  /**
+   * \return true if the subflows only send a DATA_ACK when it advanced,
+   * and delay their ACKs until DataAckEveryN in-order segments arrived
+   * on the subflow or the DataAckTimeout expired
+   */
+  bool GetDataAckCoalescing () const;
+
+  /**
+   * \return the delay after which a subflow sends its pending ACK
+   * when DATA_ACK coalescing is enabled
+   */
+  Time GetDataAckTimeout () const;
+
+  /**
+   * \return the number of in-order segments a subflow receives before it
+   * sends an ACK when DATA_ACK coalescing is enabled
+   */
+  uint32_t GetDataAckEveryN () const;
+
+  /**
+   * \return true if the connection level buffers are resized from the
+   * measured delivery rate and the congestion windows of the subflows
+   */
+  bool GetBufferAutoTuning () const;
+
+  /**
+   * \return the size the receive buffer can grow to with autotuning
+   */
+  uint32_t GetMaxRcvBufSize () const;
 
   /*********************************************
    * Interface methods inherited from Socket
@@ -399,6 +431,23 @@ public:
   virtual uint32_t UnAckDataCount ();
   virtual uint32_t GetTotalCwnd ();
 
+  /**
+   * \brief Grow the receive buffer to twice the data received on all the
+   * subflows during the largest subflow RTT.
+   *
+   * Called for every data segment received, does nothing unless
+   * BufferAutoTuning is enabled.
+   * \param size bytes just received
+   */
+  virtual void TuneRcvBuf (uint32_t size);
+
+  /**
+   * \brief Grow the send buffer to twice the sum of the subflow windows.
+   *
+   * Called on new DATA_ACKs, does nothing unless BufferAutoTuning is enabled.
+   */
+  virtual void TuneSndBuf ();
+
   virtual void PersistTimeout();
 
 
@@ -720,6 +769,14 @@ protected: // protected methods
   // Hong Jiaming: tag is a conception in ns3. ns3 has two kinds of tag:
   //               tag of packets and tag of bytes. Here is the former one.
   bool     m_tagSubflows;  //!<Whether or not to add the subflow packet tag
+  bool     m_dataAckCoalescing; //!< Only ACK every m_dataAckEveryN segments, DATA_ACK only when it advanced
+  uint32_t m_dataAckEveryN;     //!< Number of in-order segments of a subflow before it sends an ACK
+  Time     m_dataAckTimeout;    //!< Delay before a pending ACK is sent anyway
+  bool     m_bufferAutoTuning;  //!< Resize the buffers with the connection
+  uint32_t m_maxRcvBufSize;     //!< Receive buffer autotuning limit
+  uint32_t m_maxSndBufSize;     //!< Send buffer autotuning limit
+  uint64_t m_rcvSpaceBytes;     //!< Bytes received since the delivery measurement started
+  Time     m_rcvSpaceTime;      //!< When the delivery measurement started
 
   Ptr<MpTcpScheduler> m_scheduler;  //!<
 
@@ -26,6 +26,16 @@ namespace ns3
 {
 
 NS_OBJECT_ENSURE_REGISTERED(MpTcpScheduler);
+
+TypeId
+MpTcpScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpScheduler")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+  ;
+  return tid;
+}
   
 MpTcpScheduler::MpTcpScheduler () : m_metaSock(0)
 {
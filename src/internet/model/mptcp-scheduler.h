@@ -43,6 +43,8 @@ class MpTcpScheduler : public Object
 
 public:
 
+  static TypeId GetTypeId (void);
+
   MpTcpScheduler ();
   virtual ~MpTcpScheduler();
 
@@ -41,7 +41,9 @@
 #include "ipv6.h"
 #include "ns3/node.h"
 #include "ns3/ptr.h"
+#include "ns3/gso-tag.h"
 #include "tcp-option-mptcp.h"
+#include "tcp-option-ts.h"
 #include "mptcp-id-manager.h"
 //#include "ns3/ipv4-address.h"
 #include "ns3/trace-helper.h"
@@ -132,6 +134,7 @@ MpTcpSubflow::CancelAllTimers()
   m_retxEvent.Cancel();
   m_lastAckEvent.Cancel();
   m_timewaitEvent.Cancel();
+  m_delAckEvent.Cancel();
   NS_LOG_LOGIC("CancelAllTimers");
 }
 
@@ -158,6 +161,8 @@ MpTcpSubflow::MpTcpSubflow(const MpTcpSubflow& sock)
   m_localNonce(sock.m_localNonce),
   m_id(0),
   m_dssFlags(0),
+  m_lastDataAck(0),
+  m_rcvRtt(0),
   m_routeId(0),
   m_metaSocket(0),
   m_backupSubflow(sock.m_backupSubflow)
@@ -174,7 +179,9 @@ MpTcpSubflow::MpTcpSubflow () :
     m_masterSocket(false),
     m_localNonce(0),
     m_id(0),
-    m_dssFlags(0)
+    m_dssFlags(0),
+    m_lastDataAck(0),
+    m_rcvRtt(0)
 {
   NS_LOG_FUNCTION(this);
 }
@@ -323,8 +330,7 @@ MpTcpSubflow::SendPacket(TcpHeader header, Ptr<Packet> p)
     NS_ASSERT_MSG(mapping->TailSSN() >= ssnHead +p->GetSize() -1, "mapping should cover the whole packet" );
 
     AppendDSSMapping(mapping);
-    // For now we append the data ack everytime
-    AppendDSSAck();
+    AppendDSSAckIfAdvanced();
 
     //Check to see if we need to add the DATA_FIN option, i.e. this is the last packet and close on empty is true.
     GetMeta()->CheckAndAppendDataFin(this, ssnHead, p->GetSize(), mapping);
@@ -640,6 +646,7 @@ MpTcpSubflow::AddMpTcpOptionDSS(TcpHeader& header)
     uint64_t dack = GetMeta()->GetRxBuffer()->NextRxSequence().GetValue();
     //Make sure ACK is 64 bits
     dss->SetDataAck (dack, false);
+    m_lastDataAck = SequenceNumber64(dack);
   }
 
   // If no mapping set but DATA_FIN set, we have to create the mapping from scratch
@@ -1289,6 +1296,21 @@ MpTcpSubflow::AppendDSSAck()
   }
 }
 
+void
+MpTcpSubflow::AppendDSSAckIfAdvanced()
+{
+  NS_LOG_FUNCTION(this);
+  if(!GetMeta()->GetDataAckCoalescing()
+     || GetMeta()->GetRxBuffer()->NextRxSequence() != m_lastDataAck)
+  {
+    AppendDSSAck();
+  }
+  else
+  {
+    m_dssFlags &= ~TcpOptionMpTcpDSS::DataAckPresent;
+  }
+}
+
 void
 MpTcpSubflow::AppendDSSFin()
 {
@@ -1308,6 +1330,17 @@ MpTcpSubflow::ReceivedData(Ptr<Packet> p, const TcpHeader& tcpHeader)
   Ptr<MpTcpMapping> mapping = m_RxMappings.GetMappingForSSN(tcpHeader.GetSequenceNumber());
   bool sendAck = false;
 
+  // The peer echoes the timestamp of the ACK that released this segment
+  if (tcpHeader.HasOption(TcpOption::TS))
+  {
+    Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS>(tcpHeader.GetOption(TcpOption::TS));
+    if (ts->GetEcho() != 0)
+    {
+      Time sample = TcpOptionTS::ElapsedTimeFromTsValue(ts->GetEcho());
+      m_rcvRtt = m_rcvRtt.IsZero() ? sample : (m_rcvRtt * 7 + sample) / 8;
+    }
+  }
+
 
   // OutOfRange
   // If cannot find an adequate mapping, then it should [check RFC]
@@ -1357,22 +1390,45 @@ MpTcpSubflow::ReceivedData(Ptr<Packet> p, const TcpHeader& tcpHeader)
     }
   else
     {
-      // In-sequence packet: ACK if delayed ack count allows
-      // Hong Jiaming: m_delAckMaxCount is set to be 0 in file tcp-socket.cc to disable delayed Ack
-      NS_ASSERT(m_tcpParams->m_delAckMaxCount == 0);
-      if (++m_delAckCount >= m_tcpParams->m_delAckMaxCount)
+      // In-sequence packet: with DATA_ACK coalescing, ACK every
+      // DataAckEveryN segments of this subflow
+      if (GetMeta()->GetDataAckCoalescing())
       {
-        m_delAckEvent.Cancel ();
-        m_delAckCount = 0;
-        sendAck = true;
+        m_delAckCount += GsoTag::GetSegments(p);
+        if (m_delAckCount >= GetMeta()->GetDataAckEveryN())
+        {
+          m_delAckEvent.Cancel ();
+          m_delAckCount = 0;
+          sendAck = true;
+        }
+        else if (m_delAckEvent.IsExpired ())
+        {
+          m_delAckEvent = Simulator::Schedule (GetMeta()->GetDataAckTimeout(),
+                                               &MpTcpSubflow::DelAckTimeout, this);
+          NS_LOG_LOGIC (this << " scheduled delayed ACK at "
+                        << (Simulator::Now () + Simulator::GetDelayLeft (m_delAckEvent)).GetSeconds ());
+        }
       }
-      else if (m_delAckEvent.IsExpired ())
+      else
       {
-        NS_ASSERT(false); // Hong Jiaming: delayed Ack should be disabled
-        m_delAckEvent = Simulator::Schedule (m_tcpParams->m_delAckTimeout,
-                                             &MpTcpSubflow::DelAckTimeout, this);
-        NS_LOG_LOGIC (this << " scheduled delayed ACK at "
-                      << (Simulator::Now () + Simulator::GetDelayLeft (m_delAckEvent)).GetSeconds ());
+        // In-sequence packet: ACK if delayed ack count allows
+        // Hong Jiaming: m_delAckMaxCount is set to be 0 in file tcp-socket.cc to disable delayed Ack
+        NS_ASSERT(m_tcpParams->m_delAckMaxCount == 0);
+        m_delAckCount += GsoTag::GetSegments(p);
+        if (m_delAckCount >= m_tcpParams->m_delAckMaxCount)
+        {
+          m_delAckEvent.Cancel ();
+          m_delAckCount = 0;
+          sendAck = true;
+        }
+        else if (m_delAckEvent.IsExpired ())
+        {
+          NS_ASSERT(false); // Hong Jiaming: delayed Ack should be disabled
+          m_delAckEvent = Simulator::Schedule (m_tcpParams->m_delAckTimeout,
+                                               &MpTcpSubflow::DelAckTimeout, this);
+          NS_LOG_LOGIC (this << " scheduled delayed ACK at "
+                        << (Simulator::Now () + Simulator::GetDelayLeft (m_delAckEvent)).GetSeconds ());
+        }
       }
     }
 
@@ -1384,11 +1440,44 @@ MpTcpSubflow::ReceivedData(Ptr<Packet> p, const TcpHeader& tcpHeader)
 
   if(sendAck)
   {
-    AppendDSSAck();
+    AppendDSSAckIfAdvanced();
     SendEmptyPacket(TcpHeader::ACK);
   }
 }
 
+Time
+MpTcpSubflow::GetRcvRtt(void) const
+{
+  return m_rcvRtt;
+}
+
+uint8_t
+MpTcpSubflow::CalculateWScale() const
+{
+  NS_LOG_FUNCTION(this);
+  if (!m_metaSocket || !m_metaSocket->GetBufferAutoTuning())
+  {
+    return TcpSocketBase::CalculateWScale();
+  }
+
+  uint32_t maxSpace = std::max(m_metaSocket->GetMaxRcvBufSize(), m_rxBuffer->MaxBufferSize());
+  uint8_t scale = 0;
+  while (maxSpace > m_tcpParams->m_maxWinSize && scale < 14)
+  {
+    maxSpace = maxSpace >> 1;
+    ++scale;
+  }
+  return scale;
+}
+
+void
+MpTcpSubflow::DelAckTimeout(void)
+{
+  NS_LOG_FUNCTION(this);
+  AppendDSSAck();
+  TcpSocketBase::DelAckTimeout();
+}
+
   /*
    Receive Window:  The receive window in the TCP header indicates the
    amount of free buffer space for the whole data-level connection
@@ -1514,9 +1603,8 @@ MpTcpSubflow::ReceivedAck(Ptr<Packet> p, const TcpHeader& header)
   // if packet size > 0 then it will call ReceivedData
   TcpSocketBase::ReceivedAck(p, header );
 
-  // By default we always append a DACK
-  // We should consider more advanced schemes
-  AppendDSSAck();
+  // Append a DACK, unless DATA_ACK coalescing is enabled and it did not advance
+  AppendDSSAckIfAdvanced();
 }
 
 /* Hong Jiaming: below is added for RL-MPTCP only */
@@ -239,6 +239,12 @@ public:
 
   /* Following public functions are just for RL-MPTCP */
   Ptr<TcpSocketState> GetTcb(void);
+
+  /**
+   * \return the RTT measured on the data received, from the timestamps
+   * echoed by the peer; zero if no sample was taken yet
+   */
+  Time GetRcvRtt(void) const;
   double GetDelayBandwidthProduct(void);
 
 protected:
@@ -334,6 +340,12 @@ protected:
    */
   virtual void AppendDSSAck();
 
+  /**
+   * \brief Like AppendDSSAck, but with DATA_ACK coalescing enabled on the meta,
+   * only if the DATA_ACK advanced since the last one sent on this subflow
+   */
+  void AppendDSSAckIfAdvanced();
+
   /**
    * rename to addDSSFin
    */
@@ -352,6 +364,19 @@ protected:
 
   virtual void
   ReTxTimeout();
+
+  /**
+   * Send the delayed ACK, with a DATA_ACK
+   */
+  virtual void
+  DelAckTimeout(void);
+
+  /**
+   * With buffer autotuning on the meta, scale for the largest buffer
+   * the meta may grow to rather than the current one
+   */
+  virtual uint8_t
+  CalculateWScale() const;
   /**
   This one overridesprevious one, adding MPTCP options when needed
   */
@@ -387,6 +412,8 @@ private:
   // Delayed values to
   uint8_t m_dssFlags;           //!< used to know if AddMpTcpOptions should send a flag
   Ptr<MpTcpMapping> m_dssMapping;    //!< Pending ds configuration to be sent in next packet
+  SequenceNumber64 m_lastDataAck;    //!< Last DATA_ACK sent on this subflow
+  Time m_rcvRtt;                     //!< Smoothed RTT measured on the data received
 
 
   bool m_backupSubflow; //!< Priority
@@ -149,12 +149,18 @@ RttMeanDeviation::GetTypeId (void)
 }
 
 RttMeanDeviation::RttMeanDeviation()
+  : m_shiftAlpha (-1),
+    m_shiftBeta (-1),
+    m_rttShift (0),
+    m_variationShift (0)
 {
   NS_LOG_FUNCTION (this);
 }
 
 RttMeanDeviation::RttMeanDeviation (const RttMeanDeviation& c)
-  : RttEstimator (c), m_alpha (c.m_alpha), m_beta (c.m_beta)
+  : RttEstimator (c), m_alpha (c.m_alpha), m_beta (c.m_beta),
+    m_shiftAlpha (c.m_shiftAlpha), m_shiftBeta (c.m_shiftBeta),
+    m_rttShift (c.m_rttShift), m_variationShift (c.m_variationShift)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -225,7 +231,7 @@ RttMeanDeviation::IntegerUpdate (Time m, uint32_t rttShift, uint32_t variationSh
   int64_t meas = m.GetInteger ();
   int64_t delta = meas - m_estimatedRtt.GetInteger ();
   int64_t srtt = (m_estimatedRtt.GetInteger () << rttShift) + delta;
-  m_estimatedRtt = Time::From (srtt >> rttShift);
+  m_estimatedRtt = Time (srtt >> rttShift);
   if (delta < 0)
     {
       delta = -delta;
@@ -233,7 +239,7 @@ RttMeanDeviation::IntegerUpdate (Time m, uint32_t rttShift, uint32_t variationSh
   delta -= m_estimatedVariation.GetInteger ();
   int64_t rttvar = m_estimatedVariation.GetInteger () << variationShift;
   rttvar += delta;
-  m_estimatedVariation = Time::From (rttvar >> variationShift);
+  m_estimatedVariation = Time (rttvar >> variationShift);
   return;
 }
 
@@ -246,10 +252,14 @@ RttMeanDeviation::Measurement (Time m)
     // be done with integer arithmetic according to Jacobson/Karels paper.
     // If not, since class Time only supports integer multiplication,
     // must convert Time to floating point and back again
-    uint32_t rttShift = CheckForReciprocalPowerOfTwo (m_alpha);
-    uint32_t variationShift = CheckForReciprocalPowerOfTwo (m_beta);
-    if (rttShift && variationShift){
-      IntegerUpdate (m, rttShift, variationShift);
+    if (m_alpha != m_shiftAlpha || m_beta != m_shiftBeta){
+      m_rttShift = CheckForReciprocalPowerOfTwo (m_alpha);
+      m_variationShift = CheckForReciprocalPowerOfTwo (m_beta);
+      m_shiftAlpha = m_alpha;
+      m_shiftBeta = m_beta;
+    }
+    if (m_rttShift && m_variationShift){
+      IntegerUpdate (m, m_rttShift, m_variationShift);
     }
     else{
       FloatingPointUpdate (m);
@@ -183,6 +183,11 @@ private:
   void FloatingPointUpdate (Time m);
   double       m_alpha;       //!< Filter gain for average
   double       m_beta;        //!< Filter gain for variation
+  // The gains are attributes, so the shifts are recomputed when they change
+  double       m_shiftAlpha;  //!< Filter gain for average of m_rttShift
+  double       m_shiftBeta;   //!< Filter gain for variation of m_variationShift
+  uint32_t     m_rttShift;    //!< log base 2 (1/alpha), or zero
+  uint32_t     m_variationShift; //!< log base 2 (1/beta), or zero
 
 };
 
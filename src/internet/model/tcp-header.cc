@@ -316,14 +316,33 @@ void
 TcpHeader::Serialize (Buffer::Iterator start)  const
 {
   Buffer::Iterator i = start;
-  i.WriteHtonU16 (m_sourcePort);
-  i.WriteHtonU16 (m_destinationPort);
-  i.WriteHtonU32 (m_sequenceNumber.GetValue ());
-  i.WriteHtonU32 (m_ackNumber.GetValue ());
-  i.WriteHtonU16 (GetLength () << 12 | m_flags); //reserved bits are all zero
-  i.WriteHtonU16 (m_windowSize);
-  i.WriteHtonU16 (0);
-  i.WriteHtonU16 (m_urgentPointer);
+
+  // Build the fixed header in place, and copy it into the packet at once
+  uint8_t header[20];
+  uint32_t sequenceNumber = m_sequenceNumber.GetValue ();
+  uint32_t ackNumber = m_ackNumber.GetValue ();
+  uint16_t lengthFlags = GetLength () << 12 | m_flags; //reserved bits are all zero
+  header[0] = m_sourcePort >> 8;
+  header[1] = m_sourcePort & 0xff;
+  header[2] = m_destinationPort >> 8;
+  header[3] = m_destinationPort & 0xff;
+  header[4] = sequenceNumber >> 24;
+  header[5] = (sequenceNumber >> 16) & 0xff;
+  header[6] = (sequenceNumber >> 8) & 0xff;
+  header[7] = sequenceNumber & 0xff;
+  header[8] = ackNumber >> 24;
+  header[9] = (ackNumber >> 16) & 0xff;
+  header[10] = (ackNumber >> 8) & 0xff;
+  header[11] = ackNumber & 0xff;
+  header[12] = lengthFlags >> 8;
+  header[13] = lengthFlags & 0xff;
+  header[14] = m_windowSize >> 8;
+  header[15] = m_windowSize & 0xff;
+  header[16] = 0;
+  header[17] = 0;
+  header[18] = m_urgentPointer >> 8;
+  header[19] = m_urgentPointer & 0xff;
+  i.Write (header, sizeof (header));
 
   // Serialize options if they exist
   // This implementation does not presently try to align options on word
@@ -332,9 +351,10 @@ TcpHeader::Serialize (Buffer::Iterator start)  const
   TcpOptionList::const_iterator op;
   for (op = m_options.begin (); op != m_options.end (); ++op)
     {
-      optionLen += (*op)->GetSerializedSize ();
+      uint32_t size = (*op)->GetSerializedSize ();
+      optionLen += size;
       (*op)->Serialize (i);
-      i.Next ((*op)->GetSerializedSize ());
+      i.Next (size);
     }
 
   // padding to word alignment; add ENDs and/or pad values (they are the same)
@@ -362,16 +382,21 @@ TcpHeader::Deserialize (Buffer::Iterator start)
 {
   m_optionsLen = 0;
   Buffer::Iterator i = start;
-  m_sourcePort = i.ReadNtohU16 ();
-  m_destinationPort = i.ReadNtohU16 ();
-  m_sequenceNumber = i.ReadNtohU32 ();
-  m_ackNumber = i.ReadNtohU32 ();
-  uint16_t field = i.ReadNtohU16 ();
+
+  // Copy the fixed header out of the packet at once, and decode it in place
+  uint8_t header[20];
+  i.Read (header, sizeof (header));
+  m_sourcePort = (header[0] << 8) | header[1];
+  m_destinationPort = (header[2] << 8) | header[3];
+  m_sequenceNumber = (static_cast<uint32_t> (header[4]) << 24) | (header[5] << 16)
+    | (header[6] << 8) | header[7];
+  m_ackNumber = (static_cast<uint32_t> (header[8]) << 24) | (header[9] << 16)
+    | (header[10] << 8) | header[11];
+  uint16_t field = (header[12] << 8) | header[13];
   m_flags = field & 0x3F;
   m_length = field >> 12;
-  m_windowSize = i.ReadNtohU16 ();
-  i.Next (2);
-  m_urgentPointer = i.ReadNtohU16 ();
+  m_windowSize = (header[14] << 8) | header[15];
+  m_urgentPointer = (header[18] << 8) | header[19];
 
   // Deserialize options if they exist
   m_options.clear ();
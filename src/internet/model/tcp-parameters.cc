@@ -28,6 +28,8 @@ namespace ns3 {
                                   , m_retxThresh (3)
                                   , m_limitedTx (false)
                                   , m_maxWinSize (0)
+                                  , m_gsoMaxSegs (1)
+                                  , m_gsoCwndFraction (0.25)
                                   , m_mptcpEnabled (false)
                                   , m_winScalingEnabled (false)
                                   , m_timestampEnabled (false) // Hong Jiaming: it's false here
@@ -54,6 +56,8 @@ namespace ns3 {
                                                               , m_retxThresh (params.m_retxThresh)
                                                               , m_limitedTx (params.m_limitedTx)
                                                               , m_maxWinSize (params.m_maxWinSize)
+                                                              , m_gsoMaxSegs (params.m_gsoMaxSegs)
+                                                              , m_gsoCwndFraction (params.m_gsoCwndFraction)
                                                               , m_mptcpEnabled (params.m_mptcpEnabled)
                                                               , m_winScalingEnabled (params.m_winScalingEnabled)
                                                               , m_timestampEnabled (params.m_timestampEnabled)
@@ -49,6 +49,9 @@ namespace ns3
     bool              m_limitedTx;        //!< perform limited transmit
     // Window Management
     uint16_t          m_maxWinSize;       //!< Maximum window size to advertise
+    // Segmentation offload
+    uint32_t          m_gsoMaxSegs;       //!< Maximum number of segments of a super-segment
+    double            m_gsoCwndFraction;  //!< Maximum fraction of the cwnd sent in a super-segment
     
     // Tcp Header Options
     bool              m_mptcpEnabled;       //!< MPTCP Enabled
@@ -108,6 +108,10 @@ template<typename NUMERIC_TYPE, typename SIGNED_TYPE>
 void
 TcpRxBuffer<NUMERIC_TYPE, SIGNED_TYPE>::Dump() const
 {
+  if (!NS_LOG_IS_ENABLED (LOG_DEBUG))
+    {
+      return;
+    }
   NS_LOG_DEBUG("=== Dumping content of RxBuffer");
   NS_LOG_DEBUG("> nextRxSeq=" << m_nextRxSeq << " Occupancy=" << m_size);
   BufConstIterator i = m_data.begin ();
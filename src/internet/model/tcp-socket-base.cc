@@ -41,6 +41,9 @@
 #include "ns3/double.h"
 #include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/gso-tag.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv6-header.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
 #include "ipv4-end-point.h"
@@ -2144,6 +2147,14 @@ TcpSocketBase::SendPacket(TcpHeader header, Ptr<Packet> p)
       return;
     }
 
+  if (p->GetSize () > m_tcb->m_segmentSize)
+    {
+      // Super-segment: each segment carries a copy of the IP and TCP headers
+      GsoTag gsoTag ((p->GetSize () + m_tcb->m_segmentSize - 1) / m_tcb->m_segmentSize,
+                     GetL3HeaderSize () + header.GetSerializedSize ());
+      p->ReplacePacketTag (gsoTag);
+    }
+
   m_txTrace (p, header, this);
 
   if (m_endPoint != 0)
@@ -2589,7 +2600,7 @@ TcpSocketBase::SendPendingData (bool withAck)
                     " cWnd: " << m_tcb->m_cWnd <<
                     " unAck: " << UnAckDataCount ());
 
-      uint32_t s = std::min (w, m_tcb->m_segmentSize);  // Send no more than window
+      uint32_t s = std::min (w, GetGsoSize ());  // Send no more than window
       uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_tcb->m_nextTxSequence += sz;                     // Advance next tx sequence
@@ -2601,6 +2612,32 @@ TcpSocketBase::SendPendingData (bool withAck)
   return (nPacketsSent > 0);
 }
 
+uint32_t
+TcpSocketBase::GetGsoSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t segs = m_tcpParams->m_gsoMaxSegs;
+  if (segs <= 1 || (m_endPoint == 0 && m_endPoint6 == 0))
+    {
+      return m_tcb->m_segmentSize;
+    }
+  // Leave room for the IP header and the largest TCP header in a 64 kB packet
+  segs = std::min (segs, (65535 - GetL3HeaderSize () - 60) / m_tcb->m_segmentSize);
+  uint32_t cwndSegs = static_cast<uint32_t> (m_tcb->m_cWnd * m_tcpParams->m_gsoCwndFraction) / m_tcb->m_segmentSize;
+  segs = std::min (segs, cwndSegs);
+  return std::max (segs, 1U) * m_tcb->m_segmentSize;
+}
+
+uint32_t
+TcpSocketBase::GetL3HeaderSize (void) const
+{
+  if (m_endPoint6 != 0)
+    {
+      return Ipv6Header ().GetSerializedSize ();
+    }
+  return Ipv4Header ().GetSerializedSize ();
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount () const
 {
@@ -2743,7 +2780,9 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     }
   else
     { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_tcpParams->m_delAckMaxCount)
+      // A super-segment counts as all the segments it carries
+      m_delAckCount += GsoTag::GetSegments (p);
+      if (m_delAckCount >= m_tcpParams->m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
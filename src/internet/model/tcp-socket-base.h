@@ -304,6 +304,27 @@ public:
    */
   virtual uint32_t AvailableWindow (void) const;
 
+  /**
+   * \brief Get the maximum amount of data sent at once in a segment
+   *
+   * With segmentation offload (GsoMaxSegments attribute greater than 1), a
+   * super-segment carries up to GsoMaxSegments segments, but no more than
+   * the GsoCwndFraction of the congestion window, so that a window is still
+   * acknowledged by several ACKs.
+   *
+   * \return the maximum size of the payload of a (super-)segment
+   */
+  uint32_t GetGsoSize (void) const;
+
+  /**
+   * \brief Get the size of the IP header of the segments, from the address
+   * family of the connection
+   *
+   * \return the size of the IPv6 header for an IPv6 connection, of the
+   * IPv4 header otherwise
+   */
+  uint32_t GetL3HeaderSize (void) const;
+
   // Return Peer ISN
   /*virtual SequenceNumber32 GetLocalIsn (void) const;
    virtual SequenceNumber32 GetPeerIsn (void) const;
@@ -813,7 +834,7 @@ protected:
    *
    * \returns the Window Scale factor
    */
-  uint8_t CalculateWScale () const;
+  virtual uint8_t CalculateWScale () const;
 
   /** \brief Process the timestamp option from other side
    *
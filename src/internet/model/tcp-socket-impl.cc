@@ -118,6 +118,23 @@ TcpSocketImpl::GetTypeId(void)
                  MakeBooleanAccessor (&TcpSocketImpl::SetLimitedTransmit,
                                       &TcpSocketImpl::GetLimitedTransmit),
                  MakeBooleanChecker ())
+  .AddAttribute ("GsoMaxSegments",
+                 "Maximum number of segments sent at once in a super-segment "
+                 "(1 disables the segmentation offload).  The devices, the "
+                 "queues counting packets, the error models and the receiver "
+                 "handle a super-segment as a single packet, see the TCP "
+                 "model documentation",
+                 UintegerValue (1),
+                 MakeUintegerAccessor (&TcpSocketImpl::SetGsoMaxSegments,
+                                       &TcpSocketImpl::GetGsoMaxSegments),
+                 MakeUintegerChecker<uint32_t> (1))
+  .AddAttribute ("GsoCwndFraction",
+                 "Maximum fraction of the congestion window sent in a "
+                 "super-segment, which bounds the loss of ack clock accuracy",
+                 DoubleValue (0.25),
+                 MakeDoubleAccessor (&TcpSocketImpl::SetGsoCwndFraction,
+                                     &TcpSocketImpl::GetGsoCwndFraction),
+                 MakeDoubleChecker<double> (0, 1))
 
   ;
   return tid;
@@ -349,6 +366,26 @@ bool TcpSocketImpl::GetLimitedTransmit () const
   return m_tcpParams->m_limitedTx;
 }
 
+void TcpSocketImpl::SetGsoMaxSegments (uint32_t segments)
+{
+  m_tcpParams->m_gsoMaxSegs = segments;
+}
+
+uint32_t TcpSocketImpl::GetGsoMaxSegments () const
+{
+  return m_tcpParams->m_gsoMaxSegs;
+}
+
+void TcpSocketImpl::SetGsoCwndFraction (double fraction)
+{
+  m_tcpParams->m_gsoCwndFraction = fraction;
+}
+
+double TcpSocketImpl::GetGsoCwndFraction () const
+{
+  return m_tcpParams->m_gsoCwndFraction;
+}
+
 void TcpSocketImpl::SetMinRto (Time minRto)
 {
   m_tcpParams->m_minRto = minRto;
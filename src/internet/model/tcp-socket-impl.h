@@ -213,6 +213,12 @@ namespace ns3
     virtual void SetLimitedTransmit (bool flag);
     virtual bool GetLimitedTransmit () const;
     
+    virtual void SetGsoMaxSegments (uint32_t segments);
+    virtual uint32_t GetGsoMaxSegments () const;
+    
+    virtual void SetGsoCwndFraction (double fraction);
+    virtual double GetGsoCwndFraction () const;
+    
     /**
      * \brief Call CopyObject<> to clone me
      * \returns a copy of the socket
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-interface.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv4-end-point-demux.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux lookup preferences and index updates.
+ */
+class Ipv4EndPointDemuxLookupTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param demux The demux.
+   * \param saddr The source address of the packet.
+   * \param sport The source port of the packet.
+   * \returns The only end point found for a packet to 10.0.0.1:80, or 0.
+   */
+  Ipv4EndPoint *Lookup (Ipv4EndPointDemux &demux, Ipv4Address saddr, uint16_t sport);
+};
+
+Ipv4EndPointDemuxLookupTestCase::Ipv4EndPointDemuxLookupTestCase ()
+  : TestCase ("Lookup of the most exact end point")
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxLookupTestCase::Lookup (Ipv4EndPointDemux &demux, Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints =
+    demux.Lookup (Ipv4Address ("10.0.0.1"), 80, saddr, sport, CreateObject<Ipv4Interface> ());
+  NS_TEST_EXPECT_MSG_LT (endPoints.size (), 2, "More than one end point found");
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv4EndPointDemuxLookupTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.0.2");
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1000), 0, "End point found in an empty demux");
+  Ipv4EndPoint *any = demux.Allocate (80);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1000), any, "Wildcard end point not found");
+  Ipv4EndPoint *listen = demux.Allocate (local, 80);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1000), listen, "Local address not preferred");
+  Ipv4EndPoint *connection = demux.Allocate (local, 80, peer, 1000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1000), connection, "Four-tuple not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1001), listen, "Four-tuple matched another peer");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80, peer, 1000), 0, "Duplicate four-tuple allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80), 0, "Duplicate local address allocated");
+
+  // The end points are indexed again when their peer changes
+  listen->SetPeer (peer, 1001);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1001), listen, "End point not found after SetPeer");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1002), any, "End point found with its previous peer");
+  any->SetPeer (peer, 1002);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1002), any, "All but local address not found");
+
+  connection->SetRxEnabled (false);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, peer, 1000), 0, "End point with disabled Rx found");
+  demux.DeAllocate (connection);
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 1001), listen, "Simple lookup failed");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "Local port not found");
+  demux.DeAllocate (listen);
+  demux.DeAllocate (any);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), false, "Local port found after DeAllocate");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 0, "End points left");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux ephemeral port allocation.
+ */
+class Ipv4EndPointDemuxEphemeralTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxEphemeralTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxEphemeralTestCase::Ipv4EndPointDemuxEphemeralTestCase ()
+  : TestCase ("Allocation of the ephemeral ports")
+{
+}
+
+void
+Ipv4EndPointDemuxEphemeralTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  demux.Allocate (49154);
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49153, "Unexpected first ephemeral port");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49155, "Port in use allocated");
+  uint32_t n = 2;
+  Ipv4EndPoint *middle = 0;
+  Ipv4EndPoint *endPoint;
+  while ((endPoint = demux.Allocate ()) != 0)
+    {
+      if (endPoint->GetLocalPort () == 60000)
+        {
+          middle = endPoint;
+        }
+      n++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (n, 65535 - 49152, "Not all the ephemeral ports were allocated");
+
+  // A released port is found again, whatever the last port allocated
+  NS_TEST_ASSERT_MSG_NE (middle, 0, "Port 60000 not allocated");
+  demux.DeAllocate (middle);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (60000), false, "Released port still in use");
+  endPoint = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (endPoint, 0, "Released port not allocated again");
+  NS_TEST_EXPECT_MSG_EQ (endPoint->GetLocalPort (), 60000, "Unexpected port allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (), 0, "Port allocated with all the ports in use");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (Ipv4Address ("10.0.0.1"), 60000, Ipv4Address ("10.0.0.2"), 1000),
+                         endPoint, "Wildcard end point not found by the simple lookup");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (Ipv4Address ("10.0.0.1"), 80, Ipv4Address ("10.0.0.2"), 1000),
+                         0, "Simple lookup found an unused port");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux TestSuite.
+ */
+class Ipv4EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  Ipv4EndPointDemuxTestSuite ()
+    : TestSuite ("ipv4-end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4EndPointDemuxEphemeralTestCase, TestCase::QUICK);
+  }
+};
+
+static Ipv4EndPointDemuxTestSuite g_ipv4EndPointDemuxTestSuite;
@@ -14,19 +14,26 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <sstream>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
+#include "ns3/global-route-manager.h"
+#include "ns3/global-route-manager-impl.h"
+#include "ns3/global-router-interface.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
+#include "ns3/output-stream-wrapper.h"
 #include "ns3/packet.h"
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/pointer.h"
+#include "ns3/simulation-singleton.h"
 #include "ns3/simulator.h"
 #include "ns3/string.h"
 #include "ns3/test.h"
@@ -420,6 +427,226 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
 }
 
 
+/**
+ * \param node the node
+ * \return the global routes of the node, as printed
+ */
+static std::string
+GetRoutingTable (Ptr<Node> node)
+{
+  std::ostringstream oss;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&oss);
+  node->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->PrintRoutingTable (stream);
+  return oss.str ();
+}
+
+
+class Ipv4GlobalRoutingRecomputeTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingRecomputeTestCase ();
+  virtual ~Ipv4GlobalRoutingRecomputeTestCase ();
+
+private:
+  /**
+   * Remove the route to a destination from the global routes of a node.
+   * \param node the node
+   * \param dest the destination
+   * \return true if the node had a route to dest
+   */
+  bool RemoveRouteTo (Ptr<Node> node, Ipv4Address dest);
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingRecomputeTestCase::Ipv4GlobalRoutingRecomputeTestCase ()
+  : TestCase ("Incremental recomputation of the global routes")
+{
+}
+
+Ipv4GlobalRoutingRecomputeTestCase::~Ipv4GlobalRoutingRecomputeTestCase ()
+{
+}
+
+bool
+Ipv4GlobalRoutingRecomputeTestCase::RemoveRouteTo (Ptr<Node> node, Ipv4Address dest)
+{
+  Ptr<Ipv4GlobalRouting> routing = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+    {
+      if (routing->GetRoute (i)->GetDest () == dest)
+        {
+          routing->RemoveRoute (i);
+          return true;
+        }
+    }
+  return false;
+}
+
+// Test program for two disconnected areas, using global routing
+//
+// n0<--10.1.1.0/30-->n1<--10.1.1.4/30-->n2     n3<--10.1.2.0/30-->n4
+//
+// The link between n1 and n2 goes down: the routes recomputed are compared
+// with the ones computed from scratch.  Every node gets a host route that
+// global routing does not compute: it is deleted with the other routes of
+// the nodes which are recomputed, and kept by the nodes which are not.
+//
+void
+Ipv4GlobalRoutingRecomputeTestCase::DoRun (void)
+{
+  NodeContainer c;
+  c.Create (5);
+
+  InternetStackHelper internet;
+  internet.Install (c);
+
+  SimpleNetDeviceHelper devHelper;
+  NetDeviceContainer d0d1 = devHelper.Install (NodeContainer (c.Get (0), c.Get (1)));
+  NetDeviceContainer d1d2 = devHelper.Install (NodeContainer (c.Get (1), c.Get (2)));
+  NetDeviceContainer d3d4 = devHelper.Install (NodeContainer (c.Get (3), c.Get (4)));
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.252");
+  ipv4.Assign (d0d1);
+  ipv4.SetBase ("10.1.1.4", "255.255.255.252");
+  Ipv4InterfaceContainer i1i2 = ipv4.Assign (d1d2);
+  ipv4.SetBase ("10.1.2.0", "255.255.255.252");
+  ipv4.Assign (d3d4);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string before0 = GetRoutingTable (c.Get (0));
+  std::string before3 = GetRoutingTable (c.Get (3));
+  Ipv4Address marker ("10.9.9.9");
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      c.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->AddHostRouteTo (marker, 1);
+    }
+
+  i1i2.Get (0).first->SetDown (i1i2.Get (0).second);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> recomputed;
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      bool kept = RemoveRouteTo (c.Get (i), marker);
+      NS_TEST_EXPECT_MSG_EQ (kept, (i >= 3), "Routes of node " << i << (kept ? " not recomputed" : " recomputed"));
+      recomputed.push_back (GetRoutingTable (c.Get (i)));
+    }
+
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (recomputed[i], GetRoutingTable (c.Get (i)), "Recomputed routes of node " << i << " differ");
+    }
+  NS_TEST_EXPECT_MSG_NE (recomputed[0], before0, "Routes of node 0 not recomputed");
+  NS_TEST_EXPECT_MSG_EQ (recomputed[3], before3, "Routes of node 3 changed");
+
+  Simulator::Destroy ();
+}
+
+
+class Ipv4GlobalRoutingFlapTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFlapTestCase ();
+  virtual ~Ipv4GlobalRoutingFlapTestCase ();
+
+private:
+  /**
+   * Recompute the routes, and check them against the routes computed
+   * from scratch.
+   * \param c the nodes
+   * \param step the name of the change, for the messages
+   */
+  void Recompute (NodeContainer c, std::string step);
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingFlapTestCase::Ipv4GlobalRoutingFlapTestCase ()
+  : TestCase ("Shortest path trees rebuilt for a link flap")
+{
+}
+
+Ipv4GlobalRoutingFlapTestCase::~Ipv4GlobalRoutingFlapTestCase ()
+{
+}
+
+void
+Ipv4GlobalRoutingFlapTestCase::Recompute (NodeContainer c, std::string step)
+{
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  GlobalRouteManagerImpl *impl = SimulationSingleton<GlobalRouteManagerImpl>::Get ();
+  NS_TEST_EXPECT_MSG_EQ (impl->GetNBuiltTrees (), 2, "Trees rebuilt when the link goes " << step);
+  NS_TEST_EXPECT_MSG_EQ (impl->GetNRefreshedTrees (), 4, "Trees refreshed when the link goes " << step);
+  std::vector<std::string> recomputed;
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      recomputed.push_back (GetRoutingTable (c.Get (i)));
+    }
+
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (recomputed[i], GetRoutingTable (c.Get (i)),
+                             "Routes of node " << i << " differ when the link goes " << step);
+    }
+}
+
+// Test program for a link flap in a connected area, using global routing
+//
+//   n0               n4
+//   | \             / |
+//   |  n2 ------- n3  |
+//   | /             \ |
+//   n1               n5
+//
+// The link between n0 and n1 goes down, then up again: only n0 and n1
+// see their own links change, and the link is on no shortest path of
+// the other nodes.  Their trees are kept, and only their routes through
+// n0 and n1 are refreshed from them.
+//
+void
+Ipv4GlobalRoutingFlapTestCase::DoRun (void)
+{
+  NodeContainer c;
+  c.Create (6);
+
+  InternetStackHelper internet;
+  internet.Install (c);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  uint32_t links[][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 }, { 2, 3 }, { 3, 4 }, { 3, 5 }, { 4, 5 } };
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.252");
+  Ipv4InterfaceContainer i0i1;
+  for (uint32_t i = 0; i < sizeof (links) / sizeof (links[0]); i++)
+    {
+      NetDeviceContainer d = devHelper.Install (NodeContainer (c.Get (links[i][0]), c.Get (links[i][1])));
+      Ipv4InterfaceContainer interfaces = ipv4.Assign (d);
+      ipv4.NewNetwork ();
+      if (i == 0)
+        {
+          i0i1 = interfaces;
+        }
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  GlobalRouteManagerImpl *impl = SimulationSingleton<GlobalRouteManagerImpl>::Get ();
+  NS_TEST_EXPECT_MSG_EQ (impl->GetNBuiltTrees (), 6, "Trees built from scratch");
+
+  i0i1.Get (0).first->SetDown (i0i1.Get (0).second);
+  Recompute (c, "down");
+  i0i1.Get (0).first->SetUp (i0i1.Get (0).second);
+  Recompute (c, "up");
+
+  Simulator::Destroy ();
+}
+
+
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
 public:
@@ -431,6 +658,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingRecomputeTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingFlapTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -20,12 +20,15 @@
 #include "ns3/config.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
 #include "ns3/packet.h"
 #include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/simulator.h"
 #include "ns3/string.h"
 #include "ns3/test.h"
@@ -36,6 +39,8 @@
 #include "ns3/socket-factory.h"
 #include "ns3/udp-socket-factory.h"
 
+#include <sstream>
+
 using namespace ns3;
 
 class Ipv4StaticRoutingSlash32TestCase : public TestCase
@@ -179,6 +184,151 @@ Ipv4StaticRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+// Check the route lookup against a linear search of the routing table,
+// with random routes sharing prefixes, metrics and interfaces
+class Ipv4StaticRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv4StaticRoutingLookupTestCase ();
+  virtual ~Ipv4StaticRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Find the route to a destination like the linear search of the
+   * routing table did: the longest prefix, then the lowest metric and
+   * the last route added, or the first host route added.
+   * \param routing the routing table
+   * \param dest the destination
+   * \param oif the output interface, or -1
+   * \returns the index of the route, or -1
+   */
+  int32_t LookupLinear (Ptr<Ipv4StaticRouting> routing, Ipv4Address dest, int32_t oif);
+};
+
+Ipv4StaticRoutingLookupTestCase::Ipv4StaticRoutingLookupTestCase ()
+  : TestCase ("Longest prefix match with metric tie-breaking")
+{
+}
+
+Ipv4StaticRoutingLookupTestCase::~Ipv4StaticRoutingLookupTestCase ()
+{
+}
+
+int32_t
+Ipv4StaticRoutingLookupTestCase::LookupLinear (Ptr<Ipv4StaticRouting> routing, Ipv4Address dest, int32_t oif)
+{
+  int32_t found = -1;
+  uint16_t longest_mask = 0;
+  uint32_t shortest_metric = 0xffffffff;
+  for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+    {
+      Ipv4RoutingTableEntry route = routing->GetRoute (i);
+      uint32_t metric = routing->GetMetric (i);
+      Ipv4Mask mask = route.GetDestNetworkMask ();
+      uint16_t masklen = mask.GetPrefixLength ();
+      if (!mask.IsMatch (dest, route.GetDestNetwork ()))
+        {
+          continue;
+        }
+      if (oif >= 0 && route.GetInterface () != (uint32_t) oif)
+        {
+          continue;
+        }
+      if (masklen < longest_mask)
+        {
+          continue;
+        }
+      if (masklen > longest_mask)
+        {
+          shortest_metric = 0xffffffff;
+        }
+      longest_mask = masklen;
+      if (metric > shortest_metric)
+        {
+          continue;
+        }
+      shortest_metric = metric;
+      found = i;
+      if (masklen == 32)
+        {
+          break;
+        }
+    }
+  return found;
+}
+
+void
+Ipv4StaticRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      int32_t ifIndex = ipv4->AddInterface (device);
+      std::ostringstream oss;
+      oss << "192.168.0." << 4 * i + 1;
+      ipv4->AddAddress (ifIndex, Ipv4InterfaceAddress (Ipv4Address (oss.str ().c_str ()), Ipv4Mask ("/30")));
+      ipv4->SetUp (ifIndex);
+    }
+
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  Ptr<Ipv4StaticRouting> routing = ipv4RoutingHelper.GetStaticRouting (ipv4);
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+
+  // The gateway of each route tells which one was chosen
+  uint32_t gateway = Ipv4Address ("172.16.0.0").Get ();
+  for (uint32_t i = 0; i < 400; i++)
+    {
+      Ipv4Address network ((10 << 24) | (rand->GetInteger (0, 3) << 16)
+                           | (rand->GetInteger (0, 3) << 8) | rand->GetInteger (0, 3));
+      uint32_t length = rand->GetInteger (0, 32);
+      uint32_t mask = length == 0 ? 0 : 0xffffffff << (32 - length);
+      if (rand->GetInteger (0, 19) == 0)
+        {
+          mask ^= 0x0000ff00; // not contiguous
+        }
+      uint32_t interface = rand->GetInteger (1, 2);
+      uint32_t metric = rand->GetInteger (0, 3);
+      routing->AddNetworkRouteTo (network, Ipv4Mask (mask), Ipv4Address (++gateway), interface, metric);
+      if (rand->GetInteger (0, 9) == 0)
+        {
+          routing->RemoveRoute (rand->GetInteger (0, routing->GetNRoutes () - 1));
+        }
+    }
+
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Ipv4Address dest ((10 << 24) | (rand->GetInteger (0, 3) << 16)
+                        | (rand->GetInteger (0, 3) << 8) | rand->GetInteger (0, 3));
+      int32_t oif = rand->GetInteger (0, 2) == 0 ? rand->GetInteger (1, 2) : -1;
+      Ipv4Header header;
+      header.SetDestination (dest);
+      Socket::SocketErrno sockerr;
+      Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header,
+                                                   oif < 0 ? 0 : ipv4->GetNetDevice (oif), sockerr);
+      int32_t expected = LookupLinear (routing, dest, oif);
+      if (expected < 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (route, 0, "Route found to " << dest);
+          continue;
+        }
+      NS_TEST_ASSERT_MSG_NE (route, 0, "No route found to " << dest);
+      Ipv4RoutingTableEntry entry = routing->GetRoute (expected);
+      NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), entry.GetGateway (), "Wrong route to " << dest);
+      NS_TEST_ASSERT_MSG_EQ (route->GetOutputDevice (), ipv4->GetNetDevice (entry.GetInterface ()),
+                             "Wrong device to " << dest);
+    }
+
+  Simulator::Destroy ();
+}
+
 class Ipv4StaticRoutingTestSuite : public TestSuite
 {
 public:
@@ -189,6 +339,7 @@ Ipv4StaticRoutingTestSuite::Ipv4StaticRoutingTestSuite ()
   : TestSuite ("ipv4-static-routing", UNIT)
 {
   AddTestCase (new Ipv4StaticRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4StaticRoutingLookupTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
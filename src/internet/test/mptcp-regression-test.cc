@@ -0,0 +1,768 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * MPTCP regression tests.
+ *
+ * Each test case transfers a fixed amount of data over an MPTCP
+ * connection with two subflows, on the "simplest" or the "classic"
+ * topology of scratch/run/mptcp-helper-topology.cc, for one
+ * scheduler and one congestion control.  The topologies are rebuilt
+ * here with SimpleNetDevices and static routes, since the internet
+ * module cannot depend on point-to-point, and the bottleneck links
+ * drop 1% of the packets so that congestion control and
+ * retransmissions are exercised.
+ *
+ * The "mptcp-regression" suite checks the goodput and the reordering
+ * seen at the meta level (peak number of out-of-order bytes held in
+ * the meta receive buffer) against fixed thresholds, with a fixed
+ * seed.  With DATA_ACK coalescing, it also checks the number of ACKs
+ * and the mean delay of the ACKs of each subflow.
+ *
+ * The "mptcp-performance" suite runs the same scenarios and logs
+ * the simulator throughput in processed events per wall-clock
+ * second (NS_LOG=MpTcpRegressionTest=info).  Wall-clock speed depends
+ * on the host, so it is reported, not checked.
+ */
+
+#include <cmath>
+#include <map>
+
+#include "ns3/test.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/mptcp-meta-socket.h"
+#include "ns3/mptcp-scheduler-round-robin.h"
+#include "ns3/mptcp-scheduler-fastest-rtt.h"
+#include "ns3/mptcp-scheduler-random.h"
+#include "ns3/mptcp-scheduler-largest-dbp.h"
+#include "ns3/mptcp-lia.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpRegressionTest");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief MapScheduler that counts the events handed to the simulator.
+ *
+ * Used to measure the simulator throughput without touching the
+ * simulator implementation.
+ */
+class MpTcpCountingScheduler : public MapScheduler
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual Event RemoveNext (void)
+  {
+    ++g_count;
+    return MapScheduler::RemoveNext ();
+  }
+
+  static uint64_t g_count; //!< events removed from any instance
+};
+
+uint64_t MpTcpCountingScheduler::g_count = 0;
+
+/// Buffer sizes the autotuning cases start from, in bytes
+static const uint32_t g_initialBufSize = 16384;
+/// Buffer sizes the autotuning cases must stay under, in bytes
+static const uint32_t g_maxTunedBufSize = 1 << 20;
+
+TypeId
+MpTcpCountingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpCountingScheduler")
+    .SetParent<MapScheduler> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<MpTcpCountingScheduler> ()
+  ;
+  return tid;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Transfer a file over two subflows and check goodput, reordering
+ * and, optionally, the simulator throughput.
+ */
+class MpTcpRegressionTestCase : public TestCase
+{
+public:
+  /// Topology to build
+  enum Topology
+  {
+    SIMPLEST, //!< B --- C === A, two parallel links between router and client
+    CLASSIC,  //!< B --- C, then two disjoint two-hop paths to A
+    SYMMETRIC //!< SIMPLEST with two identical parallel links
+  };
+
+  /**
+   * \brief Constructor.
+   * \param topology topology to build
+   * \param scheduler MpTcpScheduler TypeId
+   * \param congestion TcpCongestionOps TypeId of the subflows
+   * \param minGoodput minimum goodput, as a fraction of the aggregate bottleneck rate
+   * \param maxReordering maximum peak out-of-order bytes in the meta receive buffer
+   * \param reportEventRate log the events processed per wall-clock second
+   * \param dataAckEveryN DATA_ACK coalescing at the server, 0 to disable it
+   * \param maxAckRatio maximum packets received by the client per segment sent
+   * \param maxAckDelay maximum mean delay of the ACKs of each subflow,
+   * zero to skip the check
+   * \param bufferAutoTuning start from small buffers and let the meta sockets grow them
+   */
+  MpTcpRegressionTestCase (Topology topology, TypeId scheduler, TypeId congestion,
+                           double minGoodput, uint32_t maxReordering, bool reportEventRate,
+                           uint32_t dataAckEveryN = 0, double maxAckRatio = 1.5,
+                           Time maxAckDelay = Time (0), bool bufferAutoTuning = false);
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * \brief Create a point-to-point SimpleNetDevice pair and address it.
+   * \param a first node
+   * \param b second node
+   * \param rate link rate
+   * \param delay propagation delay
+   * \param network network address of the link, mask 255.255.255.0
+   * \param errorRate packet error rate on reception at a
+   * \return the interfaces, a first
+   *
+   * SimpleNetDevice transmits immediately when its queue overflows, so
+   * the queue is large enough never to overflow and losses are
+   * introduced with an error model instead.
+   */
+  Ipv4InterfaceContainer Link (Ptr<Node> a, Ptr<Node> b, DataRate rate, Time delay,
+                               const char *network, double errorRate = 0);
+
+  /**
+   * \brief Get the static routing protocol of a node.
+   * \param node the node
+   * \return the static routing protocol
+   */
+  static Ptr<Ipv4StaticRouting> GetStaticRouting (Ptr<Node> node);
+
+  /// Build the simplest network of mptcp-helper-topology.cc, or its symmetric variant
+  void CreateSimplestNetwork (void);
+  /// Build the classic network of mptcp-helper-topology.cc
+  void CreateClassicNetwork (void);
+
+  /**
+   * \brief Connect the client, once the nodes are initialized.
+   * \param socket the client socket
+   */
+  void StartFlow (Ptr<Socket> socket);
+  /**
+   * \brief Send as much data as the meta socket accepts.
+   * \param socket the sending socket
+   * \param available bytes available in the tx buffer
+   */
+  void SendData (Ptr<Socket> socket, uint32_t available);
+  /**
+   * \brief Client connected.
+   * \param socket the connected socket
+   */
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  /**
+   * \brief Client meta socket fully established, open the second subflow.
+   * \param meta the meta socket
+   */
+  void FullyEstablished (Ptr<MpTcpMetaSocket> meta);
+  /**
+   * \brief Server accepted a connection.
+   * \param socket the accepted socket
+   * \param from the peer address
+   */
+  void Accept (Ptr<Socket> socket, const Address &from);
+  /**
+   * \brief Server received data.
+   * \param socket the receiving socket
+   */
+  void Receive (Ptr<Socket> socket);
+  /// Sample the out-of-order bytes held by the server meta socket
+  void SampleReordering (void);
+  /**
+   * \brief Client received an IPv4 packet, i.e. an ACK.
+   * \param packet the packet
+   * \param ipv4 the IPv4 stack
+   * \param interface the receiving interface
+   */
+  void ClientRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * \brief Server received an IPv4 packet: start the ACK delay of its subflow.
+   * \param packet the packet
+   * \param ipv4 the IPv4 stack
+   * \param interface the receiving interface
+   */
+  void ServerRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * \brief Server sent an IPv4 packet: end the ACK delay of its subflow.
+   * \param packet the packet
+   * \param ipv4 the IPv4 stack
+   * \param interface the sending interface
+   */
+  void ServerTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  /// Delays between the data segments of a subflow and the ACKs that follow
+  struct AckDelay
+  {
+    AckDelay () : pending (false), count (0) {}
+    bool pending;   //!< a data segment is waiting for an ACK
+    Time since;     //!< arrival of the oldest data segment waiting for an ACK
+    Time total;     //!< sum of the delays
+    uint32_t count; //!< number of delays
+  };
+
+  Topology m_topology;             //!< topology to build
+  TypeId m_schedulerTypeId;        //!< scheduler under test
+  TypeId m_congestionTypeId;       //!< congestion control under test
+  double m_minGoodput;             //!< goodput threshold, fraction of m_aggregateRate
+  uint32_t m_maxReordering;        //!< reordering threshold, bytes
+  bool m_reportEventRate;          //!< log the simulator throughput
+  uint32_t m_dataAckEveryN;        //!< DataAckEveryN of the server, 0 if not coalescing
+  double m_maxAckRatio;            //!< reverse path threshold, packets per segment
+  Time m_maxAckDelay;              //!< ACK delay threshold, zero to skip the check
+  bool m_bufferAutoTuning;         //!< BufferAutoTuning of the meta sockets
+
+  NodeContainer m_nodes;           //!< all nodes
+  Ptr<Node> m_client;              //!< sender
+  Ptr<Node> m_server;              //!< receiver
+  Ipv4Address m_serverAddress;     //!< receiver address
+  Ipv4Address m_clientSecondAddress; //!< local address of the second subflow
+  DataRate m_aggregateRate;        //!< sum of the path bottlenecks
+  int64_t m_errorStreams;          //!< next random stream for the error models
+
+  Ptr<MpTcpMetaSocket> m_serverMeta; //!< accepted meta socket
+  uint32_t m_totalBytes;           //!< bytes to transfer
+  uint32_t m_sent;                 //!< bytes accepted by the client socket
+  uint32_t m_received;             //!< bytes read by the server application
+  Time m_firstRx;                  //!< first byte received
+  Time m_lastRx;                   //!< last byte received
+  uint32_t m_peakReordering;       //!< peak out-of-order bytes at the server meta
+  uint32_t m_clientRx;             //!< packets received by the client
+  std::map<Ipv4Address, AckDelay> m_ackDelays; //!< ACK delays, by client address of the subflow
+  bool m_secondSubflowRequested;   //!< the second subflow was requested
+};
+
+MpTcpRegressionTestCase::MpTcpRegressionTestCase (Topology topology, TypeId scheduler, TypeId congestion,
+                                                  double minGoodput, uint32_t maxReordering,
+                                                  bool reportEventRate,
+                                                  uint32_t dataAckEveryN, double maxAckRatio,
+                                                  Time maxAckDelay, bool bufferAutoTuning)
+  : TestCase ("MPTCP " + std::string (topology == SIMPLEST ? "simplest"
+                                      : topology == CLASSIC ? "classic" : "symmetric")
+              + " network, " + scheduler.GetName () + ", " + congestion.GetName ()
+              + (dataAckEveryN ? ", DATA_ACK every " + std::to_string (dataAckEveryN) : "")
+              + (bufferAutoTuning ? ", buffer autotuning" : "")),
+    m_topology (topology),
+    m_schedulerTypeId (scheduler),
+    m_congestionTypeId (congestion),
+    m_minGoodput (minGoodput),
+    m_maxReordering (maxReordering),
+    m_reportEventRate (reportEventRate),
+    m_dataAckEveryN (dataAckEveryN),
+    m_maxAckRatio (maxAckRatio),
+    m_maxAckDelay (maxAckDelay),
+    m_bufferAutoTuning (bufferAutoTuning),
+    m_errorStreams (0),
+    m_totalBytes (1000000),
+    m_sent (0),
+    m_received (0),
+    m_peakReordering (0),
+    m_clientRx (0),
+    m_secondSubflowRequested (false)
+{
+}
+
+void
+MpTcpRegressionTestCase::DoSetup (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  // Same socket settings as SetConfigDefaults in scratch/run
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1418));
+  Config::SetDefault ("ns3::TcpSocket::InitialSlowStartThreshold", UintegerValue (0xffffffff));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (1 << 30));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (1 << 20));
+  Config::SetDefault ("ns3::TcpSocket::InitialCwnd", UintegerValue (4));
+  Config::SetDefault ("ns3::TcpSocketImpl::Timestamp", BooleanValue (true));
+  Config::SetDefault ("ns3::TcpSocketImpl::EnableMpTcp", BooleanValue (true));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::Scheduler", TypeIdValue (m_schedulerTypeId));
+  Config::SetDefault ("ns3::MpTcpMetaSocket::TagSubflows", BooleanValue (true));
+  if (m_bufferAutoTuning)
+    {
+      Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (g_initialBufSize));
+      Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (g_initialBufSize));
+      Config::SetDefault ("ns3::MpTcpMetaSocket::BufferAutoTuning", BooleanValue (true));
+    }
+
+  ObjectFactory scheduler;
+  scheduler.SetTypeId (MpTcpCountingScheduler::GetTypeId ());
+  Simulator::SetScheduler (scheduler);
+}
+
+void
+MpTcpRegressionTestCase::DoTeardown (void)
+{
+  m_serverMeta = 0;
+  Simulator::Destroy ();
+  Config::Reset ();
+}
+
+Ipv4InterfaceContainer
+MpTcpRegressionTestCase::Link (Ptr<Node> a, Ptr<Node> b, DataRate rate, Time delay,
+                               const char *network, double errorRate)
+{
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  devHelper.SetDeviceAttribute ("DataRate", DataRateValue (rate));
+  devHelper.SetChannelAttribute ("Delay", TimeValue (delay));
+  devHelper.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (1000));
+
+  NodeContainer pair (a, b);
+  NetDeviceContainer devices = devHelper.Install (pair);
+  if (errorRate > 0)
+    {
+      Ptr<RateErrorModel> errorModel = CreateObject<RateErrorModel> ();
+      errorModel->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+      errorModel->SetRate (errorRate);
+      // Fixed stream, so that the losses do not depend on the test order
+      m_errorStreams += errorModel->AssignStreams (m_errorStreams);
+      devices.Get (0)->SetAttribute ("ReceiveErrorModel", PointerValue (errorModel));
+    }
+
+  Ipv4AddressHelper addressHelper;
+  addressHelper.SetBase (network, "255.255.255.0");
+  return addressHelper.Assign (devices);
+}
+
+Ptr<Ipv4StaticRouting>
+MpTcpRegressionTestCase::GetStaticRouting (Ptr<Node> node)
+{
+  Ipv4StaticRoutingHelper helper;
+  return helper.GetStaticRouting (node->GetObject<Ipv4> ());
+}
+
+void
+MpTcpRegressionTestCase::CreateSimplestNetwork (void)
+{
+  //                        ----
+  //                      /      \
+  //      (server) B ---  C        A (client)
+  //                     \      /
+  //                       ----
+  // The server is created first so that the client is not node 0,
+  // which exchanges states with the RL agent.
+  m_nodes.Create (3);
+  m_server = m_nodes.Get (0);
+  Ptr<Node> C = m_nodes.Get (1);
+  m_client = m_nodes.Get (2);
+
+  InternetStackHelper stackHelper;
+  stackHelper.Install (m_nodes);
+
+  Ipv4InterfaceContainer bc = Link (m_server, C, DataRate ("1Mbps"), MilliSeconds (6), "192.168.0.0");
+  DataRate rate1 ("300Kbps");
+  DataRate rate2 ("100Kbps");
+  if (m_topology == SYMMETRIC)
+    {
+      rate1 = DataRate ("400Kbps");
+      rate2 = rate1;
+    }
+  Ipv4InterfaceContainer ca1 = Link (C, m_client, rate1, MilliSeconds (15), "192.168.9.0", 0.01);
+  Ipv4InterfaceContainer ca2 = Link (C, m_client, rate2, MilliSeconds (15), "192.168.11.0", 0.01);
+  m_aggregateRate = DataRate (rate1.GetBitRate () + rate2.GetBitRate ());
+
+  m_serverAddress = bc.GetAddress (0);
+  m_clientSecondAddress = ca2.GetAddress (1);
+
+  Ptr<Ipv4StaticRouting> routing = GetStaticRouting (m_client);
+  routing->AddHostRouteTo (m_serverAddress, ca1.GetAddress (0), 1);
+  routing->AddHostRouteTo (m_serverAddress, ca2.GetAddress (0), 2);
+
+  routing = GetStaticRouting (m_server);
+  routing->AddHostRouteTo (ca1.GetAddress (1), bc.GetAddress (1), 1);
+  routing->AddHostRouteTo (ca2.GetAddress (1), bc.GetAddress (1), 1);
+
+  routing = GetStaticRouting (C);
+  routing->AddHostRouteTo (m_serverAddress, m_serverAddress, 1);
+  routing->AddHostRouteTo (ca1.GetAddress (1), ca1.GetAddress (1), 2);
+  routing->AddHostRouteTo (ca2.GetAddress (1), ca2.GetAddress (1), 3);
+}
+
+void
+MpTcpRegressionTestCase::CreateClassicNetwork (void)
+{
+  //                        D ---- E
+  //                      /         \
+  //      (server) B ---  C          A (client)
+  //                      \         /
+  //                        F ---- G
+  m_nodes.Create (7);
+  m_server = m_nodes.Get (0);
+  Ptr<Node> C = m_nodes.Get (1);
+  Ptr<Node> D = m_nodes.Get (2);
+  Ptr<Node> E = m_nodes.Get (3);
+  Ptr<Node> F = m_nodes.Get (4);
+  Ptr<Node> G = m_nodes.Get (5);
+  m_client = m_nodes.Get (6);
+
+  InternetStackHelper stackHelper;
+  stackHelper.Install (m_nodes);
+
+  Ipv4InterfaceContainer bc = Link (m_server, C, DataRate ("1Mbps"), MilliSeconds (20), "192.168.0.0");
+  Ipv4InterfaceContainer cd = Link (C, D, DataRate ("200Kbps"), MilliSeconds (2), "192.168.1.0", 0.01);
+  Ipv4InterfaceContainer cf = Link (C, F, DataRate ("150Kbps"), MilliSeconds (5), "192.168.2.0", 0.01);
+  Ipv4InterfaceContainer de = Link (D, E, DataRate ("500Kbps"), MilliSeconds (5), "192.168.3.0");
+  Ipv4InterfaceContainer fg = Link (F, G, DataRate ("500Kbps"), MilliSeconds (10), "192.168.4.0");
+  Ipv4InterfaceContainer ea = Link (E, m_client, DataRate ("500Kbps"), MilliSeconds (5), "192.168.5.0");
+  Ipv4InterfaceContainer ga = Link (G, m_client, DataRate ("500Kbps"), MilliSeconds (5), "192.168.6.0");
+  m_aggregateRate = DataRate ("350Kbps");
+
+  m_serverAddress = bc.GetAddress (0);
+  Ipv4Address clientFirst = ea.GetAddress (1);
+  m_clientSecondAddress = ga.GetAddress (1);
+
+  // Upper path for the first client address, lower path for the second one
+  Ptr<Ipv4StaticRouting> routing = GetStaticRouting (m_client);
+  routing->AddHostRouteTo (m_serverAddress, ea.GetAddress (0), 1);
+  routing->AddHostRouteTo (m_serverAddress, ga.GetAddress (0), 2);
+
+  routing = GetStaticRouting (m_server);
+  routing->AddHostRouteTo (clientFirst, bc.GetAddress (1), 1);
+  routing->AddHostRouteTo (m_clientSecondAddress, bc.GetAddress (1), 1);
+
+  routing = GetStaticRouting (C);
+  routing->AddHostRouteTo (m_serverAddress, m_serverAddress, 1);
+  routing->AddHostRouteTo (clientFirst, cd.GetAddress (1), 2);
+  routing->AddHostRouteTo (m_clientSecondAddress, cf.GetAddress (1), 3);
+
+  routing = GetStaticRouting (D);
+  routing->AddHostRouteTo (m_serverAddress, cd.GetAddress (0), 1);
+  routing->AddHostRouteTo (clientFirst, de.GetAddress (1), 2);
+
+  routing = GetStaticRouting (E);
+  routing->AddHostRouteTo (m_serverAddress, de.GetAddress (0), 1);
+  routing->AddHostRouteTo (clientFirst, clientFirst, 2);
+
+  routing = GetStaticRouting (F);
+  routing->AddHostRouteTo (m_serverAddress, cf.GetAddress (0), 1);
+  routing->AddHostRouteTo (m_clientSecondAddress, fg.GetAddress (1), 2);
+
+  routing = GetStaticRouting (G);
+  routing->AddHostRouteTo (m_serverAddress, fg.GetAddress (0), 1);
+  routing->AddHostRouteTo (m_clientSecondAddress, m_clientSecondAddress, 2);
+}
+
+void
+MpTcpRegressionTestCase::StartFlow (Ptr<Socket> socket)
+{
+  socket->Connect (InetSocketAddress (m_serverAddress, 4000));
+}
+
+void
+MpTcpRegressionTestCase::SendData (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sent < m_totalBytes && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (m_totalBytes - m_sent, socket->GetTxAvailable ());
+      int actual = socket->Send (Create<Packet> (size));
+      if (actual <= 0)
+        {
+          break;
+        }
+      m_sent += actual;
+    }
+}
+
+void
+MpTcpRegressionTestCase::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  SendData (socket, socket->GetTxAvailable ());
+}
+
+void
+MpTcpRegressionTestCase::FullyEstablished (Ptr<MpTcpMetaSocket> meta)
+{
+  if (!m_secondSubflowRequested)
+    {
+      m_secondSubflowRequested = true;
+      meta->ConnectNewSubflow (InetSocketAddress (m_clientSecondAddress, 0),
+                               InetSocketAddress (m_serverAddress, 4000));
+    }
+}
+
+void
+MpTcpRegressionTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  m_serverMeta = DynamicCast<MpTcpMetaSocket> (socket);
+  socket->SetRecvCallback (MakeCallback (&MpTcpRegressionTestCase::Receive, this));
+}
+
+void
+MpTcpRegressionTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      if (m_received == 0)
+        {
+          m_firstRx = Simulator::Now ();
+        }
+      m_received += packet->GetSize ();
+      m_lastRx = Simulator::Now ();
+    }
+}
+
+void
+MpTcpRegressionTestCase::SampleReordering (void)
+{
+  if (m_serverMeta)
+    {
+      Ptr<TcpRxBuffer64> rxBuffer = m_serverMeta->GetRxBuffer ();
+      uint32_t outOfOrder = rxBuffer->Size () - rxBuffer->Available ();
+      m_peakReordering = std::max (m_peakReordering, outOfOrder);
+    }
+  if (m_received < m_totalBytes)
+    {
+      Simulator::Schedule (MilliSeconds (10), &MpTcpRegressionTestCase::SampleReordering, this);
+    }
+}
+
+void
+MpTcpRegressionTestCase::ClientRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_clientRx++;
+}
+
+void
+MpTcpRegressionTestCase::ServerRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  Ipv4Header ipHeader;
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (ipHeader);
+  copy->RemoveHeader (tcpHeader);
+  AckDelay &delay = m_ackDelays[ipHeader.GetSource ()];
+  if (copy->GetSize () > 0 && !delay.pending)
+    {
+      delay.pending = true;
+      delay.since = Simulator::Now ();
+    }
+}
+
+void
+MpTcpRegressionTestCase::ServerTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  Ipv4Header ipHeader;
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (ipHeader);
+  copy->RemoveHeader (tcpHeader);
+  AckDelay &delay = m_ackDelays[ipHeader.GetDestination ()];
+  if ((tcpHeader.GetFlags () & TcpHeader::ACK) && delay.pending)
+    {
+      delay.pending = false;
+      delay.total += Simulator::Now () - delay.since;
+      delay.count++;
+    }
+}
+
+void
+MpTcpRegressionTestCase::DoRun (void)
+{
+  if (m_topology == CLASSIC)
+    {
+      CreateClassicNetwork ();
+    }
+  else
+    {
+      CreateSimplestNetwork ();
+    }
+
+  // MpTcpSocketFactory always uses MpTcpLia, so create the meta sockets
+  // through TcpL4Protocol to pick the congestion control
+  Ptr<Socket> sink = m_server->GetObject<TcpL4Protocol> ()->CreateSocket (m_congestionTypeId,
+                                                                          MpTcpMetaSocket::GetTypeId ());
+  if (m_dataAckEveryN)
+    {
+      // Accepted meta sockets are forked from the listening one
+      sink->SetAttribute ("DataAckCoalescing", BooleanValue (true));
+      sink->SetAttribute ("DataAckEveryN", UintegerValue (m_dataAckEveryN));
+    }
+  sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 4000));
+  sink->Listen ();
+  sink->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                           MakeCallback (&MpTcpRegressionTestCase::Accept, this));
+
+  Ptr<Socket> source = m_client->GetObject<TcpL4Protocol> ()->CreateSocket (m_congestionTypeId,
+                                                                            MpTcpMetaSocket::GetTypeId ());
+  source->Bind ();
+  source->SetConnectCallback (MakeCallback (&MpTcpRegressionTestCase::ConnectionSucceeded, this),
+                              MakeNullCallback<void, Ptr<Socket> > ());
+  source->SetSendCallback (MakeCallback (&MpTcpRegressionTestCase::SendData, this));
+  Ptr<MpTcpMetaSocket> meta = DynamicCast<MpTcpMetaSocket> (source);
+  NS_TEST_ASSERT_MSG_NE (meta, 0, "TcpL4Protocol did not create a meta socket");
+  meta->SetFullyEstablishedCallback (MakeCallback (&MpTcpRegressionTestCase::FullyEstablished, this));
+  Simulator::ScheduleWithContext (m_client->GetId (), Seconds (0),
+                                  &MpTcpRegressionTestCase::StartFlow, this, source);
+
+  m_client->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext
+    ("Rx", MakeCallback (&MpTcpRegressionTestCase::ClientRx, this));
+  m_server->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext
+    ("Rx", MakeCallback (&MpTcpRegressionTestCase::ServerRx, this));
+  m_server->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext
+    ("Tx", MakeCallback (&MpTcpRegressionTestCase::ServerTx, this));
+
+  Simulator::Schedule (MilliSeconds (10), &MpTcpRegressionTestCase::SampleReordering, this);
+  Simulator::Stop (Seconds (60));
+
+  uint64_t events = MpTcpCountingScheduler::g_count;
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsedMs = clock.End ();
+  events = MpTcpCountingScheduler::g_count - events;
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, m_totalBytes, "Transfer did not complete");
+  NS_TEST_EXPECT_MSG_EQ (meta->GetNSubflows (), 2, "Second subflow was not created");
+
+  double goodput = m_received * 8.0 / (m_lastRx - m_firstRx).GetSeconds ();
+  double utilization = goodput / m_aggregateRate.GetBitRate ();
+  double ackRatio = m_clientRx / std::ceil (m_totalBytes / 1418.0);
+  NS_LOG_INFO (GetName () << ": " << m_firstRx.GetSeconds () << "-" << m_lastRx.GetSeconds () << "s, " << meta->GetNSubflows () << " subflows, goodput " << goodput << "bps (" << utilization * 100
+                          << "% of the aggregate rate), peak reordering "
+                          << m_peakReordering << " bytes, " << ackRatio << " ACKs per segment");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (utilization, m_minGoodput, "Goodput regression");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_peakReordering, m_maxReordering, "Reordering regression");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (ackRatio, m_maxAckRatio, "Reverse path regression");
+  for (std::map<Ipv4Address, AckDelay>::const_iterator it = m_ackDelays.begin (); it != m_ackDelays.end (); ++it)
+    {
+      Time mean = it->second.total / std::max<int64_t> (it->second.count, 1);
+      NS_LOG_INFO (GetName () << ": subflow of " << it->first << ", " << it->second.count
+                              << " ACKs, mean ACK delay " << mean.GetMilliSeconds () << " ms");
+      if (!m_maxAckDelay.IsZero ())
+        {
+          NS_TEST_EXPECT_MSG_LT_OR_EQ (mean, m_maxAckDelay, "ACK delay regression on the subflow of " << it->first);
+        }
+    }
+
+  if (m_bufferAutoTuning)
+    {
+      UintegerValue rcvBuf;
+      UintegerValue sndBuf;
+      m_serverMeta->GetAttribute ("RcvBufSize", rcvBuf);
+      meta->GetAttribute ("SndBufSize", sndBuf);
+      NS_LOG_INFO (GetName () << ": receive buffer " << rcvBuf.Get ()
+                              << " bytes, send buffer " << sndBuf.Get () << " bytes");
+      NS_TEST_EXPECT_MSG_GT (rcvBuf.Get (), g_initialBufSize, "Receive buffer did not grow");
+      NS_TEST_EXPECT_MSG_GT (sndBuf.Get (), g_initialBufSize, "Send buffer did not grow");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (rcvBuf.Get (), g_maxTunedBufSize, "Receive buffer overgrown");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (sndBuf.Get (), g_maxTunedBufSize, "Send buffer overgrown");
+    }
+
+  if (m_reportEventRate)
+    {
+      double eventRate = events * 1000.0 / std::max<int64_t> (elapsedMs, 1);
+      NS_LOG_INFO (GetName () << ": " << events << " events, " << elapsedMs << " ms, "
+                              << static_cast<uint64_t> (eventRate) << " events/s");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Goodput and reordering thresholds for every scheduler and congestion control.
+ */
+class MpTcpRegressionTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param name suite name
+   * \param type suite type
+   * \param reportEventRate log the events processed per wall-clock second
+   */
+  MpTcpRegressionTestSuite (std::string name, TestSuite::Type type, bool reportEventRate)
+    : TestSuite (name, type)
+  {
+    TypeId schedulers[] = {
+      MpTcpSchedulerRoundRobin::GetTypeId (),
+      MpTcpSchedulerFastestRTT::GetTypeId (),
+      MpTcpSchedulerRandom::GetTypeId (),
+      MpTcpSchedulerLargestDBP::GetTypeId ()
+    };
+    TypeId congestions[] = {
+      TcpNewReno::GetTypeId (),
+      MpTcpLia::GetTypeId ()
+    };
+
+    for (uint32_t i = 0; i < sizeof (schedulers) / sizeof (schedulers[0]); i++)
+      {
+        for (uint32_t j = 0; j < sizeof (congestions) / sizeof (congestions[0]); j++)
+          {
+            AddTestCase (new MpTcpRegressionTestCase (MpTcpRegressionTestCase::SIMPLEST,
+                                                      schedulers[i], congestions[j],
+                                                      0.75, 320000, reportEventRate),
+                         TestCase::QUICK);
+            AddTestCase (new MpTcpRegressionTestCase (MpTcpRegressionTestCase::CLASSIC,
+                                                      schedulers[i], congestions[j],
+                                                      0.75, 320000, reportEventRate),
+                         TestCase::EXTENSIVE);
+          }
+        // The receiver only ACKs every other segment of each subflow, and
+        // the ACKs wait less than the DataAckTimeout on average
+        AddTestCase (new MpTcpRegressionTestCase (MpTcpRegressionTestCase::SIMPLEST,
+                                                  schedulers[i], MpTcpLia::GetTypeId (),
+                                                  0.75, 320000, reportEventRate, 2, 0.8, MilliSeconds (35)),
+                     TestCase::QUICK);
+        // Same with identical paths, where the segments alternate between
+        // the subflows: each subflow still ACKs every other of its own
+        // segments, and none of them waits for the DataAckTimeout
+        AddTestCase (new MpTcpRegressionTestCase (MpTcpRegressionTestCase::SYMMETRIC,
+                                                  schedulers[i], MpTcpLia::GetTypeId (),
+                                                  0.75, 320000, reportEventRate, 2, 0.65, MilliSeconds (35)),
+                     TestCase::QUICK);
+        // The meta sockets start from small buffers and grow them; head of
+        // line blocking now shows in the goodput
+        AddTestCase (new MpTcpRegressionTestCase (MpTcpRegressionTestCase::SIMPLEST,
+                                                  schedulers[i], MpTcpLia::GetTypeId (),
+                                                  0.7, 320000, reportEventRate, 0, 1.5, Time (0), true),
+                     TestCase::QUICK);
+      }
+  }
+};
+
+static MpTcpRegressionTestSuite g_mpTcpRegressionTestSuite ("mptcp-regression", TestSuite::SYSTEM, false);
+static MpTcpRegressionTestSuite g_mpTcpPerformanceTestSuite ("mptcp-performance", TestSuite::PERFORMANCE, true);
+
+} // namespace ns3
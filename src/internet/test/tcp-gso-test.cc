@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/mptcp-meta-socket.h"
+#include "ns3/tcp-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/gso-tag.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload test
+ *
+ * A bulk transfer over a link with a MTU of 1500 bytes, with and without
+ * segmentation offload, over TCP on IPv4 and IPv6 and over an MPTCP
+ * subflow.  With segmentation offload, the data is sent in fewer, larger
+ * packets that cross the link unfragmented, each with the header size of
+ * its address family in its GsoTag, and all the data is received.
+ */
+class TcpGsoTestCase : public TestCase
+{
+public:
+  TcpGsoTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Run a bulk transfer
+   * \param gsoMaxSegments the GsoMaxSegments attribute of the sender
+   * \param mptcp whether the transfer uses MPTCP meta sockets
+   * \param ipv6 whether the transfer uses IPv6 instead of IPv4
+   */
+  void RunTransfer (uint32_t gsoMaxSegments, bool mptcp, bool ipv6 = false);
+  /**
+   * \brief Create a TCP socket, or an MPTCP meta socket
+   * \param node the node of the socket
+   * \param mptcp whether to create an MPTCP meta socket
+   * \return the socket
+   */
+  static Ptr<Socket> CreateSocket (Ptr<Node> node, bool mptcp);
+  /**
+   * \brief Accept a connection
+   * \param s the new socket
+   * \param from the address of the peer
+   */
+  void Accept (Ptr<Socket> s, const Address &from);
+  /**
+   * \brief Read the received data
+   * \param s the receiving socket
+   */
+  void Recv (Ptr<Socket> s);
+  /**
+   * \brief Write data as long as the send buffer has room
+   * \param s the sending socket
+   * \param available the room in the send buffer
+   */
+  void Send (Ptr<Socket> s, uint32_t available);
+  /**
+   * \brief Count the data packets sent
+   * \param p the packet, with its IPv4 header
+   * \param ipv4 the IPv4 stack of the sender
+   * \param interface the sending interface
+   */
+  void Tx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * \brief Count the data packets sent over IPv6
+   * \param p the packet, with its IPv6 header
+   * \param ipv6 the IPv6 stack of the sender
+   * \param interface the sending interface
+   */
+  void Tx6 (Ptr<const Packet> p, Ptr<Ipv6> ipv6, uint32_t interface);
+  /**
+   * \brief Count a data packet sent
+   * \param p the packet, with its IP header
+   * \param payload the payload of the packet, without the IP and TCP headers
+   * \param headerSize the size of its IP and TCP headers
+   */
+  void CountData (Ptr<const Packet> p, Ptr<const Packet> payload, uint32_t headerSize);
+
+  uint32_t m_toSend;     //!< bytes still to write
+  uint32_t m_received;   //!< bytes received
+  uint32_t m_packets;    //!< data packets sent
+  uint32_t m_maxSize;    //!< largest data packet sent
+  uint32_t m_maxSegs;    //!< largest number of segments of a packet sent
+  uint32_t m_badHeaders; //!< super-segments whose GsoTag has a wrong header size
+};
+
+TcpGsoTestCase::TcpGsoTestCase ()
+  : TestCase ("TCP bulk transfer with segmentation offload")
+{
+}
+
+void
+TcpGsoTestCase::Accept (Ptr<Socket> s, const Address &from)
+{
+  s->SetRecvCallback (MakeCallback (&TcpGsoTestCase::Recv, this));
+}
+
+void
+TcpGsoTestCase::Recv (Ptr<Socket> s)
+{
+  Ptr<Packet> p;
+  while ((p = s->Recv ()) && p->GetSize () > 0)
+    {
+      m_received += p->GetSize ();
+    }
+}
+
+void
+TcpGsoTestCase::Send (Ptr<Socket> s, uint32_t available)
+{
+  while (m_toSend > 0 && s->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (m_toSend, std::min (s->GetTxAvailable (), 10000U));
+      int sent = s->Send (Create<Packet> (size));
+      if (sent <= 0)
+        {
+          return;
+        }
+      m_toSend -= sent;
+    }
+}
+
+void
+TcpGsoTestCase::Tx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> payload = p->Copy ();
+  Ipv4Header ipHeader;
+  TcpHeader tcpHeader;
+  payload->RemoveHeader (ipHeader);
+  payload->RemoveHeader (tcpHeader);
+  CountData (p, payload, ipHeader.GetSerializedSize () + tcpHeader.GetSerializedSize ());
+}
+
+void
+TcpGsoTestCase::Tx6 (Ptr<const Packet> p, Ptr<Ipv6> ipv6, uint32_t interface)
+{
+  Ptr<Packet> payload = p->Copy ();
+  Ipv6Header ipHeader;
+  TcpHeader tcpHeader;
+  payload->RemoveHeader (ipHeader);
+  payload->RemoveHeader (tcpHeader);
+  CountData (p, payload, ipHeader.GetSerializedSize () + tcpHeader.GetSerializedSize ());
+}
+
+void
+TcpGsoTestCase::CountData (Ptr<const Packet> p, Ptr<const Packet> payload, uint32_t headerSize)
+{
+  if (payload->GetSize () > 0)
+    {
+      m_packets++;
+      m_maxSize = std::max (m_maxSize, payload->GetSize ());
+      m_maxSegs = std::max (m_maxSegs, GsoTag::GetSegments (p));
+      GsoTag gsoTag;
+      if (p->PeekPacketTag (gsoTag) && gsoTag.GetHeaderSize () != headerSize)
+        {
+          m_badHeaders++;
+        }
+    }
+}
+
+Ptr<Socket>
+TcpGsoTestCase::CreateSocket (Ptr<Node> node, bool mptcp)
+{
+  if (mptcp)
+    {
+      return node->GetObject<TcpL4Protocol> ()->CreateSocket (TcpNewReno::GetTypeId (),
+                                                              MpTcpMetaSocket::GetTypeId ());
+    }
+  return Socket::CreateSocket (node, TcpSocketFactory::GetTypeId ());
+}
+
+void
+TcpGsoTestCase::RunTransfer (uint32_t gsoMaxSegments, bool mptcp, bool ipv6)
+{
+  m_toSend = 500000;
+  m_received = 0;
+  m_packets = 0;
+  m_maxSize = 0;
+  m_maxSegs = 0;
+  m_badHeaders = 0;
+
+  // The addresses are usable at once, without duplicate address detection
+  Config::SetDefault ("ns3::Icmpv6L4Protocol::DAD", BooleanValue (false));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      dev->SetMtu (1500);
+      dev->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+      dev->SetChannel (channel);
+      nodes.Get (i)->AddDevice (dev);
+      devices.Add (dev);
+    }
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+  Ipv6AddressHelper ipv6Helper;
+  ipv6Helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces6 = ipv6Helper.Assign (devices);
+
+  // The sender is not node 0, whose MPTCP meta sockets exchange states
+  // with the RL agent.  The master subflow is created with the meta
+  // socket, so the sender attributes are defaults.
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1000));
+  Config::SetDefault ("ns3::TcpSocketImpl::GsoMaxSegments", UintegerValue (gsoMaxSegments));
+  Ptr<Socket> server = CreateSocket (nodes.Get (0), mptcp);
+  if (ipv6)
+    {
+      server->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 50000));
+    }
+  else
+    {
+      server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+    }
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpGsoTestCase::Accept, this));
+
+  Ptr<Socket> source = CreateSocket (nodes.Get (1), mptcp);
+  source->SetSendCallback (MakeCallback (&TcpGsoTestCase::Send, this));
+  if (ipv6)
+    {
+      nodes.Get (1)->GetObject<Ipv6L3Protocol> ()->TraceConnectWithoutContext
+        ("Tx", MakeCallback (&TcpGsoTestCase::Tx6, this));
+      source->Bind6 ();
+      source->Connect (Inet6SocketAddress (interfaces6.GetAddress (0, 1), 50000));
+    }
+  else
+    {
+      nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext
+        ("Tx", MakeCallback (&TcpGsoTestCase::Tx, this));
+      source->Bind ();
+      source->Connect (InetSocketAddress (interfaces.GetAddress (0), 50000));
+    }
+  Simulator::ScheduleNow (&TcpGsoTestCase::Send, this, source, 0);
+
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  Config::Reset ();
+}
+
+void
+TcpGsoTestCase::DoRun (void)
+{
+  RunTransfer (1, false);
+  NS_TEST_ASSERT_MSG_EQ (m_received, 500000, "Data lost without segmentation offload");
+  NS_TEST_EXPECT_MSG_EQ (m_maxSize, 1000, "Segment larger than the MSS without segmentation offload");
+  NS_TEST_EXPECT_MSG_EQ (m_maxSegs, 1, "Super-segment sent without segmentation offload");
+  uint32_t packets = m_packets;
+
+  RunTransfer (16, false);
+  NS_TEST_ASSERT_MSG_EQ (m_received, 500000, "Data lost with segmentation offload");
+  NS_TEST_EXPECT_MSG_GT (m_maxSize, 1500, "No super-segment larger than the MTU");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxSize, 16000, "Super-segment larger than GsoMaxSegments segments");
+  NS_TEST_EXPECT_MSG_EQ (m_maxSegs, (m_maxSize + 999) / 1000, "Unexpected number of segments");
+  NS_TEST_EXPECT_MSG_LT (m_packets * 4, packets, "Not enough data packets saved");
+  NS_TEST_EXPECT_MSG_EQ (m_badHeaders, 0, "Wrong header size in the GsoTag");
+
+  RunTransfer (1, false, true);
+  NS_TEST_ASSERT_MSG_EQ (m_received, 500000, "Data lost over IPv6 without segmentation offload");
+  NS_TEST_EXPECT_MSG_EQ (m_maxSegs, 1, "Super-segment sent over IPv6 without segmentation offload");
+  uint32_t ipv6Packets = m_packets;
+
+  RunTransfer (16, false, true);
+  NS_TEST_ASSERT_MSG_EQ (m_received, 500000, "Data lost over IPv6 with segmentation offload");
+  NS_TEST_EXPECT_MSG_GT (m_maxSize, 1500, "No super-segment larger than the MTU over IPv6");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxSize, 16000, "Super-segment larger than GsoMaxSegments segments over IPv6");
+  NS_TEST_EXPECT_MSG_EQ (m_maxSegs, (m_maxSize + 999) / 1000, "Unexpected number of segments over IPv6");
+  NS_TEST_EXPECT_MSG_LT (m_packets * 4, ipv6Packets, "Not enough data packets saved over IPv6");
+  NS_TEST_EXPECT_MSG_EQ (m_badHeaders, 0, "Wrong IPv6 header size in the GsoTag");
+
+  RunTransfer (1, true);
+  NS_TEST_ASSERT_MSG_EQ (m_received, 500000, "Data lost on the MPTCP subflow without segmentation offload");
+  NS_TEST_EXPECT_MSG_EQ (m_maxSegs, 1, "Super-segment sent on the MPTCP subflow without segmentation offload");
+  uint32_t mptcpPackets = m_packets;
+
+  RunTransfer (16, true);
+  NS_TEST_ASSERT_MSG_EQ (m_received, 500000, "Data lost on the MPTCP subflow with segmentation offload");
+  NS_TEST_EXPECT_MSG_GT (m_maxSize, 1500, "No super-segment larger than the MTU on the MPTCP subflow");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxSize, 16000, "Super-segment larger than GsoMaxSegments segments on the MPTCP subflow");
+  NS_TEST_EXPECT_MSG_EQ (m_maxSegs, (m_maxSize + 999) / 1000, "Unexpected number of segments on the MPTCP subflow");
+  NS_TEST_EXPECT_MSG_LT (m_packets * 4, mptcpPackets, "Not enough data packets saved on the MPTCP subflow");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload test suite
+ */
+static class TcpGsoTestSuite : public TestSuite
+{
+public:
+  TcpGsoTestSuite ()
+    : TestSuite ("tcp-gso", UNIT)
+  {
+    AddTestCase (new TcpGsoTestCase (), TestCase::QUICK);
+  }
+} g_tcpGsoTestSuite; ///< the test suite
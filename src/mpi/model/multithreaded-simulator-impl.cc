@@ -0,0 +1,781 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/uinteger.h"
+#include "ns3/callback.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/** Largest timestamp, for LPs without events. */
+const uint64_t MAX_TS = std::numeric_limits<uint64_t>::max ();
+
+/**
+ * Find the partition of a node.
+ * \param [in,out] parent The union-find forest, indexed by node id.
+ * \param [in] id The node id.
+ * \returns The id of the node which represents the partition.
+ */
+uint32_t
+FindRoot (std::vector<uint32_t> &parent, uint32_t id)
+{
+  while (parent[id] != id)
+    {
+      parent[id] = parent[parent[id]];
+      id = parent[id];
+    }
+  return id;
+}
+
+/**
+ * Order of the messages inserted in an LP, independent of the threads.
+ * \param [in] a A message.
+ * \param [in] b Another message.
+ * \returns true if a must be inserted before b.
+ */
+template <typename M>
+bool
+MessageLess (const M *a, const M *b)
+{
+  if (a->ts != b->ts)
+    {
+      return a->ts < b->ts;
+    }
+  if (a->src != b->src)
+    {
+      return a->src < b->src;
+    }
+  return a->seq < b->seq;
+}
+
+} // unnamed namespace
+
+thread_local MultithreadedSimulatorImpl::LogicalProcess *MultithreadedSimulatorImpl::g_currentLp = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "The largest number of threads running the partitions, "
+                   "0 for one per processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MinLookahead",
+                   "Point-to-point links with a smaller delay do not separate partitions.",
+                   TimeValue (MicroSeconds (1)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_minLookahead),
+                   MakeTimeChecker (TimeStep (1)))
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_partitioned (false),
+    m_lookahead (MAX_TS),
+    m_maxThreads (0),
+    m_stop (false),
+    m_round (0),
+    m_windowEnd (0),
+    m_nextLp (0),
+    m_nThreads (1),
+    m_barrierCount (0),
+    m_barrierGeneration (0),
+    m_done (false)
+{
+  NS_LOG_FUNCTION (this);
+  m_public = CreateLogicalProcess (0);
+  // uids are allocated from 4, as in DefaultSimulatorImpl
+  m_public->m_uid = 4;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::CreateLogicalProcess (uint32_t id) const
+{
+  LogicalProcess *lp = new LogicalProcess;
+  lp->m_id = id;
+  lp->m_uid = 0;
+  lp->m_currentUid = 0;
+  lp->m_currentTs = 0;
+  lp->m_currentContext = Simulator::NO_CONTEXT;
+  lp->m_unscheduledEvents = 0;
+  lp->m_mailbox[0] = 0;
+  lp->m_mailbox[1] = 0;
+  lp->m_sendSeq = 0;
+  lp->m_minSent = MAX_TS;
+  return lp;
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lps.push_back (m_public);
+  for (std::vector<LogicalProcess *>::iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      LogicalProcess *lp = *i;
+      for (uint32_t parity = 0; parity < 2; parity++)
+        {
+          Message *msg = lp->m_mailbox[parity].exchange (0);
+          while (msg != 0)
+            {
+              Message *next = msg->next;
+              msg->event->Unref ();
+              delete msg;
+              msg = next;
+            }
+        }
+      if (lp->m_events != 0)
+        {
+          while (!lp->m_events->IsEmpty ())
+            {
+              Scheduler::Event next = lp->m_events->RemoveNext ();
+              next.impl->Unref ();
+            }
+        }
+      delete lp;
+    }
+  m_lps.clear ();
+  m_public = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+
+  std::vector<LogicalProcess *> lps (m_lps);
+  lps.push_back (m_public);
+  for (std::vector<LogicalProcess *>::iterator i = lps.begin (); i != lps.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->m_events != 0)
+        {
+          while (!(*i)->m_events->IsEmpty ())
+            {
+              scheduler->Insert ((*i)->m_events->RemoveNext ());
+            }
+        }
+      (*i)->m_events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  LogicalProcess *lp = Current ();
+  return lp == m_public ? 0 : lp->m_id;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_lps.size ();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return m_lookahead == MAX_TS ? GetMaximumSimulationTime () : TimeStep (m_lookahead);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetThreadCount (void) const
+{
+  return m_nThreads;
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::Current (void) const
+{
+  return g_currentLp != 0 ? g_currentLp : m_public;
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::Owner (uint32_t context, LogicalProcess *current) const
+{
+  if (context < m_lpOfNode.size ())
+    {
+      return m_lps[m_lpOfNode[context]];
+    }
+  return current;
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::Holder (const EventId &id) const
+{
+  // Insert () records the LP in the event: zero for the public LP,
+  // the index of a node LP plus one otherwise
+  uint32_t owner = id.PeekEventImpl ()->GetOwner ();
+  return owner == 0 ? m_public : m_lps[owner - 1];
+}
+
+void
+MultithreadedSimulatorImpl::Partition (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+
+  // Only the point-to-point channels give a deep copy of the packets
+  // to the receiver, so only they can separate partitions
+  TypeId p2pTid;
+  bool haveP2p = TypeId::LookupByNameFailSafe ("ns3::PointToPointChannel", &p2pTid);
+
+  struct Link
+  {
+    uint32_t a;
+    uint32_t b;
+    uint64_t delay;
+  };
+  std::vector<Link> links;
+  std::vector<uint32_t> parent (nNodes);
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      parent[i] = i;
+    }
+
+  for (NodeList::Iterator n = NodeList::Begin (); n != NodeList::End (); ++n)
+    {
+      uint32_t id = (*n)->GetId ();
+      for (uint32_t i = 0; i < (*n)->GetNDevices (); i++)
+        {
+          Ptr<Channel> channel = (*n)->GetDevice (i)->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          if (haveP2p && channel->GetInstanceTypeId () == p2pTid && channel->GetNDevices () == 2)
+            {
+              TimeValue delay;
+              channel->GetAttribute ("Delay", delay);
+              if (delay.Get () >= m_minLookahead)
+                {
+                  Link link;
+                  link.a = channel->GetDevice (0)->GetNode ()->GetId ();
+                  link.b = channel->GetDevice (1)->GetNode ()->GetId ();
+                  link.delay = delay.Get ().GetTimeStep ();
+                  links.push_back (link);
+                  continue;
+                }
+            }
+          for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+            {
+              uint32_t other = channel->GetDevice (j)->GetNode ()->GetId ();
+              parent[FindRoot (parent, other)] = FindRoot (parent, id);
+            }
+        }
+    }
+
+  // One LP per connected component, numbered by smallest node id
+  std::vector<uint32_t> lpOfRoot (nNodes, nNodes);
+  m_lpOfNode.resize (nNodes);
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      uint32_t root = FindRoot (parent, i);
+      if (lpOfRoot[root] == nNodes)
+        {
+          lpOfRoot[root] = m_lps.size ();
+          LogicalProcess *lp = CreateLogicalProcess (m_lps.size ());
+          lp->m_events = m_schedulerFactory.Create<Scheduler> ();
+          lp->m_uid = m_public->m_uid;
+          lp->m_currentTs = m_public->m_currentTs;
+          m_lps.push_back (lp);
+        }
+      m_lpOfNode[i] = lpOfRoot[root];
+      NodeList::GetNode (i)->SetAttribute ("SystemId", UintegerValue (m_lpOfNode[i]));
+    }
+
+  m_lookahead = MAX_TS;
+  for (std::vector<Link>::const_iterator i = links.begin (); i != links.end (); ++i)
+    {
+      if (m_lpOfNode[i->a] != m_lpOfNode[i->b])
+        {
+          m_lookahead = std::min (m_lookahead, i->delay);
+        }
+    }
+
+  // Hand the events scheduled so far for the nodes to their LP
+  std::vector<Scheduler::Event> kept;
+  while (!m_public->m_events->IsEmpty ())
+    {
+      Scheduler::Event ev = m_public->m_events->RemoveNext ();
+      if (ev.key.m_context < nNodes)
+        {
+          LogicalProcess *lp = m_lps[m_lpOfNode[ev.key.m_context]];
+          ev.impl->SetOwner (lp->m_id + 1);
+          lp->m_events->Insert (ev);
+          lp->m_unscheduledEvents++;
+          m_public->m_unscheduledEvents--;
+        }
+      else
+        {
+          kept.push_back (ev);
+        }
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = kept.begin (); i != kept.end (); ++i)
+    {
+      m_public->m_events->Insert (*i);
+    }
+
+  m_partitioned = true;
+  NS_LOG_INFO (nNodes << " nodes in " << m_lps.size () << " partitions, lookahead " << GetLookahead ());
+}
+
+Scheduler::Event
+MultithreadedSimulatorImpl::Insert (LogicalProcess *lp, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = lp->m_uid;
+  lp->m_uid++;
+  event->SetOwner (lp == m_public ? 0 : lp->m_id + 1);
+  lp->m_unscheduledEvents++;
+  lp->m_events->Insert (ev);
+  return ev;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextTs (LogicalProcess *lp) const
+{
+  return lp->m_events->IsEmpty () ? MAX_TS : lp->m_events->PeekNext ().key.m_ts;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextPartitionTs (void) const
+{
+  uint64_t next = MAX_TS;
+  for (std::vector<LogicalProcess *>::const_iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      next = std::min (next, std::min (NextTs (*i), (*i)->m_minSent));
+    }
+  return next;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (LogicalProcess *lp)
+{
+  Scheduler::Event next = lp->m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= lp->m_currentTs);
+  lp->m_unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  lp->m_currentTs = next.key.m_ts;
+  lp->m_currentContext = next.key.m_context;
+  lp->m_currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (LogicalProcess *lp)
+{
+  g_currentLp = lp;
+  lp->m_minSent = MAX_TS;
+
+  // The messages sent during the previous round, in an order which
+  // does not depend on the threads
+  Message *msg = lp->m_mailbox[(m_round - 1) & 1].exchange (0, std::memory_order_acquire);
+  while (msg != 0)
+    {
+      lp->m_inbox.push_back (msg);
+      msg = msg->next;
+    }
+  if (!lp->m_inbox.empty ())
+    {
+      std::sort (lp->m_inbox.begin (), lp->m_inbox.end (), MessageLess<Message>);
+      for (std::vector<Message *>::const_iterator i = lp->m_inbox.begin (); i != lp->m_inbox.end (); ++i)
+        {
+          Insert (lp, (*i)->ts, (*i)->context, (*i)->event);
+          delete *i;
+        }
+      lp->m_inbox.clear ();
+    }
+
+  while (!m_stop && !lp->m_events->IsEmpty ()
+         && lp->m_events->PeekNext ().key.m_ts < m_windowEnd)
+    {
+      ProcessOneEvent (lp);
+    }
+  g_currentLp = 0;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessPartitions (void)
+{
+  uint32_t i;
+  while ((i = m_nextLp++) < m_lps.size ())
+    {
+      ProcessWindow (m_lps[i]);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  if (m_nThreads == 1)
+    {
+      return;
+    }
+  uint32_t generation = m_barrierGeneration.load ();
+  if (++m_barrierCount == m_nThreads)
+    {
+      m_barrierCount = 0;
+      m_barrierGeneration++;
+      return;
+    }
+  while (m_barrierGeneration.load () == generation)
+    {
+      std::this_thread::yield ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ThreadRun (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (true)
+    {
+      Barrier ();
+      if (m_done)
+        {
+          return;
+        }
+      ProcessPartitions ();
+      Barrier ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return m_stop || (m_public->m_events->IsEmpty () && NextPartitionTs () == MAX_TS);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_partitioned)
+    {
+      Partition ();
+    }
+  m_stop = false;
+
+  m_nThreads = m_maxThreads > 0 ? m_maxThreads : std::max (1u, std::thread::hardware_concurrency ());
+  m_nThreads = std::max (1u, std::min<uint32_t> (m_nThreads, m_lps.size ()));
+#ifndef NS3_MTP
+  if (m_nThreads > 1)
+    {
+      NS_LOG_WARN ("ns-3 was configured without --enable-mtp: running the partitions on one thread");
+      m_nThreads = 1;
+    }
+#endif
+  m_done = false;
+  m_barrierCount = 0;
+  for (uint32_t i = 1; i < m_nThreads; i++)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::ThreadRun, this));
+      thread->Start ();
+      m_threads.push_back (thread);
+    }
+
+  while (true)
+    {
+      // Serial phase: the events without a node context run while all
+      // the LPs are at or before their timestamp
+      uint64_t next = NextPartitionTs ();
+      while (!m_stop && !m_public->m_events->IsEmpty () && NextTs (m_public) <= next)
+        {
+          ProcessOneEvent (m_public);
+          next = NextPartitionTs ();
+        }
+      if (m_stop || next == MAX_TS)
+        {
+          break;
+        }
+
+      // Parallel phase: no message sent in the window can be for an
+      // event inside the window
+      m_windowEnd = next > MAX_TS - m_lookahead ? MAX_TS : next + m_lookahead;
+      m_windowEnd = std::min (m_windowEnd, NextTs (m_public));
+      m_round++;
+      m_nextLp = 0;
+      Barrier ();
+      ProcessPartitions ();
+      Barrier ();
+    }
+
+  m_done = true;
+  Barrier ();
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  Simulator::Schedule (delay, &Simulator::Stop);
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  LogicalProcess *lp = Current ();
+
+  Time tAbsolute = delay + TimeStep (lp->m_currentTs);
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (lp->m_currentTs));
+  Scheduler::Event ev = Insert (lp, tAbsolute.GetTimeStep (), lp->m_currentContext, event);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+  LogicalProcess *current = Current ();
+  LogicalProcess *target = Owner (context, current);
+  uint64_t ts = current->m_currentTs + delay.GetTimeStep ();
+
+  // The main thread only runs while the LPs are paused
+  if (target == current || g_currentLp == 0)
+    {
+      Insert (target, ts, context, event);
+      return;
+    }
+
+  NS_ABORT_MSG_IF ((uint64_t) delay.GetTimeStep () < m_lookahead,
+                   "Event for node " << context << " in " << delay <<
+                   ", within the lookahead of its partition: " << GetLookahead ());
+  Message *msg = new Message;
+  msg->event = event;
+  msg->ts = ts;
+  msg->context = context;
+  msg->src = current->m_id;
+  msg->seq = current->m_sendSeq++;
+  current->m_minSent = std::min (current->m_minSent, ts);
+
+  std::atomic<Message *> &head = target->m_mailbox[m_round & 1];
+  msg->next = head.load (std::memory_order_relaxed);
+  while (!head.compare_exchange_weak (msg->next, msg, std::memory_order_release,
+                                      std::memory_order_relaxed))
+    {
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  CriticalSection cs (m_destroyEventsMutex);
+  EventId id (Ptr<EventImpl> (event, false), Current ()->m_currentTs, 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (Current ()->m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  return TimeStep (id.GetTs () - Current ()->m_currentTs);
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  LogicalProcess *lp = Holder (id);
+  if (lp != Current () && g_currentLp != 0)
+    {
+      // The thread of the other LP may be using its event list: the
+      // event stays there, cancelled
+      id.PeekEventImpl ()->Cancel ();
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  lp->m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  lp->m_unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  if (id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  LogicalProcess *lp = Holder (id);
+  if (lp != Current () && g_currentLp != 0)
+    {
+      // The thread of the other LP moves its clock meanwhile: the event
+      // itself tells whether that thread ran it
+      return id.PeekEventImpl ()->IsInvoked ();
+    }
+  if (id.GetTs () < lp->m_currentTs
+      || (id.GetTs () == lp->m_currentTs && id.GetUid () <= lp->m_currentUid))
+    {
+      return true;
+    }
+  return false;
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return Current ()->m_currentContext;
+}
+
+} // namespace ns3
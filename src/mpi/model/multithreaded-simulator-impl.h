@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/object-factory.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Shared-memory parallel simulator implementation using lookahead
+ *
+ * When Run () is first called, the nodes are partitioned into logical
+ * processes (LPs): the nodes attached to a channel always share an LP,
+ * except for the two ends of a point-to-point link whose delay is at
+ * least MinLookahead. The lookahead is the smallest delay of the
+ * point-to-point links between different LPs. Each node gets the index
+ * of its LP as SystemId, and Simulator::GetSystemId () returns the
+ * index of the LP being run.
+ *
+ * The simulation proceeds in rounds, with the conservative
+ * synchronization of DistributedSimulatorImpl: all the LPs process
+ * their events up to the smallest next event time plus the lookahead,
+ * on up to MaxThreads threads, then wait for each other. An event
+ * scheduled with the context of a node in another LP is pushed into
+ * a lock-free mailbox of that LP, and inserted in its event list at
+ * the next round. The point-to-point channels give the receiver a
+ * deep copy of the packets which cross LPs.
+ *
+ * Events without a node context (in particular the events scheduled
+ * before Run () from the main program, such as Simulator::Stop) run on
+ * the main thread, while all the LPs are paused at their timestamp.
+ * Events scheduled by an LP without a node context stay in that LP.
+ *
+ * A node may cancel, or check, an event held by another LP while that
+ * LP runs: the event is only flagged as cancelled, and it counts as
+ * expired once the other LP started it. Whether that already happened
+ * depends on the threads, unless the timestamp of the event is at
+ * least a lookahead before or after the current time.
+ *
+ * Results do not depend on the number of threads. Ties between events
+ * with the same timestamp may be broken differently than with
+ * DefaultSimulatorImpl.
+ *
+ * The reference counts and the packet buffers are only thread-safe when
+ * ns-3 is configured with --enable-mtp: without it, the LPs are all run
+ * by the main thread. Packet metadata (Packet::EnablePrinting) is not
+ * supported with several threads, and the models must not share objects
+ * between nodes of different LPs.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns The number of LPs, zero before the first Run ().
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * \returns The lookahead between the LPs, valid after the first Run ().
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \returns The number of threads which ran the LPs in the last Run ().
+   */
+  uint32_t GetThreadCount (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event sent to another LP. */
+  struct Message
+  {
+    EventImpl *event;   //!< The event
+    uint64_t ts;        //!< Absolute timestamp
+    uint32_t context;   //!< Context of the event
+    uint32_t src;       //!< Index of the sending LP
+    uint64_t seq;       //!< Sequence number in the sending LP
+    Message *next;      //!< Next message in the mailbox
+  };
+
+  /** A logical process: a partition of the nodes with its own event list. */
+  struct LogicalProcess
+  {
+    uint32_t m_id;                      //!< Index of the LP
+    Ptr<Scheduler> m_events;            //!< Event list
+    uint32_t m_uid;                     //!< Next event uid
+    /** Uid of the event being run, not read by the other LPs. */
+    uint32_t m_currentUid;
+    /** Timestamp of the event being run, not read by the other LPs. */
+    uint64_t m_currentTs;
+    uint32_t m_currentContext;          //!< Context of the event being run
+    int m_unscheduledEvents;            //!< Events in the event list
+    /** Messages from the other LPs, per round parity. */
+    std::atomic<Message *> m_mailbox[2];
+    uint64_t m_sendSeq;                 //!< Messages sent so far
+    uint64_t m_minSent;                 //!< Smallest timestamp sent in this round
+    std::vector<Message *> m_inbox;     //!< Messages being inserted
+  };
+
+  /**
+   * \returns The LP of the calling thread: the public LP outside of
+   * the parallel phases.
+   */
+  LogicalProcess * Current (void) const;
+  /**
+   * \param [in] context A node context.
+   * \param [in] current The LP scheduling the event.
+   * \returns The LP which runs the events of this context.
+   */
+  LogicalProcess * Owner (uint32_t context, LogicalProcess *current) const;
+  /**
+   * \param [in] id A scheduled event.
+   * \returns The LP whose event list holds the event: events without
+   * a node context stay with the LP which scheduled them.
+   */
+  LogicalProcess * Holder (const EventId &id) const;
+  /**
+   * Create an LP with an empty event list.
+   * \param [in] id The index of the LP.
+   * \returns The new LP.
+   */
+  LogicalProcess * CreateLogicalProcess (uint32_t id) const;
+  /**
+   * Insert an event in the event list of an LP.
+   * \param [in] lp The LP.
+   * \param [in] ts The absolute timestamp.
+   * \param [in] context The context of the event.
+   * \param [in] event The event.
+   * \returns The scheduler event.
+   */
+  Scheduler::Event Insert (LogicalProcess *lp, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * \param [in] lp An LP.
+   * \returns The timestamp of its next event, or the largest timestamp.
+   */
+  uint64_t NextTs (LogicalProcess *lp) const;
+  /**
+   * \returns The smallest timestamp of the events of the node LPs,
+   * including those in the mailboxes.
+   */
+  uint64_t NextPartitionTs (void) const;
+  /** Partition the nodes, compute the lookahead and dispatch the events. */
+  void Partition (void);
+  /** Run the next event of an LP. \param [in] lp The LP. */
+  void ProcessOneEvent (LogicalProcess *lp);
+  /**
+   * Insert the messages of the previous round, then run the events
+   * before the end of the window.
+   * \param [in] lp The LP.
+   */
+  void ProcessWindow (LogicalProcess *lp);
+  /** Run the windows of the LPs not yet taken by another thread. */
+  void ProcessPartitions (void);
+  /** Wait until all the threads reach this point. */
+  void Barrier (void);
+  /** Main loop of the additional threads. */
+  void ThreadRun (void);
+
+  /** The LP of the calling thread, zero outside of the parallel phases. */
+  static thread_local LogicalProcess *g_currentLp;
+
+  typedef std::list<EventId> DestroyEvents;
+  DestroyEvents m_destroyEvents;        //!< Events to run at Destroy
+  SystemMutex m_destroyEventsMutex;     //!< Protects m_destroyEvents
+
+  ObjectFactory m_schedulerFactory;     //!< Factory of the event lists
+  LogicalProcess *m_public;             //!< Events without a node context
+  std::vector<LogicalProcess *> m_lps;  //!< The node LPs
+  std::vector<uint32_t> m_lpOfNode;     //!< LP index, per node id
+  bool m_partitioned;                   //!< Partition () was called
+  Time m_minLookahead;                  //!< Smallest delay of a link between LPs
+  uint64_t m_lookahead;                 //!< Lookahead, in timesteps
+  uint32_t m_maxThreads;                //!< Largest number of threads
+
+  std::atomic<bool> m_stop;             //!< Stop () was called
+  uint32_t m_round;                     //!< Current round
+  uint64_t m_windowEnd;                 //!< Events before this timestamp may run
+  std::atomic<uint32_t> m_nextLp;       //!< Next LP to take in this round
+  uint32_t m_nThreads;                  //!< Threads running the LPs
+  std::atomic<uint32_t> m_barrierCount; //!< Threads waiting at the barrier
+  std::atomic<uint32_t> m_barrierGeneration; //!< Barriers passed
+  bool m_done;                          //!< The additional threads must exit
+  std::vector<Ptr<SystemThread> > m_threads; //!< The additional threads
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
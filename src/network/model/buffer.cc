@@ -20,6 +20,7 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/block-pool.h"
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -52,94 +53,68 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+namespace {
+
+/** Data size of the smallest buffer size class, in bytes. */
+const uint32_t BUFFER_POOL_MIN_SIZE = 64;
+/** Number of buffer size classes, doubling in size: up to 64KiB. */
+const uint32_t BUFFER_POOL_CLASSES = 11;
+
+/**
+ * \param [in] size A data size.
+ * \returns The smallest size class which holds \p size bytes,
+ * BUFFER_POOL_CLASSES if none does.
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
+uint32_t
+BufferSizeClass (uint32_t size)
 {
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  uint32_t sizeClass = 0;
+  while (sizeClass < BUFFER_POOL_CLASSES
+         && (BUFFER_POOL_MIN_SIZE << sizeClass) < size)
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
+      sizeClass++;
     }
+  return sizeClass;
 }
 
+/** Free buffer data of the current thread. */
+thread_local BlockPool<BUFFER_POOL_CLASSES> g_bufferPool;
+
+} // unnamed namespace
+
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  // Only the data allocated for a whole size class goes back to the pool
+  uint32_t sizeClass = BufferSizeClass (data->m_size);
+  if (sizeClass == BUFFER_POOL_CLASSES
+      || data->m_size != BUFFER_POOL_MIN_SIZE << sizeClass
+      || !g_bufferPool.Push (sizeClass, data))
     {
       Buffer::Deallocate (data);
     }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  uint32_t sizeClass = BufferSizeClass (dataSize);
+  if (sizeClass == BUFFER_POOL_CLASSES)
     {
-      g_freeList = new Buffer::FreeList ();
+      return Buffer::Allocate (dataSize);
     }
-  else if (IS_INITIALIZED (g_freeList))
+  struct Buffer::Data *data = static_cast<struct Buffer::Data *> (g_bufferPool.Pop (sizeClass));
+  if (data == 0)
     {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
+      // Allocate the whole class, so that the data fits any buffer of the class
+      data = Buffer::Allocate (BUFFER_POOL_MIN_SIZE << sizeClass);
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
+  // The free list link overwrote the head of the data
+  data->m_count = 1;
+  data->m_size = BUFFER_POOL_MIN_SIZE << sizeClass;
   return data;
 }
 #else /* BUFFER_FREE_LIST */
@@ -169,8 +144,7 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
-  struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
+  struct Buffer::Data *data = static_cast<struct Buffer::Data *> (::operator new (size));
   data->m_size = reqSize;
   data->m_count = 1;
   return data;
@@ -181,8 +155,7 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
+  ::operator delete (data);
 }
 
 Buffer::Buffer ()
@@ -400,9 +373,16 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
-      m_end == m_zeroAreaEnd &&
-      m_end == m_data->m_dirtyEnd &&
+  if (GetSize () == 0)
+    {
+      // Share the data of o, whose zero area stays virtual
+      uint32_t maxZeroAreaStart = m_maxZeroAreaStart;
+      *this = o;
+      m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, maxZeroAreaStart);
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
+  if (m_end == m_zeroAreaEnd &&
       o.m_start == o.m_zeroAreaStart &&
       o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
     {
@@ -411,6 +391,23 @@ Buffer::AddAtEnd (const Buffer &o)
        * we attempt to aggregate two buffers which contain
        * adjacent zero areas.
        */
+      if (m_data->m_count != 1 || m_end != m_data->m_dirtyEnd)
+        {
+          /* The data is shared and may not be extended in place:
+           * copy the bytes before the zero area only, at the same
+           * offset to keep the room for the headers.
+           */
+          struct Buffer::Data *newData = Buffer::Create (m_zeroAreaStart);
+          memcpy (newData->m_data + m_start, m_data->m_data + m_start, m_zeroAreaStart - m_start);
+          m_data->m_count--;
+          if (m_data->m_count == 0)
+            {
+              Buffer::Recycle (m_data);
+            }
+          m_data = newData;
+          m_data->m_dirtyStart = m_start;
+          m_data->m_dirtyEnd = m_end;
+        }
       uint32_t zeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
       m_zeroAreaEnd += zeroSize;
       m_end = m_zeroAreaEnd;
@@ -1123,12 +1120,36 @@ void
 Buffer::Iterator::Read (uint8_t *buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
+  const uint8_t *data = GetContiguous (size);
+  if (data != 0)
+    {
+      memcpy (buffer, data, size);
+      m_current += size;
+      return;
+    }
   for (uint32_t i = 0; i < size; i++)
     {
       buffer[i] = ReadU8 ();
     }
 }
 
+const uint8_t *
+Buffer::Iterator::GetContiguous (uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT_MSG (m_current >= m_dataStart && m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
+  if (m_current + size <= m_zeroStart)
+    {
+      return &m_data[m_current];
+    }
+  else if (m_current >= m_zeroEnd)
+    {
+      return &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+    }
+  return 0;
+}
+
 uint16_t
 Buffer::Iterator::CalculateIpChecksum (uint16_t size)
 {
@@ -1143,11 +1164,28 @@ Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
   /* see RFC 1071 to understand this code. */
   uint32_t sum = initialChecksum;
 
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
+  const uint8_t *data = GetContiguous (size);
+  if (data != 0)
+    {
+      // Same words as ReadU16, without checking the zero area for each byte
+      for (uint32_t j = 0; j + 1 < size; j += 2)
+        {
+          sum += data[j] | (data[j + 1] << 8);
+        }
+      if (size & 1)
+        {
+          sum += data[size - 1];
+        }
+      m_current += size;
+    }
+  else
+    {
+      for (int j = 0; j < size/2; j++)
+        sum += ReadU16 ();
 
-  if (size & 1)
-    sum += ReadU8 ();
+      if (size & 1)
+        sum += ReadU8 ();
+    }
 
   while (sum >> 16)
     sum = (sum & 0xffff) + (sum >> 16);
@@ -405,6 +405,12 @@ private:
      * \returns true if [start, end) is not in the "virtual zero area".
      */
     bool CheckNoZero (uint32_t start, uint32_t end) const;
+    /**
+     * \param size the number of bytes to read from the current position.
+     * \returns a pointer to the bytes, or zero if they are not all
+     *          stored contiguously outside of the zero area.
+     */
+    const uint8_t * GetContiguous (uint32_t size) const;
     /**
      * Checks that the buffer position is not in the "virtual zero area".
      *
@@ -783,19 +789,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
@@ -22,7 +22,10 @@
 #include <vector>
 #include <cstring>
 
+// The free list is shared by all threads
+#ifndef NS3_MTP
 #define USE_FREE_LIST 1
+#endif
 #define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
 
@@ -124,6 +124,67 @@ NetDeviceQueue::HasWakeCallbackSet (void) const
   return (!m_wakeCallback.IsNull ());
 }
 
+void
+NetDeviceQueue::NotifyQueuedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  if (!m_queueLimits)
+    {
+      return;
+    }
+  m_queueLimits->Queued (bytes);
+  if (m_queueLimits->Available () >= 0)
+    {
+      return;
+    }
+  Stop ();
+}
+
+void
+NetDeviceQueue::NotifyTransmittedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  if ((!m_queueLimits) || (!bytes))
+    {
+      return;
+    }
+  m_queueLimits->Completed (bytes);
+  if (m_queueLimits->Available () < 0)
+    {
+      return;
+    }
+  if (m_stopped)
+    {
+      Wake ();
+    }
+}
+
+void
+NetDeviceQueue::ResetQueueLimits ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_queueLimits)
+    {
+      return;
+    }
+  m_queueLimits->Reset ();
+}
+
+void
+NetDeviceQueue::SetQueueLimits (Ptr<QueueLimits> ql)
+{
+  NS_LOG_FUNCTION (this << ql);
+  m_queueLimits = ql;
+  ResetQueueLimits ();
+}
+
+Ptr<QueueLimits>
+NetDeviceQueue::GetQueueLimits ()
+{
+  NS_LOG_FUNCTION (this);
+  return m_queueLimits;
+}
+
 
 NS_OBJECT_ENSURE_REGISTERED (NetDeviceQueueInterface);
 
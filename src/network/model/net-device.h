@@ -31,6 +31,7 @@
 #include "address.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/queue-limits.h"
 
 namespace ns3 {
 
@@ -213,9 +214,49 @@ public:
    */
   virtual bool HasWakeCallbackSet (void) const;
 
+  /**
+   * \brief Called by the netdevice to report the number of bytes queued to the device queue
+   * \param bytes number of bytes queued to the device queue
+   *
+   * If queue limits are set, the device queue is stopped when the amount of
+   * data queued exceeds the limit. This is the analogous to the
+   * netdev_tx_sent_queue function of the Linux kernel.
+   */
+  virtual void NotifyQueuedBytes (uint32_t bytes);
+
+  /**
+   * \brief Called by the netdevice to report the number of bytes it is going to transmit
+   * \param bytes number of bytes the device is going to transmit
+   *
+   * If queue limits are set, the limit is recomputed and the device queue,
+   * if stopped, is woken up when the amount of data queued is back within
+   * the limit.  The device must only call this method when its queue has room
+   * for another packet.  This is the analogous to the netdev_tx_completed_queue
+   * function of the Linux kernel.
+   */
+  virtual void NotifyTransmittedBytes (uint32_t bytes);
+
+  /**
+   * \brief Reset queue limits state
+   */
+  void ResetQueueLimits (void);
+
+  /**
+   * \brief Set queue limits to this queue
+   * \param ql the queue limits associated to this queue
+   */
+  void SetQueueLimits (Ptr<QueueLimits> ql);
+
+  /**
+   * \brief Get queue limits to this queue
+   * \return the queue limits associated to this queue, if any
+   */
+  Ptr<QueueLimits> GetQueueLimits (void);
+
 private:
   bool m_stopped;   //!< Status of the transmission queue
   WakeCallback m_wakeCallback;   //!< Wake callback
+  Ptr<QueueLimits> m_queueLimits;   //!< Queue limits object
 };
 
 
@@ -30,8 +30,11 @@
 #include "ns3/assert.h"
 #include "ns3/global-value.h"
 #include "ns3/boolean.h"
+#include "ns3/config.h"
 #include "ns3/simulator.h"
 
+#include <sstream>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Node");
@@ -67,7 +70,7 @@ Node::GetTypeId (void)
                    MakeUintegerAccessor (&Node::m_id),
                    MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("SystemId", "The systemId of this node: a unique integer used for parallel simulations.",
-                   TypeId::ATTR_GET || TypeId::ATTR_SET,
+                   TypeId::ATTR_GET | TypeId::ATTR_SET,
                    UintegerValue (0),
                    MakeUintegerAccessor (&Node::m_sid),
                    MakeUintegerChecker<uint32_t> ())
@@ -136,6 +139,12 @@ Node::AddDevice (Ptr<NetDevice> device)
   Simulator::ScheduleWithContext (GetId (), Seconds (0.0), 
                                   &NetDevice::Initialize, device);
   NotifyDeviceAdded (device);
+  if (IsInitialized () && Config::HasPersistentConnections ())
+    {
+      std::ostringstream oss;
+      oss << "/NodeList/" << GetId () << "/DeviceList/" << index;
+      Config::NotifyNewObject (device, oss.str ());
+    }
   return index;
 }
 Ptr<NetDevice>
@@ -162,6 +171,12 @@ Node::AddApplication (Ptr<Application> application)
   application->SetNode (this);
   Simulator::ScheduleWithContext (GetId (), Seconds (0.0), 
                                   &Application::Initialize, application);
+  if (IsInitialized () && Config::HasPersistentConnections ())
+    {
+      std::ostringstream oss;
+      oss << "/NodeList/" << GetId () << "/ApplicationList/" << index;
+      Config::NotifyNewObject (application, oss.str ());
+    }
   return index;
 }
 Ptr<Application> 
@@ -221,6 +236,15 @@ Node::DoInitialize (void)
     }
 
   Object::DoInitialize ();
+
+  // The persistent trace connections reach the objects aggregated
+  // to the node and the devices and applications added until now.
+  if (Config::HasPersistentConnections ())
+    {
+      std::ostringstream oss;
+      oss << "/NodeList/" << GetId ();
+      Config::NotifyNewObject (this, oss.str ());
+    }
 }
 
 void
@@ -22,6 +22,9 @@
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/block-pool.h"
 #include "packet-metadata.h"
 #include "buffer.h"
 #include "header.h"
@@ -33,25 +36,77 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+bool PacketMetadata::m_lean = false;
+bool PacketMetadata::m_leanChecked = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
 
-PacketMetadata::DataFreeList::~DataFreeList ()
+namespace {
+
+/** Size of the smallest metadata size class, in bytes. */
+const uint32_t METADATA_POOL_MIN_SIZE = 16;
+/** Number of metadata size classes, doubling in size: up to 2KiB. */
+const uint32_t METADATA_POOL_CLASSES = 8;
+
+/**
+ * \param [in] size A metadata size.
+ * \returns The smallest size class which holds \p size bytes,
+ * METADATA_POOL_CLASSES if none does.
+ */
+uint32_t
+MetadataSizeClass (uint32_t size)
 {
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
+  uint32_t sizeClass = 0;
+  while (sizeClass < METADATA_POOL_CLASSES
+         && (METADATA_POOL_MIN_SIZE << sizeClass) < size)
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+/** Free metadata storage of the current thread. */
+thread_local BlockPool<METADATA_POOL_CLASSES> g_metadataPool;
+
+} // unnamed namespace
+
+/**
+ * \ingroup packet
+ * \brief The packets do not track any metadata.
+ *
+ * Read once, when the first packet is created or the metadata is first
+ * enabled.
+ */
+static GlobalValue g_leanPackets ("LeanPackets",
+                                  "If true, the packets allocate no metadata storage and "
+                                  "enabling the packet metadata has no effect. "
+                                  "Must be set before the first packet is created.",
+                                  BooleanValue (false),
+                                  MakeBooleanChecker ());
+
+void
+PacketMetadata::CheckLean (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  BooleanValue lean;
+  // Packets created before the global value is registered are not lean,
+  // which is always safe
+  if (GlobalValue::GetValueByNameFailSafe ("LeanPackets", lean))
     {
-      PacketMetadata::Deallocate (*i);
+      m_lean = lean.Get ();
+      m_leanChecked = true;
     }
-  PacketMetadata::m_enable = false;
 }
 
 void 
 PacketMetadata::Enable (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  if (IsLean ())
+    {
+      NS_LOG_WARN ("Packet metadata not enabled, the packets are lean");
+      return;
+    }
   NS_ASSERT_MSG (!m_metadataSkipped,
                  "Error: attempting to enable the packet metadata "
                  "subsystem too late in the simulation, which is not allowed.\n"
@@ -67,7 +122,7 @@ PacketMetadata::EnableChecking (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   Enable ();
-  m_enableChecking = true;
+  m_enableChecking = m_enable;
 }
 
 void
@@ -133,6 +188,10 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_head == 0xffff && m_used == 0;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -571,47 +630,38 @@ struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
-  NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
-  if (size > m_maxSize)
+  uint32_t sizeClass = MetadataSizeClass (size);
+  if (sizeClass == METADATA_POOL_CLASSES)
     {
-      m_maxSize = size;
+      return PacketMetadata::Allocate (size);
     }
-  while (!m_freeList.empty ()) 
+  struct PacketMetadata::Data *data =
+    static_cast<struct PacketMetadata::Data *> (g_metadataPool.Pop (sizeClass));
+  if (data == 0)
     {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
+      NS_LOG_LOGIC ("create alloc size="<<(METADATA_POOL_MIN_SIZE << sizeClass));
+      return PacketMetadata::Allocate (METADATA_POOL_MIN_SIZE << sizeClass);
     }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  // The free list link overwrote the head of the storage
+  data->m_count = 1;
+  data->m_size = METADATA_POOL_MIN_SIZE << sizeClass;
+  data->m_dirtyEnd = 0;
+  NS_LOG_LOGIC ("create found size="<<data->m_size);
+  return data;
 }
 
 void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
+  // Only the storage allocated for a whole size class goes back to the pool
+  uint32_t sizeClass = MetadataSizeClass (data->m_size);
+  if (sizeClass == METADATA_POOL_CLASSES
+      || data->m_size != METADATA_POOL_MIN_SIZE << sizeClass
+      || !g_metadataPool.Push (sizeClass, data))
     {
       PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
     }
 }
 
@@ -625,8 +675,7 @@ PacketMetadata::Allocate (uint32_t n)
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
+  struct PacketMetadata::Data *data = static_cast<struct PacketMetadata::Data *> (::operator new (size));
   data->m_size = n;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
@@ -636,8 +685,7 @@ void
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  ::operator delete (data);
 }
 
 
@@ -159,6 +159,18 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Check whether the packets are lean
+   *
+   * Lean packets, selected by the LeanPackets global value, allocate no
+   * metadata storage at all, and Enable () and EnableChecking () have no
+   * effect on them, so that the tracing helpers cannot turn the metadata
+   * back on.  The global value is read only once, when the first packet
+   * is created or the metadata is first enabled.
+   *
+   * \returns true if the packets do not track any metadata
+   */
+  static inline bool IsLean (void);
 
   /**
    * \brief Constructor
@@ -491,16 +503,6 @@ private:
     uint64_t packetUid;
   };
 
-  /**
-   * \brief Class to hold all the metadata
-   */
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
-  };
-
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -656,9 +658,15 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  /**
+   * \brief Read the LeanPackets global value
+   */
+  static void CheckLean (void);
+
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_lean; //!< The packets do not allocate any metadata storage
+  static bool m_leanChecked; //!< The LeanPackets global value has been read
 
   /**
    * Set to true when adding metadata to a packet is skipped because
@@ -667,10 +675,9 @@ public:
    */
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
   static uint16_t m_chunkUid; //!< Chunk Uid
 
-  struct Data *m_data; //!< Metadata storage
+  struct Data *m_data; //!< Metadata storage, null for lean packets
   /*
      head -(next)-> tail
        ^             |
@@ -686,14 +693,27 @@ public:
 
 namespace ns3 {
 
+bool
+PacketMetadata::IsLean (void)
+{
+  if (!m_leanChecked)
+    {
+      CheckLean ();
+    }
+  return m_lean;
+}
+
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (IsLean () ? 0 : PacketMetadata::Create (10)),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
+  if (m_data != 0)
+    {
+      memset (m_data->m_data, 0xff, 4);
+    }
   if (size > 0)
     {
       DoAddHeader (0, size);
@@ -706,9 +726,11 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +738,15 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0 && --m_data->m_count == 0)
         {
           PacketMetadata::Recycle (m_data);
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,9 +756,7 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0 && --m_data->m_count == 0)
     {
       PacketMetadata::Recycle (m_data);
     }
@@ -28,16 +28,67 @@
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/block-pool.h"
 #include <cstring>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+namespace {
+
+/** Free tag nodes of the current thread, a single size class. */
+thread_local BlockPool<1> g_tagDataPool;
+
+} // unnamed namespace
+
+void *
+PacketTagList::TagData::operator new (std::size_t size)
+{
+  NS_ASSERT (size == sizeof (struct TagData));
+  void *p = g_tagDataPool.Pop (0);
+  if (p == 0)
+    {
+      p = ::operator new (size);
+    }
+  return p;
+}
+
+void
+PacketTagList::TagData::operator delete (void *p)
+{
+  if (p != 0 && !g_tagDataPool.Push (0, p))
+    {
+      ::operator delete (p);
+    }
+}
+
+uint32_t
+PacketTagList::FindInline (TypeId tid) const
+{
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          return i;
+        }
+    }
+  return INLINE_TAGS;
+}
+
+void
+PacketTagList::RemoveInline (uint32_t i)
+{
+  m_nInline--;
+  for (; i < m_nInline; i++)
+    {
+      m_inline[i] = m_inline[i + 1];
+    }
+}
+
 bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
+PacketTagList::COWTraverse (Tag & tag, TypeId tid, PacketTagList::COWWriter Writer)
 {
-  TypeId tid = tag.GetInstanceTypeId ();
   NS_LOG_FUNCTION (this << tid);
   NS_LOG_INFO     ("looking for " << tid);
 
@@ -157,7 +208,17 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  TypeId tid = tag.GetInstanceTypeId ();
+  uint32_t i = FindInline (tid);
+  if (i == INLINE_TAGS)
+    {
+      return COWTraverse (tag, tid, &PacketTagList::RemoveWriter);
+    }
+  NS_LOG_FUNCTION (this << tid);
+  tag.Deserialize (TagBuffer (m_inline[i].data,
+                              m_inline[i].data + INLINE_SIZE));
+  RemoveInline (i);
+  return true;
 }
 
 // COWWriter implementing Remove
@@ -196,7 +257,23 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
+  TypeId tid = tag.GetInstanceTypeId ();
+  uint32_t i = FindInline (tid);
+  if (i != INLINE_TAGS)
+    {
+      NS_LOG_FUNCTION (this << tid);
+      if (tag.GetSerializedSize () <= INLINE_SIZE)
+        {
+          tag.Serialize (TagBuffer (m_inline[i].data,
+                                    m_inline[i].data + tag.GetSerializedSize ()));
+          return true;
+        }
+      // the new value does not fit inline anymore
+      RemoveInline (i);
+      Add (tag);
+      return true;
+    }
+  bool found = COWTraverse (tag, tid, &PacketTagList::ReplaceWriter);
   if (!found)
     {
       Add (tag);
@@ -243,28 +320,65 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
 void 
 PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
   // ensure this id was not yet added
+  NS_ASSERT_MSG (FindInline (tid) == INLINE_TAGS, "Error: cannot add the same kind of tag twice.");
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (), "Error: cannot add the same kind of tag twice.");
+      NS_ASSERT_MSG (cur->tid != tid, "Error: cannot add the same kind of tag twice.");
+    }
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  if (m_next == 0 && m_nInline < INLINE_TAGS
+      && tag.GetSerializedSize () <= INLINE_SIZE)
+    {
+      struct InlineTag &slot = self->m_inline[self->m_nInline++];
+      slot.tid = tid;
+      tag.Serialize (TagBuffer (slot.data, slot.data + tag.GetSerializedSize ()));
+      return;
     }
   struct TagData * head = new struct TagData ();
   head->count = 1;
   head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
+  head->tid = tid;
   head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_next = head;
+}
+
+void
+PacketTagList::DeepCopy (PacketTagList const &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  RemoveAll ();
+  CopyInline (o);
+  struct TagData **tail = &m_next;
+  for (struct TagData *cur = o.m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData *copy = new struct TagData ();
+      std::memcpy (copy->data, cur->data, TagData::MAX_SIZE);
+      copy->tid = cur->tid;
+      copy->count = 1;
+      copy->next = 0;
+      *tail = copy;
+      tail = &copy->next;
+    }
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = FindInline (tid);
+  if (i != INLINE_TAGS)
+    {
+      tag.Deserialize (TagBuffer (const_cast<uint8_t *> (m_inline[i].data),
+                                  const_cast<uint8_t *> (m_inline[i].data) + INLINE_SIZE));
+      return true;
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
@@ -284,5 +398,25 @@ PacketTagList::Head (void) const
   return m_next;
 }
 
+uint32_t
+PacketTagList::GetNInline (void) const
+{
+  return m_nInline;
+}
+
+TypeId
+PacketTagList::GetInlineTypeId (uint32_t i) const
+{
+  NS_ASSERT (i < m_nInline);
+  return m_inline[i].tid;
+}
+
+const uint8_t *
+PacketTagList::GetInlineData (uint32_t i) const
+{
+  NS_ASSERT (i < m_nInline);
+  return m_inline[i].data;
+}
+
 } /* namespace ns3 */
 
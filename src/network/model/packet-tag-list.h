@@ -26,6 +26,7 @@
 */
 
 #include <stdint.h>
+#include <cstddef>
 #include <ostream>
 #include "ns3/type-id.h"
 
@@ -120,6 +121,18 @@ class Tag;
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
  *
+ * \par <b> Inline tags: </b>
+ * \n
+ * The first #INLINE_TAGS tags, when they serialize to at most
+ * #INLINE_SIZE bytes, are not put in the tree: they are serialized in
+ * a small array inside the PacketTagList itself, which is copied with
+ * it. The other tags, and all the tags added once the tree is started,
+ * go to the tree, so the inline tags are always older than the tree.
+ * Packets carrying a couple of small tags (flow ids, TTLs, segment
+ * counts) never allocate a TagData, and the array adds 20 bytes to
+ * each Packet. Tags are found by comparing their TypeId, a 16 bit
+ * index, looked up once per operation.
+ *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
@@ -165,8 +178,27 @@ public:
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
     uint32_t count;           /**< Number of incoming links */
+
+    /**
+     * Allocate a node from the free list of the current thread.
+     * \param [in] size The size of the node.
+     * \returns The memory of the node.
+     */
+    static void * operator new (std::size_t size);
+    /**
+     * Return a node to the free list of the current thread.
+     * \param [in] p The memory of the node.
+     */
+    static void operator delete (void *p);
   };  /* struct TagData */
 
+  /** Tags stored in the PacketTagList, before the tree is used. */
+  enum
+  {
+    INLINE_TAGS = 2,  /**< Number of inline tags */
+    INLINE_SIZE = 8   /**< Largest serialized size of an inline tag */
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -229,6 +261,13 @@ public:
    * \returns True if \pname{tag} is found, false otherwise.
    */
   bool Peek (Tag &tag) const;
+  /**
+   * Replace the tags of this list with copies of the tags of another
+   * list, which share no node with it.
+   *
+   * \param [in] o The list to copy.
+   */
+  void DeepCopy (PacketTagList const &o);
   /**
    * Remove all tags from this list (up to the first merge).
    */
@@ -237,8 +276,46 @@ public:
    * \returns pointer to head of tag list
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \returns The number of inline tags.
+   */
+  uint32_t GetNInline (void) const;
+  /**
+   * \param [in] i The index of an inline tag.
+   * \returns The type of the inline tag.
+   */
+  TypeId GetInlineTypeId (uint32_t i) const;
+  /**
+   * \param [in] i The index of an inline tag.
+   * \returns The serialized inline tag.
+   */
+  const uint8_t * GetInlineData (uint32_t i) const;
 
 private:
+  /** A small tag stored in the PacketTagList. */
+  struct InlineTag
+  {
+    TypeId tid;                         /**< Type of the tag serialized into #data */
+    uint8_t data[INLINE_SIZE];          /**< Serialization buffer */
+  };
+
+  /**
+   * Find an inline tag.
+   * \param [in] tid The type of the tag.
+   * \returns The index of the tag, or #INLINE_TAGS if it is not inline.
+   */
+  uint32_t FindInline (TypeId tid) const;
+  /**
+   * Remove an inline tag, keeping the others in order.
+   * \param [in] i The index of the tag.
+   */
+  void RemoveInline (uint32_t i);
+  /**
+   * Copy the inline tags of another list.
+   * \param [in] o The list to copy.
+   */
+  inline void CopyInline (PacketTagList const &o);
+
   /**
    * Typedef of method function pointer for copy-on-write operations
    *
@@ -257,10 +334,11 @@ private:
    * Traverse the list implementing copy-on-write, using \pname{Writer}.
    *
    * \param [in] tag The tag type to operate on.
+   * \param [in] tid The TypeId of \pname{tag}.
    * \param [in] Writer The copy-on-write function to use.
    * \returns True if \pname{tag} found, false otherwise.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  bool COWTraverse   (Tag & tag, TypeId tid, PacketTagList::COWWriter Writer);
   /**
    * Copy-on-write implementing Remove.
    *
@@ -291,6 +369,8 @@ private:
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+  uint32_t m_nInline;                     //!< Number of inline tags
+  struct InlineTag m_inline[INLINE_TAGS]; //!< The inline tags, oldest first
 };
 
 } // namespace ns3
@@ -302,7 +382,8 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_nInline (0)
 {
 }
 
@@ -313,25 +394,41 @@ PacketTagList::PacketTagList (PacketTagList const &o)
     {
       m_next->count++;
     }
+  CopyInline (o);
 }
 
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0)
+        {
+          m_next->count++;
+        }
     }
+  CopyInline (o);
   return *this;
 }
 
+void
+PacketTagList::CopyInline (PacketTagList const &o)
+{
+  // Only the used part of the array is copied
+  m_nInline = o.m_nInline;
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      m_inline[i] = o.m_inline[i];
+    }
+}
+
 PacketTagList::~PacketTagList ()
 {
   RemoveAll ();
@@ -359,6 +456,7 @@ PacketTagList::RemoveAll (void)
       delete prev;
     }
   m_next = 0;
+  m_nInline = 0;
 }
 
 } // namespace ns3
@@ -22,13 +22,18 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include <string>
+#include <vector>
 #include <cstdarg>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
+#ifdef NS3_MTP
+std::atomic<uint32_t> Packet::m_globalUid (0);
+#else
 uint32_t Packet::m_globalUid = 0;
+#endif
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,39 +86,49 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const PacketTagList *list)
+  : m_list (list),
+    m_current (list->Head ()),
+    m_nInline (list->GetNInline ())
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current != 0 || m_nInline != 0;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  // The tree holds the most recent tags, the inline tags are visited last
+  if (m_current != 0)
+    {
+      const struct PacketTagList::TagData *prev = m_current;
+      m_current = m_current->next;
+      return PacketTagIterator::Item (prev->tid, prev->data);
+    }
+  m_nInline--;
+  return PacketTagIterator::Item (m_list->GetInlineTypeId (m_nInline),
+                                  m_list->GetInlineData (m_nInline));
 }
 
-PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
-  : m_data (data)
+PacketTagIterator::Item::Item (TypeId tid, const uint8_t *data)
+  : m_tid (tid),
+    m_data (data)
 {
 }
 TypeId
 PacketTagIterator::Item::GetTypeId (void) const
 {
-  return m_data->tid;
+  return m_tid;
 }
 void
 PacketTagIterator::Item::GetTag (Tag &tag) const
 {
-  NS_ASSERT (tag.GetInstanceTypeId () == m_data->tid);
-  tag.Deserialize (TagBuffer ((uint8_t*)m_data->data,
-                              (uint8_t*)m_data->data
+  NS_ASSERT (tag.GetInstanceTypeId () == m_tid);
+  tag.Deserialize (TagBuffer ((uint8_t*)m_data,
+                              (uint8_t*)m_data
                               + PacketTagList::TagData::MAX_SIZE));
 }
 
@@ -127,6 +142,21 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // The serialized packet carries the buffer, the metadata and the
+  // nix-vector, but not the tags
+  uint32_t size = GetSerializedSize ();
+  std::vector<uint8_t> buffer (size);
+  Serialize (&buffer[0], size);
+  Ptr<Packet> copy = Create<Packet> (&buffer[0], size, true);
+  copy->m_byteTagList.Add (m_byteTagList);
+  copy->m_packetTagList.DeepCopy (m_packetTagList);
+  return copy;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -137,10 +167,9 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid++, 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -179,10 +208,9 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid++, size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -205,10 +233,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid++, size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -881,7 +908,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (&m_packetTagList);
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -34,6 +34,9 @@
 #include "ns3/assert.h"
 #include "ns3/ptr.h"
 #include "ns3/deprecated.h"
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 
 namespace ns3 {
 
@@ -152,10 +155,12 @@ private:
     friend class PacketTagIterator;
     /**
      * Constructor
-     * \param data the data to copy.
+     * \param tid the ns3::TypeId of the tag.
+     * \param data the serialized tag.
      */
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data; //!< the tag data
+    Item (TypeId tid, const uint8_t *data);
+    TypeId m_tid; //!< the ns3::TypeId of the tag
+    const uint8_t *m_data; //!< the serialized tag
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -169,10 +174,12 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the tags of the packet
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list; //!< the tags of the packet
+  const struct PacketTagList::TagData *m_current;  //!< actual position over the tree of tags
+  uint32_t m_nInline; //!< number of inline tags not visited yet
 };
 
 /**
@@ -424,6 +431,17 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief Copy the packet, its metadata and its tags, without sharing
+   * any data with it.
+   *
+   * \returns The copy of the packet.
+   *
+   * Unlike Copy (), which shares the buffers of the packet, the copy
+   * can be handed to another thread of a multithreaded simulation.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -727,7 +745,11 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
+#ifdef NS3_MTP
+  static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid
+#else
   static uint32_t m_globalUid; //!< Global counter of packets Uid
+#endif
 };
 
 /**
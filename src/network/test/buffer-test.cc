@@ -359,6 +359,30 @@ BufferTest::DoRun (void)
   val2 <<= 8;
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
+
+  // Concatenating fragments of zero-filled buffers keeps the zero area
+  // virtual, even when the data of the fragments is shared.
+  Buffer write0 (1448);
+  write0.AddAtStart (2);
+  write0.Begin ().WriteHtonU16 (0x1234);
+  Buffer segment = write0.CreateFragment (0, 1002);
+  segment.AddAtEnd (Buffer (1448).CreateFragment (0, 552));
+  NS_TEST_ASSERT_MSG_EQ (segment.GetSize (), 1554, "Bad concatenated size");
+  NS_TEST_ASSERT_MSG_LT (segment.GetSerializedSize (), 100, "Zero area materialized");
+  i = segment.Begin ();
+  NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU16 (), 0x1234, "Bad data before the zero area");
+  uint32_t nonZero = 0;
+  while (!i.IsEnd ())
+    {
+      nonZero += i.ReadU8 () != 0;
+    }
+  NS_TEST_ASSERT_MSG_EQ (nonZero, 0, "Bad zero area");
+  segment.Begin ().WriteHtonU16 (0xabcd);
+  NS_TEST_ASSERT_MSG_EQ (write0.Begin ().ReadNtohU16 (), 0x1234, "Shared data modified");
+  Buffer empty;
+  empty.AddAtEnd (segment);
+  NS_TEST_ASSERT_MSG_EQ (empty.GetSize (), 1554, "Bad size after concatenation to an empty buffer");
+  NS_TEST_ASSERT_MSG_EQ (empty.Begin ().ReadNtohU16 (), 0xabcd, "Bad data after concatenation to an empty buffer");
 }
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/dynamic-queue-limits.h"
+#include "ns3/net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief DynamicQueueLimits convergence test
+ *
+ * A device transmits a 1500 byte packet every ms and reports the
+ * completed packets every 4 ms, when the producer queues packets until
+ * the limit is reached.  The limit must grow enough to keep the device
+ * busy, and not much more.
+ */
+class DynamicQueueLimitsTestCase : public TestCase
+{
+public:
+  DynamicQueueLimitsTestCase ();
+  virtual void DoRun (void);
+private:
+  /// Transmit a packet, and report the completed ones every 4 ms
+  void Tick (void);
+  /// Queue packets until the limit is reached
+  void Fill (void);
+
+  Ptr<DynamicQueueLimits> m_dql;  //!< the queue limits
+  uint32_t m_ticks;               //!< number of ticks
+  uint32_t m_queued;              //!< packets queued and not transmitted yet
+  uint32_t m_done;                //!< packets transmitted and not reported yet
+  uint32_t m_starved;             //!< ticks with no packet to transmit in the last second
+  uint32_t m_maxLimit;            //!< maximum limit in the last second
+};
+
+DynamicQueueLimitsTestCase::DynamicQueueLimitsTestCase ()
+  : TestCase ("Dynamic queue limits avoid starvation with a small limit")
+{
+}
+
+void
+DynamicQueueLimitsTestCase::Fill (void)
+{
+  while (m_dql->Available () >= 0)
+    {
+      m_dql->Queued (1500);
+      m_queued++;
+    }
+}
+
+void
+DynamicQueueLimitsTestCase::Tick (void)
+{
+  if (m_queued > 0)
+    {
+      m_queued--;
+      m_done++;
+    }
+  else if (m_ticks >= 4000)
+    {
+      m_starved++;
+    }
+  if (++m_ticks % 4 == 0)
+    {
+      m_dql->Completed (m_done * 1500);
+      m_done = 0;
+      Fill ();
+      if (m_ticks > 4000)
+        {
+          // The bytes in flight right after filling are bounded by the limit
+          // plus the last packet
+          m_maxLimit = std::max (m_maxLimit, m_queued * 1500 - 1500);
+        }
+    }
+  if (m_ticks < 5000)
+    {
+      Simulator::Schedule (MilliSeconds (1), &DynamicQueueLimitsTestCase::Tick, this);
+    }
+}
+
+void
+DynamicQueueLimitsTestCase::DoRun (void)
+{
+  m_dql = CreateObject<DynamicQueueLimits> ();
+  m_dql->Reset ();
+  m_ticks = 0;
+  m_queued = 0;
+  m_done = 0;
+  m_starved = 0;
+  m_maxLimit = 0;
+
+  NS_TEST_EXPECT_MSG_EQ (m_dql->Available (), 0, "The initial limit is not the minimum limit");
+  Fill ();
+  NS_TEST_EXPECT_MSG_EQ (m_queued, 1, "A single packet exceeds the initial limit");
+
+  Simulator::Schedule (MilliSeconds (1), &DynamicQueueLimitsTestCase::Tick, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_starved, 0, "The device starved with the dynamic limit");
+  // 4 packets are transmitted between two completions
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_maxLimit, 4 * 1500, "The limit is too small");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxLimit, 8 * 1500, "The limit is not reduced");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Stop and wake of a NetDeviceQueue with queue limits
+ */
+class NetDeviceQueueLimitsTestCase : public TestCase
+{
+public:
+  NetDeviceQueueLimitsTestCase ();
+  virtual void DoRun (void);
+private:
+  /// Wake callback
+  void Wake (void);
+
+  uint32_t m_wakes;     //!< number of wake callbacks
+};
+
+NetDeviceQueueLimitsTestCase::NetDeviceQueueLimitsTestCase ()
+  : TestCase ("The device queue is stopped and woken up by the queue limits")
+{
+}
+
+void
+NetDeviceQueueLimitsTestCase::Wake (void)
+{
+  m_wakes++;
+}
+
+void
+NetDeviceQueueLimitsTestCase::DoRun (void)
+{
+  m_wakes = 0;
+  Ptr<NetDeviceQueue> txq = Create<NetDeviceQueue> ();
+  txq->SetWakeCallback (MakeCallback (&NetDeviceQueueLimitsTestCase::Wake, this));
+
+  // Without queue limits, the reports have no effect
+  txq->NotifyQueuedBytes (1500);
+  txq->NotifyTransmittedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), false, "Device queue stopped without queue limits");
+  NS_TEST_EXPECT_MSG_EQ (m_wakes, 0, "Device queue woken up without queue limits");
+
+  txq->SetQueueLimits (CreateObjectWithAttributes<DynamicQueueLimits> ("MinLimit", UintegerValue (3000)));
+  txq->NotifyQueuedBytes (1500);
+  txq->NotifyQueuedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), false, "Device queue stopped within the limit");
+  txq->NotifyQueuedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), true, "Device queue not stopped over the limit");
+
+  txq->NotifyTransmittedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (txq->IsStopped (), false, "Device queue not started within the limit");
+  NS_TEST_EXPECT_MSG_EQ (m_wakes, 1, "Device queue not woken up within the limit");
+  txq->NotifyTransmittedBytes (1500);
+  NS_TEST_EXPECT_MSG_EQ (m_wakes, 1, "Device queue woken up while not stopped");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief DynamicQueueLimits test suite
+ */
+static class DynamicQueueLimitsTestSuite : public TestSuite
+{
+public:
+  DynamicQueueLimitsTestSuite ()
+    : TestSuite ("dynamic-queue-limits", UNIT)
+  {
+    AddTestCase (new DynamicQueueLimitsTestCase (), TestCase::QUICK);
+    AddTestCase (new NetDeviceQueueLimitsTestCase (), TestCase::QUICK);
+  }
+} g_dynamicQueueLimitsTestSuite; ///< the test suite
@@ -39,6 +39,7 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/rng-seed-manager.h"
+#include <cmath>
 
 using namespace ns3;
 
@@ -224,6 +225,88 @@ BurstErrorModelSimple::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_drops, 260 , "Wrong number of drops.");
 }
 
+/**
+ * \brief Uniform random variable counting its draws
+ */
+class CountingUniformRandomVariable : public UniformRandomVariable
+{
+public:
+  CountingUniformRandomVariable () : m_draws (0) {}
+  using UniformRandomVariable::GetValue;
+  virtual double GetValue (void)
+  {
+    m_draws++;
+    return UniformRandomVariable::GetValue ();
+  }
+  uint32_t m_draws; //!< number of draws
+};
+
+class GeometricRateErrorModelTest : public TestCase
+{
+public:
+  GeometricRateErrorModelTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the errored packets of a unit and rate against the binomial law
+   * \param unit the error unit
+   * \param rate the error rate
+   * \param size the size of the packets
+   */
+  void Check (RateErrorModel::ErrorUnit unit, double rate, uint32_t size);
+};
+
+GeometricRateErrorModelTest::GeometricRateErrorModelTest ()
+  : TestCase ("GeometricRateErrorModel errors packets like RateErrorModel, with one draw per error")
+{
+}
+
+void
+GeometricRateErrorModelTest::Check (RateErrorModel::ErrorUnit unit, double rate, uint32_t size)
+{
+  Ptr<CountingUniformRandomVariable> uv = CreateObject<CountingUniformRandomVariable> ();
+  uv->SetStream (52);
+  Ptr<GeometricRateErrorModel> em = CreateObject<GeometricRateErrorModel> ();
+  em->SetRandomVariable (uv);
+  em->SetUnit (unit);
+  em->SetRate (rate);
+
+  uint32_t n = 100000;
+  uint32_t errors = 0;
+  uint32_t pairs = 0;
+  bool previous = false;
+  Ptr<Packet> p = Create<Packet> (size);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      bool error = em->IsCorrupt (p);
+      errors += error;
+      pairs += error && previous;
+      previous = error;
+    }
+
+  double units = unit == RateErrorModel::ERROR_UNIT_PACKET ? 1 : size;
+  units *= unit == RateErrorModel::ERROR_UNIT_BIT ? 8 : 1;
+  double per = 1 - std::pow (1 - rate, units);
+  // Within 5 standard deviations of the binomial law
+  double sigma = std::sqrt (n * per * (1 - per));
+  NS_TEST_EXPECT_MSG_EQ_TOL (errors, n * per, 5 * sigma, "Unexpected number of errors");
+  // The packets are errored independently of each other
+  sigma = std::sqrt (n * per * per * (1 - per * per));
+  NS_TEST_EXPECT_MSG_EQ_TOL (pairs, n * per * per, 5 * sigma + 1, "Unexpected number of consecutive errors");
+  // One draw per error, plus the draw of the gap after the last one
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (uv->m_draws, errors + 1, "More than one draw per error");
+}
+
+void
+GeometricRateErrorModelTest::DoRun (void)
+{
+  Check (RateErrorModel::ERROR_UNIT_BIT, 1e-5, 1000);
+  Check (RateErrorModel::ERROR_UNIT_BYTE, 1e-3, 1500);
+  Check (RateErrorModel::ERROR_UNIT_PACKET, 0.01, 1000);
+  Check (RateErrorModel::ERROR_UNIT_BIT, 1e-9, 1500);
+}
+
 // This is the start of an error model test suite.  For starters, this is
 // just testing that the SimpleNetDevice is working but this can be
 // extended to many more test cases in the future
@@ -238,6 +321,7 @@ ErrorModelTestSuite::ErrorModelTestSuite ()
 {
   AddTestCase (new ErrorModelSimple, TestCase::QUICK);
   AddTestCase (new BurstErrorModelSimple, TestCase::QUICK);
+  AddTestCase (new GeometricRateErrorModelTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
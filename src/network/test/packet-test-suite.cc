@@ -27,6 +27,8 @@
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <set>
+#include <vector>
 
 using namespace ns3;
 
@@ -582,6 +584,42 @@ PacketTest::DoRun (void)
     tmp->AddPaddingAtEnd (50);
     CHECK (tmp, 1, E (25, 0, 50));
   }
+
+  /* Test DeepCopy: the copy keeps the tags, and shares nothing. */
+  {
+    Ptr<Packet> tmp = Create<Packet> (100);
+    tmp->AddByteTag (ATestTag<25> ());
+    tmp->AddHeader (ATestHeader<10> ());
+    tmp->AddByteTag (ATestTag<2> ());
+    // More packet tags than are stored inline
+    tmp->AddPacketTag (ATestTag<10> (10));
+    tmp->AddPacketTag (ATestTag<11> (11));
+    tmp->AddPacketTag (ATestTag<12> (12));
+    tmp->AddPacketTag (ATestTag<13> (13));
+    tmp->AddPacketTag (ATestTag<14> (14));
+    tmp->AddPacketTag (ATestTag<15> (15));
+
+    Ptr<Packet> copy = tmp->DeepCopy ();
+    NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 110, "Wrong copy size");
+    CHECK (copy, 2, E (25, 10, 110), E (2, 0, 110));
+    ATestTag<10> t10;
+    ATestTag<15> t15;
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (t10), true, "Inline tag not copied");
+    NS_TEST_EXPECT_MSG_EQ (t10.GetData (), 10, "Wrong inline tag");
+    NS_TEST_EXPECT_MSG_EQ (t10.m_error, false, "Wrong inline tag");
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (t15), true, "Tag node not copied");
+    NS_TEST_EXPECT_MSG_EQ (t15.GetData (), 15, "Wrong tag node");
+    NS_TEST_EXPECT_MSG_EQ (t15.m_error, false, "Wrong tag node");
+
+    ATestHeader<10> h;
+    copy->RemoveHeader (h);
+    NS_TEST_EXPECT_MSG_EQ (h.m_error, false, "Wrong header");
+    copy->RemovePacketTag (t15);
+    copy->AddByteTag (ATestTag<3> ());
+    NS_TEST_EXPECT_MSG_EQ (tmp->PeekPacketTag (t15), true, "Tag removed from the original");
+    CHECK (tmp, 2, E (25, 10, 110), E (2, 0, 110));
+    NS_TEST_EXPECT_MSG_EQ (tmp->GetSize (), 110, "Header removed from the original");
+  }
 }
 //--------------------------------------
 class PacketTagListTest : public TestCase
@@ -806,6 +844,62 @@ PacketTagListTest::DoRun (void)
     ReplaceCheck (7);
   }
   
+  { // Iteration over the inline tags and the tree
+    std::cout << GetName () << "check iteration over each tag" << std::endl;
+    Ptr<Packet> p = Create<Packet> (10);
+    p->AddPacketTag (t1);
+    p->AddPacketTag (t2);
+    p->AddPacketTag (t3);
+    p->AddPacketTag (t4);
+    p->AddPacketTag (t5);
+    p->AddPacketTag (t6);
+    p->AddPacketTag (t7);
+    p->RemovePacketTag (t2);
+    p->RemovePacketTag (t6);
+    std::set<uint16_t> seen;
+    PacketTagIterator i = p->GetPacketTagIterator ();
+    while (i.HasNext ())
+      {
+        PacketTagIterator::Item item = i.Next ();
+        NS_TEST_EXPECT_MSG_EQ (seen.insert (item.GetTypeId ().GetUid ()).second, true,
+                               "tag " << item.GetTypeId ().GetName () << " visited twice");
+      }
+    NS_TEST_EXPECT_MSG_EQ (seen.size (), 5, "wrong number of tags visited");
+    NS_TEST_EXPECT_MSG_EQ (seen.count (t2.GetInstanceTypeId ().GetUid ()), 0, "removed tag visited");
+    NS_TEST_EXPECT_MSG_EQ (seen.count (t6.GetInstanceTypeId ().GetUid ()), 0, "removed tag visited");
+  }
+
+  { // Tags too large to be inline, and tags added once the tree is started
+    std::cout << GetName () << "check inline and tree tags" << std::endl;
+    Ptr<Packet> p = Create<Packet> (10);
+    ATestTag<1> small (3);
+    ATestTag<10> large (4);
+    ATestTag<2> late (5);
+    p->AddPacketTag (small);
+    p->AddPacketTag (large);
+    p->AddPacketTag (late);
+    std::vector<uint16_t> order;
+    PacketTagIterator i = p->GetPacketTagIterator ();
+    while (i.HasNext ())
+      {
+        order.push_back (i.Next ().GetTypeId ().GetUid ());
+      }
+    NS_TEST_ASSERT_MSG_EQ (order.size (), 3, "wrong number of tags visited");
+    NS_TEST_EXPECT_MSG_EQ (order[0], late.GetInstanceTypeId ().GetUid (), "newest tag not visited first");
+    NS_TEST_EXPECT_MSG_EQ (order[1], large.GetInstanceTypeId ().GetUid (), "tags visited out of order");
+    NS_TEST_EXPECT_MSG_EQ (order[2], small.GetInstanceTypeId ().GetUid (), "oldest tag not visited last");
+
+    ATestTag<10> peekLarge;
+    NS_TEST_EXPECT_MSG_EQ (p->RemovePacketTag (peekLarge), true, "large tag not found");
+    NS_TEST_EXPECT_MSG_EQ (peekLarge.GetData (), 4, "wrong large tag value");
+    ATestTag<1> peekSmall;
+    ATestTag<2> peekLate;
+    NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (peekSmall), true, "inline tag not found");
+    NS_TEST_EXPECT_MSG_EQ (peekSmall.GetData (), 3, "wrong inline tag value");
+    NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (peekLate), true, "tree tag not found");
+    NS_TEST_EXPECT_MSG_EQ (peekLate.GetData (), 5, "wrong tree tag value");
+  }
+
   { // Timing
     std::cout << GetName () << "add+remove timing" << std::endl;
     int flm = std::numeric_limits<int>::max ();
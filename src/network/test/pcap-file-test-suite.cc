@@ -25,6 +25,12 @@
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/packet.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 
 using namespace ns3;
 
@@ -1121,6 +1127,114 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that a PcapFileWrapper in asynchronous mode writes
+// the same file as in synchronous mode, and that the records are stored by
+// Simulator::Destroy.
+// ===========================================================================
+class AsyncWriteTestCase : public TestCase
+{
+public:
+  AsyncWriteTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AsyncWriteTestCase::AsyncWriteTestCase ()
+  : TestCase ("Check that PcapFileWrapper writes the same file in asynchronous mode")
+{
+}
+
+void
+AsyncWriteTestCase::DoRun (void)
+{
+  const uint32_t snapLen = 1000;
+  std::string filenames[2];
+  Ptr<PcapFileWrapper> files[2];
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      std::stringstream filename;
+      filename << rand () << (i ? "-async" : "-sync") << ".pcap";
+      filenames[i] = CreateTempDirFilename (filename.str ());
+      files[i] = CreateObject<PcapFileWrapper> ();
+      files[i]->SetAttribute ("Asynchronous", BooleanValue (i == 1));
+      files[i]->SetAttribute ("CaptureSize", UintegerValue (snapLen));
+      files[i]->Open (filenames[i], std::ios::out);
+      NS_TEST_ASSERT_MSG_EQ (files[i]->Fail (), false, "Open (" << filenames[i] << ", \"std::ios::out\") returns error");
+      files[i]->Init (1);
+    }
+
+  //
+  // Write enough packets, some of them truncated, to fill several batches.
+  //
+  uint8_t data[1500];
+  for (uint32_t i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i & 0xff;
+    }
+  for (uint32_t i = 0; i < 5000; ++i)
+    {
+      uint32_t size = (i * 7) % sizeof (data);
+      Time t = MicroSeconds (i * 1001);
+      Ptr<Packet> p = Create<Packet> (data, size);
+      EthernetHeader header;
+      header.SetLengthType (size);
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          switch (i % 3)
+            {
+            case 0:
+              files[j]->Write (t, p);
+              break;
+            case 1:
+              files[j]->Write (t, data, size);
+              break;
+            default:
+              files[j]->Write (t, header, p);
+              break;
+            }
+        }
+    }
+
+  //
+  // The records of the asynchronous file must be stored at
+  // Simulator::Destroy, before it is closed.
+  //
+  files[0]->Close ();
+  Simulator::Destroy ();
+  uint32_t sec (0), usec (0), packets (0);
+  bool diff = PcapFile::Diff (filenames[0], filenames[1], sec, usec, packets, snapLen);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Asynchronous file differs at packet " << packets);
+  NS_TEST_EXPECT_MSG_EQ (packets, 5000, "Not all the packets stored");
+
+  //
+  // Records written after Simulator::Destroy fill more than a batch, which
+  // starts a new writer thread, stopped at exit.
+  //
+  const uint32_t extra = 2000;
+  for (uint32_t i = 0; i < extra; ++i)
+    {
+      files[1]->Write (Seconds (10) + MicroSeconds (i), data, sizeof (data));
+    }
+  files[1]->Close ();
+  FILE * f = std::fopen (filenames[0].c_str (), "rb");
+  NS_TEST_ASSERT_MSG_NE (f, 0, "Cannot open " << filenames[0]);
+  std::fseek (f, 0, SEEK_END);
+  uint64_t size = std::ftell (f);
+  std::fclose (f);
+  size += extra * (PcapFile::RECORD_HEADER_SIZE + snapLen);
+  NS_TEST_EXPECT_MSG_EQ (CheckFileLength (filenames[1], size), true, "Records written after Simulator::Destroy not stored");
+
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      if (remove (filenames[i].c_str ()))
+        {
+          NS_LOG_ERROR ("Failed to delete file " << filenames[i]);
+        }
+    }
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1138,6 +1252,7 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new AsyncWriteTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
@@ -61,6 +61,7 @@
  */
 
 #include <cmath>
+#include <limits>
 
 #include "error-model.h"
 
@@ -282,6 +283,159 @@ RateErrorModel::DoReset (void)
 }
 
 
+//
+// GeometricRateErrorModel
+//
+
+NS_OBJECT_ENSURE_REGISTERED (GeometricRateErrorModel);
+
+TypeId GeometricRateErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GeometricRateErrorModel")
+    .SetParent<ErrorModel> ()
+    .SetGroupName("Network")
+    .AddConstructor<GeometricRateErrorModel> ()
+    .AddAttribute ("ErrorUnit", "The error unit",
+                   EnumValue (RateErrorModel::ERROR_UNIT_BYTE),
+                   MakeEnumAccessor (&GeometricRateErrorModel::m_unit),
+                   MakeEnumChecker (RateErrorModel::ERROR_UNIT_BIT, "ERROR_UNIT_BIT",
+                                    RateErrorModel::ERROR_UNIT_BYTE, "ERROR_UNIT_BYTE",
+                                    RateErrorModel::ERROR_UNIT_PACKET, "ERROR_UNIT_PACKET"))
+    .AddAttribute ("ErrorRate", "The error rate.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&GeometricRateErrorModel::SetRate,
+                                       &GeometricRateErrorModel::GetRate),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("RanVar", "The uniform random variable on (0,1) the errors are drawn from.",
+                   StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=1.0]"),
+                   MakePointerAccessor (&GeometricRateErrorModel::m_ranvar),
+                   MakePointerChecker<RandomVariableStream> ())
+  ;
+  return tid;
+}
+
+
+GeometricRateErrorModel::GeometricRateErrorModel ()
+  : m_skip (0),
+    m_skipValid (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+GeometricRateErrorModel::~GeometricRateErrorModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RateErrorModel::ErrorUnit
+GeometricRateErrorModel::GetUnit (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_unit;
+}
+
+void
+GeometricRateErrorModel::SetUnit (enum RateErrorModel::ErrorUnit error_unit)
+{
+  NS_LOG_FUNCTION (this << error_unit);
+  m_unit = error_unit;
+  m_skipValid = false;
+}
+
+double
+GeometricRateErrorModel::GetRate (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_rate;
+}
+
+void
+GeometricRateErrorModel::SetRate (double rate)
+{
+  NS_LOG_FUNCTION (this << rate);
+  m_rate = rate;
+  m_skipValid = false;
+}
+
+void
+GeometricRateErrorModel::SetRandomVariable (Ptr<RandomVariableStream> ranvar)
+{
+  NS_LOG_FUNCTION (this << ranvar);
+  m_ranvar = ranvar;
+}
+
+int64_t
+GeometricRateErrorModel::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_ranvar->SetStream (stream);
+  return 1;
+}
+
+uint64_t
+GeometricRateErrorModel::DrawSkip (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_rate >= 1.0)
+    {
+      return 0;
+    }
+  // P(skip >= k) = P(u <= (1 - rate)^k) = (1 - rate)^k
+  double skip = std::floor (std::log (m_ranvar->GetValue ()) / std::log1p (-m_rate));
+  if (skip >= static_cast<double> (std::numeric_limits<uint64_t>::max ()))
+    {
+      return std::numeric_limits<uint64_t>::max ();
+    }
+  return static_cast<uint64_t> (skip);
+}
+
+bool
+GeometricRateErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  if (!IsEnabled () || m_rate <= 0.0)
+    {
+      return false;
+    }
+  uint64_t units = 1;
+  switch (m_unit)
+    {
+    case RateErrorModel::ERROR_UNIT_PACKET:
+      break;
+    case RateErrorModel::ERROR_UNIT_BYTE:
+      units = p->GetSize ();
+      break;
+    case RateErrorModel::ERROR_UNIT_BIT:
+      units = 8 * static_cast<uint64_t> (p->GetSize ());
+      break;
+    default:
+      NS_ASSERT_MSG (false, "m_unit not supported yet");
+      break;
+    }
+  if (!m_skipValid)
+    {
+      m_skip = DrawSkip ();
+      m_skipValid = true;
+    }
+  if (m_skip >= units)
+    {
+      m_skip -= units;
+      return false;
+    }
+  // The units after the errored packet are drawn with the next packet
+  NS_LOG_LOGIC ("Error at unit " << m_skip << " of " << units);
+  m_skipValid = false;
+  return true;
+}
+
+void
+GeometricRateErrorModel::DoReset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_skipValid = false;
+}
+
+
 //
 // BurstErrorModel
 //
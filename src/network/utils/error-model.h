@@ -109,8 +109,9 @@ class Packet;
  *   }
  * \endcode
  *
- * Four practical error models, a RateErrorModel, a BurstErrorModel, 
- * a ListErrorModel, and a ReceiveListErrorModel, are currently implemented. 
+ * Five practical error models, a RateErrorModel, a GeometricRateErrorModel,
+ * a BurstErrorModel, a ListErrorModel, and a ReceiveListErrorModel, are
+ * currently implemented.
  */
 class ErrorModel : public Object
 {
@@ -262,6 +263,87 @@ private:
   Ptr<RandomVariableStream> m_ranvar; //!< rng stream
 };
 
+/**
+ * \brief Determine which packets are errored like a RateErrorModel,
+ * drawing one random number per error instead of one per packet.
+ *
+ * The units (bits, bytes or packets) are errored independently with the
+ * error rate, so the number of units between two errors follows a
+ * geometric distribution.  The model draws the number of units left
+ * before the next error, and subtracts the units of each packet from it:
+ * a packet is errored if the next error falls within its units.  Since
+ * the geometric distribution is memoryless, the errors of the units after
+ * an errored packet are drawn anew, and the packets are errored with
+ * the same probability 1 - (1 - rate)^units, independently of each other,
+ * as with a RateErrorModel.
+ *
+ * The random variable must be uniform on (0,1), which is the default.
+ *
+ * Reset() on this model draws the next error anew.
+ *
+ * IsCorrupt() will not modify the packet data buffer
+ */
+class GeometricRateErrorModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  GeometricRateErrorModel ();
+  virtual ~GeometricRateErrorModel ();
+
+  /**
+   * \returns the ErrorUnit being used by the underlying model
+   */
+  RateErrorModel::ErrorUnit GetUnit (void) const;
+  /**
+   * \param error_unit the ErrorUnit to be used by the underlying model
+   */
+  void SetUnit (enum RateErrorModel::ErrorUnit error_unit);
+
+  /**
+   * \returns the error rate being applied by the model
+   */
+  double GetRate (void) const;
+  /**
+   * \param rate the error rate to be used by the model
+   */
+  void SetRate (double rate);
+
+  /**
+   * \param ranvar A uniform random variable on (0,1)
+   */
+  void SetRandomVariable (Ptr<RandomVariableStream> ranvar);
+
+ /**
+  * Assign a fixed random variable stream number to the random variables
+  * used by this model.  Return the number of streams (possibly zero) that
+  * have been assigned.
+  *
+  * \param stream first stream index to use
+  * \return the number of stream indices assigned by this model
+  */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+  /**
+   * Draw the number of units before the next error.
+   * \returns the number of units before the next error
+   */
+  uint64_t DrawSkip (void);
+
+  enum RateErrorModel::ErrorUnit m_unit; //!< Error rate unit
+  double m_rate; //!< Error rate
+  Ptr<RandomVariableStream> m_ranvar; //!< rng stream
+  uint64_t m_skip; //!< Units left before the next error
+  bool m_skipValid; //!< True if m_skip has been drawn with the current rate
+};
+
 
 /**
  * \brief Determine which bursts of packets are errored corresponding to 
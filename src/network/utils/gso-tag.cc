@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "gso-tag.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("GsoTag");
+
+NS_OBJECT_ENSURE_REGISTERED (GsoTag);
+
+TypeId
+GsoTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GsoTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<GsoTag> ()
+  ;
+  return tid;
+}
+TypeId
+GsoTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+GsoTag::GetSerializedSize (void) const
+{
+  return 4;
+}
+void
+GsoTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteU16 (m_segments);
+  buf.WriteU16 (m_headerSize);
+}
+void
+GsoTag::Deserialize (TagBuffer buf)
+{
+  m_segments = buf.ReadU16 ();
+  m_headerSize = buf.ReadU16 ();
+}
+void
+GsoTag::Print (std::ostream &os) const
+{
+  os << "Segments=" << m_segments << " HeaderSize=" << m_headerSize;
+}
+GsoTag::GsoTag ()
+  : Tag (),
+    m_segments (1),
+    m_headerSize (0)
+{
+}
+
+GsoTag::GsoTag (uint16_t segments, uint16_t headerSize)
+  : Tag (),
+    m_segments (segments),
+    m_headerSize (headerSize)
+{
+}
+
+void
+GsoTag::SetSegments (uint16_t segments)
+{
+  m_segments = segments;
+}
+uint16_t
+GsoTag::GetSegments (void) const
+{
+  return m_segments;
+}
+void
+GsoTag::SetHeaderSize (uint16_t headerSize)
+{
+  m_headerSize = headerSize;
+}
+uint16_t
+GsoTag::GetHeaderSize (void) const
+{
+  return m_headerSize;
+}
+
+uint32_t
+GsoTag::GetSegments (Ptr<const Packet> p)
+{
+  GsoTag tag;
+  if (p->PeekPacketTag (tag))
+    {
+      return tag.GetSegments ();
+    }
+  return 1;
+}
+
+uint32_t
+GsoTag::GetWireSize (Ptr<const Packet> p, uint32_t linkHeaderSize)
+{
+  GsoTag tag;
+  if (p->PeekPacketTag (tag))
+    {
+      return p->GetSize () + (tag.GetSegments () - 1) * (tag.GetHeaderSize () + linkHeaderSize);
+    }
+  return p->GetSize ();
+}
+
+} // namespace ns3
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef GSO_TAG_H
+#define GSO_TAG_H
+
+#include "ns3/tag.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief Mark a packet as a super-segment (generic segmentation offload)
+ *
+ * A transport protocol may send in a single packet the payload of several
+ * segments that would each carry a copy of its headers and of the network
+ * headers.  Such a packet is not fragmented by the network layer, which
+ * may exceed the MTU, and crosses the links as a whole.  The devices
+ * account for the headers of the segments it stands for when computing its
+ * transmission time, as if it was split when serialized on the link, and
+ * the receiver gets it already coalesced (generic receive offload).
+ */
+class GsoTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  GsoTag ();
+
+  /**
+   * Constructs a GsoTag
+   *
+   * \param segments the number of segments of the packet
+   * \param headerSize the size of the network and transport headers of each segment
+   */
+  GsoTag (uint16_t segments, uint16_t headerSize);
+  /**
+   * \param segments the number of segments of the packet
+   */
+  void SetSegments (uint16_t segments);
+  /**
+   * \returns the number of segments of the packet
+   */
+  uint16_t GetSegments (void) const;
+  /**
+   * \param headerSize the size of the network and transport headers of each segment
+   */
+  void SetHeaderSize (uint16_t headerSize);
+  /**
+   * \returns the size of the network and transport headers of each segment
+   */
+  uint16_t GetHeaderSize (void) const;
+
+  /**
+   * \param p a packet
+   * \returns the number of segments of the packet, 1 if it is not a super-segment
+   */
+  static uint32_t GetSegments (Ptr<const Packet> p);
+  /**
+   * \brief Get the number of bytes a packet occupies on a link
+   *
+   * Each segment but the first one of a super-segment adds its network and
+   * transport headers and the link layer header.
+   *
+   * \param p a packet, including the link layer header
+   * \param linkHeaderSize the size of the link layer header of each segment
+   * \returns the number of bytes of the packet on the link
+   */
+  static uint32_t GetWireSize (Ptr<const Packet> p, uint32_t linkHeaderSize);
+
+private:
+  uint16_t m_segments;    //!< Number of segments
+  uint16_t m_headerSize;  //!< Size of the headers of each segment
+};
+
+} // namespace ns3
+
+#endif /* GSO_TAG_H */
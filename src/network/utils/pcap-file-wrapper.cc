@@ -21,7 +21,17 @@
 #include "ns3/uinteger.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
+#include "ns3/simulator.h"
+#include "ns3/core-config.h"
 #include "pcap-file-wrapper.h"
+#include <algorithm>
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#include <thread>
+#include <set>
+#endif
 
 namespace ns3 {
 
@@ -29,6 +39,209 @@ NS_LOG_COMPONENT_DEFINE ("PcapFileWrapper");
 
 NS_OBJECT_ENSURE_REGISTERED (PcapFileWrapper);
 
+#ifdef HAVE_PTHREAD_H
+/**
+ * \ingroup network
+ * \brief Background thread storing the records of the asynchronous pcap files
+ *
+ * A single thread serves all the files.  Each file hands its records over in
+ * large batches through a single-producer single-consumer ring, so that the
+ * simulation does not wait for the disk unless the ring of a file is full.
+ * The thread is created on demand, and stopped at Simulator::Destroy after
+ * all the records have been stored, or at exit if it was created after the
+ * last Simulator::Destroy.
+ */
+class PcapAsyncWriter
+{
+public:
+  /**
+   * \brief Get the writer thread, creating it if needed
+   * \returns the writer thread
+   */
+  static PcapAsyncWriter *Get (void);
+  /**
+   * \brief Serve a file
+   * \param file the file
+   */
+  void Add (PcapFileWrapper *file);
+  /**
+   * \brief Stop serving a file
+   * \param file the file
+   */
+  void Remove (PcapFileWrapper *file);
+  /**
+   * \brief Wake the thread up to store the batches handed over
+   */
+  void Wake (void);
+  /**
+   * \brief Store the pending records of all the files and stop the thread
+   */
+  static void Destroy (void);
+
+private:
+  PcapAsyncWriter ();
+  /**
+   * \brief Thread body
+   */
+  void Run (void);
+  /**
+   * \brief Store the batches handed over by all the files
+   * \returns whether any batch was stored
+   */
+  bool Drain (void);
+
+  static PcapAsyncWriter *g_writer;           //!< The writer thread, if any
+  static SystemMutex g_writerMutex;           //!< Protects g_writer
+
+  Ptr<SystemThread> m_thread;                 //!< The thread
+  SystemMutex m_mutex;                        //!< Protects m_files
+  SystemCondition m_wake;                     //!< Wakes the thread up
+  std::set<PcapFileWrapper *> m_files;        //!< Files served
+  std::atomic<bool> m_stop;                   //!< Whether the thread must stop
+};
+
+PcapAsyncWriter *PcapAsyncWriter::g_writer = 0;
+SystemMutex PcapAsyncWriter::g_writerMutex;
+
+/**
+ * \ingroup network
+ * \brief Stop the writer thread at exit
+ *
+ * Records written after the last Simulator::Destroy start a writer thread
+ * that no later Simulator::Destroy stops.
+ */
+static class PcapAsyncWriterCleanup
+{
+public:
+  ~PcapAsyncWriterCleanup ()
+  {
+    PcapAsyncWriter::Destroy ();
+  }
+} g_pcapAsyncWriterCleanup; //!< Stops the writer thread at exit
+
+PcapAsyncWriter *
+PcapAsyncWriter::Get (void)
+{
+  CriticalSection cs (g_writerMutex);
+  if (g_writer == 0)
+    {
+      g_writer = new PcapAsyncWriter ();
+      Simulator::ScheduleDestroy (&PcapAsyncWriter::Destroy);
+    }
+  return g_writer;
+}
+
+PcapAsyncWriter::PcapAsyncWriter ()
+  : m_stop (false)
+{
+  NS_LOG_FUNCTION (this);
+  m_thread = Create<SystemThread> (MakeCallback (&PcapAsyncWriter::Run, this));
+  m_thread->Start ();
+}
+
+void
+PcapAsyncWriter::Destroy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  PcapAsyncWriter *writer;
+  {
+    CriticalSection cs (g_writerMutex);
+    writer = g_writer;
+  }
+  if (writer == 0)
+    {
+      return;
+    }
+  std::set<PcapFileWrapper *> files;
+  {
+    CriticalSection cs (writer->m_mutex);
+    files = writer->m_files;
+  }
+  for (std::set<PcapFileWrapper *>::iterator i = files.begin (); i != files.end (); ++i)
+    {
+      (*i)->Sync ();
+    }
+  writer->m_stop = true;
+  writer->Wake ();
+  writer->m_thread->Join ();
+  // Files written after this point store their records themselves until
+  // a batch is full again, which starts a new writer thread.
+  for (std::set<PcapFileWrapper *>::iterator i = files.begin (); i != files.end (); ++i)
+    {
+      (*i)->m_registered = false;
+    }
+  {
+    CriticalSection cs (g_writerMutex);
+    g_writer = 0;
+  }
+  delete writer;
+}
+
+void
+PcapAsyncWriter::Add (PcapFileWrapper *file)
+{
+  NS_LOG_FUNCTION (this << file);
+  CriticalSection cs (m_mutex);
+  m_files.insert (file);
+}
+
+void
+PcapAsyncWriter::Remove (PcapFileWrapper *file)
+{
+  NS_LOG_FUNCTION (this << file);
+  CriticalSection cs (m_mutex);
+  m_files.erase (file);
+}
+
+void
+PcapAsyncWriter::Wake (void)
+{
+  m_wake.SetCondition (true);
+  m_wake.Signal ();
+}
+
+void
+PcapAsyncWriter::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_stop)
+    {
+      if (!Drain ())
+        {
+          // A wakeup between Drain and TimedWait is missed, so do not sleep
+          // for long.
+          m_wake.TimedWait (10000000);
+        }
+    }
+}
+
+bool
+PcapAsyncWriter::Drain (void)
+{
+  CriticalSection cs (m_mutex);
+  bool stored = false;
+  for (std::set<PcapFileWrapper *>::iterator i = m_files.begin (); i != m_files.end (); ++i)
+    {
+      PcapFileWrapper *file = *i;
+      uint32_t tail = file->m_ringTail.load (std::memory_order_relaxed);
+      while (tail != file->m_ringHead.load (std::memory_order_acquire))
+        {
+          std::vector<uint8_t> *batch = file->m_ring[tail % PcapFileWrapper::RING_SIZE];
+          file->m_file.WriteRecords (&(*batch)[0], batch->size ());
+          delete batch;
+          tail++;
+          file->m_ringTail.store (tail, std::memory_order_release);
+          stored = true;
+        }
+    }
+  return stored;
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+/// Size of the batches of records handed to the writer thread
+static const uint32_t BATCH_SIZE = 1 << 20;
+
 TypeId 
 PcapFileWrapper::GetTypeId (void)
 {
@@ -46,12 +259,24 @@ PcapFileWrapper::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&PcapFileWrapper::m_nanosecMode),
                    MakeBooleanChecker())
+    .AddAttribute ("Asynchronous",
+                   "Whether the packet records are batched in memory and stored "
+                   "by a background thread.  Without thread support, the batches "
+                   "are stored by the simulation thread.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::SetAsynchronous,
+                                        &PcapFileWrapper::GetAsynchronous),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_async (false),
+    m_registered (false),
+    m_ringHead (0),
+    m_ringTail (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -66,6 +291,8 @@ bool
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  // The writer thread may not have stored all the records yet
+  const_cast<PcapFileWrapper *> (this)->Sync ();
   return m_file.Fail ();
 }
 
@@ -73,12 +300,14 @@ bool
 PcapFileWrapper::Eof (void) const
 {
   NS_LOG_FUNCTION (this);
+  const_cast<PcapFileWrapper *> (this)->Sync ();
   return m_file.Eof ();
 }
 void 
 PcapFileWrapper::Clear (void)
 {
   NS_LOG_FUNCTION (this);
+  Sync ();
   m_file.Clear ();
 }
 
@@ -86,6 +315,14 @@ void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  Sync ();
+#ifdef HAVE_PTHREAD_H
+  if (m_registered)
+    {
+      PcapAsyncWriter::Get ()->Remove (this);
+      m_registered = false;
+    }
+#endif
   m_file.Close ();
 }
 
@@ -93,6 +330,7 @@ void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
+  Sync ();
   m_file.Open (filename, mode);
 }
 
@@ -105,6 +343,7 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // a snaplen, we use the one provided.
   //
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << tzCorrection);
+  Sync ();
   if (snapLen != std::numeric_limits<uint32_t>::max ())
     {
       m_file.Init (dataLinkType, snapLen, tzCorrection, false, m_nanosecMode);
@@ -119,6 +358,13 @@ void
 PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << p);
+  if (m_async)
+    {
+      uint32_t inclLen;
+      uint8_t *data = AddRecord (t, p->GetSize (), inclLen);
+      p->CopyData (data, inclLen);
+      return;
+    }
   if (m_file.IsNanoSecMode())
     {
       uint64_t current = t.GetNanoSeconds ();
@@ -139,6 +385,19 @@ void
 PcapFileWrapper::Write (Time t, const Header &header, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << &header << p);
+  if (m_async)
+    {
+      uint32_t headerSize = header.GetSerializedSize ();
+      uint32_t inclLen;
+      uint8_t *data = AddRecord (t, headerSize + p->GetSize (), inclLen);
+      Buffer headerBuffer;
+      headerBuffer.AddAtStart (headerSize);
+      header.Serialize (headerBuffer.Begin ());
+      uint32_t toCopy = std::min (headerSize, inclLen);
+      headerBuffer.CopyData (data, toCopy);
+      p->CopyData (data + toCopy, inclLen - toCopy);
+      return;
+    }
   if (m_file.IsNanoSecMode())
     {
       uint64_t current = t.GetNanoSeconds ();
@@ -159,6 +418,13 @@ void
 PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
 {
   NS_LOG_FUNCTION (this << t << &buffer << length);
+  if (m_async)
+    {
+      uint32_t inclLen;
+      uint8_t *data = AddRecord (t, length, inclLen);
+      std::memcpy (data, buffer, inclLen);
+      return;
+    }
   if (m_file.IsNanoSecMode())
     {
       uint64_t current = t.GetNanoSeconds ();
@@ -175,9 +441,116 @@ PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
     }
 }
 
+uint8_t *
+PcapFileWrapper::AddRecord (Time t, uint32_t totalLen, uint32_t &inclLen)
+{
+  uint64_t s;
+  uint64_t subSec;
+  if (m_file.IsNanoSecMode ())
+    {
+      uint64_t current = t.GetNanoSeconds ();
+      s       = current / 1000000000;
+      subSec  = current % 1000000000;
+    }
+  else
+    {
+      uint64_t current = t.GetMicroSeconds ();
+      s       = current / 1000000;
+      subSec  = current % 1000000;
+    }
+
+  std::size_t offset = m_pending.size ();
+  if (offset > 0 && offset + PcapFile::RECORD_HEADER_SIZE + totalLen > BATCH_SIZE)
+    {
+      HandOff ();
+      offset = 0;
+    }
+  if (m_pending.capacity () < BATCH_SIZE)
+    {
+      m_pending.reserve (BATCH_SIZE);
+    }
+  m_pending.resize (offset + PcapFile::RECORD_HEADER_SIZE);
+  inclLen = m_file.SerializePacketHeader (&m_pending[offset], s, subSec, totalLen);
+  m_pending.resize (offset + PcapFile::RECORD_HEADER_SIZE + inclLen);
+  return &m_pending[offset + PcapFile::RECORD_HEADER_SIZE];
+}
+
+void
+PcapFileWrapper::HandOff (void)
+{
+  NS_LOG_FUNCTION (this << m_pending.size ());
+#ifdef HAVE_PTHREAD_H
+  PcapAsyncWriter *writer = PcapAsyncWriter::Get ();
+  if (!m_registered)
+    {
+      writer->Add (this);
+      m_registered = true;
+    }
+  uint32_t head = m_ringHead.load (std::memory_order_relaxed);
+  while (head - m_ringTail.load (std::memory_order_acquire) == RING_SIZE)
+    {
+      writer->Wake ();
+      std::this_thread::yield ();
+    }
+  std::vector<uint8_t> *batch = new std::vector<uint8_t> ();
+  batch->swap (m_pending);
+  m_ring[head % RING_SIZE] = batch;
+  m_ringHead.store (head + 1, std::memory_order_release);
+  writer->Wake ();
+#else
+  // Without threads, the records are still stored with large writes.
+  m_file.WriteRecords (&m_pending[0], m_pending.size ());
+  m_pending.clear ();
+#endif
+}
+
+void
+PcapFileWrapper::Sync (void)
+{
+  if (m_pending.empty () && !m_registered)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  if (!m_registered)
+    {
+      // No writer thread serves this file: store the records here.
+      m_file.WriteRecords (&m_pending[0], m_pending.size ());
+      m_pending.clear ();
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (!m_pending.empty ())
+    {
+      HandOff ();
+    }
+  PcapAsyncWriter *writer = PcapAsyncWriter::Get ();
+  while (m_ringTail.load (std::memory_order_acquire) != m_ringHead.load (std::memory_order_relaxed))
+    {
+      writer->Wake ();
+      std::this_thread::yield ();
+    }
+#endif
+}
+
+void
+PcapFileWrapper::SetAsynchronous (bool async)
+{
+  NS_LOG_FUNCTION (this << async);
+  Sync ();
+  m_async = async;
+}
+
+bool
+PcapFileWrapper::GetAsynchronous (void) const
+{
+  return m_async;
+}
+
 Ptr<Packet> 
 PcapFileWrapper::Read (Time &t)
 {
+  Sync ();
   uint32_t tsSec;
   uint32_t tsUsec;
   uint32_t inclLen;
@@ -22,6 +22,8 @@
 #include <cstring>
 #include <limits>
 #include <fstream>
+#include <vector>
+#include <atomic>
 #include "ns3/ptr.h"
 #include "ns3/packet.h"
 #include "ns3/object.h"
@@ -35,6 +37,13 @@ namespace ns3 {
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * When the Asynchronous attribute is set, the packet records are batched in
+ * memory, only up to the snap length of each packet, and the batches are
+ * stored by a background thread shared by all the files, with large writes.
+ * The records keep their order.  The batches still in memory are stored when
+ * the file is closed or inspected, and at Simulator::Destroy.  Without
+ * thread support, the simulation thread stores the batches itself.
  */
 class PcapFileWrapper : public Object
 {
@@ -221,9 +230,54 @@ public:
   uint32_t GetDataLinkType (void);
 
 private:
+  friend class PcapAsyncWriter;
+
+  /**
+   * \brief Set the asynchronous mode
+   * \param async whether records are stored by the background writer thread
+   */
+  void SetAsynchronous (bool async);
+  /**
+   * \brief Get the asynchronous mode
+   * \returns whether records are stored by the background writer thread
+   */
+  bool GetAsynchronous (void) const;
+  /**
+   * \brief Add a packet record to the pending batch
+   *
+   * The record header is serialized in the batch, followed by room for the
+   * packet data, which the caller fills.
+   *
+   * \param t Packet timestamp as ns3::Time.
+   * \param totalLen Total packet length.
+   * \param inclLen [out] Number of bytes of packet data to store.
+   * \returns where to store the inclLen bytes of packet data
+   */
+  uint8_t *AddRecord (Time t, uint32_t totalLen, uint32_t &inclLen);
+  /**
+   * \brief Hand the pending batch to the writer thread
+   *
+   * Waits for the writer thread if it has too many batches of this file
+   * not yet stored.
+   */
+  void HandOff (void);
+  /**
+   * \brief Store all the records written so far in the file
+   */
+  void Sync (void);
+
+  /// Largest number of batches of a file not yet stored by the writer thread
+  static const uint32_t RING_SIZE = 8;
+
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
   bool     m_nanosecMode; //!< Timestamps in nanosecond mode
+  bool     m_async; //!< Records stored by the background writer thread
+  bool     m_registered; //!< Whether the writer thread serves this file
+  std::vector<uint8_t> m_pending; //!< Records not yet handed to the writer thread
+  std::vector<uint8_t> *m_ring[RING_SIZE]; //!< Batches handed to the writer thread
+  std::atomic<uint32_t> m_ringHead; //!< Number of batches handed to the writer thread
+  std::atomic<uint32_t> m_ringTail; //!< Number of batches stored by the writer thread
 };
 
 } // namespace ns3
@@ -44,6 +44,7 @@ class PcapFile
 public:
   static const int32_t  ZONE_DEFAULT    = 0;           /**< Time zone offset for current location */
   static const uint32_t SNAPLEN_DEFAULT = 65535;       /**< Default value for maximum octets to save per packet */
+  static const uint32_t RECORD_HEADER_SIZE = 16;    /**< Size of a packet record header in the file */
 
 public:
   PcapFile ();
@@ -153,6 +154,34 @@ public:
    */
   void Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<const Packet> p);
 
+  /**
+   * \brief Serialize a packet record header in memory
+   *
+   * The record header is laid out exactly as Write would store it in the
+   * file, so that a caller can batch whole records and store them later
+   * with WriteRecords.
+   *
+   * \param buffer      Buffer of at least RECORD_HEADER_SIZE bytes
+   * \param tsSec       Packet timestamp, seconds
+   * \param tsUsec      Packet timestamp, microseconds
+   * \param totalLen    Total packet length
+   * \returns the number of bytes of packet data to store after the header,
+   * i.e., totalLen limited to the snap length of the file
+   */
+  uint32_t SerializePacketHeader (uint8_t *buffer, uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
+
+  /**
+   * \brief Write already serialized packet records to the file
+   *
+   * The file is flushed afterwards, as the records are written in large
+   * batches.
+   *
+   * \param data        Records, each made of a header serialized by
+   *                    SerializePacketHeader and its packet data
+   * \param size        Number of bytes to write
+   */
+  void WriteRecords (uint8_t const *data, uint32_t size);
+
 
   /**
    * \brief Read next packet from file
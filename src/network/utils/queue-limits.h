@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUEUE_LIMITS_H
+#define QUEUE_LIMITS_H
+
+#include "ns3/object.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Abstract base class for the limits of a device transmission queue
+ *
+ * A QueueLimits object is attached to a NetDeviceQueue to bound the amount
+ * of data (typically bytes) a device holds in its transmission queue.  The
+ * device reports the data it queues and the data whose transmission is
+ * completed, and the NetDeviceQueue stops and wakes the queue according to
+ * the amount of data still available.  This is the analogous of the byte
+ * queue limits (BQL) of the Linux kernel.
+ */
+class QueueLimits : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual ~QueueLimits ();
+
+  /**
+   * \brief Reset queue limits state
+   */
+  virtual void Reset (void) = 0;
+
+  /**
+   * \brief Record number of completed objects and recalculate the limit
+   * \param count the number of completed objects
+   */
+  virtual void Completed (uint32_t count) = 0;
+
+  /**
+   * \brief Returns how many objects can be queued, a negative value
+   * meaning that the queue is over its limit
+   * \return the number of objects that can be queued
+   */
+  virtual int32_t Available (void) const = 0;
+
+  /**
+   * \brief Record the number of objects queued
+   * \param count the number of objects queued
+   */
+  virtual void Queued (uint32_t count) = 0;
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_LIMITS_H */
@@ -30,6 +30,7 @@
 #include "ns3/tag.h"
 #include "ns3/simulator.h"
 #include "ns3/drop-tail-queue.h"
+#include "ns3/gso-tag.h"
 
 namespace ns3 {
 
@@ -428,7 +429,8 @@ bool
 SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address& dest, uint16_t protocolNumber)
 {
   NS_LOG_FUNCTION (this << p << source << dest << protocolNumber);
-  if (p->GetSize () > GetMtu ())
+  GsoTag gsoTag;
+  if (p->GetSize () > GetMtu () && !p->PeekPacketTag (gsoTag))
     {
       return false;
     }
@@ -453,7 +455,7 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
           Time txTime = Time (0);
           if (m_bps > DataRate (0))
             {
-              txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
+              txTime = m_bps.CalculateBytesTxTime (GsoTag::GetWireSize (packet, 0));
             }
           m_channel->Send (p, protocolNumber, to, from, this);
           TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
@@ -493,7 +495,7 @@ SimpleNetDevice::TransmitComplete ()
       Time txTime = Time (0);
       if (m_bps > DataRate (0))
         {
-          txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
+          txTime = m_bps.CalculateBytesTxTime (GsoTag::GetWireSize (packet, 0));
         }
       TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
     }
@@ -20,6 +20,7 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 
@@ -97,9 +98,18 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  Ptr<Node> dstNode = m_link[wire].m_dst->GetNode ();
+  Ptr<Packet> rxPacket = p;
+  if (dstNode->GetSystemId () != src->GetNode ()->GetSystemId ())
+    {
+      // The nodes are in different partitions of a multithreaded
+      // simulation: the receiver must not share the buffers of the
+      // packet with the sender, so give it a deep copy
+      rxPacket = p->DeepCopy ();
+    }
+  Simulator::ScheduleWithContext (dstNode->GetId (),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+                                  m_link[wire].m_dst, rxPacket);
 
   // Call the tx anim callback on the net device
   m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
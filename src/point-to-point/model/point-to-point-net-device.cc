@@ -25,6 +25,8 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/gso-tag.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -67,6 +69,16 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("FastLink",
+                   "If true, do not schedule the end of the transmission of a packet "
+                   "sent while the device is idle when it has no effect, that is "
+                   "when the device queue is empty, no queue limits are set and "
+                   "nothing is connected to the PhyTxEnd trace source.  The end "
+                   "of the transmission is recovered if another packet is sent "
+                   "meanwhile, so the timings are the ones of the normal mode.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointNetDevice::m_fastLink),
+                   MakeBooleanChecker ())
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -266,7 +278,7 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+  Time txTime = m_bps.CalculateBytesTxTime (GsoTag::GetWireSize (p, PppHeader ().GetSerializedSize ()));
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
@@ -280,6 +292,55 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   return result;
 }
 
+bool
+PointToPointNetDevice::FastTransmitStart (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
+
+  //
+  // Nothing happens at the end of the transmission, so the device stays
+  // READY and only remembers when it would be over.  The packet is kept
+  // in case another one is sent before.
+  //
+  NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
+  m_currentPkt = p;
+  m_phyTxBeginTrace (m_currentPkt);
+
+  Time txTime = m_bps.CalculateBytesTxTime (GsoTag::GetWireSize (p, PppHeader ().GetSerializedSize ()));
+  m_fastTxEnd = Simulator::Now () + txTime + m_tInterframeGap;
+
+  bool result = m_channel->TransmitStart (p, this, txTime);
+  if (result == false)
+    {
+      m_phyTxDropTrace (p);
+    }
+  return result;
+}
+
+void
+PointToPointNetDevice::SyncFastTransmit (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_txMachineState == BUSY || m_currentPkt == 0)
+    {
+      return;
+    }
+
+  if (Simulator::Now () < m_fastTxEnd)
+    {
+      NS_LOG_LOGIC ("Schedule TransmitCompleteEvent of the fast link packet in " <<
+                    (m_fastTxEnd - Simulator::Now ()).GetSeconds () << "sec");
+      m_txMachineState = BUSY;
+      Simulator::Schedule (m_fastTxEnd - Simulator::Now (), &PointToPointNetDevice::TransmitComplete, this);
+    }
+  else
+    {
+      m_currentPkt = 0;
+    }
+}
+
 void
 PointToPointNetDevice::TransmitComplete (void)
 {
@@ -297,6 +358,7 @@ PointToPointNetDevice::TransmitComplete (void)
   NS_ASSERT_MSG (m_currentPkt != 0, "PointToPointNetDevice::TransmitComplete(): m_currentPkt zero");
 
   m_phyTxEndTrace (m_currentPkt);
+  uint32_t completedBytes = m_currentPkt->GetSize ();
   m_currentPkt = 0;
 
   Ptr<NetDeviceQueue> txq;
@@ -311,6 +373,9 @@ PointToPointNetDevice::TransmitComplete (void)
       NS_LOG_LOGIC ("No pending packets in device queue after tx complete");
       if (txq)
       {
+        // Report the completed bytes first, so that the queue limits do not
+        // stop the queue disc again
+        txq->NotifyTransmittedBytes (completedBytes);
         NS_LOG_DEBUG ("The device queue is being woken up (" << m_queue->GetNPackets () <<
                       " packets and " << m_queue->GetNBytes () << " bytes inside)");
         txq->Wake ();
@@ -325,22 +390,39 @@ PointToPointNetDevice::TransmitComplete (void)
   // to the device while the machine state is busy, thus causing the assert in
   // TransmitStart to fail.
   //
-  if (txq && txq->IsStopped ())
+  bool room = (m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
+               m_queue->GetNPackets () < m_queue->GetMaxPackets ()) ||
+              (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
+               m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ());
+  if (txq && txq->IsStopped () && !txq->GetQueueLimits () && room)
     {
-      if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
-           m_queue->GetNPackets () < m_queue->GetMaxPackets ()) ||
-          (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-           m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ()))
-        {
-          NS_LOG_DEBUG ("The device queue is being started (" << m_queue->GetNPackets () <<
-                        " packets and " << m_queue->GetNBytes () << " bytes inside)");
-          txq->Start ();
-        }
+      NS_LOG_DEBUG ("The device queue is being started (" << m_queue->GetNPackets () <<
+                    " packets and " << m_queue->GetNBytes () << " bytes inside)");
+      txq->Start ();
     }
   Ptr<Packet> p = item->GetPacket ();
   m_snifferTrace (p);
   m_promiscSnifferTrace (p);
   TransmitStart (p);
+
+  //
+  // With queue limits, the completed bytes may let the queue disc send more
+  // packets.  The transmitter is busy again, hence the packets sent by the
+  // woken up queue disc are just enqueued.  If the device queue has no room
+  // for another packet, the queue is not woken up now and will be when the
+  // device queue gets empty.
+  //
+  if (txq && txq->GetQueueLimits ())
+    {
+      if (room)
+        {
+          txq->NotifyTransmittedBytes (completedBytes);
+        }
+      else
+        {
+          txq->GetQueueLimits ()->Completed (completedBytes);
+        }
+    }
 }
 
 bool
@@ -586,11 +668,23 @@ PointToPointNetDevice::Send (
 
   m_macTxTrace (packet);
 
+  //
+  // The device may still be transmitting a packet sent in fast link mode.
+  //
+  SyncFastTransmit ();
+
   //
   // We should enqueue and dequeue the packet to hit the tracing hooks.
   //
   if (m_queue->Enqueue (Create<QueueItem> (packet)))
     {
+      // Report the bytes handed to the device, which may exceed the queue
+      // limits and stop the queue
+      if (txq)
+        {
+          txq->NotifyQueuedBytes (packet->GetSize ());
+        }
+
       //
       // If the channel is ready for transition we send the packet right now
       // 
@@ -613,6 +707,11 @@ PointToPointNetDevice::Send (
             }
           m_snifferTrace (packet);
           m_promiscSnifferTrace (packet);
+          if (m_fastLink && m_queue->IsEmpty () && m_phyTxEndTrace.IsEmpty () &&
+              (!txq || (!txq->IsStopped () && !txq->GetQueueLimits ())))
+            {
+              return FastTransmitStart (packet);
+            }
           return TransmitStart (packet);
         }
       // We have enqueued a packet but we have not dequeued any packet. Thus, we
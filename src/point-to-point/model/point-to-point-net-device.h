@@ -277,6 +277,31 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * Start Sending a Packet Down the Wire in fast link mode.
+   *
+   * Like TransmitStart, but the device stays READY and no event is
+   * scheduled for the end of the transmission, whose time is stored
+   * instead.  Used when the end of the transmission has no effect: the
+   * device queue is empty, no queue limits are set and no sink is
+   * connected to the PhyTxEnd trace source.
+   *
+   * \see SyncFastTransmit()
+   * \param p a reference to the packet to send
+   * \returns true if success, false on failure
+   */
+  bool FastTransmitStart (Ptr<Packet> p);
+
+  /**
+   * Bring the transmit state machine up to date with a packet sent in fast
+   * link mode.
+   *
+   * If the packet is still being transmitted, the device becomes BUSY and
+   * the TransmitComplete event is scheduled, as if the packet had been sent
+   * by TransmitStart.  Otherwise, the device is left READY.
+   */
+  void SyncFastTransmit (void);
+
   /**
    * \brief Make the link up and running
    *
@@ -309,6 +334,17 @@ private:
    */
   Time           m_tInterframeGap;
 
+  /**
+   * True if the TransmitComplete event is elided when it has no effect
+   */
+  bool m_fastLink;
+
+  /**
+   * The end of the interframe gap following the last packet sent in fast
+   * link mode
+   */
+  Time m_fastTxEnd;
+
   /**
    * The PointToPointChannel to which this PointToPointNetDevice has been
    * attached.
@@ -0,0 +1,565 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/object-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/multithreaded-simulator-impl.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief Test class for the MultithreadedSimulatorImpl over point-to-point links
+ *
+ * A chain of nodes forwards packets in both directions. One of the links
+ * is shorter than MinLookahead, so its two nodes share a partition. The
+ * packet counts, arrival times and tags at both ends of the chain must be
+ * the same with the default simulator and with the multithreaded simulator,
+ * whatever its number of threads.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /** What the ends of the chain received. */
+  struct Result
+  {
+    uint32_t packets;      //!< Packets received
+    uint64_t bytes;        //!< Bytes received
+    int64_t arrivalSum;    //!< Sum of the arrival times, in ns
+    uint64_t packetTagSum; //!< Sum of the packet tags received
+    uint64_t byteTagSum;   //!< Sum of the byte tags received
+  };
+
+  /**
+   * \brief Run the scenario
+   *
+   * \param threads The threads of the multithreaded simulator, or zero
+   *                for the default simulator
+   * \returns The results at the first and the last node
+   */
+  std::vector<Result> RunScenario (uint32_t threads);
+
+  /**
+   * \brief Send a packet, and schedule the next one
+   *
+   * \param device The device to send on
+   * \param size The size of the packet
+   * \param count The number of packets left to send
+   */
+  void Emit (Ptr<NetDevice> device, uint32_t size, uint32_t count);
+
+  /**
+   * \brief Forward a packet to the next node, or record it at the end of the chain
+   *
+   * \param device The receiving device
+   * \param p The packet
+   * \param protocol The protocol number
+   * \param from The sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::vector<Ptr<NetDevice> > m_left;   //!< Device towards the first node, per node
+  std::vector<Ptr<NetDevice> > m_right;  //!< Device towards the last node, per node
+  std::vector<Result> m_results;         //!< Results, per node
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPointMultithreaded")
+{
+}
+
+void
+PointToPointMultithreadedTest::Emit (Ptr<NetDevice> device, uint32_t size, uint32_t count)
+{
+  // Tagged, to check that the tags cross the partitions
+  Ptr<Packet> p = Create<Packet> (size);
+  p->AddPacketTag (FlowIdTag (count));
+  p->AddByteTag (FlowIdTag (size));
+  device->Send (p, device->GetBroadcast (), 0x800);
+  if (count > 1)
+    {
+      Simulator::Schedule (MicroSeconds (700), &PointToPointMultithreadedTest::Emit, this,
+                           device, 100 + (size * 7) % 400, count - 1);
+    }
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
+                                        uint16_t protocol, const Address &from)
+{
+  // Only the thread running the partition of the node touches its entries
+  uint32_t node = device->GetNode ()->GetId ();
+  Ptr<NetDevice> next = device == m_left[node] ? m_right[node] : m_left[node];
+  if (next == 0)
+    {
+      Result &result = m_results[node];
+      result.packets++;
+      result.bytes += p->GetSize ();
+      result.arrivalSum += Simulator::Now ().GetNanoSeconds ();
+      FlowIdTag tag;
+      if (p->PeekPacketTag (tag))
+        {
+          result.packetTagSum += tag.GetFlowId ();
+        }
+      if (p->FindFirstMatchingByteTag (tag))
+        {
+          result.byteTagSum += tag.GetFlowId ();
+        }
+    }
+  else
+    {
+      next->Send (p->Copy (), next->GetBroadcast (), protocol);
+    }
+  return true;
+}
+
+std::vector<PointToPointMultithreadedTest::Result>
+PointToPointMultithreadedTest::RunScenario (uint32_t threads)
+{
+  Ptr<MultithreadedSimulatorImpl> mt;
+  if (threads > 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId ("ns3::MultithreadedSimulatorImpl");
+      factory.Set ("MaxThreads", UintegerValue (threads));
+      mt = factory.Create<MultithreadedSimulatorImpl> ();
+      Simulator::SetImplementation (mt);
+    }
+
+  const char *delays[] = { "2ms", "5ms", "100ns", "3ms", "1ms" };
+  uint32_t nNodes = sizeof (delays) / sizeof (delays[0]) + 1;
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+  m_left.assign (nNodes, 0);
+  m_right.assign (nNodes, 0);
+  Result empty = { 0, 0, 0, 0, 0 };
+  m_results.assign (nNodes, empty);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
+  for (uint32_t i = 0; i + 1 < nNodes; i++)
+    {
+      p2p.SetChannelAttribute ("Delay", StringValue (delays[i]));
+      NetDeviceContainer devices = p2p.Install (nodes.Get (i), nodes.Get (i + 1));
+      m_right[i] = devices.Get (0);
+      m_left[i + 1] = devices.Get (1);
+    }
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      for (uint32_t j = 0; j < nodes.Get (i)->GetNDevices (); j++)
+        {
+          nodes.Get (i)->GetDevice (j)->SetReceiveCallback (
+            MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+        }
+    }
+
+  Simulator::ScheduleWithContext (0, MicroSeconds (10), &PointToPointMultithreadedTest::Emit,
+                                  this, m_right[0], 500, 300);
+  Simulator::ScheduleWithContext (nNodes - 1, MicroSeconds (10), &PointToPointMultithreadedTest::Emit,
+                                  this, m_left[nNodes - 1], 300, 300);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  if (mt != 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (mt->GetPartitionCount (), nNodes - 1, "The 100ns link is not cut");
+      NS_TEST_EXPECT_MSG_EQ (mt->GetLookahead (), MilliSeconds (1), "Wrong lookahead");
+      NS_TEST_EXPECT_MSG_EQ (mt->GetThreadCount (), threads, "The partitions did not run on all the threads");
+    }
+
+  std::vector<Result> results;
+  results.push_back (m_results[0]);
+  results.push_back (m_results[nNodes - 1]);
+  m_left.clear ();
+  m_right.clear ();
+  Simulator::Destroy ();
+  return results;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  std::vector<Result> expected = RunScenario (0);
+  NS_TEST_ASSERT_MSG_EQ (expected[0].packets, 300, "Packets lost on the way to the first node");
+  NS_TEST_ASSERT_MSG_EQ (expected[1].packets, 300, "Packets lost on the way to the last node");
+  NS_TEST_ASSERT_MSG_EQ (expected[0].packetTagSum, 300 * 301 / 2, "Packet tags lost on the way");
+  NS_TEST_ASSERT_MSG_NE (expected[1].byteTagSum, 0, "Byte tags lost on the way");
+
+#ifdef NS3_MTP
+  uint32_t threads[] = { 1, 4 };
+#else
+  // Without --enable-mtp, the multithreaded simulator runs on one thread
+  std::cout << GetName () << ": ns-3 was configured without --enable-mtp, "
+            << "skipping the runs on several threads" << std::endl;
+  uint32_t threads[] = { 1 };
+#endif
+  for (uint32_t i = 0; i < sizeof (threads) / sizeof (threads[0]); i++)
+    {
+      std::vector<Result> results = RunScenario (threads[i]);
+      for (uint32_t j = 0; j < results.size (); j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (results[j].packets, expected[j].packets,
+                                 "Different packet count with " << threads[i] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (results[j].bytes, expected[j].bytes,
+                                 "Different byte count with " << threads[i] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (results[j].arrivalSum, expected[j].arrivalSum,
+                                 "Different arrival times with " << threads[i] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (results[j].packetTagSum, expected[j].packetTagSum,
+                                 "Different packet tags with " << threads[i] << " threads");
+          NS_TEST_EXPECT_MSG_EQ (results[j].byteTagSum, expected[j].byteTagSum,
+                                 "Different byte tags with " << threads[i] << " threads");
+        }
+    }
+}
+
+/**
+ * \brief Test class for the events without a node context in the MultithreadedSimulatorImpl
+ *
+ * Events scheduled by the main program have no node context and stay
+ * with the public LP. A node of another LP must still find them to
+ * check whether they expired, and to remove them.
+ */
+class PointToPointMultithreadedEventIdTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedEventIdTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /** \brief Check and remove the events of the main program, from a node */
+  void Check (void);
+  /** \brief The event run before Check () */
+  void Early (void);
+  /** \brief The event removed by Check (): must not run */
+  void Late (void);
+
+  EventId m_early;  //!< Event of the main program, run before Check ()
+  EventId m_late;   //!< Event of the main program, removed by Check ()
+  bool m_earlyRan;  //!< Early () ran
+  bool m_lateRan;   //!< Late () ran
+  bool m_checked;   //!< Check () ran
+};
+
+PointToPointMultithreadedEventIdTest::PointToPointMultithreadedEventIdTest ()
+  : TestCase ("PointToPointMultithreadedEventId"),
+    m_earlyRan (false),
+    m_lateRan (false),
+    m_checked (false)
+{
+}
+
+void
+PointToPointMultithreadedEventIdTest::Check (void)
+{
+  m_checked = true;
+  NS_TEST_EXPECT_MSG_EQ (m_early.IsExpired (), true, "The early event did run");
+  NS_TEST_EXPECT_MSG_EQ (m_late.IsRunning (), true, "The late event is still pending");
+  Simulator::Remove (m_late);
+  NS_TEST_EXPECT_MSG_EQ (m_late.IsRunning (), false, "The late event was removed");
+}
+
+void
+PointToPointMultithreadedEventIdTest::Early (void)
+{
+  m_earlyRan = true;
+}
+
+void
+PointToPointMultithreadedEventIdTest::Late (void)
+{
+  m_lateRan = true;
+}
+
+void
+PointToPointMultithreadedEventIdTest::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::MultithreadedSimulatorImpl");
+  factory.Set ("MaxThreads", UintegerValue (2));
+  Ptr<MultithreadedSimulatorImpl> mt = factory.Create<MultithreadedSimulatorImpl> ();
+  Simulator::SetImplementation (mt);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  p2p.Install (nodes);
+
+  m_early = Simulator::Schedule (MilliSeconds (1), &PointToPointMultithreadedEventIdTest::Early, this);
+  m_late = Simulator::Schedule (Seconds (5), &PointToPointMultithreadedEventIdTest::Late, this);
+  Simulator::ScheduleWithContext (1, MilliSeconds (10), &PointToPointMultithreadedEventIdTest::Check, this);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (mt->GetPartitionCount (), 2, "The link is not cut");
+  NS_TEST_EXPECT_MSG_EQ (m_earlyRan, true, "The early event did not run");
+  NS_TEST_EXPECT_MSG_EQ (m_checked, true, "The node did not check the events");
+  NS_TEST_EXPECT_MSG_EQ (m_lateRan, false, "The removed event ran");
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the events cancelled across LPs in the MultithreadedSimulatorImpl
+ *
+ * Each node of a chain schedules a series of ticks, which the previous
+ * node (the last one for the first node) checks and cancels while both
+ * LPs run. The ticks at least two lookaheads away from the checking
+ * node, in the past or in the future, must
+ * be seen expired or pending, whatever the threads do; the ones cancelled
+ * in the future must not run, and the other ones must. The ticks closer
+ * to the checking node are checked and cancelled too, to stress the threads,
+ * but their fate is not checked.
+ */
+class PointToPointMultithreadedCancelTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedCancelTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /** The ticks of a node. */
+  struct Ticks
+  {
+    // Bytes rather than bits, since the node and the checking node write
+    // different entries from different threads
+    std::vector<EventId> events;     //!< The tick events
+    std::vector<uint8_t> cancelled;  //!< Cancelled at least two lookaheads ahead
+    std::vector<uint8_t> racy;       //!< Cancelled closer than that: may run
+    std::vector<uint8_t> ran;        //!< The tick ran
+    uint32_t errors;                 //!< Wrong checks by the node, or cancelled ticks run
+  };
+
+  /**
+   * \brief Schedule the ticks of a node
+   * \param node The node
+   */
+  void Start (uint32_t node);
+  /**
+   * \brief Run a tick
+   * \param node The node
+   * \param k The index of the tick
+   */
+  void Tick (uint32_t node, uint32_t k);
+  /**
+   * \brief Check and cancel the ticks of the next node, from a node
+   * \param node The node
+   */
+  void Poke (uint32_t node);
+
+  /** Sizes of the scenario. */
+  enum
+  {
+    NODES = 4,    //!< Nodes in the chain
+    TICKS = 2000  //!< Ticks per node
+  };
+
+  std::vector<Ticks> m_ticks;  //!< The ticks, per node
+  Time m_margin;               //!< Two lookaheads
+};
+
+PointToPointMultithreadedCancelTest::PointToPointMultithreadedCancelTest ()
+  : TestCase ("PointToPointMultithreadedCancel"),
+    m_margin (MilliSeconds (2))
+{
+}
+
+void
+PointToPointMultithreadedCancelTest::Start (uint32_t node)
+{
+  Ticks &ticks = m_ticks[node];
+  for (uint32_t k = 0; k < TICKS; k++)
+    {
+      ticks.events.push_back (Simulator::Schedule (MicroSeconds (5 * k), &PointToPointMultithreadedCancelTest::Tick,
+                                                   this, node, k));
+    }
+}
+
+void
+PointToPointMultithreadedCancelTest::Tick (uint32_t node, uint32_t k)
+{
+  // The checking node cancelled this tick at least two lookaheads ago,
+  // in an earlier round
+  Ticks &ticks = m_ticks[node];
+  ticks.ran[k] = 1;
+  if (ticks.cancelled[k])
+    {
+      ticks.errors++;
+    }
+}
+
+void
+PointToPointMultithreadedCancelTest::Poke (uint32_t node)
+{
+  Ticks &peer = m_ticks[(node + 1) % NODES];
+  Time now = Simulator::Now ();
+  for (uint32_t k = 0; k < TICKS; k++)
+    {
+      const EventId &id = peer.events[k];
+      Time ts = MicroSeconds (5 * k);
+      if (ts + m_margin <= now)
+        {
+          if (!id.IsExpired ())
+            {
+              m_ticks[node].errors++;
+            }
+        }
+      else if (ts >= now + m_margin)
+        {
+          if (id.IsExpired () != (peer.cancelled[k] != 0)
+              || (!peer.cancelled[k] && Simulator::GetDelayLeft (id) != ts - now))
+            {
+              m_ticks[node].errors++;
+            }
+          if (k % 5 == 0)
+            {
+              Simulator::Cancel (id);
+              peer.cancelled[k] = 1;
+            }
+          else if (k % 5 == 1)
+            {
+              Simulator::Remove (id);
+              peer.cancelled[k] = 1;
+            }
+        }
+      else
+        {
+          id.IsExpired ();
+          Simulator::GetDelayLeft (id);
+          if (k % 5 == 2)
+            {
+              Simulator::Cancel (id);
+              peer.racy[k] = 1;
+            }
+        }
+    }
+  if (now < MilliSeconds (9))
+    {
+      Simulator::Schedule (MicroSeconds (50), &PointToPointMultithreadedCancelTest::Poke, this, node);
+    }
+}
+
+void
+PointToPointMultithreadedCancelTest::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::MultithreadedSimulatorImpl");
+  factory.Set ("MaxThreads", UintegerValue (NODES));
+  Ptr<MultithreadedSimulatorImpl> mt = factory.Create<MultithreadedSimulatorImpl> ();
+  Simulator::SetImplementation (mt);
+
+  NodeContainer nodes;
+  nodes.Create (NODES);
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  for (uint32_t i = 0; i + 1 < NODES; i++)
+    {
+      p2p.Install (nodes.Get (i), nodes.Get (i + 1));
+    }
+
+  Ticks empty;
+  empty.cancelled.assign (TICKS, 0);
+  empty.racy.assign (TICKS, 0);
+  empty.ran.assign (TICKS, 0);
+  empty.errors = 0;
+  m_ticks.assign (NODES, empty);
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      Simulator::ScheduleWithContext (i, Seconds (0), &PointToPointMultithreadedCancelTest::Start, this, i);
+      Simulator::ScheduleWithContext (i, MilliSeconds (2), &PointToPointMultithreadedCancelTest::Poke, this, i);
+    }
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (mt->GetPartitionCount (), NODES, "The links are not cut");
+  NS_TEST_EXPECT_MSG_EQ (mt->GetLookahead (), MilliSeconds (1), "Wrong lookahead");
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      const Ticks &ticks = m_ticks[i];
+      NS_TEST_EXPECT_MSG_EQ (ticks.errors, 0, "Wrong checks or cancelled ticks run at node " << i);
+      uint32_t cancelled = 0;
+      for (uint32_t k = 0; k < TICKS; k++)
+        {
+          if (ticks.cancelled[k])
+            {
+              cancelled++;
+              NS_TEST_EXPECT_MSG_EQ (ticks.ran[k], 0, "Cancelled tick " << k << " of node " << i << " ran");
+            }
+          else if (!ticks.racy[k])
+            {
+              NS_TEST_EXPECT_MSG_EQ (ticks.ran[k], 1, "Tick " << k << " of node " << i << " did not run");
+            }
+        }
+      NS_TEST_EXPECT_MSG_GT (cancelled, 0, "No tick of node " << i << " was cancelled");
+    }
+  m_ticks.clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief TestSuite for the MultithreadedSimulatorImpl over point-to-point links
+ */
+class PointToPointMultithreadedTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  PointToPointMultithreadedTestSuite ();
+};
+
+PointToPointMultithreadedTestSuite::PointToPointMultithreadedTestSuite ()
+  : TestSuite ("point-to-point-multithreaded", SYSTEM)
+{
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedEventIdTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedCancelTest, TestCase::QUICK);
+}
+
+static PointToPointMultithreadedTestSuite g_pointToPointMultithreadedTestSuite; //!< The testsuite
@@ -23,9 +23,53 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/dynamic-queue-limits.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include <vector>
+#include <algorithm>
 
 using namespace ns3;
 
+/**
+ * \brief Connect two devices through a channel, each on a new node
+ *
+ * A device without a queue gets a DropTailQueue, and both devices get a
+ * NetDeviceQueueInterface, as the PointToPointHelper would do.
+ *
+ * \param devA the first device
+ * \param devB the second device
+ * \param channel the channel
+ * \return the NetDeviceQueueInterface of the first device
+ */
+static Ptr<NetDeviceQueueInterface>
+ConnectDevices (Ptr<PointToPointNetDevice> devA, Ptr<PointToPointNetDevice> devB,
+                Ptr<PointToPointChannel> channel)
+{
+  Ptr<PointToPointNetDevice> devices[2] = { devA, devB };
+  Ptr<NetDeviceQueueInterface> ifaceA;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      devices[i]->Attach (channel);
+      devices[i]->SetAddress (Mac48Address::Allocate ());
+      if (devices[i]->GetQueue () == 0)
+        {
+          devices[i]->SetQueue (CreateObject<DropTailQueue> ());
+        }
+      node->AddDevice (devices[i]);
+
+      Ptr<NetDeviceQueueInterface> iface = CreateObject<NetDeviceQueueInterface> ();
+      devices[i]->AggregateObject (iface);
+      if (i == 0)
+        {
+          ifaceA = iface;
+        }
+    }
+  return ifaceA;
+}
+
 /**
  * \brief Test class for PointToPoint model
  *
@@ -70,32 +114,239 @@ PointToPointTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
 void
 PointToPointTest::DoRun (void)
 {
-  Ptr<Node> a = CreateObject<Node> ();
-  Ptr<Node> b = CreateObject<Node> ();
   Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
   Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
   Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  ConnectDevices (devA, devB, channel);
 
-  devA->Attach (channel);
-  devA->SetAddress (Mac48Address::Allocate ());
-  devA->SetQueue (CreateObject<DropTailQueue> ());
-  devB->Attach (channel);
-  devB->SetAddress (Mac48Address::Allocate ());
-  devB->SetQueue (CreateObject<DropTailQueue> ());
+  Simulator::Schedule (Seconds (1.0), &PointToPointTest::SendOnePacket, this, devA);
 
-  a->AddDevice (devA);
-  b->AddDevice (devB);
+  Simulator::Run ();
 
-  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
-  devA->AggregateObject (ifaceA);
-  Ptr<NetDeviceQueueInterface> ifaceB = CreateObject<NetDeviceQueueInterface> ();
-  devB->AggregateObject (ifaceB);
+  Simulator::Destroy ();
+}
 
-  Simulator::Schedule (Seconds (1.0), &PointToPointTest::SendOnePacket, this, devA);
+/**
+ * \brief Test class for the byte queue limits of the PointToPoint model
+ *
+ * A producer sends packets to the device as long as its transmission
+ * queue is not stopped, as a queue disc does, and sends again when the
+ * queue is woken up.  With queue limits, the device queue holds no more
+ * than the packets needed to keep the link busy, and all the packets are
+ * transmitted.
+ */
+class PointToPointQueueLimitsTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointQueueLimitsTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send packets until the transmission queue is stopped
+   */
+  void Produce (void);
+
+  /**
+   * \brief Receive a packet
+   * \param device the receiving device
+   * \param p the packet
+   * \param protocol the protocol
+   * \param sender the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &sender);
+
+  Ptr<PointToPointNetDevice> m_device;  //!< the sending device
+  Ptr<NetDeviceQueue> m_txq;            //!< the transmission queue of the sending device
+  uint32_t m_toSend;                    //!< packets still to send
+  uint32_t m_received;                  //!< packets received
+  uint32_t m_maxQueued;                 //!< maximum number of packets in the device queue
+};
+
+PointToPointQueueLimitsTest::PointToPointQueueLimitsTest ()
+  : TestCase ("PointToPoint with byte queue limits")
+{
+}
+
+void
+PointToPointQueueLimitsTest::Produce (void)
+{
+  while (m_toSend > 0 && !m_txq->IsStopped ())
+    {
+      m_device->Send (Create<Packet> (1000), m_device->GetBroadcast (), 0x800);
+      m_toSend--;
+      m_maxQueued = std::max (m_maxQueued, m_device->GetQueue ()->GetNPackets ());
+    }
+}
+
+bool
+PointToPointQueueLimitsTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &sender)
+{
+  m_received++;
+  return true;
+}
+
+void
+PointToPointQueueLimitsTest::DoRun (void)
+{
+  m_device = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  m_device->SetDataRate (DataRate ("1Mbps"));
+  m_device->SetQueue (CreateObjectWithAttributes<DropTailQueue> ("MaxPackets", UintegerValue (100)));
+  Ptr<NetDeviceQueueInterface> ifaceA = ConnectDevices (m_device, devB, channel);
+  // Replace the callback set by the node
+  devB->SetReceiveCallback (MakeCallback (&PointToPointQueueLimitsTest::Receive, this));
+
+  m_txq = ifaceA->GetTxQueue (0);
+  m_txq->SetQueueLimits (CreateObject<DynamicQueueLimits> ());
+  m_txq->SetWakeCallback (MakeCallback (&PointToPointQueueLimitsTest::Produce, this));
+  m_toSend = 100;
+  m_received = 0;
+  m_maxQueued = 0;
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointQueueLimitsTest::Produce, this);
 
   Simulator::Run ();
 
+  NS_TEST_EXPECT_MSG_EQ (m_toSend, 0, "The producer was not woken up");
+  NS_TEST_EXPECT_MSG_EQ (m_received, 100, "Packets lost");
+  // Without queue limits, the producer would fill the device queue
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxQueued, 2, "The queue limits did not bound the device queue");
+
+  m_txq = 0;
+  m_device = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test class for the fast link mode of the PointToPoint model
+ *
+ * The same packets, isolated or sent while the device is busy, are
+ * received at the same times with and without the fast link mode, while
+ * the end of the transmission of the isolated packets is not scheduled
+ * in fast link mode.
+ */
+class PointToPointFastLinkTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointFastLinkTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send packets over a link
+   * \param fastLink the value of the FastLink attribute of the sender
+   * \param rxTimes the reception times of the packets
+   * \return the time of the last event
+   */
+  Time RunLink (bool fastLink, std::vector<Time> &rxTimes);
+
+  /**
+   * \brief Send packets to the device
+   * \param device the sending device
+   * \param n the number of packets
+   */
+  void Send (Ptr<PointToPointNetDevice> device, uint32_t n);
+
+  /**
+   * \brief Receive a packet
+   * \param device the receiving device
+   * \param p the packet
+   * \param protocol the protocol
+   * \param sender the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &sender);
+
+  std::vector<Time> *m_rxTimes;  //!< the reception times of the current run
+};
+
+PointToPointFastLinkTest::PointToPointFastLinkTest ()
+  : TestCase ("PointToPoint in fast link mode")
+{
+}
+
+void
+PointToPointFastLinkTest::Send (Ptr<PointToPointNetDevice> device, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      device->Send (Create<Packet> (1000), device->GetBroadcast (), 0x800);
+    }
+}
+
+bool
+PointToPointFastLinkTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &sender)
+{
+  m_rxTimes->push_back (Simulator::Now ());
+  return true;
+}
+
+Time
+PointToPointFastLinkTest::RunLink (bool fastLink, std::vector<Time> &rxTimes)
+{
+  Ptr<PointToPointNetDevice> devA = CreateObjectWithAttributes<PointToPointNetDevice> ("FastLink", BooleanValue (fastLink),
+                                                                                       "InterframeGap", TimeValue (MilliSeconds (5)));
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObjectWithAttributes<PointToPointChannel> ("Delay", TimeValue (MilliSeconds (2)));
+
+  devA->SetDataRate (DataRate ("1Mbps"));
+  ConnectDevices (devA, devB, channel);
+  // Replace the callback set by the node
+  devB->SetReceiveCallback (MakeCallback (&PointToPointFastLinkTest::Receive, this));
+
+  m_rxTimes = &rxTimes;
+  // The transmission of a packet lasts 8.016 ms: an isolated packet, a
+  // burst of three packets, and a packet sent during the transmission of
+  // an isolated one
+  Simulator::Schedule (Seconds (1.0), &PointToPointFastLinkTest::Send, this, devA, 1);
+  Simulator::Schedule (Seconds (2.0), &PointToPointFastLinkTest::Send, this, devA, 3);
+  Simulator::Schedule (Seconds (3.0), &PointToPointFastLinkTest::Send, this, devA, 1);
+  Simulator::Schedule (Seconds (3.004), &PointToPointFastLinkTest::Send, this, devA, 1);
+  Simulator::Schedule (Seconds (4.0), &PointToPointFastLinkTest::Send, this, devA, 1);
+
+  Simulator::Run ();
+  Time end = Simulator::Now ();
   Simulator::Destroy ();
+  return end;
+}
+
+void
+PointToPointFastLinkTest::DoRun (void)
+{
+  std::vector<Time> normalTimes;
+  std::vector<Time> fastTimes;
+  Time normalEnd = RunLink (false, normalTimes);
+  Time fastEnd = RunLink (true, fastTimes);
+
+  NS_TEST_ASSERT_MSG_EQ (normalTimes.size (), 7, "Packets lost in normal mode");
+  NS_TEST_ASSERT_MSG_EQ (fastTimes.size (), 7, "Packets lost in fast link mode");
+  for (uint32_t i = 0; i < normalTimes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (fastTimes[i], normalTimes[i], "Packet " << i << " not received at the same time");
+    }
+  // The interframe gap is longer than the propagation delay, so the last
+  // event is the end of the transmission in normal mode, and the reception
+  // in fast link mode
+  NS_TEST_EXPECT_MSG_EQ (normalEnd, Seconds (4.0) + MicroSeconds (8016) + MilliSeconds (5), "Unexpected end in normal mode");
+  NS_TEST_EXPECT_MSG_EQ (fastEnd, fastTimes.back (), "End of transmission scheduled in fast link mode");
 }
 
 /**
@@ -114,6 +365,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointQueueLimitsTest, TestCase::QUICK);
+  AddTestCase (new PointToPointFastLinkTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Latency and throughput of the FqCoDel and PIE queue discs versus RED.
+ *
+ * A dumbbell topology: nLeaf TCP senders on the right send to the sinks
+ * on the left through a bottleneck link, whose devices use the queue
+ * disc selected by --queueDiscType.  The first sender sends at a constant
+ * rate lower than its share of the bottleneck, the others are bulk
+ * senders.  The device queues are short, so the delays are the ones of
+ * the queue discs.  At the
+ * end, the flow monitor statistics of each flow are printed: goodput and
+ * mean one way delay, then the aggregate goodput, the mean delay of all
+ * the packets and Jain's fairness index of the goodputs.
+ *
+ *   ./waf --run "fqcodel-pie-vs-red --queueDiscType=FqCoDel"
+ *   ./waf --run "fqcodel-pie-vs-red --queueDiscType=PIE"
+ *   ./waf --run "fqcodel-pie-vs-red --queueDiscType=RED"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/point-to-point-layout-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/flow-monitor-module.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  uint32_t nLeaf = 4;
+  uint32_t maxPackets = 5;
+  uint32_t queueDiscLimitPackets = 1000;
+  uint32_t pktSize = 1000;
+  std::string queueDiscType = "FqCoDel";
+  uint16_t port = 5001;
+  std::string bottleNeckLinkBw = "10Mbps";
+  std::string bottleNeckLinkDelay = "10ms";
+  std::string lightDataRate = "1Mbps";
+  double simDuration = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("nLeaf", "Number of left and right side leaf nodes", nLeaf);
+  cmd.AddValue ("maxPackets", "Max Packets allowed in the device queue", maxPackets);
+  cmd.AddValue ("queueDiscLimitPackets", "Max Packets allowed in the queue disc", queueDiscLimitPackets);
+  cmd.AddValue ("queueDiscType", "Set QueueDisc type to FqCoDel, PIE or RED", queueDiscType);
+  cmd.AddValue ("bottleNeckLinkBw", "Bottleneck link data rate", bottleNeckLinkBw);
+  cmd.AddValue ("lightDataRate", "Data rate of the first sender", lightDataRate);
+  cmd.AddValue ("simDuration", "Simulation duration in seconds", simDuration);
+  cmd.Parse (argc, argv);
+
+  if ((queueDiscType != "FqCoDel") && (queueDiscType != "PIE") && (queueDiscType != "RED"))
+    {
+      NS_ABORT_MSG ("Invalid queue disc type: Use --queueDiscType=FqCoDel, --queueDiscType=PIE or --queueDiscType=RED");
+    }
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (pktSize));
+  Config::SetDefault ("ns3::Queue::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  Config::SetDefault ("ns3::Queue::MaxPackets", UintegerValue (maxPackets));
+
+  Config::SetDefault ("ns3::FqCoDelQueueDisc::PacketLimit", UintegerValue (queueDiscLimitPackets));
+  Config::SetDefault ("ns3::PieQueueDisc::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  Config::SetDefault ("ns3::PieQueueDisc::QueueLimit", UintegerValue (queueDiscLimitPackets));
+  Config::SetDefault ("ns3::RedQueueDisc::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  Config::SetDefault ("ns3::RedQueueDisc::QueueLimit", UintegerValue (queueDiscLimitPackets));
+  Config::SetDefault ("ns3::RedQueueDisc::MeanPktSize", UintegerValue (pktSize));
+  Config::SetDefault ("ns3::RedQueueDisc::LinkBandwidth", StringValue (bottleNeckLinkBw));
+  Config::SetDefault ("ns3::RedQueueDisc::LinkDelay", StringValue (bottleNeckLinkDelay));
+
+  // Create the point-to-point link helpers
+  PointToPointHelper bottleNeckLink;
+  bottleNeckLink.SetDeviceAttribute ("DataRate", StringValue (bottleNeckLinkBw));
+  bottleNeckLink.SetChannelAttribute ("Delay", StringValue (bottleNeckLinkDelay));
+
+  PointToPointHelper pointToPointLeaf;
+  pointToPointLeaf.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  pointToPointLeaf.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  PointToPointDumbbellHelper d (nLeaf, pointToPointLeaf,
+                                nLeaf, pointToPointLeaf,
+                                bottleNeckLink);
+
+  // Install Stack
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  TrafficControlHelper tchBottleneck;
+  if (queueDiscType == "FqCoDel")
+    {
+      uint16_t handle = tchBottleneck.SetRootQueueDisc ("ns3::FqCoDelQueueDisc");
+      tchBottleneck.AddPacketFilter (handle, "ns3::FqCoDelIpv4PacketFilter");
+    }
+  else if (queueDiscType == "PIE")
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::PieQueueDisc");
+    }
+  else
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::RedQueueDisc");
+    }
+  // The devices of the bottleneck link are the first ones of the routers
+  QueueDiscContainer queueDiscs = tchBottleneck.Install (d.GetLeft ()->GetDevice (0));
+  queueDiscs.Add (tchBottleneck.Install (d.GetRight ()->GetDevice (0)));
+
+  // Assign IP Addresses
+  d.AssignIpv4Addresses (Ipv4AddressHelper ("10.1.1.0", "255.255.255.0"),
+                         Ipv4AddressHelper ("10.2.1.0", "255.255.255.0"),
+                         Ipv4AddressHelper ("10.3.1.0", "255.255.255.0"));
+
+  // Install a constant rate sender on the first right side node and a
+  // bulk sender on the others
+  Address sinkLocalAddress (InetSocketAddress (Ipv4Address::GetAny (), port));
+  PacketSinkHelper packetSinkHelper ("ns3::TcpSocketFactory", sinkLocalAddress);
+  ApplicationContainer sinkApps;
+  for (uint32_t i = 0; i < d.LeftCount (); ++i)
+    {
+      sinkApps.Add (packetSinkHelper.Install (d.GetLeft (i)));
+    }
+  sinkApps.Start (Seconds (0.0));
+  sinkApps.Stop (Seconds (simDuration));
+
+  ApplicationContainer clientApps;
+  OnOffHelper lightHelper ("ns3::TcpSocketFactory",
+                           InetSocketAddress (d.GetLeftIpv4Address (0), port));
+  lightHelper.SetConstantRate (DataRate (lightDataRate), pktSize);
+  clientApps.Add (lightHelper.Install (d.GetRight (0)));
+  for (uint32_t i = 1; i < d.RightCount (); ++i)
+    {
+      BulkSendHelper clientHelper ("ns3::TcpSocketFactory",
+                                   InetSocketAddress (d.GetLeftIpv4Address (i), port));
+      clientHelper.SetAttribute ("SendSize", UintegerValue (pktSize));
+      clientApps.Add (clientHelper.Install (d.GetRight (i)));
+    }
+  clientApps.Start (Seconds (1.0));
+  clientApps.Stop (Seconds (simDuration));
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  FlowMonitorHelper flowmonHelper;
+  Ptr<FlowMonitor> flowmon = flowmonHelper.InstallAll ();
+
+  Simulator::Stop (Seconds (simDuration));
+  Simulator::Run ();
+
+  flowmon->CheckForLostPackets ();
+  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmonHelper.GetClassifier ());
+  FlowMonitor::FlowStatsContainer stats = flowmon->GetFlowStats ();
+
+  double duration = simDuration - 1.0;
+  double sum = 0, sumSquares = 0, delaySum = 0;
+  uint64_t rxPackets = 0;
+  uint32_t nFlows = 0;
+  std::cout << "QueueDisc Type: " << queueDiscType << std::endl;
+  for (FlowMonitor::FlowStatsContainer::const_iterator i = stats.begin (); i != stats.end (); ++i)
+    {
+      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (i->first);
+      if (t.destinationPort != port || i->second.rxPackets == 0)
+        {
+          // Skip the flows of acknowledgments
+          continue;
+        }
+      double goodput = i->second.rxBytes * 8.0 / duration / 1e6;
+      double delay = i->second.delaySum.GetSeconds () / i->second.rxPackets * 1000;
+      std::cout << "  Flow " << t.sourceAddress << " -> " << t.destinationAddress
+                << ": goodput " << goodput << " Mbps, mean delay " << delay << " ms" << std::endl;
+      sum += goodput;
+      sumSquares += goodput * goodput;
+      delaySum += i->second.delaySum.GetSeconds ();
+      rxPackets += i->second.rxPackets;
+      nFlows++;
+    }
+  if (nFlows > 0)
+    {
+      std::cout << "Aggregate goodput: " << sum << " Mbps" << std::endl;
+      std::cout << "Mean delay: " << delaySum / rxPackets * 1000 << " ms" << std::endl;
+      std::cout << "Jain's fairness index: " << sum * sum / (nFlows * sumSquares) << std::endl;
+    }
+  std::cout << "Queue disc drops: " << queueDiscs.Get (0)->GetTotalDroppedPackets ()
+    + queueDiscs.Get (1)->GetTotalDroppedPackets () << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
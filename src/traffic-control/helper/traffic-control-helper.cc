@@ -353,9 +353,43 @@ TrafficControlHelper::Install (Ptr<NetDevice> d)
   // Set the root queue disc on the device
   tc->SetRootQueueDiscOnDevice (d, m_queueDiscs[0]);
 
+  // Set the queue limits on the device queues, which exist now that the
+  // traffic control layer has set up the device
+  if (m_queueLimitsFactory.GetTypeId ().GetUid ())
+    {
+      Ptr<NetDeviceQueueInterface> ndqi = d->GetObject<NetDeviceQueueInterface> ();
+      NS_ASSERT (ndqi);
+      for (uint8_t i = 0; i < ndqi->GetNTxQueues (); i++)
+        {
+          ndqi->GetTxQueue (i)->SetQueueLimits (m_queueLimitsFactory.Create<QueueLimits> ());
+        }
+    }
+
   return container;
 }
 
+void
+TrafficControlHelper::SetQueueLimits (std::string type,
+                                      std::string n01, const AttributeValue& v01,
+                                      std::string n02, const AttributeValue& v02,
+                                      std::string n03, const AttributeValue& v03,
+                                      std::string n04, const AttributeValue& v04,
+                                      std::string n05, const AttributeValue& v05,
+                                      std::string n06, const AttributeValue& v06,
+                                      std::string n07, const AttributeValue& v07,
+                                      std::string n08, const AttributeValue& v08)
+{
+  m_queueLimitsFactory.SetTypeId (type);
+  m_queueLimitsFactory.Set (n01, v01);
+  m_queueLimitsFactory.Set (n02, v02);
+  m_queueLimitsFactory.Set (n03, v03);
+  m_queueLimitsFactory.Set (n04, v04);
+  m_queueLimitsFactory.Set (n05, v05);
+  m_queueLimitsFactory.Set (n06, v06);
+  m_queueLimitsFactory.Set (n07, v07);
+  m_queueLimitsFactory.Set (n08, v08);
+}
+
 QueueDiscContainer
 TrafficControlHelper::Install (NetDeviceContainer c)
 {
@@ -376,6 +410,17 @@ TrafficControlHelper::Uninstall (Ptr<NetDevice> d)
   NS_ASSERT (tc != 0);
 
   tc->DeleteRootQueueDiscOnDevice (d);
+
+  // Without a queue disc, nothing requeues the packets refused by the queue
+  // limits, hence remove them
+  Ptr<NetDeviceQueueInterface> ndqi = d->GetObject<NetDeviceQueueInterface> ();
+  if (ndqi)
+    {
+      for (uint8_t i = 0; i < ndqi->GetNTxQueues (); i++)
+        {
+          ndqi->GetTxQueue (i)->SetQueueLimits (0);
+        }
+    }
 }
 
 void
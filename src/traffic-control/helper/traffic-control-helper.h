@@ -416,6 +416,43 @@ public:
                                  std::string n14 = "", const AttributeValue &v14 = EmptyAttributeValue (),
                                  std::string n15 = "", const AttributeValue &v15 = EmptyAttributeValue ());
 
+  /**
+   * Helper function used to set the queue limits (of the given type and with
+   * the given attributes) on the transmission queues of the devices the root
+   * queue disc is installed on, e.g., to use Byte Queue Limits:
+   *
+   * \code
+   *   tch.SetQueueLimits ("ns3::DynamicQueueLimits", "HoldTime", StringValue ("4ms"));
+   * \endcode
+   *
+   * \param type the type of queue limits
+   * \param n01 the name of the attribute to set on the queue limits
+   * \param v01 the value of the attribute to set on the queue limits
+   * \param n02 the name of the attribute to set on the queue limits
+   * \param v02 the value of the attribute to set on the queue limits
+   * \param n03 the name of the attribute to set on the queue limits
+   * \param v03 the value of the attribute to set on the queue limits
+   * \param n04 the name of the attribute to set on the queue limits
+   * \param v04 the value of the attribute to set on the queue limits
+   * \param n05 the name of the attribute to set on the queue limits
+   * \param v05 the value of the attribute to set on the queue limits
+   * \param n06 the name of the attribute to set on the queue limits
+   * \param v06 the value of the attribute to set on the queue limits
+   * \param n07 the name of the attribute to set on the queue limits
+   * \param v07 the value of the attribute to set on the queue limits
+   * \param n08 the name of the attribute to set on the queue limits
+   * \param v08 the value of the attribute to set on the queue limits
+   */
+  void SetQueueLimits (std::string type,
+                       std::string n01 = "", const AttributeValue &v01 = EmptyAttributeValue (),
+                       std::string n02 = "", const AttributeValue &v02 = EmptyAttributeValue (),
+                       std::string n03 = "", const AttributeValue &v03 = EmptyAttributeValue (),
+                       std::string n04 = "", const AttributeValue &v04 = EmptyAttributeValue (),
+                       std::string n05 = "", const AttributeValue &v05 = EmptyAttributeValue (),
+                       std::string n06 = "", const AttributeValue &v06 = EmptyAttributeValue (),
+                       std::string n07 = "", const AttributeValue &v07 = EmptyAttributeValue (),
+                       std::string n08 = "", const AttributeValue &v08 = EmptyAttributeValue ());
+
   /**
    * \param c set of devices
    * \returns a QueueDisc container with the queue discs installed on the devices
@@ -461,6 +498,8 @@ private:
   std::vector<QueueDiscFactory> m_queueDiscFactory;
   /// Vector of all the created queue discs
   std::vector<Ptr<QueueDisc> > m_queueDiscs;
+  /// Factory to create the queue limits, if any, of the device queues
+  ObjectFactory m_queueLimitsFactory;
 };
 
 } // namespace ns3
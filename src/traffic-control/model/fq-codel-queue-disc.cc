@@ -0,0 +1,439 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Based on the Linux fq_codel queue discipline by
+ * Eric Dumazet <edumazet@google.com>
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/queue.h"
+#include "ns3/net-device.h"
+#include "fq-codel-queue-disc.h"
+#include "codel-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FqCoDelQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelFlow);
+
+TypeId FqCoDelFlow::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelFlow")
+    .SetParent<QueueDiscClass> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqCoDelFlow> ()
+  ;
+  return tid;
+}
+
+FqCoDelFlow::FqCoDelFlow ()
+  : m_deficit (0),
+    m_status (INACTIVE)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqCoDelFlow::~FqCoDelFlow ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqCoDelFlow::SetDeficit (uint32_t deficit)
+{
+  NS_LOG_FUNCTION (this << deficit);
+  m_deficit = deficit;
+}
+
+int32_t
+FqCoDelFlow::GetDeficit (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_deficit;
+}
+
+void
+FqCoDelFlow::IncreaseDeficit (int32_t deficit)
+{
+  NS_LOG_FUNCTION (this << deficit);
+  m_deficit += deficit;
+}
+
+void
+FqCoDelFlow::SetStatus (FlowStatus status)
+{
+  NS_LOG_FUNCTION (this);
+  m_status = status;
+}
+
+FqCoDelFlow::FlowStatus
+FqCoDelFlow::GetStatus (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_status;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelQueueDisc);
+
+TypeId FqCoDelQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqCoDelQueueDisc> ()
+    .AddAttribute ("Interval",
+                   "The CoDel algorithm interval for each FQCoDel queue",
+                   StringValue ("100ms"),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("Target",
+                   "The CoDel algorithm target queue delay for each FQCoDel queue",
+                   StringValue ("5ms"),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_target),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacketLimit",
+                   "The hard limit on the real queue size, measured in packets",
+                   UintegerValue (10 * 1024),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_limit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Flows",
+                   "The number of queues into which the incoming packets are classified",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_flows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Quantum",
+                   "The number of bytes each queue gets to dequeue on each round "
+                   "of the scheduling algorithm (zero to use the MTU of the device)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::SetQuantum,
+                                         &FqCoDelQueueDisc::GetQuantum),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DropBatchSize",
+                   "The maximum number of packets dropped from the fat flow",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_dropBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+FqCoDelQueueDisc::FqCoDelQueueDisc ()
+  : QueueDisc (),
+    m_quantum (0),
+    m_overlimitDroppedPackets (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqCoDelQueueDisc::~FqCoDelQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqCoDelQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_newFlows.clear ();
+  m_oldFlows.clear ();
+  m_flowsIndices.clear ();
+  QueueDisc::DoDispose ();
+}
+
+void
+FqCoDelQueueDisc::SetQuantum (uint32_t quantum)
+{
+  NS_LOG_FUNCTION (this << quantum);
+  m_quantum = quantum;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetQuantum (void) const
+{
+  return m_quantum;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetDropOverLimit (void) const
+{
+  return m_overlimitDroppedPackets;
+}
+
+bool
+FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  int32_t ret = Classify (item);
+
+  if (ret == PacketFilter::PF_NO_MATCH)
+    {
+      NS_LOG_ERROR ("No filter has been able to classify this packet, drop it.");
+      Drop (item);
+      return false;
+    }
+
+  uint32_t h = ret % m_flows;
+
+  Ptr<FqCoDelFlow> flow;
+  if (m_flowsIndices[h] < 0)
+    {
+      NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
+      flow = m_flowFactory.Create<FqCoDelFlow> ();
+      Ptr<QueueDisc> qd = m_queueDiscFactory.Create<QueueDisc> ();
+      qd->Initialize ();
+      flow->SetQueueDisc (qd);
+      AddQueueDiscClass (flow);
+
+      m_flowsIndices[h] = GetNQueueDiscClasses () - 1;
+    }
+  else
+    {
+      flow = StaticCast<FqCoDelFlow> (GetQueueDiscClass (m_flowsIndices[h]));
+    }
+
+  if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
+    {
+      flow->SetStatus (FqCoDelFlow::NEW_FLOW);
+      flow->SetDeficit (m_quantum);
+      m_newFlows.push_back (flow);
+    }
+
+  flow->GetQueueDisc ()->Enqueue (item);
+
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h << "; flow index " << m_flowsIndices[h]);
+
+  if (GetNPackets () > m_limit)
+    {
+      FqCoDelDrop ();
+    }
+
+  return true;
+}
+
+Ptr<QueueDiscItem>
+FqCoDelQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<FqCoDelFlow> flow;
+  Ptr<QueueDiscItem> item;
+
+  do
+    {
+      bool found = false;
+
+      while (!found && !m_newFlows.empty ())
+        {
+          flow = m_newFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (m_quantum);
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+              m_oldFlows.push_back (flow);
+              m_newFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found a new flow with positive deficit");
+              found = true;
+            }
+        }
+
+      while (!found && !m_oldFlows.empty ())
+        {
+          flow = m_oldFlows.front ();
+
+          if (flow->GetDeficit () <= 0)
+            {
+              flow->IncreaseDeficit (m_quantum);
+              m_oldFlows.push_back (flow);
+              m_oldFlows.pop_front ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found an old flow with positive deficit");
+              found = true;
+            }
+        }
+
+      if (!found)
+        {
+          NS_LOG_DEBUG ("No flow found to dequeue a packet");
+          return 0;
+        }
+
+      item = flow->GetQueueDisc ()->Dequeue ();
+
+      if (!item)
+        {
+          NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
+          if (flow->GetStatus () == FqCoDelFlow::NEW_FLOW && !m_oldFlows.empty ())
+            {
+              // An emptied new flow goes to the end of the old flows, so
+              // that it cannot starve them by becoming new again
+              m_oldFlows.push_back (flow);
+              m_newFlows.pop_front ();
+              flow->SetStatus (FqCoDelFlow::OLD_FLOW);
+            }
+          else if (flow->GetStatus () == FqCoDelFlow::NEW_FLOW)
+            {
+              m_newFlows.pop_front ();
+              flow->SetStatus (FqCoDelFlow::INACTIVE);
+            }
+          else
+            {
+              m_oldFlows.pop_front ();
+              flow->SetStatus (FqCoDelFlow::INACTIVE);
+            }
+        }
+      else
+        {
+          NS_LOG_DEBUG ("Dequeued packet " << item->GetPacket ());
+        }
+    } while (item == 0);
+
+  flow->IncreaseDeficit (-item->GetPacketSize ());
+
+  return item;
+}
+
+Ptr<const QueueDiscItem>
+FqCoDelQueueDisc::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<FqCoDelFlow> flow;
+
+  if (!m_newFlows.empty ())
+    {
+      flow = m_newFlows.front ();
+    }
+  else
+    {
+      if (!m_oldFlows.empty ())
+        {
+          flow = m_oldFlows.front ();
+        }
+      else
+        {
+          return 0;
+        }
+    }
+
+  return flow->GetQueueDisc ()->Peek ();
+}
+
+bool
+FqCoDelQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("FqCoDelQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () == 0)
+    {
+      NS_LOG_ERROR ("FqCoDelQueueDisc needs at least a packet filter");
+      return false;
+    }
+
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("FqCoDelQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  if (m_quantum == 0 && GetNetDevice () == 0)
+    {
+      NS_LOG_ERROR ("FqCoDelQueueDisc needs a quantum when it is not installed on a device");
+      return false;
+    }
+
+  return true;
+}
+
+void
+FqCoDelQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // we are at initialization time. If the user has not set a quantum value,
+  // set the quantum to the MTU of the device
+  if (m_quantum == 0)
+    {
+      m_quantum = GetNetDevice ()->GetMtu ();
+      NS_LOG_DEBUG ("Setting the quantum to the MTU of the device: " << m_quantum);
+    }
+
+  m_flowsIndices.assign (m_flows, -1);
+
+  m_flowFactory.SetTypeId ("ns3::FqCoDelFlow");
+
+  m_queueDiscFactory.SetTypeId ("ns3::CoDelQueueDisc");
+  m_queueDiscFactory.Set ("Mode", EnumValue (Queue::QUEUE_MODE_PACKETS));
+  m_queueDiscFactory.Set ("MaxPackets", UintegerValue (m_limit + 1));
+  m_queueDiscFactory.Set ("Interval", TimeValue (m_interval));
+  m_queueDiscFactory.Set ("Target", TimeValue (m_target));
+}
+
+uint32_t
+FqCoDelQueueDisc::FqCoDelDrop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t maxBacklog = 0, index = 0;
+  Ptr<QueueDisc> qd;
+
+  /* Queue is full! Find the fat flow and drop packet(s) from it */
+  for (uint32_t i = 0; i < GetNQueueDiscClasses (); i++)
+    {
+      qd = GetQueueDiscClass (i)->GetQueueDisc ();
+      uint32_t bytes = qd->GetNBytes ();
+      if (bytes > maxBacklog)
+        {
+          maxBacklog = bytes;
+          index = i;
+        }
+    }
+
+  /* Our goal is to drop half of this fat flow backlog */
+  uint32_t len = 0, count = 0, threshold = maxBacklog >> 1;
+  qd = GetQueueDiscClass (index)->GetQueueDisc ();
+  Ptr<QueueItem> item;
+
+  do
+    {
+      // The internal queue notifies the drop to the CoDel queue disc,
+      // which notifies it to this queue disc
+      item = qd->GetInternalQueue (0)->Remove ();
+      len += item->GetPacketSize ();
+      m_overlimitDroppedPackets++;
+    } while (++count < m_dropBatchSize && len < threshold);
+
+  NS_LOG_DEBUG ("Dropped " << count << " packets (" << len << " bytes) from flow index " << index);
+
+  return index;
+}
+
+} // namespace ns3
@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Based on the Linux fq_codel queue discipline by
+ * Eric Dumazet <edumazet@google.com>
+ */
+
+#ifndef FQ_CODEL_QUEUE_DISC
+#define FQ_CODEL_QUEUE_DISC
+
+#include "ns3/queue-disc.h"
+#include "ns3/object-factory.h"
+#include "ns3/nstime.h"
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A flow queue used by the FqCoDel queue disc
+ *
+ * Each flow queue is a class of the FqCoDel queue disc, having a CoDel
+ * queue disc as child, the deficit of the flow in the deficit round
+ * robin scheduler and the status of the flow.
+ */
+class FqCoDelFlow : public QueueDiscClass {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqCoDelFlow constructor
+   */
+  FqCoDelFlow ();
+
+  virtual ~FqCoDelFlow ();
+
+  /**
+   * \enum FlowStatus
+   * \brief Used to determine the status of this flow queue
+   */
+  enum FlowStatus
+    {
+      INACTIVE,
+      NEW_FLOW,
+      OLD_FLOW
+    };
+
+  /**
+   * \brief Set the deficit for this flow
+   * \param deficit the deficit for this flow
+   */
+  void SetDeficit (uint32_t deficit);
+  /**
+   * \brief Get the deficit for this flow
+   * \return the deficit for this flow
+   */
+  int32_t GetDeficit (void) const;
+  /**
+   * \brief Increase the deficit for this flow
+   * \param deficit the amount by which the deficit is to be increased
+   */
+  void IncreaseDeficit (int32_t deficit);
+  /**
+   * \brief Set the status for this flow
+   * \param status the status for this flow
+   */
+  void SetStatus (FlowStatus status);
+  /**
+   * \brief Get the status of this flow
+   * \return the status of this flow
+   */
+  FlowStatus GetStatus (void) const;
+
+private:
+  int32_t m_deficit;    //!< the deficit for this flow
+  FlowStatus m_status;  //!< the status of this flow
+};
+
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A FqCoDel packet queue disc
+ *
+ * The packets are classified into flows by the packet filters, such as
+ * FqCoDelIpv4PacketFilter, and the hash they return selects one of a
+ * bounded number of flow queues (attribute Flows).  Each flow queue is
+ * managed by a CoDel queue disc.  The flows having packets are served
+ * by deficit round robin, the new flows having priority over the old
+ * ones: both are kept in lists, so enqueue and dequeue are O(1),
+ * whatever the number of flows.  When the queue disc exceeds its limit,
+ * packets are dropped from the flow with the largest backlog.
+ */
+class FqCoDelQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqCoDelQueueDisc constructor
+   */
+  FqCoDelQueueDisc ();
+
+  virtual ~FqCoDelQueueDisc ();
+
+  /**
+   * \brief Set the quantum value.
+   *
+   * \param quantum The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  void SetQuantum (uint32_t quantum);
+
+  /**
+   * \brief Get the quantum value.
+   *
+   * \returns The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  uint32_t GetQuantum (void) const;
+
+  /**
+   * \brief Get the number of packets dropped when the queue disc was
+   * over its limit.
+   *
+   * \returns The number of packets dropped from the fattest flows
+   */
+  uint32_t GetDropOverLimit (void) const;
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Drop packets from the head of the flow with the largest
+   * backlog, until half of its backlog or DropBatchSize packets are
+   * dropped.
+   * \return the index of the flow from which packets are dropped
+   */
+  uint32_t FqCoDelDrop (void);
+
+  Time m_interval;           //!< CoDel interval attribute
+  Time m_target;             //!< CoDel target attribute
+  uint32_t m_limit;          //!< Maximum number of packets in the queue disc
+  uint32_t m_quantum;        //!< Deficit assigned to flows at each round
+  uint32_t m_flows;          //!< Number of flow queues
+  uint32_t m_dropBatchSize;  //!< Max number of packets dropped from the fat flow
+  uint32_t m_overlimitDroppedPackets; //!< Number of overlimit dropped packets
+
+  /// The index of the class of each flow queue, or -1 if not created yet
+  std::vector<int32_t> m_flowsIndices;
+  std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
+  std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
+
+  ObjectFactory m_flowFactory;         //!< Factory to create a new flow
+  ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
+};
+
+} // namespace ns3
+
+#endif /* FQ_CODEL_QUEUE_DISC */
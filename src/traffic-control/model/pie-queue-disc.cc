@@ -0,0 +1,588 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Based on the PIE algorithm of RFC 8033 and on the Linux pie queue
+ * discipline.
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "pie-queue-disc.h"
+#include "ns3/drop-tail-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PieQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (PieQueueDisc);
+
+/// The time after which the burst state is reset, in seconds
+static const double BURST_RESET_TIMEOUT = 1.5;
+
+TypeId PieQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PieQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<PieQueueDisc> ()
+    .AddAttribute ("Mode",
+                   "Determines unit for QueueLimit",
+                   EnumValue (Queue::QUEUE_MODE_PACKETS),
+                   MakeEnumAccessor (&PieQueueDisc::SetMode),
+                   MakeEnumChecker (Queue::QUEUE_MODE_BYTES, "QUEUE_MODE_BYTES",
+                                    Queue::QUEUE_MODE_PACKETS, "QUEUE_MODE_PACKETS"))
+    .AddAttribute ("MeanPktSize",
+                   "Average of packet size",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&PieQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("A",
+                   "Value of alpha",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&PieQueueDisc::m_a),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("B",
+                   "Value of beta",
+                   DoubleValue (1.25),
+                   MakeDoubleAccessor (&PieQueueDisc::m_b),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Tupdate",
+                   "Time period to calculate drop probability",
+                   TimeValue (MilliSeconds (30)),
+                   MakeTimeAccessor (&PieQueueDisc::m_tUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("Supdate",
+                   "Start time of the update timer",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&PieQueueDisc::m_sUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueLimit",
+                   "Queue limit in bytes/packets",
+                   UintegerValue (25),
+                   MakeUintegerAccessor (&PieQueueDisc::SetQueueLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DequeueThreshold",
+                   "Minimum queue size in bytes before dequeue rate is measured",
+                   UintegerValue (10000),
+                   MakeUintegerAccessor (&PieQueueDisc::m_dqThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("QueueDelayReference",
+                   "Desired queue delay",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&PieQueueDisc::m_qDelayRef),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxBurstAllowance",
+                   "Current max burst allowance in seconds before random drop",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&PieQueueDisc::m_maxBurst),
+                   MakeTimeChecker ())
+  ;
+
+  return tid;
+}
+
+PieQueueDisc::PieQueueDisc ()
+  : QueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = CreateObject<UniformRandomVariable> ();
+}
+
+PieQueueDisc::~PieQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PieQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = 0;
+  m_rtrsEvent.Cancel ();
+  QueueDisc::DoDispose ();
+}
+
+void
+PieQueueDisc::SetMode (Queue::QueueMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  m_mode = mode;
+}
+
+Queue::QueueMode
+PieQueueDisc::GetMode (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_mode;
+}
+
+void
+PieQueueDisc::SetQueueLimit (uint32_t lim)
+{
+  NS_LOG_FUNCTION (this << lim);
+  m_queueLimit = lim;
+}
+
+uint32_t
+PieQueueDisc::GetQueueSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      return GetInternalQueue (0)->GetNBytes ();
+    }
+  else if (GetMode () == Queue::QUEUE_MODE_PACKETS)
+    {
+      return GetInternalQueue (0)->GetNPackets ();
+    }
+  else
+    {
+      NS_ABORT_MSG ("Unknown PIE mode.");
+    }
+}
+
+PieQueueDisc::Stats
+PieQueueDisc::GetStats (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_stats;
+}
+
+Time
+PieQueueDisc::GetQueueDelay (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_qDelay;
+}
+
+double
+PieQueueDisc::GetDropProbability (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_dropProb;
+}
+
+int64_t
+PieQueueDisc::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uv->SetStream (stream);
+  return 1;
+}
+
+bool
+PieQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  if (!m_rtrsEvent.IsRunning ())
+    {
+      Wake ();
+    }
+
+  uint32_t nQueued = GetQueueSize ();
+
+  if ((GetMode () == Queue::QUEUE_MODE_PACKETS && nQueued >= m_queueLimit)
+      || (GetMode () == Queue::QUEUE_MODE_BYTES && nQueued + item->GetPacketSize () > m_queueLimit))
+    {
+      // Drops due to queue limit: reactive
+      Drop (item);
+      m_stats.forcedDrop++;
+      return false;
+    }
+  else if (DropEarly (item, nQueued))
+    {
+      // Early probability drop: proactive
+      Drop (item);
+      m_stats.unforcedDrop++;
+      return false;
+    }
+
+  // No drop
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
+  // because QueueDisc::AddInternalQueue sets the drop callback
+
+  NS_LOG_LOGIC ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes ());
+  NS_LOG_LOGIC ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets ());
+
+  return retval;
+}
+
+void
+PieQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Initially queue is empty so variables are initialize to zero except m_dqCount
+  m_inMeasurement = false;
+  m_dqCount = DQCOUNT_INVALID;
+  m_dropProb = 0;
+  m_avgDqRate = 0.0;
+  m_dqStart = 0;
+  m_burstState = NO_BURST;
+  m_burstReset = 0;
+  m_burstAllowance = Seconds (0);
+  m_qDelayOld = Seconds (0);
+  m_qDelay = Seconds (0);
+  m_stats.forcedDrop = 0;
+  m_stats.unforcedDrop = 0;
+  m_lastUpdate = Simulator::Now ();
+  m_rtrsEvent = Simulator::Schedule (m_sUpdate, &PieQueueDisc::CalculateP, this);
+}
+
+bool
+PieQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
+{
+  NS_LOG_FUNCTION (this << item << qSize);
+  if (m_burstAllowance.GetSeconds () > 0)
+    {
+      // If there is still burst_allowance left, skip random early drop.
+      return false;
+    }
+
+  if (m_burstState == NO_BURST)
+    {
+      m_burstState = IN_BURST_PROTECTING;
+      m_burstAllowance = m_maxBurst;
+    }
+
+  double p = m_dropProb;
+
+  uint32_t packetSize = item->GetPacketSize ();
+
+  if (GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      p = p * packetSize / m_meanPktSize;
+    }
+  bool earlyDrop = true;
+  double u =  m_uv->GetValue ();
+
+  if ((m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb < 0.2))
+    {
+      return false;
+    }
+  else if (GetMode () == Queue::QUEUE_MODE_BYTES && qSize <= 2 * m_meanPktSize)
+    {
+      return false;
+    }
+  else if (GetMode () == Queue::QUEUE_MODE_PACKETS && qSize <= 2)
+    {
+      return false;
+    }
+
+  if (u > p)
+    {
+      earlyDrop = false;
+    }
+  if (!earlyDrop)
+    {
+      return false;
+    }
+
+  return true;
+}
+
+void
+PieQueueDisc::CalculateP (void)
+{
+  NS_LOG_FUNCTION (this);
+  UpdateP ();
+  m_lastUpdate = Simulator::Now ();
+
+  // Stop the updates while the queue disc is idle, see Wake
+  if (GetInternalQueue (0)->IsEmpty () && m_dropProb == 0)
+    {
+      NS_LOG_LOGIC ("Queue disc idle, drop probability updates suspended");
+      return;
+    }
+  m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::CalculateP, this);
+}
+
+void
+PieQueueDisc::Wake (void)
+{
+  NS_LOG_FUNCTION (this);
+  // The queue disc is empty since the last update, which found a null
+  // queue delay and drop probability.  The missed updates then only
+  // decrease the burst allowance, reset the dequeue rate and move the
+  // burst state to NO_BURST, after which they have no effect.
+  int64_t missed = (Simulator::Now () - m_lastUpdate).GetTimeStep () / m_tUpdate.GetTimeStep ();
+  m_lastUpdate += TimeStep (missed * m_tUpdate.GetTimeStep ());
+  while (missed > 0
+         && !(m_burstState == NO_BURST && m_burstAllowance.IsZero () && m_avgDqRate == 0))
+    {
+      UpdateP ();
+      missed--;
+    }
+  NS_LOG_LOGIC ("Queue disc active, next update at " << m_lastUpdate + m_tUpdate);
+  m_rtrsEvent = Simulator::Schedule (m_lastUpdate + m_tUpdate - Simulator::Now (),
+                                     &PieQueueDisc::CalculateP, this);
+}
+
+void
+PieQueueDisc::UpdateP (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time qDelay;
+  double p = 0.0;
+  bool missingInitFlag = false;
+  if (m_avgDqRate > 0)
+    {
+      qDelay = Seconds (GetInternalQueue (0)->GetNBytes () / m_avgDqRate);
+    }
+  else
+    {
+      qDelay = Seconds (0);
+      missingInitFlag = true;
+    }
+
+  m_qDelay = qDelay;
+
+  if (m_burstAllowance.GetSeconds () > 0)
+    {
+      m_dropProb = 0;
+    }
+  else
+    {
+      p = m_a * (qDelay.GetSeconds () - m_qDelayRef.GetSeconds ()) + m_b * (qDelay.GetSeconds () - m_qDelayOld.GetSeconds ());
+      if (m_dropProb < 0.001)
+        {
+          p /= 32;
+        }
+      else if (m_dropProb < 0.01)
+        {
+          p /= 8;
+        }
+      else if (m_dropProb < 0.1)
+        {
+          p /= 2;
+        }
+      else if (m_dropProb < 1)
+        {
+          p /= 0.5;
+        }
+      else if (m_dropProb < 10)
+        {
+          p /= 0.125;
+        }
+      else
+        {
+          p /= 0.03125;
+        }
+      if ((m_dropProb >= 0.1) && (p > 0.02))
+        {
+          p = 0.02;
+        }
+    }
+
+  p += m_dropProb;
+
+  // For non-linear drop in prob
+
+  if (qDelay.GetSeconds () == 0 && m_qDelayOld.GetSeconds () == 0)
+    {
+      p *= 0.98;
+    }
+  else if (qDelay.GetSeconds () > 0.2)
+    {
+      p += 0.02;
+    }
+
+  m_dropProb = (p > 0) ? p : 0;
+  if (m_burstAllowance < m_tUpdate)
+    {
+      m_burstAllowance = Seconds (0);
+    }
+  else
+    {
+      m_burstAllowance -= m_tUpdate;
+    }
+
+  uint32_t burstResetLimit = BURST_RESET_TIMEOUT / m_tUpdate.GetSeconds ();
+  if ((qDelay.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds ()) && (m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb == 0) && !missingInitFlag)
+    {
+      m_dqCount = DQCOUNT_INVALID;
+      m_avgDqRate = 0.0;
+    }
+  if ((qDelay.GetSeconds () < 0.5 * m_qDelayRef.GetSeconds ()) && (m_qDelayOld.GetSeconds () < (0.5 * m_qDelayRef.GetSeconds ())) && (m_dropProb == 0) && (m_burstAllowance.GetSeconds () == 0))
+    {
+      if (m_burstState == IN_BURST_PROTECTING)
+        {
+          m_burstState = IN_BURST;
+          m_burstReset = 0;
+        }
+      else if (m_burstState == IN_BURST)
+        {
+          m_burstReset++;
+          if (m_burstReset > burstResetLimit)
+            {
+              m_burstReset = 0;
+              m_burstState = NO_BURST;
+            }
+        }
+    }
+  else if (m_burstState == IN_BURST)
+    {
+      m_burstReset = 0;
+    }
+
+  m_qDelayOld = qDelay;
+}
+
+Ptr<QueueDiscItem>
+PieQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<QueueDiscItem> item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+  double now = Simulator::Now ().GetSeconds ();
+  uint32_t pktSize = item->GetPacketSize ();
+  // The departure rate is measured in bytes, whatever the mode
+  uint32_t bytesInQueue = GetInternalQueue (0)->GetNBytes ();
+
+  // if not in a measurement cycle and the queue has built up to dequeue threshold,
+  // start the measurement cycle
+
+  if ((bytesInQueue >= m_dqThreshold) && (!m_inMeasurement))
+    {
+      m_dqStart = now;
+      m_dqCount = 0;
+      m_inMeasurement = true;
+    }
+
+  if (m_inMeasurement)
+    {
+      m_dqCount += pktSize;
+
+      // done with a measurement cycle
+      if (m_dqCount >= m_dqThreshold)
+        {
+
+          double tmp = now - m_dqStart;
+
+          if (tmp > 0)
+            {
+              if (m_avgDqRate == 0)
+                {
+                  m_avgDqRate = m_dqCount / tmp;
+                }
+              else
+                {
+                  m_avgDqRate = (0.5 * m_avgDqRate) + (0.5 * (m_dqCount / tmp));
+                }
+            }
+
+          // restart a measurement cycle if there is enough data
+          if (bytesInQueue > m_dqThreshold)
+            {
+              m_dqStart = now;
+              m_dqCount = 0;
+              m_inMeasurement = true;
+            }
+          else
+            {
+              m_dqCount = 0;
+              m_inMeasurement = false;
+            }
+        }
+    }
+
+  return item;
+}
+
+Ptr<const QueueDiscItem>
+PieQueueDisc::DoPeek () const
+{
+  NS_LOG_FUNCTION (this);
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<const QueueDiscItem> item = StaticCast<const QueueDiscItem> (GetInternalQueue (0)->Peek ());
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+bool
+PieQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("PieQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("PieQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // create a DropTail queue
+      Ptr<Queue> queue = CreateObjectWithAttributes<DropTailQueue> ("Mode", EnumValue (m_mode));
+      if (m_mode == Queue::QUEUE_MODE_PACKETS)
+        {
+          queue->SetMaxPackets (m_queueLimit);
+        }
+      else
+        {
+          queue->SetMaxBytes (m_queueLimit);
+        }
+      AddInternalQueue (queue);
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("PieQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  if (GetInternalQueue (0)->GetMode () != m_mode)
+    {
+      NS_LOG_ERROR ("The mode of the provided queue does not match the mode set on the PieQueueDisc");
+      return false;
+    }
+
+  if ((m_mode ==  Queue::QUEUE_MODE_PACKETS && GetInternalQueue (0)->GetMaxPackets () < m_queueLimit)
+      || (m_mode ==  Queue::QUEUE_MODE_BYTES && GetInternalQueue (0)->GetMaxBytes () < m_queueLimit))
+    {
+      NS_LOG_ERROR ("The size of the internal queue is less than the queue disc limit");
+      return false;
+    }
+
+  return true;
+}
+
+} // namespace ns3
@@ -195,7 +195,8 @@ QueueDisc::DoDispose (void)
   m_classes.clear ();
   m_device = 0;
   m_devQueueIface = 0;
-  m_requeued = 0;
+  m_requeued.clear ();
+  m_bulk.clear ();
   Object::DoDispose ();
 }
 
@@ -498,14 +499,15 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      uint32_t packets;
+      while (Restart (packets))
         {
-          quota -= 1;
-          if (quota <= 0)
+          if (packets >= quota)
             {
               /// \todo netif_schedule (q);
               break;
             }
+          quota -= packets;
         }
       RunEnd ();
     }
@@ -532,16 +534,19 @@ QueueDisc::RunEnd (void)
 }
 
 bool
-QueueDisc::Restart (void)
+QueueDisc::Restart (uint32_t &packets)
 {
   NS_LOG_FUNCTION (this);
+  m_bulk.clear ();
   Ptr<QueueDiscItem> item = DequeuePacket();
   if (item == 0)
     {
       NS_LOG_LOGIC ("No packet to send");
+      packets = 0;
       return false;
     }
 
+  packets = 1 + m_bulk.size ();
   return Transmit (item);
 }
 
@@ -553,15 +558,15 @@ QueueDisc::DequeuePacket ()
   Ptr<QueueDiscItem> item;
 
   // First check if there is a requeued packet
-  if (m_requeued != 0)
+  if (!m_requeued.empty ())
     {
         // If the queue where the requeued packet is destined to is not stopped, return
         // the requeued packet; otherwise, return an empty packet.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        if (!m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            item = m_requeued.front ();
+            m_requeued.pop_front ();
 
             m_nPackets--;
             m_nBytes -= item->GetPacketSize ();
@@ -584,18 +589,50 @@ QueueDisc::DequeuePacket ()
           if (item != 0)
             {
               item->AddHeader ();
+              TryBulkDequeue (item);
             }
-          // Here, Linux tries bulk dequeues
         }
     }
   return item;
 }
 
+void
+QueueDisc::TryBulkDequeue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  // Linux only dequeues in bulk for queue discs attached to a single device
+  // queue, and the queue limits tell how many bytes the device can take
+  if (m_devQueueIface->GetNTxQueues () > 1)
+    {
+      return;
+    }
+  Ptr<QueueLimits> ql = m_devQueueIface->GetTxQueue (0)->GetQueueLimits ();
+  if (!ql)
+    {
+      return;
+    }
+
+  int32_t bytelimit = ql->Available () - static_cast<int32_t> (item->GetPacketSize ());
+  while (bytelimit > 0)
+    {
+      Ptr<QueueDiscItem> next = Dequeue ();
+      if (next == 0)
+        {
+          break;
+        }
+      next->AddHeader ();
+      bytelimit -= next->GetPacketSize ();
+      m_bulk.push_back (next);
+    }
+  NS_LOG_LOGIC ("Bulk dequeued " << m_bulk.size () << " packets");
+}
+
 void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  m_requeued.push_back (item);
   /// \todo netif_schedule (q);
 
   m_nPackets++;       // it's still part of the queue
@@ -619,16 +656,34 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   if (m_devQueueIface->GetTxQueue (item->GetTxQueueIndex ())->IsStopped ())
     {
       Requeue (item);
+      for (uint32_t i = 0; i < m_bulk.size (); i++)
+        {
+          Requeue (m_bulk[i]);
+        }
+      m_bulk.clear ();
       return false;
     }
 
-  // a single queue device makes no use of the priority tag
-  if (m_devQueueIface->GetNTxQueues () == 1)
+  SendToDevice (item);
+
+  // send the packets dequeued in bulk in a row, as Linux passes the list of
+  // packets to dev_hard_start_xmit. The queue limits leave room for all of
+  // them, but the device queue may still get stopped because it is full: the
+  // packets that cannot be sent are requeued
+  for (uint32_t i = 0; i < m_bulk.size (); i++)
     {
-      SocketPriorityTag priorityTag;
-      item->GetPacket ()->RemovePacketTag (priorityTag);
+      if (m_devQueueIface->GetTxQueue (m_bulk[i]->GetTxQueueIndex ())->IsStopped ())
+        {
+          for (; i < m_bulk.size (); i++)
+            {
+              Requeue (m_bulk[i]);
+            }
+          m_bulk.clear ();
+          return false;
+        }
+      SendToDevice (m_bulk[i]);
     }
-  m_device->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ());
+  m_bulk.clear ();
 
   // the behavior here slightly diverges from Linux. In Linux, it is advised that
   // the function called when a packet needs to be transmitted (ndo_start_xmit)
@@ -654,4 +709,18 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   return true;
 }
 
+void
+QueueDisc::SendToDevice (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  // a single queue device makes no use of the priority tag
+  if (m_devQueueIface->GetNTxQueues () == 1)
+    {
+      SocketPriorityTag priorityTag;
+      item->GetPacket ()->RemovePacketTag (priorityTag);
+    }
+  m_device->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ());
+}
+
 } // namespace ns3
@@ -25,6 +25,7 @@
 #include "ns3/queue.h"
 #include "ns3/net-device.h"
 #include <vector>
+#include <list>
 #include "packet-filter.h"
 
 namespace ns3 {
@@ -326,7 +327,9 @@ public:
   /**
    * Modelled after the Linux function __qdisc_run (net/sched/sch_generic.c)
    * Dequeues multiple packets, until a quota is exceeded or sending a packet
-   * to the device failed.
+   * to the device failed.  If the device has a single transmission queue with
+   * queue limits (see NetDeviceQueue::SetQueueLimits), each dequeue operation
+   * moves as many packets as the queue limits allow to the device.
    */
   void Run (void);
 
@@ -505,9 +508,10 @@ private:
   /**
    * Modelled after the Linux function qdisc_restart (net/sched/sch_generic.c)
    * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit).
+   * \param packets set to the number of packets dequeued
    * \return true if a packet is successfully sent to the device.
    */
-  bool Restart (void);
+  bool Restart (uint32_t &packets);
 
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
@@ -515,6 +519,15 @@ private:
    */
   Ptr<QueueDiscItem> DequeuePacket (void);
 
+  /**
+   * Modelled after the Linux function try_bulk_dequeue_skb (net/sched/sch_generic.c)
+   * If the device has a single transmission queue with queue limits, dequeue
+   * the packets fitting, along with the given packet, in the room left by the
+   * queue limits, and store them in the bulk list.
+   * \param item the packet already dequeued
+   */
+  void TryBulkDequeue (Ptr<QueueDiscItem> item);
+
   /**
    * Modelled after the Linux function dev_requeue_skb (net/sched/sch_generic.c)
    * Requeues a packet whose transmission failed.
@@ -524,13 +537,19 @@ private:
 
   /**
    * Modelled after the Linux function sch_direct_xmit (net/sched/sch_generic.c)
-   * Sends a packet to the device if the device queue is not stopped, and requeues
-   * it otherwise.
+   * Sends a packet, followed by the packets in the bulk list, to the device as
+   * long as the device queue is not stopped, and requeues the remaining ones.
    * \param item the packet to transmit
    * \return true if the device queue is not stopped and the queue disc is not empty
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
+  /**
+   * Sends a packet to the device.
+   * \param item the packet to send
+   */
+  void SendToDevice (Ptr<QueueDiscItem> item);
+
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
   std::vector<Ptr<Queue> > m_queues;            //!< Internal queues
@@ -550,7 +569,8 @@ private:
   Ptr<NetDevice> m_device;          //!< The NetDevice on which this queue discipline is installed
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
+  std::list<Ptr<QueueDiscItem> > m_requeued;    //!< The packets that failed to be transmitted
+  std::vector<Ptr<QueueDiscItem> > m_bulk;      //!< The packets bulk dequeued after the first one
   ParentDropCallback m_parentDropCallback;   //!< Parent drop callback
 
   /// Traced callback: fired when a packet is enqueued
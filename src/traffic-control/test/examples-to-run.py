@@ -23,6 +23,9 @@ cpp_examples = [
     ("codel-vs-pfifo-asymmetric --routerWanQueueDiscType=CoDel --simDuration=10", "True", "True"),
     ("codel-vs-pfifo-basic-test --queueDiscType=PfifoFast --simDuration=10", "True", "True"),
     ("codel-vs-pfifo-basic-test --queueDiscType=CoDel --simDuration=10", "True", "True"),
+    ("fqcodel-pie-vs-red --queueDiscType=FqCoDel --simDuration=5", "True", "True"),
+    ("fqcodel-pie-vs-red --queueDiscType=PIE --simDuration=5", "True", "True"),
+    ("fqcodel-pie-vs-red --queueDiscType=RED --simDuration=5", "True", "True"),
     ("pfifo-vs-red --queueDiscType=PfifoFast", "True", "True"),
     ("pfifo-vs-red --queueDiscType=PfifoFast --modeBytes=1", "True", "True"),
     ("pfifo-vs-red --queueDiscType=RED", "True", "True"),
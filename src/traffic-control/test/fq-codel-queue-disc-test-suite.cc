@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/fq-codel-queue-disc.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-packet-filter.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/udp-header.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Base class of the FqCoDelQueueDisc test cases
+ */
+class FqCoDelQueueDiscTestCase : public TestCase
+{
+public:
+  /**
+   * \param name The test case name.
+   */
+  FqCoDelQueueDiscTestCase (std::string name);
+
+protected:
+  /**
+   * \param flows The number of flow queues.
+   * \param limit The packet limit.
+   * \param dropBatchSize The maximum number of packets dropped at once.
+   * \returns An initialized FqCoDel queue disc with a quantum of 100 bytes.
+   */
+  Ptr<FqCoDelQueueDisc> CreateQueueDisc (uint32_t flows, uint32_t limit, uint32_t dropBatchSize);
+  /**
+   * Enqueue a UDP packet of 100 bytes, IP header included, from
+   * 10.10.1.1 to 10.10.1.2.
+   * \param queue The queue disc.
+   * \param sport The source port.
+   * \param dport The destination port.
+   * \returns The packet enqueued.
+   */
+  Ptr<Packet> Enqueue (Ptr<FqCoDelQueueDisc> queue, uint16_t sport, uint16_t dport);
+};
+
+FqCoDelQueueDiscTestCase::FqCoDelQueueDiscTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+Ptr<FqCoDelQueueDisc>
+FqCoDelQueueDiscTestCase::CreateQueueDisc (uint32_t flows, uint32_t limit, uint32_t dropBatchSize)
+{
+  Ptr<FqCoDelQueueDisc> queue = CreateObjectWithAttributes<FqCoDelQueueDisc> ("Flows", UintegerValue (flows),
+                                                                              "PacketLimit", UintegerValue (limit),
+                                                                              "DropBatchSize", UintegerValue (dropBatchSize),
+                                                                              "Quantum", UintegerValue (100));
+  queue->AddPacketFilter (CreateObject<FqCoDelIpv4PacketFilter> ());
+  queue->Initialize ();
+  return queue;
+}
+
+Ptr<Packet>
+FqCoDelQueueDiscTestCase::Enqueue (Ptr<FqCoDelQueueDisc> queue, uint16_t sport, uint16_t dport)
+{
+  UdpHeader udp;
+  udp.SetSourcePort (sport);
+  udp.SetDestinationPort (dport);
+  Ptr<Packet> p = Create<Packet> (100 - 20 - udp.GetSerializedSize ());
+  p->AddHeader (udp);
+  Ipv4Header hdr;
+  hdr.SetPayloadSize (p->GetSize ());
+  hdr.SetSource (Ipv4Address ("10.10.1.1"));
+  hdr.SetDestination (Ipv4Address ("10.10.1.2"));
+  hdr.SetProtocol (17);
+  Address dest;
+  queue->Enqueue (Create<Ipv4QueueDiscItem> (p, dest, 0, hdr));
+  return p;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Flow classification and bounded flow table
+ */
+class FqCoDelQueueDiscFlowsTestCase : public FqCoDelQueueDiscTestCase
+{
+public:
+  FqCoDelQueueDiscFlowsTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FqCoDelQueueDiscFlowsTestCase::FqCoDelQueueDiscFlowsTestCase ()
+  : FqCoDelQueueDiscTestCase ("Packets classified by their 5-tuple into a bounded number of flows")
+{
+}
+
+void
+FqCoDelQueueDiscFlowsTestCase::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> queue = CreateQueueDisc (1024, 100, 64);
+  Enqueue (queue, 5000, 80);
+  Enqueue (queue, 5000, 80);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 1, "Packets of a flow not in the same flow queue");
+  Enqueue (queue, 5001, 80);
+  Enqueue (queue, 5000, 81);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 3, "Packets of distinct flows in the same flow queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 4, "Unexpected number of packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 2,
+                         "Unexpected number of packets in the first flow queue");
+
+  queue = CreateQueueDisc (1, 100, 64);
+  for (uint16_t i = 0; i < 10; i++)
+    {
+      Enqueue (queue, 5000 + i, 80);
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNQueueDiscClasses (), 1, "More flow queues than the Flows attribute");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 10, "Unexpected number of packets");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Deficit round robin between new and old flows
+ */
+class FqCoDelQueueDiscDeficitTestCase : public FqCoDelQueueDiscTestCase
+{
+public:
+  FqCoDelQueueDiscDeficitTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FqCoDelQueueDiscDeficitTestCase::FqCoDelQueueDiscDeficitTestCase ()
+  : FqCoDelQueueDiscTestCase ("Deficit round robin between new and old flows")
+{
+}
+
+void
+FqCoDelQueueDiscDeficitTestCase::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> queue = CreateQueueDisc (1024, 100, 64);
+  Ptr<Packet> a1 = Enqueue (queue, 5000, 80);
+  Ptr<Packet> a2 = Enqueue (queue, 5000, 80);
+  Ptr<Packet> a3 = Enqueue (queue, 5000, 80);
+  Ptr<Packet> b1 = Enqueue (queue, 5001, 80);
+
+  // The first flow uses its quantum, then the second one, new, is served
+  // before the first one, old, gets a new quantum
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue ()->GetPacket (), a1, "Unexpected first packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue ()->GetPacket (), b1, "The new flow was not served second");
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue ()->GetPacket (), a2, "Unexpected third packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue ()->GetPacket (), a3, "Unexpected fourth packet");
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue (), 0, "Packet dequeued from an empty queue disc");
+
+  // The flows are inactive once empty, and new again with their next packet
+  Ptr<Packet> b2 = Enqueue (queue, 5001, 80);
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue ()->GetPacket (), b2, "Flow not active again");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "Packets left in the queue disc");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Drops from the fattest flow when over the packet limit
+ */
+class FqCoDelQueueDiscOverlimitTestCase : public FqCoDelQueueDiscTestCase
+{
+public:
+  FqCoDelQueueDiscOverlimitTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FqCoDelQueueDiscOverlimitTestCase::FqCoDelQueueDiscOverlimitTestCase ()
+  : FqCoDelQueueDiscTestCase ("Drops from the fattest flow when over the packet limit")
+{
+}
+
+void
+FqCoDelQueueDiscOverlimitTestCase::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> queue = CreateQueueDisc (1024, 8, 1);
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      Enqueue (queue, 5000, 80);
+    }
+  Enqueue (queue, 5001, 80);
+  Enqueue (queue, 5001, 80);
+  Enqueue (queue, 5002, 80);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 8, "Packet limit not enforced");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDropOverLimit (), 1, "Unexpected number of overlimit drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 5,
+                         "The packet was not dropped from the fattest flow");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueDiscClass (2)->GetQueueDisc ()->GetNPackets (), 1,
+                         "The packet was dropped from the last flow");
+
+  // Half of the backlog of the fattest flow is dropped at once
+  queue = CreateQueueDisc (1024, 8, 64);
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      Enqueue (queue, 5000, 80);
+    }
+  Enqueue (queue, 5001, 80);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDropOverLimit (), 4, "Half of the fattest flow not dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 5, "Unexpected number of packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 4, "Drops not counted by the queue disc");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief FqCoDelQueueDisc TestSuite
+ */
+static class FqCoDelQueueDiscTestSuite : public TestSuite
+{
+public:
+  FqCoDelQueueDiscTestSuite ()
+    : TestSuite ("fq-codel-queue-disc", UNIT)
+  {
+    AddTestCase (new FqCoDelQueueDiscFlowsTestCase (), TestCase::QUICK);
+    AddTestCase (new FqCoDelQueueDiscDeficitTestCase (), TestCase::QUICK);
+    AddTestCase (new FqCoDelQueueDiscOverlimitTestCase (), TestCase::QUICK);
+  }
+} g_fqCoDelQueueDiscTestSuite; ///< the test suite
@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/pie-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Pie Queue Disc Test Item
+ */
+class PieQueueDiscTestItem : public QueueDiscItem {
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param protocol the protocol
+   */
+  PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  virtual ~PieQueueDiscTestItem ();
+  virtual void AddHeader (void);
+
+private:
+  PieQueueDiscTestItem ();
+  /**
+   * \brief Copy constructor
+   * Disable default implementation to avoid misuse
+   */
+  PieQueueDiscTestItem (const PieQueueDiscTestItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Disable default implementation to avoid misuse
+   */
+  PieQueueDiscTestItem &operator = (const PieQueueDiscTestItem &);
+};
+
+PieQueueDiscTestItem::PieQueueDiscTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+  : QueueDiscItem (p, addr, protocol)
+{
+}
+
+PieQueueDiscTestItem::~PieQueueDiscTestItem ()
+{
+}
+
+void
+PieQueueDiscTestItem::AddHeader (void)
+{
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Pie Queue Disc Test Case
+ */
+class PieQueueDiscTestCase : public TestCase
+{
+public:
+  PieQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue a packet of 1000 bytes
+   * \param queue the queue disc
+   */
+  void Enqueue (Ptr<PieQueueDisc> queue);
+  /**
+   * Dequeue a packet
+   * \param queue the queue disc
+   */
+  void Dequeue (Ptr<PieQueueDisc> queue);
+  /**
+   * Check the limit and the burst allowance
+   * \param mode the mode of the queue disc
+   */
+  void RunLimitTest (StringValue mode);
+  /**
+   * Check the early drops of a queue disc receiving twice the
+   * traffic it can send
+   */
+  void RunOverloadTest (void);
+  /**
+   * Check the updates of an idle queue disc
+   */
+  void RunIdleTest (void);
+};
+
+PieQueueDiscTestCase::PieQueueDiscTestCase ()
+  : TestCase ("Sanity check on the pie queue disc implementation")
+{
+}
+
+void
+PieQueueDiscTestCase::Enqueue (Ptr<PieQueueDisc> queue)
+{
+  Address dest;
+  queue->Enqueue (Create<PieQueueDiscTestItem> (Create<Packet> (1000), dest, 0));
+}
+
+void
+PieQueueDiscTestCase::Dequeue (Ptr<PieQueueDisc> queue)
+{
+  queue->Dequeue ();
+}
+
+void
+PieQueueDiscTestCase::RunLimitTest (StringValue mode)
+{
+  Ptr<PieQueueDisc> queue = CreateObject<PieQueueDisc> ();
+  uint32_t limit = 10;
+  if (mode.Get () == "QUEUE_MODE_BYTES")
+    {
+      limit *= 1000;
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (limit)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Tupdate", StringValue ("30ms")), true,
+                         "Verify that we can actually set the attribute Tupdate");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueDelayReference", StringValue ("20ms")), true,
+                         "Verify that we can actually set the attribute QueueDelayReference");
+  queue->Initialize ();
+
+  // The burst allowance protects the first packets from early drops
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      Enqueue (queue);
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), limit, "The queue disc is not full");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().forcedDrop, 2, "Unexpected number of forced drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().unforcedDrop, 0, "Early drop within the burst allowance");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_EXPECT_MSG_NE (queue->Dequeue (), 0, "A packet was not dequeued");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue (), 0, "Packet dequeued from an empty queue disc");
+  Simulator::Destroy ();
+}
+
+void
+PieQueueDiscTestCase::RunOverloadTest (void)
+{
+  Ptr<PieQueueDisc> queue = CreateObjectWithAttributes<PieQueueDisc> ("QueueLimit", UintegerValue (10000));
+  queue->AssignStreams (1);
+  queue->Initialize ();
+
+  // 1000 byte packets arrive every ms and leave every 2 ms, for 10 s
+  for (uint32_t i = 0; i < 10000; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &PieQueueDiscTestCase::Enqueue, this, queue);
+      if (i % 2 == 0)
+        {
+          Simulator::Schedule (MilliSeconds (i) + MicroSeconds (1), &PieQueueDiscTestCase::Dequeue, this, queue);
+        }
+    }
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().forcedDrop, 0, "Unexpected forced drops");
+  NS_TEST_EXPECT_MSG_GT (queue->GetStats ().unforcedDrop, 4500, "Not enough early drops");
+  // Without early drops, the queue delay would be 10 s
+  NS_TEST_EXPECT_MSG_LT (queue->GetQueueDelay (), MilliSeconds (50), "Queue delay not controlled");
+  NS_TEST_EXPECT_MSG_GT (queue->GetDropProbability (), 0.4, "Unexpected drop probability");
+  Simulator::Destroy ();
+}
+
+void
+PieQueueDiscTestCase::RunIdleTest (void)
+{
+  Ptr<PieQueueDisc> queue = CreateObject<PieQueueDisc> ();
+  queue->Initialize ();
+
+  // The updates stop while the queue disc is idle, so the simulation ends
+  Simulator::Schedule (Seconds (1), &PieQueueDiscTestCase::Enqueue, this, queue);
+  Simulator::Schedule (Seconds (1.001), &PieQueueDiscTestCase::Dequeue, this, queue);
+  Simulator::Schedule (Seconds (5), &PieQueueDiscTestCase::Enqueue, this, queue);
+  Simulator::Schedule (Seconds (5.001), &PieQueueDiscTestCase::Dequeue, this, queue);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "Unexpected number of packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetDropProbability (), 0, "Unexpected drop probability");
+  // The updates are resumed on their 30 ms grid, the last one finding
+  // the queue disc idle again
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MilliSeconds (5010), "Updates not resumed on time");
+  Simulator::Destroy ();
+}
+
+void
+PieQueueDiscTestCase::DoRun (void)
+{
+  RunLimitTest (StringValue ("QUEUE_MODE_PACKETS"));
+  RunLimitTest (StringValue ("QUEUE_MODE_BYTES"));
+  RunOverloadTest ();
+  RunIdleTest ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Pie Queue Disc Test Suite
+ */
+static class PieQueueDiscTestSuite : public TestSuite
+{
+public:
+  PieQueueDiscTestSuite ()
+    : TestSuite ("pie-queue-disc", UNIT)
+  {
+    AddTestCase (new PieQueueDiscTestCase (), TestCase::QUICK);
+  }
+} g_pieQueueTestSuite; ///< the test suite
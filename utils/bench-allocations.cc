@@ -0,0 +1,55 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "bench-allocations.h"
+#include <cstdlib>
+#include <new>
+
+/// Number of calls to the global operator new, counted by the replacement below
+static uint64_t g_allocations = 0;
+/// Number of bytes requested from the global operator new
+static uint64_t g_allocatedBytes = 0;
+
+void *
+operator new (std::size_t size)
+{
+  g_allocations++;
+  g_allocatedBytes += size;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+uint64_t
+BenchGetAllocations (void)
+{
+  return g_allocations;
+}
+
+uint64_t
+BenchGetAllocatedBytes (void)
+{
+  return g_allocatedBytes;
+}
@@ -0,0 +1,42 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BENCH_ALLOCATIONS_H
+#define BENCH_ALLOCATIONS_H
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup utils
+ * Allocation counters of the benchmarks.
+ *
+ * Linking bench-allocations.cc into a program replaces the global
+ * <tt>operator new</tt> and <tt>operator delete</tt> with versions
+ * which count the allocations of the whole program.
+ */
+
+/**
+ * \returns The number of calls to the global operator new so far.
+ */
+uint64_t BenchGetAllocations (void);
+
+/**
+ * \returns The number of bytes requested from the global operator new so far.
+ */
+uint64_t BenchGetAllocatedBytes (void);
+
+#endif /* BENCH_ALLOCATIONS_H */
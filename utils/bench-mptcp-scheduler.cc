@@ -0,0 +1,297 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mptcp-meta-socket.h"
+#include "ns3/mptcp-subflow.h"
+#include "ns3/mptcp-scheduler.h"
+#include "bench-allocations.h"
+
+using namespace ns3;
+
+
+bool g_debug = false;
+
+std::string g_me;
+#define LOG(x)   std::cout << x << std::endl
+#define LOGME(x) LOG (g_me << x)
+#define DEB(x) if (g_debug) { LOGME (x) ; }
+
+// Output field width
+int g_fwidth = 12;
+
+/**
+ * Subflow whose congestion state is set directly by the benchmark,
+ * without any connection behind it.
+ */
+class BenchSubflow : public MpTcpSubflow
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::BenchSubflow")
+      .SetParent<MpTcpSubflow> ()
+      .AddConstructor<BenchSubflow> ()
+    ;
+    return tid;
+  }
+
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+
+  /**
+   * Put the subflow in ESTABLISHED with the given window state.
+   * \param cwnd congestion window, in bytes
+   * \param inFlight unacknowledged bytes
+   * \param rtt smoothed RTT estimate
+   */
+  void SetSyntheticState (uint32_t cwnd, uint32_t inFlight, Time rtt)
+  {
+    m_state = ESTABLISHED;
+    m_tcb->m_cWnd = cwnd;
+    m_tcb->m_nextTxSequence = m_txBuffer->HeadSequence () + inFlight;
+    m_rtt->Reset ();
+    m_rtt->Measurement (rtt);
+  }
+};
+
+/**
+ * Meta socket that accepts synthetic subflows in its active list.
+ */
+class BenchMetaSocket : public MpTcpMetaSocket
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::BenchMetaSocket")
+      .SetParent<MpTcpMetaSocket> ()
+      .AddConstructor<BenchMetaSocket> ()
+    ;
+    return tid;
+  }
+
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+
+  /**
+   * Add an active subflow with the given window state.
+   * \param cwnd congestion window, in bytes
+   * \param inFlight unacknowledged bytes
+   * \param rtt smoothed RTT estimate
+   */
+  void AddSyntheticSubflow (uint32_t cwnd, uint32_t inFlight, Time rtt)
+  {
+    Ptr<BenchSubflow> subflow = DynamicCast<BenchSubflow> (CreateSubflow (false));
+    NS_ASSERT (subflow);
+    subflow->SetSyntheticState (cwnd, inFlight, rtt);
+    subflow->SetSubflowId (m_subflows.size ());
+    // Not through AddSubflow (): the state traces would start sending
+    m_subflows.push_back (subflow);
+    m_activeSubflows.push_back (subflow);
+  }
+
+  /**
+   * \param rwnd connection level receive window, in bytes
+   */
+  void SetReceiverWindow (uint32_t rwnd)
+  {
+    m_rWnd = rwnd;
+  }
+
+  /// \return the segment size given to the subflows
+  uint32_t GetSegmentSize (void) const
+  {
+    return m_segmentSize;
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (BenchSubflow);
+NS_OBJECT_ENSURE_REGISTERED (BenchMetaSocket);
+
+
+class Bench
+{
+public:
+  Bench (const uint32_t decisions, const double busy)
+    : m_decisions (decisions),
+      m_busy (busy)
+  { };
+
+  void SetDecisions (const uint32_t decisions)
+  {
+    m_decisions = decisions;
+  }
+
+  void RunBench (TypeId scheduler, uint32_t subflows);
+private:
+  uint32_t m_decisions;
+  double m_busy;
+};
+
+void
+Bench::RunBench (TypeId schedulerTypeId, uint32_t subflows)
+{
+  SystemWallClockMs time;
+  double simu;
+
+  DEB ("initializing " << schedulerTypeId.GetName () << " with " << subflows << " subflows");
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper stack;
+  stack.Install (node);
+
+  Ptr<TcpL4Protocol> tcp = node->GetObject<TcpL4Protocol> ();
+  Ptr<BenchMetaSocket> meta = DynamicCast<BenchMetaSocket>
+      (tcp->CreateSocket (TcpNewReno::GetTypeId (), BenchMetaSocket::GetTypeId ()));
+  meta->SetAttribute ("SocketType", TypeIdValue (BenchSubflow::GetTypeId ()));
+  meta->SetReceiverWindow (0xffffffff);
+
+  // Same subflow states for every scheduler
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  uint32_t segmentSize = meta->GetSegmentSize ();
+  for (uint32_t i = 0; i < subflows; i++)
+    {
+      uint32_t cwnd = rand->GetInteger (2, 64) * segmentSize;
+      uint32_t inFlight = rand->GetValue () < m_busy ? cwnd : rand->GetInteger (0, cwnd - segmentSize);
+      Time rtt = MilliSeconds (rand->GetInteger (10, 200));
+      meta->AddSyntheticSubflow (cwnd, inFlight, rtt);
+    }
+
+  ObjectFactory factory (schedulerTypeId.GetName ());
+  Ptr<MpTcpScheduler> scheduler = factory.Create<MpTcpScheduler> ();
+  scheduler->SetMeta (meta);
+
+  uint32_t found = 0;
+  uint64_t allocations = BenchGetAllocations ();
+  time.Start ();
+  for (uint32_t i = 0; i < m_decisions; ++i)
+    {
+      if (scheduler->GetAvailableSubflow (segmentSize, 0xffffffff))
+        {
+          ++found;
+        }
+    }
+  simu = time.End ();
+  allocations = BenchGetAllocations () - allocations;
+  simu /= 1000;
+  DEB ("run took " << simu << "s, " << found << " decisions found a subflow");
+
+  LOG (std::left << std::setw (3 * g_fwidth) << schedulerTypeId.GetName () <<
+       std::right << std::setw (g_fwidth) << subflows <<
+       std::setw (g_fwidth) << simu <<
+       std::setw (g_fwidth) << (simu * 1e9 / m_decisions) <<
+       std::setw (g_fwidth) << (double (allocations) / m_decisions));
+
+  scheduler = 0;
+  meta->Close ();
+  Simulator::Destroy ();
+}
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t decisions = 100000;
+  uint32_t minSubflows = 2;
+  uint32_t maxSubflows = 64;
+  double busy = 0.5;
+  std::string only = "";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the MPTCP schedulers.\n"
+             "\n"
+             "Each registered MpTcpScheduler is asked for a subflow\n"
+             "repeatedly, against synthetic ESTABLISHED subflows with\n"
+             "random congestion windows, bytes in flight and RTT\n"
+             "estimates, from --min to --max subflows (doubling).\n"
+             "The time and the number of operator new calls per\n"
+             "decision are reported.");
+  cmd.AddValue ("decisions", "decisions per run (default 1E5)",          decisions);
+  cmd.AddValue ("min",       "smallest number of subflows (default 2)", minSubflows);
+  cmd.AddValue ("max",       "largest number of subflows (default 64)", maxSubflows);
+  cmd.AddValue ("busy",      "fraction of subflows with a full window", busy);
+  cmd.AddValue ("scheduler", "only benchmark this scheduler TypeId",    only);
+  cmd.AddValue ("debug",     "enable debugging output",                 g_debug);
+  cmd.Parse (argc, argv);
+  g_me = cmd.GetName () + ": ";
+
+  if (minSubflows == 0)
+    {
+      std::cerr << g_me << "Error-- the smallest number of subflows must be " <<
+        "at least 1 (--min)" << std::endl;
+      exit (1);
+    }
+
+  std::vector<TypeId> schedulers;
+  for (uint32_t i = 0; i < TypeId::GetRegisteredN (); i++)
+    {
+      TypeId tid = TypeId::GetRegistered (i);
+      if (tid.IsChildOf (MpTcpScheduler::GetTypeId ()) && tid != MpTcpScheduler::GetTypeId ()
+          && tid.HasConstructor () && (only == "" || tid.GetName () == only))
+        {
+          schedulers.push_back (tid);
+        }
+    }
+
+  LOGME (std::fixed << std::setprecision (3));
+  DEB ("debugging is ON");
+  LOGME ("schedulers: " << schedulers.size ());
+  LOGME ("decisions per run: " << decisions);
+  LOGME ("busy subflows: " << busy);
+
+  Bench bench (decisions, busy);
+
+  // table header
+  LOG ("");
+  LOG (std::left << std::setw (3 * g_fwidth) << "Scheduler" <<
+       std::right << std::setw (g_fwidth) << "Subflows" <<
+       std::setw (g_fwidth) << "Time (s)" <<
+       std::setw (g_fwidth) << "ns/decision" <<
+       std::setw (g_fwidth) << "allocs/dec");
+  LOG (std::setfill ('-') << std::setw (7 * g_fwidth) << "" << std::setfill (' '));
+
+  // prime
+  DEB ("priming");
+  if (!schedulers.empty ())
+    {
+      bench.SetDecisions (decisions / 10 + 1);
+      std::cout << "(prime) ";
+      bench.RunBench (schedulers[0], minSubflows);
+      bench.SetDecisions (decisions);
+    }
+
+  for (std::vector<TypeId>::const_iterator it = schedulers.begin (); it != schedulers.end (); ++it)
+    {
+      for (uint32_t n = minSubflows; n <= maxSubflows; n *= 2)
+        {
+          bench.RunBench (*it, n);
+        }
+    }
+
+  LOG ("");
+  return 0;
+}
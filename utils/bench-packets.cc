@@ -21,12 +21,14 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "bench-allocations.h"
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <stdlib.h> // for exit ()
 #include <limits>
 #include <algorithm>
+#include <vector>
 
 using namespace ns3;
 
@@ -302,6 +304,39 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchInFlight (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchHeader<20> tcp;
+
+  // The segments are kept until the end, so that the bytes allocated per
+  // packet are the memory held by each in-flight segment
+  std::vector<Ptr<Packet> > inFlight;
+  inFlight.reserve (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // A segment made of the end of an application write and the start
+      // of the next one, as in the TCP send buffer
+      Ptr<Packet> write0 = Create<Packet> (1448);
+      Ptr<Packet> write1 = Create<Packet> (1448);
+      Ptr<Packet> segment = write0->CreateFragment (1000, 448);
+      segment->AddAtEnd (write1->CreateFragment (0, 552));
+      segment->AddHeader (tcp);
+      segment->AddHeader (ipv4);
+      inFlight.push_back (segment);
+
+      // Received in two parts and extracted at once, as in the TCP
+      // receive buffer
+      Ptr<Packet> copy = segment->Copy ();
+      copy->RemoveHeader (ipv4);
+      copy->RemoveHeader (tcp);
+      Ptr<Packet> received = Create<Packet> ();
+      received->AddAtEnd (copy->CreateFragment (0, 500));
+      received->AddAtEnd (copy->CreateFragment (500, 500));
+    }
+}
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -317,15 +352,27 @@ static void
 runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
 {
   uint64_t minDelay = std::numeric_limits<uint64_t>::max();
+  uint64_t allocations = BenchGetAllocations ();
+  uint64_t allocatedBytes = BenchGetAllocatedBytes ();
   for (uint32_t i = 0; i < minIterations; i++)
     {
       uint64_t delay = runBenchOneIteration(bench, n);
       minDelay = std::min(minDelay, delay);
     }
+  allocations = BenchGetAllocations () - allocations;
+  allocatedBytes = BenchGetAllocatedBytes () - allocatedBytes;
   double ps = n;
   ps *= 1000;
   ps /= minDelay;
-  std::cout << ps << " packets/s"
+  double apb = allocations;
+  apb /= n;
+  apb /= minIterations;
+  double bpb = allocatedBytes;
+  bpb /= n;
+  bpb /= minIterations;
+  std::cout << ps << " packets/s, "
+            << apb << " allocations/packet, "
+            << bpb << " bytes/packet"
             << " (" << minDelay << " ms elapsed)\t"
             << name
             << std::endl;
@@ -359,6 +406,7 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchInFlight, n, minIterations, "In-flight segments of payload fragments");
 
   return 0;
 }
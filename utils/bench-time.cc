@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iostream>
+#include <limits>
+#include <vector>
+#include <stdlib.h>
+
+#include "ns3/core-module.h"
+#include "ns3/rtt-estimator.h"
+
+using namespace ns3;
+
+// Results of the benchmarks, so that the compiler keeps the computations
+static double g_sink = 0;
+
+// RTT samples, in the order they are used
+static std::vector<Time> g_samples;
+
+static void
+benchGetSeconds (uint32_t n)
+{
+  double sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += g_samples[i % g_samples.size ()].GetSeconds ();
+    }
+  g_sink += sum;
+}
+
+static void
+benchGetMicroSeconds (uint32_t n)
+{
+  int64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += g_samples[i % g_samples.size ()].GetMicroSeconds ();
+    }
+  g_sink += sum;
+}
+
+static void
+benchScale (uint32_t n)
+{
+  int64x64_t factor (1.5);
+  Time sum;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      sum += Time (g_samples[i % g_samples.size ()] * factor);
+    }
+  g_sink += sum.GetDouble ();
+}
+
+static void
+benchFromDouble (uint32_t n)
+{
+  Time sum;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double s = g_samples[i % g_samples.size ()].ToDouble (Time::S) * 0.125;
+      sum += Time::FromDouble (s, Time::S);
+    }
+  g_sink += sum.GetDouble ();
+}
+
+/**
+ * Feed the samples to a RttMeanDeviation.
+ * \param n number of samples
+ * \param alpha gain of the average
+ * \param beta gain of the variation
+ */
+static void
+benchRtt (uint32_t n, double alpha, double beta)
+{
+  Ptr<RttMeanDeviation> rtt = CreateObject<RttMeanDeviation> ();
+  rtt->SetAttribute ("Alpha", DoubleValue (alpha));
+  rtt->SetAttribute ("Beta", DoubleValue (beta));
+  for (uint32_t i = 0; i < n; i++)
+    {
+      rtt->Measurement (g_samples[i % g_samples.size ()]);
+    }
+  g_sink += rtt->GetEstimate ().GetDouble () + rtt->GetVariation ().GetDouble ();
+}
+
+static void
+benchRttInteger (uint32_t n)
+{
+  benchRtt (n, 0.125, 0.25);
+}
+
+static void
+benchRttFloatingPoint (uint32_t n)
+{
+  benchRtt (n, 0.1, 0.2);
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      SystemWallClockMs time;
+      time.Start ();
+      (*bench) (n);
+      uint64_t delay = time.End ();
+      minDelay = std::min (minDelay, delay);
+    }
+  double nsPerOp = minDelay;
+  nsPerOp *= 1e6;
+  nsPerOp /= n;
+  std::cout << nsPerOp << " ns/op"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+/**
+ * Run the benchmarks, from an event: before Simulator::Run() the Time
+ * instances are recorded, in case the resolution changes.
+ * \param n number of operations per iteration
+ * \param minIterations number of iterations to minimize the time over
+ */
+static void
+runAll (uint32_t n, uint32_t minIterations)
+{
+  runBench (&benchGetSeconds, n, minIterations, "Time::GetSeconds");
+  runBench (&benchGetMicroSeconds, n, minIterations, "Time::GetMicroSeconds");
+  runBench (&benchScale, n, minIterations, "Time * int64x64_t");
+  runBench (&benchFromDouble, n, minIterations, "Time::ToDouble and FromDouble");
+  runBench (&benchRttInteger, n, minIterations, "RttMeanDeviation::Measurement, integer update");
+  runBench (&benchRttFloatingPoint, n, minIterations, "RttMeanDeviation::Measurement, floating point update");
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 10000000;
+  uint32_t minIterations = 3;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the Time arithmetic used per segment by TCP.\n"
+             "\n"
+             "The conversions run over a set of random RTT samples, which\n"
+             "are also fed to RttMeanDeviation::Measurement, with gains\n"
+             "which are powers of two (integer update) or not (floating\n"
+             "point update). See bench-mptcp-scheduler for the scheduler\n"
+             "decisions.");
+  cmd.AddValue ("n", "number of operations per iteration (default 1E7)", n);
+  cmd.AddValue ("min-iterations", "number of iterations to minimize the time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  rand->SetStream (1);
+  for (uint32_t i = 0; i < 1024; i++)
+    {
+      g_samples.push_back (MicroSeconds (rand->GetInteger (10000, 200000)));
+    }
+
+  std::cout << "Running bench-time with n=" << n << std::endl;
+  Simulator::ScheduleNow (&runAll, n, minIterations);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  std::cout << "(" << g_sink << ")" << std::endl;
+
+  return 0;
+}